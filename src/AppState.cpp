@@ -1,8 +1,15 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <thread>
 #include "AppState.h"
+#include "Common/AllocationCounter.h"
 #include "Common/Logger.h"
+#include "Common/Tracer.h"
 
 using std::this_thread::yield;
+using std::chrono::duration;
+using std::chrono::steady_clock;
 
 namespace octronic
 {
@@ -11,35 +18,96 @@ namespace octronic
         mArgc(argc),
     	mArgv(argv),
       	mWindow(this),
-        mGridDrawer(this),
-        mGaugeBackgroundWidget(this,"Images/Gauge/Background.png"),
-        mGaugeNeedleWidget(this,"Images/Gauge/Needle.png")
+        mFrameAllocations(0),
+        mTextRenderer(this),
+        mDashboard(this)
 	{
 		debug("AppState: Constructor");
     }
 
     bool AppState::Init()
     {
+        TRACE_SCOPE("AppState::Init");
 		debug("AppState: Init");
         if (!mWindow.Init())       return false;
+        if (!mFrameUniforms.Init()) return false;
+        if (!mAssetPack.Open(ASSET_PACK_FILE_NAME))
+        {
+            info("AppState: No {}, using loose resources", ASSET_PACK_FILE_NAME);
+        }
+        if (HasArgument("--hot-reload"))
+        {
+            mAssetReloader.Start();
+        }
+        string shmName;
+        if (GetArgumentValue("--shm-ingest", shmName) && shmName.compare(0, 2, "--") != 0)
+        {
+            mShmIngest.Start(shmName);
+        }
+        else if (HasArgument("--shm-ingest"))
+        {
+            mShmIngest.Start(SHM_RING_DEFAULT_NAME);
+        }
+        string socketPath;
+        if (GetArgumentValue("--socket-ingest", socketPath) && socketPath.compare(0, 2, "--") != 0)
+        {
+            mSocketIngest.Start(socketPath, mChannelRegistry);
+        }
+        else if (HasArgument("--socket-ingest"))
+        {
+            mSocketIngest.Start(SOCKET_INGEST_DEFAULT_PATH, mChannelRegistry);
+        }
+        string budget;
+        if (GetArgumentValue("--gpu-budget-mb", budget))
+        {
+            mGpuMemoryTracker.SetBudget(static_cast<size_t>(atol(budget.c_str())) * 1024 * 1024);
+        }
+        if (!mTextRenderer.Init())
+        {
+            warn("AppState: Text rendering unavailable");
+        }
         if (!CreateWidgets())    return false;
+        mGpuMemoryTracker.LogSummary();
+        // Last, so the replay clock starts with the first frame
+        if (!InitReplay())       return false;
         return true;
     }
 
-    bool AppState::CreateWidgets()
+    bool AppState::InitReplay()
     {
-		debug("AppState: CreateGLWidgets");
-        if (!mGridDrawer.Init()) return false;
-        mWindow.AddWidget(&mGridDrawer);
+        string recordPath;
+        if (GetArgumentValue("--record", recordPath) && !mRecorder.Start(recordPath, mChannelRegistry))
+        {
+            return false;
+        }
 
-        if (!mGaugeBackgroundWidget.Init()) return false;
-        mWindow.AddWidget(&mGaugeBackgroundWidget);
+        string replayPath;
+        if (!GetArgumentValue("--replay", replayPath)) return true;
+        if (!mReplay.Open(replayPath)) return false;
 
-        if (!mGaugeNeedleWidget.Init()) return false;
-        mWindow.AddWidget(&mGaugeNeedleWidget);
+        // 0 replays as fast as frames render
+        string speed = "1";
+        GetArgumentValue("--replay-speed", speed);
+        if (!mReplay.Start(mChannelRegistry, atof(speed.c_str()))) return false;
+
+        string from;
+        if (GetArgumentValue("--replay-from", from))
+        {
+            mReplay.Seek(mReplay.GetStartTime() + atof(from.c_str()));
+        }
         return true;
     }
 
+    bool AppState::CreateWidgets()
+    {
+		debug("AppState: CreateGLWidgets");
+        string dashboardPath = DASHBOARD_DEFAULT_FILE;
+        GetArgumentValue("--dashboard", dashboardPath);
+        mDashboard.SetSnapshotsEnabled(!HasArgument("--no-dashboard-snapshot"));
+        if (!mDashboard.Load(dashboardPath)) return false;
+        return mDashboard.Init();
+    }
+
     bool AppState::GetLooping() const
     {
         return mLooping;
@@ -53,16 +121,162 @@ namespace octronic
     bool AppState::Run()
     {
 		debug("AppState: Run");
+        bool replaying = mReplay.IsOpen();
+        // A headless replay is a benchmark run and ends with the recording
+        bool exitOnReplayEnd = replaying && HasArgument("--headless");
+        uint64_t frames = 0;
+        steady_clock::time_point start = steady_clock::now();
+        ReplayFrameStats stats;
         while (mLooping)
         {
-            mWindow.Update();
+            uint64_t allocations = AllocationCounter::GetThreadCount();
+            steady_clock::time_point frameStart = steady_clock::now();
+            {
+                TRACE_SCOPE("Frame");
+                mFrameArena.Reset();
+                mAssetReloader.ApplyPending();
+                mShmIngest.Poll(mChannelRegistry);
+                mReplay.Poll();
+                mChannelRegistry.DrainAll();
+                mRecorder.Capture(mChannelRegistry);
+                mAlarmEngine.Evaluate();
+                mFrameUniforms.Update();
+                mSceneGraph.Update();
+                mTrendDownsampler.Run();
+                mWindow.Update();
+                mGpuMemoryTracker.EnforceBudget();
+                mGpuMemoryTracker.NextFrame();
+            }
+            mFrameAllocations = AllocationCounter::GetThreadCount() - allocations;
+            frames++;
+            double frameSeconds = duration<double>(steady_clock::now() - frameStart).count();
+            stats.worstFrameSeconds = std::max(stats.worstFrameSeconds, frameSeconds);
+            stats.frameSeconds += frameSeconds;
+            if (mFrameAllocations > 0) stats.lastAllocatingFrame = frames;
+            if (exitOnReplayEnd && mReplay.IsFinished()) mLooping = false;
+            Tracer::WritePendingRequest();
             yield();
         }
+        if (replaying)
+        {
+            LogReplaySummary(frames, duration<double>(steady_clock::now() - start).count(), stats);
+        }
+        mRecorder.Stop();
         return true;
     }
 
+    void AppState::LogReplaySummary(uint64_t frames, double seconds, const ReplayFrameStats& stats)
+    {
+        if (seconds <= 0.0 || frames == 0) return;
+        info("AppState: Replayed {} samples in {} frames over {:.2f}s: {:.1f} frames/s, {:.0f} samples/s",
+            mReplay.GetReplayedCount(), frames, seconds, frames / seconds, mReplay.GetReplayedCount() / seconds);
+        info("AppState: {} widgets, {:.2f} ms mean and {:.2f} ms worst frame time, {} culled in the last frame",
+            mWindow.GetWidgetStore().GetCount(), stats.frameSeconds / frames * 1000.0,
+            stats.worstFrameSeconds * 1000.0, mWindow.GetWidgetStore().GetCulledCount());
+        info("AppState: {} samples dropped by full channels, {} frames held samples back for later frames, "
+            "{} samples already missing from the recording",
+            mReplay.GetDroppedCount(), mReplay.GetPacedFrameCount(), mReplay.GetRecordedDropCount());
+        if (AllocationCounter::IsEnabled())
+        {
+            info("AppState: The last frame made {} heap allocations; the last frame to allocate was {} of {}",
+                mFrameAllocations, stats.lastAllocatingFrame, frames);
+        }
+    }
+
     Window& AppState::GetWindow()
     {
         return mWindow;
     }
+
+    GpuMemoryTracker& AppState::GetGpuMemoryTracker()
+    {
+        return mGpuMemoryTracker;
+    }
+
+    FrameUniforms& AppState::GetFrameUniforms()
+    {
+        return mFrameUniforms;
+    }
+
+    FrameArena& AppState::GetFrameArena()
+    {
+        return mFrameArena;
+    }
+
+    Dashboard& AppState::GetDashboard()
+    {
+        return mDashboard;
+    }
+
+    TextRenderer& AppState::GetTextRenderer()
+    {
+        return mTextRenderer;
+    }
+
+    AssetPack& AppState::GetAssetPack()
+    {
+        return mAssetPack;
+    }
+
+    AssetReloader& AppState::GetAssetReloader()
+    {
+        return mAssetReloader;
+    }
+
+    ChannelRegistry& AppState::GetChannelRegistry()
+    {
+        return mChannelRegistry;
+    }
+
+    AlarmEngine& AppState::GetAlarmEngine()
+    {
+        return mAlarmEngine;
+    }
+
+    uint64_t AppState::GetFrameAllocationCount() const
+    {
+        return mFrameAllocations;
+    }
+
+    SceneGraph& AppState::GetSceneGraph()
+    {
+        return mSceneGraph;
+    }
+
+    TrendDownsampler& AppState::GetTrendDownsampler()
+    {
+        return mTrendDownsampler;
+    }
+
+    Recorder& AppState::GetRecorder()
+    {
+        return mRecorder;
+    }
+
+    ReplayDriver& AppState::GetReplayDriver()
+    {
+        return mReplay;
+    }
+
+    bool AppState::HasArgument(const string& name) const
+    {
+        for (int i = 1; i < mArgc; i++)
+        {
+            if (name == mArgv[i]) return true;
+        }
+        return false;
+    }
+
+    bool AppState::GetArgumentValue(const string& name, string& value) const
+    {
+        for (int i = 1; i + 1 < mArgc; i++)
+        {
+            if (name == mArgv[i])
+            {
+                value = mArgv[i + 1];
+                return true;
+            }
+        }
+        return false;
+    }
 }
@@ -1,8 +1,21 @@
 #pragma once
 
 #include "Window.h"
-#include "Widgets/Grid.h"
-#include "Widgets/ImageWidget.h"
+#include "Common/FrameArena.h"
+#include "Common/FrameUniforms.h"
+#include "Common/GpuMemoryTracker.h"
+#include "Assets/AssetPack.h"
+#include "Assets/AssetReloader.h"
+#include "Data/AlarmEngine.h"
+#include "Data/ChannelRegistry.h"
+#include "Data/Recorder.h"
+#include "Data/ReplayDriver.h"
+#include "Data/ShmIngest.h"
+#include "Data/SocketIngestServer.h"
+#include "Text/TextRenderer.h"
+#include "Widgets/Dashboard.h"
+#include "Widgets/SceneGraph.h"
+#include "Widgets/TrendDownsampler.h"
 
 namespace octronic
 {
@@ -17,17 +30,67 @@ namespace octronic
         void SetLooping(bool looping);
 
         Window& GetWindow();
+        GpuMemoryTracker& GetGpuMemoryTracker();
+        FrameUniforms& GetFrameUniforms();
+        /** @brief Scratch memory for the current frame; see FrameArena. */
+        FrameArena& GetFrameArena();
+        AssetPack& GetAssetPack();
+        AssetReloader& GetAssetReloader();
+        ChannelRegistry& GetChannelRegistry();
+        AlarmEngine& GetAlarmEngine();
+        SceneGraph& GetSceneGraph();
+        TrendDownsampler& GetTrendDownsampler();
+        Recorder& GetRecorder();
+        ReplayDriver& GetReplayDriver();
+        Dashboard& GetDashboard();
+        TextRenderer& GetTextRenderer();
+
+        /**
+         * @brief Heap allocations the render thread made during the last
+         * frame. 0 once caches, pools and the frame arena have warmed up,
+         * and always 0 unless built with COUNT_ALLOCATIONS.
+         */
+        uint64_t GetFrameAllocationCount() const;
+
+        bool HasArgument(const string& name) const;
+        bool GetArgumentValue(const string& name, string& value) const;
 
     protected:
         bool CreateWidgets();
+        bool InitReplay();
+        struct ReplayFrameStats
+        {
+            ReplayFrameStats() : frameSeconds(0.0), worstFrameSeconds(0.0), lastAllocatingFrame(0) {}
+
+            double frameSeconds;
+            double worstFrameSeconds;
+            // 1-based; 0 if no frame allocated
+            uint64_t lastAllocatingFrame;
+        };
+
+        void LogReplaySummary(uint64_t frames, double seconds, const ReplayFrameStats& stats);
 
     private:
         bool mLooping;
         int mArgc;
         char** mArgv;
         Window mWindow;
-        Grid mGridDrawer;
-        ImageWidget mGaugeBackgroundWidget;
-        ImageWidget mGaugeNeedleWidget;
+        GpuMemoryTracker mGpuMemoryTracker;
+        FrameUniforms mFrameUniforms;
+        FrameArena mFrameArena;
+        uint64_t mFrameAllocations;
+        AssetPack mAssetPack;
+        AssetReloader mAssetReloader;
+        ChannelRegistry mChannelRegistry;
+        AlarmEngine mAlarmEngine;
+        ShmIngest mShmIngest;
+        SocketIngestServer mSocketIngest;
+        Recorder mRecorder;
+        ReplayDriver mReplay;
+        TextRenderer mTextRenderer;
+        // Before the dashboard, which destroys widget nodes and charts
+        SceneGraph mSceneGraph;
+        TrendDownsampler mTrendDownsampler;
+        Dashboard mDashboard;
 	};
 }
@@ -0,0 +1,214 @@
+/*
+ * AssetPack.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include "stb_image_aug.h"
+#include "../Common/Logger.h"
+
+namespace octronic
+{
+    // Byte-wise, as std::string::compare orders names in Find
+    static int CompareNames(const char* strings, const AssetPackEntry& a, const AssetPackEntry& b)
+    {
+        int order = memcmp(strings + a.nameOffset, strings + b.nameOffset, std::min(a.nameLength, b.nameLength));
+        if (order != 0) return order;
+        return a.nameLength < b.nameLength ? -1 : (a.nameLength > b.nameLength ? 1 : 0);
+    }
+
+    AssetPack::AssetPack()
+        : mHeader(nullptr),
+          mEntries(nullptr),
+          mStrings(nullptr)
+    {
+        debug("AssetPack: Constructor");
+    }
+
+    AssetPack::~AssetPack()
+    {
+        debug("AssetPack: Destructor");
+        Close();
+    }
+
+    bool AssetPack::Open(const string& path)
+    {
+        debug("AssetPack: {} {}", __FUNCTION__, path);
+        Close();
+
+        if (!mFile.Map(path)) return false;
+
+        const uint8_t* data = mFile.Data();
+        size_t size = mFile.Size();
+
+        auto header = reinterpret_cast<const AssetPackHeader*>(data);
+        if (size < sizeof(AssetPackHeader) ||
+            memcmp(header->magic, ASSET_PACK_MAGIC, 4) != 0 ||
+            header->version != ASSET_PACK_VERSION)
+        {
+            error("AssetPack: {} is not a version {} asset pack", path, ASSET_PACK_VERSION);
+            Close();
+            return false;
+        }
+
+        // Written as differences so no field, however large, can wrap a sum
+        if (header->entryCount > (size - sizeof(AssetPackHeader)) / sizeof(AssetPackEntry) ||
+            header->stringTableOffset < sizeof(AssetPackHeader) + header->entryCount * sizeof(AssetPackEntry) ||
+            header->stringTableOffset > size ||
+            header->stringTableSize > size - header->stringTableOffset)
+        {
+            error("AssetPack: {} has a truncated index", path);
+            Close();
+            return false;
+        }
+
+        auto entries = reinterpret_cast<const AssetPackEntry*>(data + sizeof(AssetPackHeader));
+        for (uint32_t i = 0; i < header->entryCount; i++)
+        {
+            const AssetPackEntry& e = entries[i];
+            if (e.nameOffset > header->stringTableSize ||
+                e.nameLength > header->stringTableSize - e.nameOffset ||
+                e.offset > size ||
+                e.size > size - e.offset)
+            {
+                error("AssetPack: {} entry {} is out of bounds", path, i);
+                Close();
+                return false;
+            }
+
+            if (e.size > ASSET_PACK_MAX_ENTRY_SIZE)
+            {
+                error("AssetPack: {} entry {} is larger than {} bytes", path, i, ASSET_PACK_MAX_ENTRY_SIZE);
+                Close();
+                return false;
+            }
+
+            // Inflate sizes its output from originalSize before decoding
+            if ((e.flags & AssetPackEntry_Compressed) &&
+                (e.originalSize > ASSET_PACK_MAX_INFLATED_SIZE ||
+                 e.originalSize / ASSET_PACK_MAX_INFLATE_RATIO > e.size))
+            {
+                error("AssetPack: {} entry {} claims an impossible inflated size", path, i);
+                Close();
+                return false;
+            }
+
+            // Find binary searches the index
+            const char* strings = reinterpret_cast<const char*>(data + header->stringTableOffset);
+            if (i > 0 && CompareNames(strings, entries[i - 1], e) >= 0)
+            {
+                error("AssetPack: {} index is not sorted at entry {}", path, i);
+                Close();
+                return false;
+            }
+        }
+
+        mHeader = header;
+        mEntries = entries;
+        mStrings = reinterpret_cast<const char*>(data + header->stringTableOffset);
+
+        // Pull the whole pack in with one sequential read rather than
+        // faulting it in asset by asset
+        mFile.Prefetch();
+
+        info("AssetPack: Opened {} with {} entries ({} bytes)", path, header->entryCount, size);
+        return true;
+    }
+
+    void AssetPack::Close()
+    {
+        mHeader = nullptr;
+        mEntries = nullptr;
+        mStrings = nullptr;
+        mFile.Unmap();
+    }
+
+    bool AssetPack::IsOpen() const
+    {
+        return mHeader != nullptr;
+    }
+
+    size_t AssetPack::GetEntryCount() const
+    {
+        return IsOpen() ? mHeader->entryCount : 0;
+    }
+
+    bool AssetPack::Contains(const string& name) const
+    {
+        return Find(name) != nullptr;
+    }
+
+    const AssetPackEntry* AssetPack::Find(const string& name) const
+    {
+        if (!IsOpen()) return nullptr;
+
+        const char* strings = mStrings;
+        auto begin = mEntries;
+        auto end = mEntries + mHeader->entryCount;
+        auto itr = std::lower_bound(begin, end, name,
+            [strings](const AssetPackEntry& e, const string& n)
+            {
+                return n.compare(0, n.size(), strings + e.nameOffset, e.nameLength) > 0;
+            }
+        );
+
+        if (itr != end &&
+            name.compare(0, name.size(), strings + itr->nameOffset, itr->nameLength) == 0)
+        {
+            return itr;
+        }
+        return nullptr;
+    }
+
+    bool AssetPack::Get(const string& name, AssetView& view, vector<uint8_t>& storage) const
+    {
+        const AssetPackEntry* entry = Find(name);
+        if (entry == nullptr)
+        {
+            debug("AssetPack: {} not found", name);
+            return false;
+        }
+
+        if (entry->flags & AssetPackEntry_Compressed)
+        {
+            return Inflate(entry, view, storage);
+        }
+
+        view.data = mFile.Data() + entry->offset;
+        view.size = static_cast<size_t>(entry->size);
+        return true;
+    }
+
+    bool AssetPack::Inflate(const AssetPackEntry* entry, AssetView& view, vector<uint8_t>& storage) const
+    {
+        storage.resize(static_cast<size_t>(entry->originalSize));
+        int length = stbi_zlib_decode_buffer(
+            reinterpret_cast<char*>(storage.data()), static_cast<int>(storage.size()),
+            reinterpret_cast<const char*>(mFile.Data() + entry->offset),
+            static_cast<int>(entry->size));
+
+        if (length != static_cast<int>(entry->originalSize))
+        {
+            error("AssetPack: Failed to inflate {}",
+                  string(mStrings + entry->nameOffset, entry->nameLength));
+            storage.clear();
+            return false;
+        }
+
+        view.data = storage.data();
+        view.size = storage.size();
+        return true;
+    }
+}
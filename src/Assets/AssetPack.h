@@ -0,0 +1,73 @@
+/*
+ * AssetPack.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "../Common/MappedFile.h"
+#include "AssetPackFormat.h"
+
+using std::string;
+using std::vector;
+using Coconut::MappedFile;
+
+namespace octronic
+{
+    /**
+     * @brief Read-only view of an asset's bytes. Valid for as long as the
+     * AssetPack that produced it stays open, and for compressed entries the
+     * storage it was inflated into stays alive.
+     */
+    struct AssetView
+    {
+        const uint8_t* data;
+        size_t size;
+    };
+
+    /**
+     * @brief Single-file resource pack. The pack is mapped once and stored
+     * entries are returned as views straight into the mapping. Compressed
+     * entries are inflated into storage owned by the caller, who releases
+     * it once the asset has been consumed; the pack keeps no copies.
+     */
+    class AssetPack
+    {
+    public:
+        AssetPack();
+        ~AssetPack();
+
+        bool Open(const string& path);
+        void Close();
+        bool IsOpen() const;
+
+        bool Contains(const string& name) const;
+        /**
+         * @param storage Holds the inflated bytes of a compressed entry,
+         * which view then points into. Untouched for stored entries.
+         */
+        bool Get(const string& name, AssetView& view, vector<uint8_t>& storage) const;
+        size_t GetEntryCount() const;
+
+    protected:
+        const AssetPackEntry* Find(const string& name) const;
+        bool Inflate(const AssetPackEntry* entry, AssetView& view, vector<uint8_t>& storage) const;
+
+    private:
+        MappedFile mFile;
+        const AssetPackHeader* mHeader;
+        const AssetPackEntry* mEntries;
+        const char* mStrings;
+    };
+}
@@ -0,0 +1,82 @@
+/*
+ * AssetPackFormat.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * On-disk layout of a resource pack (.pak), shared by the AssetPacker tool
+ * and the runtime reader. Fields are in the byte order of the host that
+ * packed them; a pack from a host of the other byte order fails the
+ * version check.
+ *
+ *     AssetPackHeader
+ *     AssetPackEntry[entryCount]   sorted by name (byte-wise), for bsearch
+ *     string table                 entry names, not null terminated
+ *     payloads, each starting on an ASSET_PACK_ALIGNMENT boundary
+ *
+ * Everything the reader needs to resolve a name sits at the front of the
+ * file, and payloads follow in index order, so mapping the pack and reading
+ * it front to back is a single sequential pass.
+ *
+ * Compressed payloads are zlib streams, inflated by the reader into storage
+ * the caller owns. AssetPacker only compresses with --compress, which the
+ * COMPRESS_RESOURCE_PACK build option passes.
+ */
+
+#define ASSET_PACK_MAGIC     "PDPK"
+#define ASSET_PACK_VERSION   1
+#define ASSET_PACK_ALIGNMENT 64
+#define ASSET_PACK_FILE_NAME "resources.pak"
+
+// Deflate cannot do better than about 1032:1, and the reader inflates
+// through an int-sized buffer, so larger claims mark a corrupt entry
+#define ASSET_PACK_MAX_INFLATE_RATIO 1032
+#define ASSET_PACK_MAX_INFLATED_SIZE 0x7FFFFFFF
+
+// Entry bytes reach stb's inflate and image decoders as int lengths
+#define ASSET_PACK_MAX_ENTRY_SIZE 0x7FFFFFFF
+
+namespace octronic
+{
+    enum AssetPackEntryFlags
+    {
+        AssetPackEntry_Compressed = 1 << 0
+    };
+
+    struct AssetPackHeader
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t flags;
+        uint64_t stringTableOffset;
+        uint64_t stringTableSize;
+    };
+
+    struct AssetPackEntry
+    {
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        uint32_t flags;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t size;
+        uint64_t originalSize;
+    };
+
+    static_assert(sizeof(AssetPackHeader) == 32, "AssetPackHeader must be packed");
+    static_assert(sizeof(AssetPackEntry) == 40, "AssetPackEntry must be packed");
+}
@@ -0,0 +1,169 @@
+/*
+ * AssetReloader.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "AssetReloader.h"
+
+#include <algorithm>
+#include "SOIL.h"
+#include "../Common/File.h"
+#include "../Common/Logger.h"
+#include "../Common/Tracer.h"
+#include "../Widgets/ImageWidget.h"
+
+using std::lock_guard;
+using Coconut::File;
+
+namespace octronic
+{
+    AssetReloader::AssetReloader()
+    {
+        debug("AssetReloader: Constructor");
+    }
+
+    AssetReloader::~AssetReloader()
+    {
+        debug("AssetReloader: Destructor");
+        Stop();
+        for (auto& pending : mDecoded)
+        {
+            SOIL_free_image_data(pending.second.data);
+        }
+    }
+
+    bool AssetReloader::Start()
+    {
+        debug("AssetReloader: {}", __FUNCTION__);
+        if (!mWatcher.Start([this](const vector<string>& paths) { OnFilesChanged(paths); }))
+        {
+            return false;
+        }
+
+        // Pick up widgets registered before the watcher was running
+        lock_guard<mutex> lock(mMutex);
+        for (auto& entry : mWidgets)
+        {
+            mWatcher.AddDirectory(File(entry.first).GetDirectory());
+        }
+        info("AssetReloader: Hot reload enabled");
+        return true;
+    }
+
+    void AssetReloader::Stop()
+    {
+        mWatcher.Stop();
+    }
+
+    bool AssetReloader::IsRunning() const
+    {
+        return mWatcher.IsRunning();
+    }
+
+    void AssetReloader::Watch(ImageWidget* widget)
+    {
+        string path = widget->GetImageFilePath();
+        lock_guard<mutex> lock(mMutex);
+        vector<ImageWidget*>& widgets = mWidgets[path];
+        if (std::find(widgets.begin(), widgets.end(), widget) == widgets.end())
+        {
+            widgets.push_back(widget);
+        }
+        if (mWatcher.IsRunning())
+        {
+            mWatcher.AddDirectory(File(path).GetDirectory());
+        }
+    }
+
+    void AssetReloader::Unwatch(ImageWidget* widget)
+    {
+        lock_guard<mutex> lock(mMutex);
+        for (auto& entry : mWidgets)
+        {
+            vector<ImageWidget*>& widgets = entry.second;
+            widgets.erase(std::remove(widgets.begin(), widgets.end(), widget), widgets.end());
+        }
+    }
+
+    void AssetReloader::OnFilesChanged(const vector<string>& paths)
+    {
+        for (const string& path : paths)
+        {
+            {
+                lock_guard<mutex> lock(mMutex);
+                if (mWidgets.find(path) == mWidgets.end()) continue;
+            }
+
+            TRACE_SCOPE_DETAIL("AssetReloader::Decode", path);
+            DecodedImage image;
+            int channels = 0;
+            image.data = SOIL_load_image(path.c_str(), &image.width, &image.height,
+                &channels, SOIL_LOAD_RGBA);
+
+            if (image.data == nullptr)
+            {
+                warn("AssetReloader: Unable to decode {}, keeping the current texture", path);
+                continue;
+            }
+
+            ImageWidget::PrepareImageData(image.data, image.width, image.height);
+            debug("AssetReloader: Decoded {} {}x{}", path, image.width, image.height);
+
+            // A newer decode of the same file supersedes one not yet applied
+            lock_guard<mutex> lock(mMutex);
+            mReloaded.insert(path);
+            auto existing = mDecoded.find(path);
+            if (existing != mDecoded.end())
+            {
+                SOIL_free_image_data(existing->second.data);
+                existing->second = image;
+            }
+            else
+            {
+                mDecoded[path] = image;
+            }
+        }
+    }
+
+    bool AssetReloader::IsReloaded(const string& path)
+    {
+        lock_guard<mutex> lock(mMutex);
+        return mReloaded.count(path) > 0;
+    }
+
+    void AssetReloader::ApplyPending()
+    {
+        TRACE_SCOPE("AssetReloader::ApplyPending");
+        map<string, DecodedImage> decoded;
+        map<string, vector<ImageWidget*>> widgets;
+        {
+            lock_guard<mutex> lock(mMutex);
+            if (mDecoded.empty()) return;
+            decoded.swap(mDecoded);
+            for (auto& entry : decoded)
+            {
+                widgets[entry.first] = mWidgets[entry.first];
+            }
+        }
+
+        for (auto& entry : decoded)
+        {
+            const DecodedImage& image = entry.second;
+            for (ImageWidget* widget : widgets[entry.first])
+            {
+                widget->ReplaceImage(image.data, image.width, image.height);
+            }
+            info("AssetReloader: Reloaded {} for {} widget(s)", entry.first, widgets[entry.first].size());
+            SOIL_free_image_data(image.data);
+        }
+    }
+}
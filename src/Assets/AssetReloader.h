@@ -0,0 +1,79 @@
+/*
+ * AssetReloader.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "FileWatcher.h"
+
+using std::map;
+using std::mutex;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace octronic
+{
+    class ImageWidget;
+
+    /**
+     * @brief Hot reloads images that change on disk. Changed files are
+     * decoded on the FileWatcher thread; ApplyPending, called on the render
+     * thread, re-uploads them into the existing textures of every
+     * ImageWidget using that file.
+     */
+    class AssetReloader
+    {
+    public:
+        AssetReloader();
+        ~AssetReloader();
+
+        bool Start();
+        void Stop();
+        bool IsRunning() const;
+
+        void Watch(ImageWidget* widget);
+        void Unwatch(ImageWidget* widget);
+
+        void ApplyPending();
+
+        /**
+         * @brief True once path has been reloaded from disk. Its loose file
+         * is then newer than any copy in the AssetPack or baked container,
+         * so widgets re-reading it must decode the file itself.
+         */
+        bool IsReloaded(const string& path);
+
+    protected:
+        void OnFilesChanged(const vector<string>& paths);
+
+    private:
+        struct DecodedImage
+        {
+            uint8_t* data;
+            int width;
+            int height;
+        };
+
+        FileWatcher mWatcher;
+        mutex mMutex;
+        map<string, vector<ImageWidget*>> mWidgets;
+        map<string, DecodedImage> mDecoded;
+        set<string> mReloaded;
+    };
+}
@@ -0,0 +1,172 @@
+/*
+ * FileWatcher.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "FileWatcher.h"
+
+#ifdef __linux__
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+#include "../Common/Logger.h"
+#include "../Common/Tracer.h"
+#include "../Common/Time.h"
+
+using std::lock_guard;
+
+namespace octronic
+{
+    FileWatcher::FileWatcher()
+        : mInotifyFd(-1),
+          mRunning(false),
+          mDebounceMs(0)
+    {
+        debug("FileWatcher: Constructor");
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+        debug("FileWatcher: Destructor");
+        Stop();
+    }
+
+    bool FileWatcher::Start(ChangeCallback callback, long debounceMs)
+    {
+        debug("FileWatcher: {}", __FUNCTION__);
+        if (mRunning) return true;
+#ifdef __linux__
+        mInotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (mInotifyFd < 0)
+        {
+            error("FileWatcher: inotify_init1 failed");
+            return false;
+        }
+        mCallback = callback;
+        mDebounceMs = debounceMs;
+        mRunning = true;
+        mThread = thread(&FileWatcher::Run, this);
+        return true;
+#else
+        warn("FileWatcher: Not supported on this platform");
+        return false;
+#endif
+    }
+
+    void FileWatcher::Stop()
+    {
+        if (!mRunning) return;
+        debug("FileWatcher: {}", __FUNCTION__);
+        mRunning = false;
+        if (mThread.joinable()) mThread.join();
+#ifdef __linux__
+        close(mInotifyFd);
+#endif
+        mInotifyFd = -1;
+        lock_guard<mutex> lock(mWatchesMutex);
+        mWatches.clear();
+        mPending.clear();
+    }
+
+    bool FileWatcher::IsRunning() const
+    {
+        return mRunning;
+    }
+
+    bool FileWatcher::AddDirectory(const string& directory)
+    {
+#ifdef __linux__
+        if (mInotifyFd < 0) return false;
+
+        string watchPath = directory.empty() ? "." : directory;
+        int wd = inotify_add_watch(mInotifyFd, watchPath.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0)
+        {
+            error("FileWatcher: Unable to watch {}", watchPath);
+            return false;
+        }
+
+        lock_guard<mutex> lock(mWatchesMutex);
+        mWatches[wd] = directory.empty() ? "" : directory + "/";
+        debug("FileWatcher: Watching {}", watchPath);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void FileWatcher::Run()
+    {
+#ifdef __linux__
+        Tracer::SetThreadName("FileWatcher");
+        debug("FileWatcher: Thread started");
+        alignas(inotify_event) char buffer[4096];
+        const int pollIntervalMs = 50;
+
+        while (mRunning)
+        {
+            pollfd pfd;
+            pfd.fd = mInotifyFd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            poll(&pfd, 1, pollIntervalMs);
+
+            long now = Time::GetCurrentTime();
+
+            if (pfd.revents & POLLIN)
+            {
+                ssize_t length;
+                while ((length = read(mInotifyFd, buffer, sizeof(buffer))) > 0)
+                {
+                    lock_guard<mutex> lock(mWatchesMutex);
+                    for (char* ptr = buffer; ptr < buffer + length;)
+                    {
+                        auto event = reinterpret_cast<inotify_event*>(ptr);
+                        auto dir = mWatches.find(event->wd);
+                        if (event->len > 0 && dir != mWatches.end())
+                        {
+                            mPending[dir->second + event->name] = now;
+                        }
+                        ptr += sizeof(inotify_event) + event->len;
+                    }
+                }
+            }
+
+            vector<string> settled;
+            {
+                lock_guard<mutex> lock(mWatchesMutex);
+                for (auto itr = mPending.begin(); itr != mPending.end();)
+                {
+                    if (now - itr->second >= mDebounceMs)
+                    {
+                        settled.push_back(itr->first);
+                        itr = mPending.erase(itr);
+                    }
+                    else
+                    {
+                        itr++;
+                    }
+                }
+            }
+
+            if (!settled.empty())
+            {
+                debug("FileWatcher: {} file(s) changed", settled.size());
+                mCallback(settled);
+            }
+        }
+        debug("FileWatcher: Thread stopped");
+#endif
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * FileWatcher.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::atomic;
+using std::function;
+using std::map;
+using std::mutex;
+using std::string;
+using std::thread;
+using std::vector;
+
+namespace octronic
+{
+    /**
+     * @brief Watches directories for files that have been rewritten and
+     * reports them from its own thread. Bursts of events for the same file
+     * (editors often write, truncate and rename) are coalesced, and a file
+     * is only reported once it has been quiet for the debounce interval.
+     *
+     * Backed by inotify on Linux. Start fails on other platforms.
+     */
+    class FileWatcher
+    {
+    public:
+        typedef function<void(const vector<string>&)> ChangeCallback;
+
+        FileWatcher();
+        ~FileWatcher();
+
+        bool Start(ChangeCallback callback, long debounceMs = 150);
+        void Stop();
+        bool IsRunning() const;
+
+        /**
+         * @brief Watches a directory (non-recursively). Changed paths are
+         * reported as directory + "/" + file name, or the bare file name
+         * for an empty directory.
+         */
+        bool AddDirectory(const string& directory);
+
+    protected:
+        void Run();
+
+    private:
+        int mInotifyFd;
+        atomic<bool> mRunning;
+        thread mThread;
+        ChangeCallback mCallback;
+        long mDebounceMs;
+        mutex mWatchesMutex;
+        map<int, string> mWatches;
+        map<string, long> mPending;
+    };
+}
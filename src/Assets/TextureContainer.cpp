@@ -0,0 +1,292 @@
+/*
+ * TextureContainer.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "TextureContainer.h"
+
+#include <atomic>
+#include <cstring>
+#include "../Common/Logger.h"
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace octronic
+{
+    // Set by QueryGLSupport on the render thread, read from loader threads
+    static std::atomic<bool> S3TCSupported(false);
+
+    TextureContainer::TextureContainer()
+        : mData(nullptr),
+          mSize(0),
+          mHeader(nullptr),
+          mLevels(nullptr)
+    {
+    }
+
+    bool TextureContainer::Open(const string& path)
+    {
+        Close();
+        if (!mFile.Map(path)) return false;
+        if (!Parse(mFile.Data(), mFile.Size()))
+        {
+            error("TextureContainer: {} is not a valid texture container", path);
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    bool TextureContainer::Parse(const uint8_t* data, size_t size)
+    {
+        mHeader = nullptr;
+        mLevels = nullptr;
+
+        if (data == nullptr || size < sizeof(TextureContainerHeader)) return false;
+
+        auto header = reinterpret_cast<const TextureContainerHeader*>(data);
+        if (memcmp(header->magic, TEXTURE_CONTAINER_MAGIC, 4) != 0)
+        {
+            error("TextureContainer: Bad magic");
+            return false;
+        }
+
+        if (header->version != TEXTURE_CONTAINER_VERSION)
+        {
+            error("TextureContainer: Unsupported version {}", header->version);
+            return false;
+        }
+
+        if (header->format > TexturePixelFormat_DXT5 || header->levelCount == 0)
+        {
+            error("TextureContainer: Bad format {} or level count {}",
+                  header->format, header->levelCount);
+            return false;
+        }
+
+        if (header->levelCount > (size - sizeof(TextureContainerHeader)) / sizeof(TextureContainerLevel))
+        {
+            return false;
+        }
+        size_t tableEnd = sizeof(TextureContainerHeader) +
+            header->levelCount * sizeof(TextureContainerLevel);
+
+        auto levels = reinterpret_cast<const TextureContainerLevel*>(data + sizeof(TextureContainerHeader));
+        for (uint32_t i = 0; i < header->levelCount; i++)
+        {
+            // Written as a difference so a huge offset cannot wrap around
+            if (levels[i].offset < tableEnd || levels[i].offset > size ||
+                levels[i].size > size - levels[i].offset)
+            {
+                error("TextureContainer: Level {} out of bounds", i);
+                return false;
+            }
+
+            // Each level must follow from the one before, as GL's mip chain does
+            uint32_t width = i == 0 ? header->width : (levels[i - 1].width > 1 ? levels[i - 1].width / 2 : 1);
+            uint32_t height = i == 0 ? header->height : (levels[i - 1].height > 1 ? levels[i - 1].height / 2 : 1);
+            if ((i > 0 && levels[i - 1].width == 1 && levels[i - 1].height == 1) ||
+                levels[i].width != width || levels[i].height != height ||
+                width > TEXTURE_CONTAINER_MAX_LEVEL_SIZE || height > TEXTURE_CONTAINER_MAX_LEVEL_SIZE)
+            {
+                error("TextureContainer: Level {} is {}x{}, not {}x{}",
+                      i, levels[i].width, levels[i].height, width, height);
+                return false;
+            }
+
+            // GL reads the payload size implied by the dimensions, not ours
+            if (levels[i].width == 0 || levels[i].height == 0 ||
+                levels[i].size > TEXTURE_CONTAINER_MAX_LEVEL_SIZE ||
+                levels[i].size != LevelSize(header->format, levels[i].width, levels[i].height))
+            {
+                error("TextureContainer: Level {} is {} bytes, not {}x{} in format {}",
+                      i, levels[i].size, levels[i].width, levels[i].height, header->format);
+                return false;
+            }
+        }
+
+        mData = data;
+        mSize = size;
+        mHeader = header;
+        mLevels = levels;
+        return true;
+    }
+
+    void TextureContainer::Close()
+    {
+        mFile.Unmap();
+        mData = nullptr;
+        mSize = 0;
+        mHeader = nullptr;
+        mLevels = nullptr;
+    }
+
+    bool TextureContainer::IsLoaded() const
+    {
+        return mHeader != nullptr;
+    }
+
+    bool TextureContainer::IsCompressed() const
+    {
+        return IsLoaded() && mHeader->format != TexturePixelFormat_RGBA8;
+    }
+
+    bool TextureContainer::IsPremultiplied() const
+    {
+        return IsLoaded() && (mHeader->flags & TextureContainer_PremultipliedAlpha);
+    }
+
+    bool TextureContainer::IsSupportedByGL() const
+    {
+        if (!IsLoaded()) return false;
+        return !IsCompressed() || HasS3TCSupport();
+    }
+
+    uint32_t TextureContainer::GetFormat() const
+    {
+        return mHeader->format;
+    }
+
+    uint32_t TextureContainer::GetWidth() const
+    {
+        return mHeader->width;
+    }
+
+    uint32_t TextureContainer::GetHeight() const
+    {
+        return mHeader->height;
+    }
+
+    uint32_t TextureContainer::GetLevelCount() const
+    {
+        return mHeader->levelCount;
+    }
+
+    const TextureContainerLevel& TextureContainer::GetLevel(uint32_t level) const
+    {
+        return mLevels[level];
+    }
+
+    const uint8_t* TextureContainer::GetLevelData(uint32_t level) const
+    {
+        return mData + mLevels[level].offset;
+    }
+
+    GLuint TextureContainer::Upload(uint32_t baseLevel) const
+    {
+        if (!IsSupportedByGL() || baseLevel >= mHeader->levelCount) return 0;
+
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+
+        GLenum internalFormat = GL_RGBA;
+        switch (mHeader->format)
+        {
+            case TexturePixelFormat_DXT1:
+                internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+                break;
+            case TexturePixelFormat_DXT5:
+                internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+                break;
+        }
+
+        GLint level = 0;
+        for (uint32_t i = baseLevel; i < mHeader->levelCount; i++, level++)
+        {
+            const TextureContainerLevel& l = mLevels[i];
+            if (IsCompressed())
+            {
+                glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat,
+                    l.width, l.height, 0, static_cast<GLsizei>(l.size), mData + l.offset);
+            }
+            else
+            {
+                glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, l.width, l.height, 0,
+                    GL_RGBA, GL_UNSIGNED_BYTE, mData + l.offset);
+            }
+        }
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+            level > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        if (GLCheckError())
+        {
+            glDeleteTextures(1, &texture);
+            return 0;
+        }
+        return texture;
+    }
+
+    uint64_t TextureContainer::LevelSize(uint32_t format, uint32_t width, uint32_t height)
+    {
+        // DXT encodes 4x4 blocks, partial blocks included
+        uint64_t blocks = ((static_cast<uint64_t>(width) + 3) / 4) * ((static_cast<uint64_t>(height) + 3) / 4);
+        switch (format)
+        {
+            case TexturePixelFormat_RGBA8:
+                return static_cast<uint64_t>(width) * height * 4;
+            case TexturePixelFormat_DXT1:
+                return blocks * 8;
+            case TexturePixelFormat_DXT5:
+                return blocks * 16;
+        }
+        return 0;
+    }
+
+    string TextureContainer::BakedPathFor(const string& imagePath)
+    {
+        auto extStart = imagePath.find_last_of('.');
+        auto endOfPath = imagePath.find_last_of("/\\");
+        if (extStart == string::npos ||
+            (endOfPath != string::npos && extStart < endOfPath))
+        {
+            return imagePath + TEXTURE_CONTAINER_EXTENSION;
+        }
+        return imagePath.substr(0, extStart) + TEXTURE_CONTAINER_EXTENSION;
+    }
+
+    void TextureContainer::QueryGLSupport()
+    {
+        bool supported = false;
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            auto ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (ext != nullptr && strcmp(ext, "GL_EXT_texture_compression_s3tc") == 0)
+            {
+                supported = true;
+                break;
+            }
+        }
+        S3TCSupported.store(supported, std::memory_order_release);
+        debug("TextureContainer: S3TC support {}", supported);
+    }
+
+    bool TextureContainer::HasS3TCSupport()
+    {
+        return S3TCSupported.load(std::memory_order_acquire);
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * TextureContainer.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <string>
+#include "../Common/GLHeader.h"
+#include "../Common/MappedFile.h"
+#include "TextureContainerFormat.h"
+
+using std::string;
+using Coconut::MappedFile;
+
+namespace octronic
+{
+    /**
+     * @brief Runtime view of a baked texture container. The container is
+     * either memory mapped from disk with Open or parsed in place from a
+     * caller-owned buffer with Parse. Level payloads are never copied.
+     */
+    class TextureContainer
+    {
+    public:
+        TextureContainer();
+
+        bool Open(const string& path);
+        bool Parse(const uint8_t* data, size_t size);
+        void Close();
+
+        bool IsLoaded() const;
+        bool IsCompressed() const;
+        bool IsPremultiplied() const;
+        bool IsSupportedByGL() const;
+
+        uint32_t GetFormat() const;
+        uint32_t GetWidth() const;
+        uint32_t GetHeight() const;
+        uint32_t GetLevelCount() const;
+        const TextureContainerLevel& GetLevel(uint32_t level) const;
+        const uint8_t* GetLevelData(uint32_t level) const;
+
+        /**
+         * @brief Creates a GL texture from levels [baseLevel, levelCount).
+         * @return The texture name, or 0 on failure.
+         */
+        GLuint Upload(uint32_t baseLevel = 0) const;
+
+        /** @brief Payload bytes of one width x height level in format. */
+        static uint64_t LevelSize(uint32_t format, uint32_t width, uint32_t height);
+        static string BakedPathFor(const string& imagePath);
+        /**
+         * @brief Reads the current context's extensions. Render thread,
+         * once the context is current; until then HasS3TCSupport is false.
+         */
+        static void QueryGLSupport();
+        /** @brief As last queried. Makes no GL calls, so safe on any thread. */
+        static bool HasS3TCSupport();
+
+    private:
+        MappedFile mFile;
+        const uint8_t* mData;
+        size_t mSize;
+        const TextureContainerHeader* mHeader;
+        const TextureContainerLevel* mLevels;
+    };
+}
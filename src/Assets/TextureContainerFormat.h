@@ -0,0 +1,78 @@
+/*
+ * TextureContainerFormat.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * On-disk layout of a baked texture (.pdtx), shared by the TextureBaker tool
+ * and the runtime loader. Fields are in the byte order of the host that
+ * baked them; a container from a host of the other byte order fails the
+ * version check.
+ *
+ *     TextureContainerHeader
+ *     TextureContainerLevel[levelCount]   (level 0 is the full resolution)
+ *     payloads, each starting on a TEXTURE_CONTAINER_ALIGNMENT boundary
+ *
+ * Payload offsets are relative to the start of the file so a mapped
+ * container can be handed to glTexImage2D without copying. Level 0 is
+ * width x height, and each further level halves the one before it (never
+ * below 1), stopping at 1x1 at the latest, as GL expects of a mip chain.
+ */
+
+#define TEXTURE_CONTAINER_MAGIC     "PDTX"
+#define TEXTURE_CONTAINER_VERSION   1
+#define TEXTURE_CONTAINER_ALIGNMENT 16
+#define TEXTURE_CONTAINER_EXTENSION ".pdtx"
+// Level sizes and dimensions reach GL as GLsizei
+#define TEXTURE_CONTAINER_MAX_LEVEL_SIZE 0x7FFFFFFF
+
+namespace octronic
+{
+    enum TextureContainerPixelFormat
+    {
+        TexturePixelFormat_RGBA8 = 0,
+        TexturePixelFormat_DXT1  = 1,
+        TexturePixelFormat_DXT5  = 2
+    };
+
+    enum TextureContainerFlags
+    {
+        TextureContainer_PremultipliedAlpha = 1 << 0
+    };
+
+    struct TextureContainerHeader
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levelCount;
+        uint32_t flags;
+        uint32_t reserved;
+    };
+
+    struct TextureContainerLevel
+    {
+        uint32_t width;
+        uint32_t height;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    static_assert(sizeof(TextureContainerHeader) == 32, "TextureContainerHeader must be packed");
+    static_assert(sizeof(TextureContainerLevel) == 24, "TextureContainerLevel must be packed");
+}
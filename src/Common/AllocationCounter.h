@@ -0,0 +1,36 @@
+/*
+ * AllocationCounter.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace octronic
+{
+    /**
+     * @brief Counts heap allocations per thread. Built with the CMake
+     * option COUNT_ALLOCATIONS, AllocationCounter.cpp replaces the global
+     * operator new, so everything allocated with new, including by the
+     * standard containers, is counted; malloc is not. The cost is one
+     * thread-local increment per allocation. Without the option the
+     * global operators are left alone and every count is 0.
+     */
+    class AllocationCounter
+    {
+    public:
+        static bool IsEnabled();
+        /** @brief Allocations made by the calling thread so far. */
+        static uint64_t GetThreadCount();
+    };
+}
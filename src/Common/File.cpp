@@ -17,9 +17,8 @@
 
 #include "File.h"
 
-#include <fstream>
-#include <sstream>
 #include <cstdio>
+#include <sys/stat.h>
 
 #include "Logger.h"
 
@@ -27,13 +26,40 @@
 #undef DeleteFile
 #endif
 
-using std::istreambuf_iterator;
-using std::ios;
-using std::stringstream;
-using std::ifstream;
+#ifdef _WIN32
+    #define fstat _fstat
+    #define fileno _fileno
+    #define stat _stat
+#endif
 
 namespace Coconut
 {
+    /**
+    * @brief Reads a whole file into a container with a single allocation
+    * sized by fstat and a single read, rather than growing it piecemeal.
+    */
+    template<typename Container>
+    static bool ReadWholeFile(const string& path, Container& data)
+    {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == nullptr) return false;
+
+        struct stat st;
+        if (fstat(fileno(file), &st) != 0)
+        {
+            fclose(file);
+            return false;
+        }
+
+        data.resize(static_cast<size_t>(st.st_size));
+        size_t bytesRead = data.empty() ? 0 : fread(&data[0], sizeof(char), data.size(), file);
+        fclose(file);
+
+        // File may have shrunk between fstat and read
+        data.resize(bytesRead);
+        return true;
+    }
+
     File::File(string path)
     {
         mPath = path;
@@ -66,63 +92,48 @@ namespace Coconut
 
     string File::ReadString() const
     {
-        ifstream inputStream;
-        stringstream stringStream;
-
-        inputStream.open(mPath.c_str(), ifstream::in);
-        if (inputStream.is_open())
-        {
-            string line;
-            while ( getline (inputStream,line) )
-            {
-                stringStream << line << '\n';
-            }
-            auto data = stringStream.str();
-            inputStream.close();
-            return data;
-        }
-        else
-        {
-            return "";
-        }
+        string data;
+        ReadWholeFile(mPath, data);
+        return data;
     }
 
     vector<string> File::ReadAsLines() const
     {
         vector<string> lines;
-        ifstream inputStream;
+        string data = ReadString();
 
-        inputStream.open(mPath.c_str(), ifstream::in);
-        if (inputStream.is_open())
-        {
-            string line;
-            while ( getline (inputStream,line) )
-            {
-                lines.push_back(line);
-            }
-            inputStream.close();
-            return lines;
-        }
-        else
+        size_t lineStart = 0;
+        while (lineStart < data.size())
         {
-            return lines;
+            size_t lineEnd = data.find('\n', lineStart);
+            if (lineEnd == string::npos) lineEnd = data.size();
+            size_t length = lineEnd - lineStart;
+            if (length > 0 && data[lineEnd - 1] == '\r') length--;
+            lines.push_back(data.substr(lineStart, length));
+            lineStart = lineEnd + 1;
         }
+        return lines;
     }
 
     vector<char> File::ReadBinary() const
     {
         vector<char> data;
-        ifstream inputStream;
-        inputStream.open(mPath.c_str(), ios::binary );
-        data = vector<char>
-        (
-            (istreambuf_iterator<char>(inputStream)),
-            (istreambuf_iterator<char>())
-        );
-        inputStream.close();
+        ReadWholeFile(mPath, data);
         return data;
     }
 
+    MappedFile File::Map() const
+    {
+        return MappedFile(mPath);
+    }
+
+    int File::GetFileSize() const
+    {
+        struct stat st;
+        if (stat(mPath.c_str(), &st) != 0) return -1;
+        return static_cast<int>(st.st_size);
+    }
+
     bool File::Create() const
     {
         string data = ".";
@@ -20,6 +20,7 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include "MappedFile.h"
 
 using std::string;
 using std::vector;
@@ -41,6 +42,14 @@ namespace Coconut
         string ReadString() const;
     	vector<string> ReadAsLines() const;
         vector<char> ReadBinary() const;
+
+        /**
+        * @brief Maps the file read-only without copying it. The returned
+        * mapping is released when it goes out of scope; check IsMapped()
+        * before use.
+        */
+        MappedFile Map() const;
+
         int GetFileSize() const;
         bool WriteBinary(const vector<char>&) const;
         bool WriteString(const string&) const;
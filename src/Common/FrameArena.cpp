@@ -0,0 +1,112 @@
+/*
+ * FrameArena.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "FrameArena.h"
+
+#include <algorithm>
+#include "Logger.h"
+
+namespace octronic
+{
+    // Offset of the first alignment-aligned address at or after block + used.
+    // Aligning the address, not the offset, also covers alignments beyond
+    // the max_align_t alignment operator new gives the block.
+    static inline size_t AlignUp(const uint8_t* block, size_t used, size_t alignment)
+    {
+        uintptr_t address = reinterpret_cast<uintptr_t>(block) + used;
+        return used + ((alignment - (address & (alignment - 1))) & (alignment - 1));
+    }
+
+    FrameArena::FrameArena(size_t capacity)
+        : mBlock(nullptr),
+          mCapacity(std::max<size_t>(capacity, 64)),
+          mUsed(0),
+          mAllocations(0),
+          mOverflowCapacity(0),
+          mOverflowUsed(0),
+          mOverflowBytes(0)
+    {
+        mBlock = static_cast<uint8_t*>(::operator new(mCapacity));
+        mOverflow.reserve(FRAME_ARENA_RESERVED_OVERFLOW_BLOCKS);
+    }
+
+    FrameArena::~FrameArena()
+    {
+        Reset();
+        ::operator delete(mBlock);
+    }
+
+    void* FrameArena::Allocate(size_t bytes, size_t alignment)
+    {
+        mAllocations++;
+        size_t offset = AlignUp(mBlock, mUsed, alignment);
+        if (offset + bytes <= mCapacity)
+        {
+            mUsed = offset + bytes;
+            return mBlock + offset;
+        }
+
+        offset = mOverflow.empty() ? 0 : AlignUp(mOverflow.back(), mOverflowUsed, alignment);
+        if (mOverflow.empty() || offset + bytes > mOverflowCapacity)
+        {
+            // Each spill at least doubles, so a frame takes few blocks.
+            // The extra alignment bytes cover the padding at its start.
+            mOverflowCapacity = std::max(bytes + alignment, std::max(mCapacity, mOverflowCapacity * 2));
+            mOverflow.push_back(static_cast<uint8_t*>(::operator new(mOverflowCapacity)));
+            mOverflowBytes += mOverflowCapacity;
+            offset = AlignUp(mOverflow.back(), 0, alignment);
+        }
+        mOverflowUsed = offset + bytes;
+        return mOverflow.back() + offset;
+    }
+
+    void FrameArena::Reset()
+    {
+        if (!mOverflow.empty())
+        {
+            for (uint8_t* block : mOverflow) ::operator delete(block);
+            mOverflow.clear();
+            // Big enough for the frame that just spilled
+            ::operator delete(mBlock);
+            mCapacity += mOverflowBytes;
+            mBlock = static_cast<uint8_t*>(::operator new(mCapacity));
+            debug("FrameArena: Grew to {} KiB", mCapacity / 1024);
+        }
+        mUsed = 0;
+        mAllocations = 0;
+        mOverflowCapacity = 0;
+        mOverflowUsed = 0;
+        mOverflowBytes = 0;
+    }
+
+    size_t FrameArena::GetAllocationCount() const
+    {
+        return mAllocations;
+    }
+
+    size_t FrameArena::GetBytesUsed() const
+    {
+        return mUsed + mOverflowBytes;
+    }
+
+    size_t FrameArena::GetOverflowCount() const
+    {
+        return mOverflow.size();
+    }
+
+    size_t FrameArena::GetCapacity() const
+    {
+        return mCapacity;
+    }
+}
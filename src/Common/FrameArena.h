@@ -0,0 +1,79 @@
+/*
+ * FrameArena.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+#define FRAME_ARENA_DEFAULT_CAPACITY (256 * 1024)
+// Spill blocks a frame can take before the list of them reallocates
+#define FRAME_ARENA_RESERVED_OVERFLOW_BLOCKS 32
+
+namespace octronic
+{
+    /**
+     * @brief Linear allocator for data that lives no longer than the
+     * frame: staging arrays, gathered widget lists and the like. Allocate
+     * bumps a pointer; AppState resets the arena at the start of every
+     * frame, which frees everything at once. Nothing is destructed, so it
+     * only suits trivially destructible types.
+     *
+     * A frame that outgrows the block spills into heap blocks, which Reset
+     * frees and folds into a single larger block, so a steady workload
+     * stops touching the heap after its first frames. Render thread only.
+     */
+    class FrameArena
+    {
+    public:
+        FrameArena(size_t capacity = FRAME_ARENA_DEFAULT_CAPACITY);
+        ~FrameArena();
+
+        /** @brief alignment must be a power of two; it may exceed max_align_t's. */
+        void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+        template <typename T>
+        T* AllocateArray(size_t count)
+        {
+            return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void Reset();
+
+        /** @brief Allocate calls since the last Reset. */
+        size_t GetAllocationCount() const;
+        /** @brief Bytes taken since the last Reset, padding and spilled blocks included. */
+        size_t GetBytesUsed() const;
+        /** @brief Heap blocks taken since the last Reset; 0 when warmed up. */
+        size_t GetOverflowCount() const;
+        size_t GetCapacity() const;
+
+    private:
+        FrameArena(const FrameArena&);
+        FrameArena& operator=(const FrameArena&);
+
+        uint8_t* mBlock;
+        size_t mCapacity;
+        size_t mUsed;
+        size_t mAllocations;
+        vector<uint8_t*> mOverflow;
+        // Bytes in the current overflow block, and used of them
+        size_t mOverflowCapacity;
+        size_t mOverflowUsed;
+        size_t mOverflowBytes;
+    };
+}
@@ -0,0 +1,99 @@
+/*
+ * FrameUniforms.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "FrameUniforms.h"
+
+#include "Logger.h"
+
+namespace octronic
+{
+    // std140 layout of FrameData, padded to a vec4
+    struct FrameData
+    {
+        float frameTime;
+        float frameDelta;
+        float padding[2];
+    };
+
+    FrameUniforms::FrameUniforms()
+        : mBuffer(0),
+          mStart(std::chrono::steady_clock::now()),
+          mTime(0.0),
+          mEpoch(0.0),
+          mDelta(0.0f)
+    {
+        debug("FrameUniforms: Constructor");
+    }
+
+    FrameUniforms::~FrameUniforms()
+    {
+        debug("FrameUniforms: Destructor");
+        if (mBuffer > 0) glDeleteBuffers(1, &mBuffer);
+    }
+
+    bool FrameUniforms::Init()
+    {
+        debug("FrameUniforms: {}", __FUNCTION__);
+        glGenBuffers(1, &mBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, mBuffer);
+        mStart = std::chrono::steady_clock::now();
+        Update();
+        return !GLCheckError();
+    }
+
+    void FrameUniforms::Update()
+    {
+        double now = std::chrono::duration<double>(std::chrono::steady_clock::now() - mStart).count();
+        mDelta = static_cast<float>(now - mTime);
+        mTime = now;
+        // Whole intervals keep periodic effects such as the alarm blink in phase
+        while (mTime - mEpoch >= FRAME_UNIFORMS_REBASE_SECONDS) mEpoch += FRAME_UNIFORMS_REBASE_SECONDS;
+
+        FrameData data = { ToShaderTime(mTime), mDelta, { 0.0f, 0.0f } };
+        glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(data), &data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    bool FrameUniforms::BindProgram(GLuint program) const
+    {
+        GLuint index = glGetUniformBlockIndex(program, "FrameData");
+        if (index == GL_INVALID_INDEX) return false;
+        glUniformBlockBinding(program, index, FRAME_UNIFORMS_BINDING);
+        return true;
+    }
+
+    double FrameUniforms::GetTime() const
+    {
+        return mTime;
+    }
+
+    float FrameUniforms::GetDelta() const
+    {
+        return mDelta;
+    }
+
+    double FrameUniforms::GetEpoch() const
+    {
+        return mEpoch;
+    }
+
+    float FrameUniforms::ToShaderTime(double time) const
+    {
+        return static_cast<float>(time - mEpoch);
+    }
+}
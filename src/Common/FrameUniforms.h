@@ -0,0 +1,73 @@
+/*
+ * FrameUniforms.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <chrono>
+#include "GLHeader.h"
+
+#define FRAME_UNIFORMS_BINDING 0
+// Interval at which the shader clock restarts from zero. A float frame
+// time this large still resolves a quarter of a millisecond.
+#define FRAME_UNIFORMS_REBASE_SECONDS 3600.0
+
+/**
+ * GLSL declaration of the block, for shaders that animate on the GPU.
+ */
+#define FRAME_UNIFORMS_GLSL \
+    "layout (std140) uniform FrameData { float frameTime; float frameDelta; };\n"
+
+namespace octronic
+{
+    /**
+     * @brief Per-frame values shared by every shader through one uniform
+     * buffer at FRAME_UNIFORMS_BINDING. Updated once per frame, so widgets
+     * that animate from keyframes in their vertex shader cost nothing on
+     * the CPU between keyframes.
+     *
+     * Times on the CPU are double seconds since Init. Shaders get float
+     * seconds since the epoch, which moves forward every
+     * FRAME_UNIFORMS_REBASE_SECONDS so the float keeps its precision on
+     * long runs. Times handed to shaders are converted with ToShaderTime
+     * and rewritten whenever GetEpoch changes.
+     */
+    class FrameUniforms
+    {
+    public:
+        FrameUniforms();
+        ~FrameUniforms();
+
+        bool Init();
+        void Update();
+
+        /**
+         * @brief Connects the program's FrameData block, if it has one, to
+         * the shared buffer.
+         */
+        bool BindProgram(GLuint program) const;
+
+        double GetTime() const;
+        float GetDelta() const;
+        double GetEpoch() const;
+        /** @brief A CPU time as the shaders' frameTime would read it. */
+        float ToShaderTime(double time) const;
+
+    private:
+        GLuint mBuffer;
+        std::chrono::steady_clock::time_point mStart;
+        double mTime;
+        double mEpoch;
+        float mDelta;
+    };
+}
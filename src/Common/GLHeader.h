@@ -40,7 +40,7 @@
 
 using std::string;
 
-static bool _GLCheckError_(const string& file, int line)
+static bool _GLCheckError_(const char* file, int line)
 {
 	GLenum errorCode = 0;
 	bool wasError = false;
@@ -0,0 +1,201 @@
+/*
+ * GpuMemoryTracker.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "GpuMemoryTracker.h"
+
+#include <algorithm>
+#include "Logger.h"
+#include "../Widgets/Widget.h"
+
+namespace octronic
+{
+    GpuMemoryTracker::GpuMemoryTracker()
+        : mTotalBytes(0),
+          mBudget(0),
+          mFrame(0),
+          mWarnedOverBudget(false)
+    {
+        for (int i = 0; i < GpuResource_Count; i++)
+        {
+            mCategoryBytes[i] = 0;
+            mCategoryCount[i] = 0;
+        }
+    }
+
+    uint64_t GpuMemoryTracker::KeyFor(GpuResourceCategory category, GLuint name)
+    {
+        return (static_cast<uint64_t>(category) << 32) | name;
+    }
+
+    void GpuMemoryTracker::Track(Widget* owner, GpuResourceCategory category, GLuint name, size_t bytes)
+    {
+        if (name == 0) return;
+
+        Allocation& allocation = mAllocations[KeyFor(category, name)];
+        if (allocation.owner == nullptr)
+        {
+            allocation.owner = owner;
+            allocation.category = category;
+            allocation.bytes = 0;
+            mCategoryCount[category]++;
+            if (mWidgets.find(owner) == mWidgets.end())
+            {
+                WidgetUsage usage = {};
+                usage.lastDrawn = mFrame;
+                mWidgets[owner] = usage;
+            }
+            mWidgets[owner].objectCount++;
+        }
+
+        WidgetUsage& usage = mWidgets[allocation.owner];
+        usage.bytes[category] = usage.bytes[category] - allocation.bytes + bytes;
+        mCategoryBytes[category] = mCategoryBytes[category] - allocation.bytes + bytes;
+        mTotalBytes = mTotalBytes - allocation.bytes + bytes;
+        allocation.bytes = bytes;
+    }
+
+    void GpuMemoryTracker::Release(GpuResourceCategory category, GLuint name)
+    {
+        auto itr = mAllocations.find(KeyFor(category, name));
+        if (itr == mAllocations.end()) return;
+
+        const Allocation& allocation = itr->second;
+        mCategoryCount[category]--;
+        mCategoryBytes[category] -= allocation.bytes;
+        mTotalBytes -= allocation.bytes;
+
+        auto usage = mWidgets.find(allocation.owner);
+        usage->second.bytes[category] -= allocation.bytes;
+        if (--usage->second.objectCount == 0) mWidgets.erase(usage);
+        mAllocations.erase(itr);
+    }
+
+    void GpuMemoryTracker::MarkDrawn(Widget* widget)
+    {
+        auto usage = mWidgets.find(widget);
+        if (usage != mWidgets.end()) usage->second.lastDrawn = mFrame;
+    }
+
+    void GpuMemoryTracker::NextFrame()
+    {
+        mFrame++;
+    }
+
+    void GpuMemoryTracker::SetBudget(size_t bytes)
+    {
+        mBudget = bytes;
+        mWarnedOverBudget = false;
+        info("GpuMemoryTracker: Budget {} KiB", bytes / 1024);
+    }
+
+    size_t GpuMemoryTracker::GetBudget() const
+    {
+        return mBudget;
+    }
+
+    bool GpuMemoryTracker::IsOverBudget() const
+    {
+        return mBudget > 0 && mTotalBytes > mBudget;
+    }
+
+    void GpuMemoryTracker::EnforceBudget()
+    {
+        if (!IsOverBudget())
+        {
+            mWarnedOverBudget = false;
+            return;
+        }
+
+        // Invisible widgets holding textures, least recently drawn first.
+        // The list is a member so frames spent over budget reuse its storage
+        mEvictionCandidates.clear();
+        for (auto& entry : mWidgets)
+        {
+            if (!entry.first->GetVisible() && entry.second.bytes[GpuResource_Texture] > 0)
+            {
+                mEvictionCandidates.push_back(pair<uint64_t, Widget*>(entry.second.lastDrawn, entry.first));
+            }
+        }
+        std::sort(mEvictionCandidates.begin(), mEvictionCandidates.end());
+
+        for (auto& candidate : mEvictionCandidates)
+        {
+            if (!IsOverBudget()) break;
+            size_t before = mTotalBytes;
+            if (candidate.second->EvictTextures())
+            {
+                debug("GpuMemoryTracker: Evicted {} KiB of textures, unused for {} frames",
+                      (before - mTotalBytes) / 1024, mFrame - candidate.first);
+            }
+        }
+
+        if (IsOverBudget() && !mWarnedOverBudget)
+        {
+            warn("GpuMemoryTracker: {} KiB in use exceeds the {} KiB budget with nothing left to evict",
+                 mTotalBytes / 1024, mBudget / 1024);
+            mWarnedOverBudget = true;
+        }
+    }
+
+    size_t GpuMemoryTracker::GetTotalBytes() const
+    {
+        return mTotalBytes;
+    }
+
+    size_t GpuMemoryTracker::GetCategoryBytes(GpuResourceCategory category) const
+    {
+        return mCategoryBytes[category];
+    }
+
+    size_t GpuMemoryTracker::GetCategoryCount(GpuResourceCategory category) const
+    {
+        return mCategoryCount[category];
+    }
+
+    size_t GpuMemoryTracker::GetWidgetBytes(const Widget* widget) const
+    {
+        auto usage = mWidgets.find(const_cast<Widget*>(widget));
+        if (usage == mWidgets.end()) return 0;
+        size_t total = 0;
+        for (int i = 0; i < GpuResource_Count; i++) total += usage->second.bytes[i];
+        return total;
+    }
+
+    void GpuMemoryTracker::LogSummary() const
+    {
+        info("GpuMemoryTracker: {} KiB in use, budget {} KiB", mTotalBytes / 1024, mBudget / 1024);
+        for (int i = 0; i < GpuResource_Count; i++)
+        {
+            auto category = static_cast<GpuResourceCategory>(i);
+            info("GpuMemoryTracker:   {} x{} {} KiB", GetCategoryName(category),
+                 mCategoryCount[i], mCategoryBytes[i] / 1024);
+        }
+        for (auto& entry : mWidgets)
+        {
+            debug("GpuMemoryTracker:   Widget {} {} KiB", static_cast<const void*>(entry.first),
+                  GetWidgetBytes(entry.first) / 1024);
+        }
+    }
+
+    const char* GpuMemoryTracker::GetCategoryName(GpuResourceCategory category)
+    {
+        switch (category)
+        {
+            case GpuResource_Texture:      return "Textures";
+            case GpuResource_VertexBuffer: return "Vertex buffers";
+            case GpuResource_VertexArray:  return "Vertex arrays";
+            default:                       return "Unknown";
+        }
+    }
+}
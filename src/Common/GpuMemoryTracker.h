@@ -0,0 +1,104 @@
+/*
+ * GpuMemoryTracker.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+#include "GLHeader.h"
+
+using std::map;
+using std::pair;
+using std::vector;
+
+namespace octronic
+{
+    class Widget;
+
+    enum GpuResourceCategory
+    {
+        GpuResource_Texture = 0,
+        GpuResource_VertexBuffer,
+        GpuResource_VertexArray,
+        GpuResource_Count
+    };
+
+    /**
+     * @brief Accounts for the GL objects widgets allocate, per widget and
+     * per category. When a budget is set, EnforceBudget evicts textures of
+     * invisible widgets, least recently drawn first; widgets restore them
+     * when they are next drawn. Render thread only.
+     */
+    class GpuMemoryTracker
+    {
+    public:
+        GpuMemoryTracker();
+
+        /**
+         * @brief Records or resizes the allocation behind a GL object name.
+         */
+        void Track(Widget* owner, GpuResourceCategory category, GLuint name, size_t bytes);
+        void Release(GpuResourceCategory category, GLuint name);
+
+        void MarkDrawn(Widget* widget);
+        void NextFrame();
+
+        /**
+         * @brief Budget in bytes across all categories, 0 for no limit.
+         */
+        void SetBudget(size_t bytes);
+        size_t GetBudget() const;
+        bool IsOverBudget() const;
+        void EnforceBudget();
+
+        size_t GetTotalBytes() const;
+        size_t GetCategoryBytes(GpuResourceCategory category) const;
+        size_t GetCategoryCount(GpuResourceCategory category) const;
+        size_t GetWidgetBytes(const Widget* widget) const;
+
+        void LogSummary() const;
+
+        static const char* GetCategoryName(GpuResourceCategory category);
+
+    private:
+        struct Allocation
+        {
+            Widget* owner;
+            GpuResourceCategory category;
+            size_t bytes;
+        };
+
+        struct WidgetUsage
+        {
+            size_t bytes[GpuResource_Count];
+            size_t objectCount;
+            uint64_t lastDrawn;
+        };
+
+        static uint64_t KeyFor(GpuResourceCategory category, GLuint name);
+
+        map<uint64_t, Allocation> mAllocations;
+        map<Widget*, WidgetUsage> mWidgets;
+        vector<pair<uint64_t, Widget*>> mEvictionCandidates;
+        size_t mCategoryBytes[GpuResource_Count];
+        size_t mCategoryCount[GpuResource_Count];
+        size_t mTotalBytes;
+        size_t mBudget;
+        uint64_t mFrame;
+        bool mWarnedOverBudget;
+    };
+}
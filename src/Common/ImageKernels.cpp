@@ -0,0 +1,712 @@
+/*
+ * ImageKernels.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "ImageKernels.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__)
+    #define IMAGE_KERNELS_AVX2
+    #include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define IMAGE_KERNELS_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define IMAGE_KERNELS_NEON
+    #include <arm_neon.h>
+#endif
+
+#if defined(IMAGE_KERNELS_AVX2) || defined(IMAGE_KERNELS_SSE2) || defined(IMAGE_KERNELS_NEON)
+    #define IMAGE_KERNELS_SIMD
+#endif
+
+using std::vector;
+
+namespace octronic
+{
+    static bool sSimdEnabled = true;
+
+    // Scalar reference ########################################################
+
+    // round(c * a / 255) without a division
+    static inline uint8_t MulDiv255(uint32_t c, uint32_t a)
+    {
+        uint32_t t = c * a + 128;
+        return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+    }
+
+    static void PremultiplyAlphaScalar(uint8_t* p, size_t count)
+    {
+        for (size_t i = 0; i < count; i++, p += 4)
+        {
+            uint32_t a = p[3];
+            p[0] = MulDiv255(p[0], a);
+            p[1] = MulDiv255(p[1], a);
+            p[2] = MulDiv255(p[2], a);
+        }
+    }
+
+    static void SwizzleChannelsScalar(uint8_t* p, size_t count, const int order[4])
+    {
+        for (size_t i = 0; i < count; i++, p += 4)
+        {
+            uint8_t in[4] = { p[0], p[1], p[2], p[3] };
+            p[0] = in[order[0]];
+            p[1] = in[order[1]];
+            p[2] = in[order[2]];
+            p[3] = in[order[3]];
+        }
+    }
+
+    static void DownsampleBoxScalar(const uint8_t* src, int width, int height,
+        uint8_t* dst, int firstColumn)
+    {
+        const int dstWidth = ImageKernels::MipWidth(width);
+        const int dstHeight = ImageKernels::MipHeight(height);
+        const int blockX = width > 1 ? 2 : 1;
+        const int blockY = height > 1 ? 2 : 1;
+        const int shift = (blockX == 2) + (blockY == 2);
+        const int rounding = (1 << shift) >> 1;
+
+        for (int y = 0; y < dstHeight; y++)
+        {
+            for (int x = firstColumn; x < dstWidth; x++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    int sum = rounding;
+                    for (int v = 0; v < blockY; v++)
+                    {
+                        for (int u = 0; u < blockX; u++)
+                        {
+                            sum += src[((y * blockY + v) * width + x * blockX + u) * 4 + c];
+                        }
+                    }
+                    dst[(y * dstWidth + x) * 4 + c] = static_cast<uint8_t>(sum >> shift);
+                }
+            }
+        }
+    }
+
+    // SIMD ####################################################################
+
+#ifdef IMAGE_KERNELS_SSE2
+    // Premultiplies two pixels widened to 16 bits per channel
+    static inline __m128i PremultiplyPairSSE2(__m128i px)
+    {
+        const __m128i rgbMask  = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+        const __m128i alphaOne = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+        __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, 0xFF), 0xFF);
+        alpha = _mm_or_si128(_mm_and_si128(alpha, rgbMask), alphaOne);
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(px, alpha), _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+#endif
+
+#ifdef IMAGE_KERNELS_AVX2
+    static inline __m256i PremultiplyPairAVX2(__m256i px)
+    {
+        const __m256i rgbMask  = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+        const __m256i alphaOne = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+        __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px, 0xFF), 0xFF);
+        alpha = _mm256_or_si256(_mm256_and_si256(alpha, rgbMask), alphaOne);
+        __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(px, alpha), _mm256_set1_epi16(128));
+        return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+    }
+#endif
+
+#ifdef IMAGE_KERNELS_NEON
+    static inline uint8x8_t MulDiv255NEON(uint8x8_t c, uint8x8_t a)
+    {
+        uint16x8_t t = vaddq_u16(vmull_u8(c, a), vdupq_n_u16(128));
+        return vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+    }
+#endif
+
+    // Kernels #################################################################
+
+    void ImageKernels::PremultiplyAlpha(uint8_t* rgba, size_t pixelCount)
+    {
+        size_t i = 0;
+#ifdef IMAGE_KERNELS_SIMD
+        const size_t simdCount = sSimdEnabled ? pixelCount : 0;
+#endif
+#if defined(IMAGE_KERNELS_AVX2)
+        const __m256i zero = _mm256_setzero_si256();
+        for (; i + 8 <= simdCount; i += 8)
+        {
+            __m256i* p = reinterpret_cast<__m256i*>(rgba + i * 4);
+            __m256i v = _mm256_loadu_si256(p);
+            __m256i lo = PremultiplyPairAVX2(_mm256_unpacklo_epi8(v, zero));
+            __m256i hi = PremultiplyPairAVX2(_mm256_unpackhi_epi8(v, zero));
+            _mm256_storeu_si256(p, _mm256_packus_epi16(lo, hi));
+        }
+#elif defined(IMAGE_KERNELS_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 4 <= simdCount; i += 4)
+        {
+            __m128i* p = reinterpret_cast<__m128i*>(rgba + i * 4);
+            __m128i v = _mm_loadu_si128(p);
+            __m128i lo = PremultiplyPairSSE2(_mm_unpacklo_epi8(v, zero));
+            __m128i hi = PremultiplyPairSSE2(_mm_unpackhi_epi8(v, zero));
+            _mm_storeu_si128(p, _mm_packus_epi16(lo, hi));
+        }
+#elif defined(IMAGE_KERNELS_NEON)
+        for (; i + 8 <= simdCount; i += 8)
+        {
+            uint8_t* p = rgba + i * 4;
+            uint8x8x4_t v = vld4_u8(p);
+            v.val[0] = MulDiv255NEON(v.val[0], v.val[3]);
+            v.val[1] = MulDiv255NEON(v.val[1], v.val[3]);
+            v.val[2] = MulDiv255NEON(v.val[2], v.val[3]);
+            vst4_u8(p, v);
+        }
+#endif
+        PremultiplyAlphaScalar(rgba + i * 4, pixelCount - i);
+    }
+
+    // 8-bit transfer functions are table lookups on every path, not SIMD:
+    // SSE2 has no byte gather, and a 256 entry table beats evaluating the
+    // sRGB curve in SIMD at this precision.
+    struct TransferTable
+    {
+        uint8_t values[256];
+
+        explicit TransferTable(bool toLinear)
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                float v = i / 255.0f;
+                if (toLinear)
+                {
+                    v = v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+                }
+                else
+                {
+                    v = v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+                }
+                values[i] = static_cast<uint8_t>(v * 255.0f + 0.5f);
+            }
+        }
+    };
+
+    static const uint8_t* SrgbToLinearTable()
+    {
+        static const TransferTable table(true);
+        return table.values;
+    }
+
+    static const uint8_t* LinearToSrgbTable()
+    {
+        static const TransferTable table(false);
+        return table.values;
+    }
+
+    static void ApplyTable(uint8_t* p, size_t count, const uint8_t* table)
+    {
+        for (size_t i = 0; i < count; i++, p += 4)
+        {
+            p[0] = table[p[0]];
+            p[1] = table[p[1]];
+            p[2] = table[p[2]];
+        }
+    }
+
+    void ImageKernels::SrgbToLinear(uint8_t* rgba, size_t pixelCount)
+    {
+        ApplyTable(rgba, pixelCount, SrgbToLinearTable());
+    }
+
+    void ImageKernels::LinearToSrgb(uint8_t* rgba, size_t pixelCount)
+    {
+        ApplyTable(rgba, pixelCount, LinearToSrgbTable());
+    }
+
+    void ImageKernels::SwizzleChannels(uint8_t* rgba, size_t pixelCount, const int order[4])
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            if (order[c] < 0 || order[c] > 3) return;
+        }
+
+        size_t i = 0;
+#ifdef IMAGE_KERNELS_SIMD
+        const size_t simdCount = sSimdEnabled ? pixelCount : 0;
+#endif
+#if defined(IMAGE_KERNELS_AVX2)
+        char control[32];
+        for (int b = 0; b < 32; b++)
+        {
+            control[b] = static_cast<char>((b % 16) / 4 * 4 + order[b % 4]);
+        }
+        const __m256i shuffle = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(control));
+        for (; i + 8 <= simdCount; i += 8)
+        {
+            __m256i* p = reinterpret_cast<__m256i*>(rgba + i * 4);
+            _mm256_storeu_si256(p, _mm256_shuffle_epi8(_mm256_loadu_si256(p), shuffle));
+        }
+#elif defined(IMAGE_KERNELS_SSE2)
+        // No byte shuffle in SSE2: move each channel with 32-bit lane shifts
+        const __m128i byteMask = _mm_set1_epi32(0xFF);
+        for (; i + 4 <= simdCount; i += 4)
+        {
+            __m128i* p = reinterpret_cast<__m128i*>(rgba + i * 4);
+            __m128i v = _mm_loadu_si128(p);
+            __m128i out = _mm_setzero_si128();
+            for (int c = 0; c < 4; c++)
+            {
+                __m128i channel = _mm_and_si128(
+                    _mm_srl_epi32(v, _mm_cvtsi32_si128(order[c] * 8)), byteMask);
+                out = _mm_or_si128(out, _mm_sll_epi32(channel, _mm_cvtsi32_si128(c * 8)));
+            }
+            _mm_storeu_si128(p, out);
+        }
+#elif defined(IMAGE_KERNELS_NEON)
+        for (; i + 16 <= simdCount; i += 16)
+        {
+            uint8_t* p = rgba + i * 4;
+            uint8x16x4_t in = vld4q_u8(p);
+            uint8x16x4_t out;
+            out.val[0] = in.val[order[0]];
+            out.val[1] = in.val[order[1]];
+            out.val[2] = in.val[order[2]];
+            out.val[3] = in.val[order[3]];
+            vst4q_u8(p, out);
+        }
+#endif
+        SwizzleChannelsScalar(rgba + i * 4, pixelCount - i, order);
+    }
+
+    void ImageKernels::DownsampleBox(const uint8_t* src, int width, int height, uint8_t* dst)
+    {
+        if (width < 2 || height < 2 || !sSimdEnabled)
+        {
+            DownsampleBoxScalar(src, width, height, dst, 0);
+            return;
+        }
+
+        const int dstWidth = MipWidth(width);
+        int simdColumns = 0;
+
+#if defined(IMAGE_KERNELS_SSE2)
+        const int dstHeight = MipHeight(height);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+        simdColumns = dstWidth / 4 * 4;
+        for (int y = 0; y < dstHeight; y++)
+        {
+            const uint8_t* row0 = src + (2 * y) * width * 4;
+            const uint8_t* row1 = row0 + width * 4;
+            uint8_t* out = dst + y * dstWidth * 4;
+
+            for (int x = 0; x < simdColumns; x += 4)
+            {
+                __m128i result[2];
+                for (int half = 0; half < 2; half++)
+                {
+                    // Four source pixels from each row make two output pixels
+                    int offset = (2 * x + half * 4) * 4;
+                    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + offset));
+                    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + offset));
+                    __m128i left  = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                    __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                    left  = _mm_add_epi16(left,  _mm_srli_si128(left, 8));
+                    right = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+                    __m128i sum = _mm_unpacklo_epi64(left, right);
+                    result[half] = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4),
+                    _mm_packus_epi16(result[0], result[1]));
+            }
+        }
+#elif defined(IMAGE_KERNELS_NEON)
+        const int dstHeight = MipHeight(height);
+        simdColumns = dstWidth / 8 * 8;
+        for (int y = 0; y < dstHeight; y++)
+        {
+            const uint8_t* row0 = src + (2 * y) * width * 4;
+            const uint8_t* row1 = row0 + width * 4;
+            uint8_t* out = dst + y * dstWidth * 4;
+
+            for (int x = 0; x < simdColumns; x += 8)
+            {
+                uint8x16x4_t a = vld4q_u8(row0 + x * 8);
+                uint8x16x4_t b = vld4q_u8(row1 + x * 8);
+                uint8x8x4_t result;
+                for (int c = 0; c < 4; c++)
+                {
+                    uint16x8_t sum = vpadalq_u8(vpaddlq_u8(a.val[c]), b.val[c]);
+                    result.val[c] = vrshrn_n_u16(sum, 2);
+                }
+                vst4_u8(out + x * 4, result);
+            }
+        }
+#endif
+        if (simdColumns < dstWidth)
+        {
+            DownsampleBoxScalar(src, width, height, dst, simdColumns);
+        }
+    }
+
+    // Resampling ##############################################################
+
+    // Filter weights are 2.14 fixed point so two taps fit a 16-bit multiply
+    static const int ResampleWeightBits = 14;
+    static const int ResampleWeightOne = 1 << ResampleWeightBits;
+
+    struct ResampleTaps
+    {
+        vector<int> start;
+        vector<int> count;
+        vector<int16_t> weights;
+        int stride;
+    };
+
+    // Mitchell-Netravali, B = C = 1/3
+    static float MitchellFilter(float x)
+    {
+        const float B = 1.0f / 3.0f;
+        const float C = 1.0f / 3.0f;
+        x = std::fabs(x);
+        if (x < 1.0f)
+        {
+            return ((12 - 9 * B - 6 * C) * x * x * x +
+                    (-18 + 12 * B + 6 * C) * x * x +
+                    (6 - 2 * B)) / 6.0f;
+        }
+        if (x < 2.0f)
+        {
+            return ((-B - 6 * C) * x * x * x +
+                    (6 * B + 30 * C) * x * x +
+                    (-12 * B - 48 * C) * x +
+                    (8 * B + 24 * C)) / 6.0f;
+        }
+        return 0.0f;
+    }
+
+    static void BuildResampleTaps(int srcSize, int dstSize, ResampleTaps& taps)
+    {
+        const float scale = static_cast<float>(srcSize) / dstSize;
+        const float filterScale = scale > 1.0f ? scale : 1.0f;
+        const float support = 2.0f * filterScale;
+
+        taps.stride = static_cast<int>(std::ceil(support)) * 2 + 1;
+        taps.start.resize(dstSize);
+        taps.count.resize(dstSize);
+        taps.weights.assign(static_cast<size_t>(dstSize) * taps.stride, 0);
+
+        vector<float> weights(taps.stride);
+        for (int i = 0; i < dstSize; i++)
+        {
+            const float centre = (i + 0.5f) * scale - 0.5f;
+            int first = static_cast<int>(std::ceil(centre - support));
+            int last = static_cast<int>(std::floor(centre + support));
+            if (first < 0) first = 0;
+            if (last > srcSize - 1) last = srcSize - 1;
+            if (last - first + 1 > taps.stride) last = first + taps.stride - 1;
+
+            // Normalise over the taps that survive clipping at the edges
+            float total = 0.0f;
+            for (int j = first; j <= last; j++)
+            {
+                weights[j - first] = MitchellFilter((j - centre) / filterScale);
+                total += weights[j - first];
+            }
+
+            int16_t* fixed = &taps.weights[static_cast<size_t>(i) * taps.stride];
+            int fixedTotal = 0;
+            int largest = 0;
+            for (int j = 0; j <= last - first; j++)
+            {
+                fixed[j] = static_cast<int16_t>(std::floor(weights[j] / total * ResampleWeightOne + 0.5f));
+                fixedTotal += fixed[j];
+                if (fixed[j] > fixed[largest]) largest = j;
+            }
+            // Rounding must not change the overall gain
+            fixed[largest] = static_cast<int16_t>(fixed[largest] + ResampleWeightOne - fixedTotal);
+
+            taps.start[i] = first;
+            taps.count[i] = last - first + 1;
+        }
+    }
+
+    // Negative lobes may push a channel past alpha, which is not a valid
+    // premultiplied colour
+    static inline void ClampToAlpha(uint8_t* p)
+    {
+        if (p[0] > p[3]) p[0] = p[3];
+        if (p[1] > p[3]) p[1] = p[3];
+        if (p[2] > p[3]) p[2] = p[3];
+    }
+
+    static inline void StoreResampled(uint8_t* p, const int32_t sum[4])
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            int32_t v = (sum[c] + (ResampleWeightOne >> 1)) >> ResampleWeightBits;
+            p[c] = static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+        }
+        ClampToAlpha(p);
+    }
+
+#ifdef IMAGE_KERNELS_SSE2
+    // Two 16-bit taps in each 32-bit lane, as _mm_madd_epi16 expects
+    static inline __m128i WeightPairSSE2(int16_t first, int16_t second)
+    {
+        uint32_t pair = static_cast<uint16_t>(first) | (static_cast<uint32_t>(static_cast<uint16_t>(second)) << 16);
+        return _mm_set1_epi32(static_cast<int32_t>(pair));
+    }
+
+    // Rounds, shifts and saturates four pixels of 32-bit sums, then clamps
+    // colour to alpha
+    static inline __m128i PackResampledSSE2(__m128i p0, __m128i p1, __m128i p2, __m128i p3)
+    {
+        const __m128i half = _mm_set1_epi32(ResampleWeightOne >> 1);
+        p0 = _mm_srai_epi32(_mm_add_epi32(p0, half), ResampleWeightBits);
+        p1 = _mm_srai_epi32(_mm_add_epi32(p1, half), ResampleWeightBits);
+        p2 = _mm_srai_epi32(_mm_add_epi32(p2, half), ResampleWeightBits);
+        p3 = _mm_srai_epi32(_mm_add_epi32(p3, half), ResampleWeightBits);
+        __m128i px = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+        __m128i alpha = _mm_srli_epi32(px, 24);
+        alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 8));
+        alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+        return _mm_min_epu8(px, alpha);
+    }
+#endif
+
+    static void ResampleHorizontal(const uint8_t* src, int srcWidth, int height,
+        uint8_t* dst, int dstWidth, const ResampleTaps& taps)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t* row = src + static_cast<size_t>(y) * srcWidth * 4;
+            uint8_t* out = dst + static_cast<size_t>(y) * dstWidth * 4;
+
+            for (int x = 0; x < dstWidth; x++)
+            {
+                const uint8_t* p = row + taps.start[x] * 4;
+                const int16_t* w = &taps.weights[static_cast<size_t>(x) * taps.stride];
+                const int count = taps.count[x];
+                int k = 0;
+#if defined(IMAGE_KERNELS_SSE2)
+                if (sSimdEnabled)
+                {
+                    // Interleave two neighbouring pixels so one madd applies
+                    // a pair of taps to every channel
+                    const __m128i zero = _mm_setzero_si128();
+                    __m128i sum = zero;
+                    for (; k + 2 <= count; k += 2)
+                    {
+                        __m128i pair = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + k * 4));
+                        pair = _mm_unpacklo_epi8(_mm_unpacklo_epi8(pair, _mm_srli_si128(pair, 4)), zero);
+                        __m128i weight = WeightPairSSE2(w[k], w[k + 1]);
+                        sum = _mm_add_epi32(sum, _mm_madd_epi16(pair, weight));
+                    }
+                    if (k < count)
+                    {
+                        int32_t single;
+                        memcpy(&single, p + k * 4, 4);
+                        __m128i px = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(single), zero), zero);
+                        sum = _mm_add_epi32(sum, _mm_madd_epi16(px, WeightPairSSE2(w[k], 0)));
+                    }
+                    int32_t packed = _mm_cvtsi128_si32(PackResampledSSE2(sum, zero, zero, zero));
+                    memcpy(out + x * 4, &packed, 4);
+                    continue;
+                }
+#elif defined(IMAGE_KERNELS_NEON)
+                if (sSimdEnabled)
+                {
+                    int32x4_t sum = vdupq_n_s32(0);
+                    for (; k < count; k++)
+                    {
+                        uint32_t single;
+                        memcpy(&single, p + k * 4, 4);
+                        int16x8_t px = vreinterpretq_s16_u16(vmovl_u8(vcreate_u8(single)));
+                        sum = vmlal_n_s16(sum, vget_low_s16(px), w[k]);
+                    }
+                    int32_t lanes[4];
+                    vst1q_s32(lanes, sum);
+                    StoreResampled(out + x * 4, lanes);
+                    continue;
+                }
+#endif
+                int32_t sum[4] = { 0, 0, 0, 0 };
+                for (; k < count; k++)
+                {
+                    for (int c = 0; c < 4; c++) sum[c] += w[k] * p[k * 4 + c];
+                }
+                StoreResampled(out + x * 4, sum);
+            }
+        }
+    }
+
+    static void ResampleVertical(const uint8_t* src, int width, uint8_t* dst,
+        int dstHeight, const ResampleTaps& taps)
+    {
+        const size_t rowBytes = static_cast<size_t>(width) * 4;
+        for (int y = 0; y < dstHeight; y++)
+        {
+            const uint8_t* first = src + taps.start[y] * rowBytes;
+            const int16_t* w = &taps.weights[static_cast<size_t>(y) * taps.stride];
+            const int count = taps.count[y];
+            uint8_t* out = dst + y * rowBytes;
+            int x = 0;
+
+#ifdef IMAGE_KERNELS_SIMD
+            const int simdWidth = sSimdEnabled ? width : 0;
+#endif
+#if defined(IMAGE_KERNELS_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            for (; x + 4 <= simdWidth; x += 4)
+            {
+                __m128i sum[4] = { zero, zero, zero, zero };
+                const uint8_t* p = first + x * 4;
+                int k = 0;
+                for (; k + 2 <= count; k += 2, p += 2 * rowBytes)
+                {
+                    // Interleave two rows so one madd applies a pair of taps
+                    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + rowBytes));
+                    __m128i weight = WeightPairSSE2(w[k], w[k + 1]);
+                    __m128i lo = _mm_unpacklo_epi8(a, b);
+                    __m128i hi = _mm_unpackhi_epi8(a, b);
+                    sum[0] = _mm_add_epi32(sum[0], _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), weight));
+                    sum[1] = _mm_add_epi32(sum[1], _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), weight));
+                    sum[2] = _mm_add_epi32(sum[2], _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), weight));
+                    sum[3] = _mm_add_epi32(sum[3], _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), weight));
+                }
+                if (k < count)
+                {
+                    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                    __m128i weight = WeightPairSSE2(w[k], 0);
+                    __m128i lo = _mm_unpacklo_epi8(a, zero);
+                    __m128i hi = _mm_unpackhi_epi8(a, zero);
+                    sum[0] = _mm_add_epi32(sum[0], _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), weight));
+                    sum[1] = _mm_add_epi32(sum[1], _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), weight));
+                    sum[2] = _mm_add_epi32(sum[2], _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), weight));
+                    sum[3] = _mm_add_epi32(sum[3], _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), weight));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4),
+                    PackResampledSSE2(sum[0], sum[1], sum[2], sum[3]));
+            }
+#elif defined(IMAGE_KERNELS_NEON)
+            for (; x + 4 <= simdWidth; x += 4)
+            {
+                int32x4_t sum[4] = { vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0), vdupq_n_s32(0) };
+                const uint8_t* p = first + x * 4;
+                for (int k = 0; k < count; k++, p += rowBytes)
+                {
+                    uint8x16_t row = vld1q_u8(p);
+                    int16x8_t lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(row)));
+                    int16x8_t hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(row)));
+                    sum[0] = vmlal_n_s16(sum[0], vget_low_s16(lo), w[k]);
+                    sum[1] = vmlal_n_s16(sum[1], vget_high_s16(lo), w[k]);
+                    sum[2] = vmlal_n_s16(sum[2], vget_low_s16(hi), w[k]);
+                    sum[3] = vmlal_n_s16(sum[3], vget_high_s16(hi), w[k]);
+                }
+                for (int i = 0; i < 4; i++)
+                {
+                    int32_t lanes[4];
+                    vst1q_s32(lanes, sum[i]);
+                    StoreResampled(out + (x + i) * 4, lanes);
+                }
+            }
+#endif
+            for (; x < width; x++)
+            {
+                int32_t sum[4] = { 0, 0, 0, 0 };
+                const uint8_t* p = first + x * 4;
+                for (int k = 0; k < count; k++, p += rowBytes)
+                {
+                    for (int c = 0; c < 4; c++) sum[c] += w[k] * p[c];
+                }
+                StoreResampled(out + x * 4, sum);
+            }
+        }
+    }
+
+    void ImageKernels::Resample(const uint8_t* src, int width, int height,
+        uint8_t* dst, int dstWidth, int dstHeight)
+    {
+        if (width <= 0 || height <= 0 || dstWidth <= 0 || dstHeight <= 0) return;
+
+        if (width == dstWidth && height == dstHeight)
+        {
+            memcpy(dst, src, static_cast<size_t>(width) * height * 4);
+            return;
+        }
+
+        // Halve with the box filter while both axes stay at least twice the
+        // target, so the final filter pass only spans a few taps
+        vector<uint8_t> halved[2];
+        int buffer = 0;
+        while (width >= dstWidth * 2 && height >= dstHeight * 2)
+        {
+            vector<uint8_t>& next = halved[buffer];
+            next.resize(static_cast<size_t>(MipWidth(width)) * MipHeight(height) * 4);
+            DownsampleBox(src, width, height, next.data());
+            src = next.data();
+            width = MipWidth(width);
+            height = MipHeight(height);
+            buffer ^= 1;
+        }
+
+        ResampleTaps horizontal, vertical;
+        BuildResampleTaps(width, dstWidth, horizontal);
+        BuildResampleTaps(height, dstHeight, vertical);
+
+        vector<uint8_t> columns(static_cast<size_t>(dstWidth) * height * 4);
+        ResampleHorizontal(src, width, height, columns.data(), dstWidth, horizontal);
+        ResampleVertical(columns.data(), dstWidth, dst, dstHeight, vertical);
+    }
+
+    int ImageKernels::MipWidth(int width)
+    {
+        return width > 1 ? width / 2 : 1;
+    }
+
+    int ImageKernels::MipHeight(int height)
+    {
+        return height > 1 ? height / 2 : 1;
+    }
+
+    void ImageKernels::SetSimdEnabled(bool enabled)
+    {
+        sSimdEnabled = enabled;
+    }
+
+    bool ImageKernels::IsSimdEnabled()
+    {
+        return sSimdEnabled;
+    }
+
+    const char* ImageKernels::GetInstructionSet()
+    {
+#if defined(IMAGE_KERNELS_AVX2)
+        return "AVX2";
+#elif defined(IMAGE_KERNELS_SSE2)
+        return "SSE2";
+#elif defined(IMAGE_KERNELS_NEON)
+        return "NEON";
+#else
+        return "Scalar";
+#endif
+    }
+}
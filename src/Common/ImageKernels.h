@@ -0,0 +1,77 @@
+/*
+ * ImageKernels.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace octronic
+{
+    /**
+     * @brief In-place and downsampling kernels for tightly packed RGBA8
+     * images. Each kernel has an SSE2, AVX2 or NEON path selected at compile
+     * time and a scalar fallback that produces bit-identical results. The
+     * sRGB conversions are the exception: a table lookup on every path.
+     */
+    class ImageKernels
+    {
+    public:
+        /**
+         * @brief Multiplies RGB by alpha, rounding to nearest.
+         */
+        static void PremultiplyAlpha(uint8_t* rgba, size_t pixelCount);
+
+        /**
+         * @brief Converts RGB between sRGB and linear encoding. Alpha is
+         * left untouched.
+         */
+        static void SrgbToLinear(uint8_t* rgba, size_t pixelCount);
+        static void LinearToSrgb(uint8_t* rgba, size_t pixelCount);
+
+        /**
+         * @brief Reorders channels so that output channel i takes input
+         * channel order[i], e.g. {2,1,0,3} converts RGBA to BGRA.
+         */
+        static void SwizzleChannels(uint8_t* rgba, size_t pixelCount, const int order[4]);
+
+        /**
+         * @brief Produces the next mipmap level with a rounded 2x2 box
+         * filter. The destination is max(w/2,1) x max(h/2,1) pixels; an odd
+         * trailing row or column is dropped, matching the GL level sizes.
+         */
+        static void DownsampleBox(const uint8_t* src, int width, int height, uint8_t* dst);
+
+        /**
+         * @brief Resizes premultiplied RGBA to any size with a separable
+         * Mitchell-Netravali filter. Large reductions are first halved with
+         * DownsampleBox. src and dst must not overlap.
+         */
+        static void Resample(const uint8_t* src, int width, int height,
+            uint8_t* dst, int dstWidth, int dstHeight);
+
+        static int MipWidth(int width);
+        static int MipHeight(int height);
+
+        /**
+         * @brief Off runs every kernel on its scalar fallback, so
+         * ImageKernelsBench can check the SIMD paths against it. Not
+         * thread-safe; leave it on outside the bench.
+         */
+        static void SetSimdEnabled(bool enabled);
+        static bool IsSimdEnabled();
+
+        static const char* GetInstructionSet();
+    };
+}
@@ -0,0 +1,251 @@
+/*
+ * JsonFloatArrayReader.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "JsonFloatArrayReader.h"
+
+#include "Logger.h"
+
+namespace octronic
+{
+    JsonFloatArrayReader::JsonFloatArrayReader(const std::string& key, float* data, size_t capacity)
+        : mKey(key),
+          mData(data),
+          mCapacity(capacity)
+    {
+        Reset();
+    }
+
+    void JsonFloatArrayReader::Reset()
+    {
+        mCount = 0;
+        mDepth = 0;
+        mArmed = false;
+        mTargetDepth = -1;
+        mTargetIsObject = false;
+        mMember = JsonFloatArrayMember_None;
+        mHasData = false;
+        mIsBase64 = false;
+        mHasExpectedCount = false;
+        mExpectedCount = 0;
+        mFound = false;
+        mDone = false;
+        mFailed = false;
+    }
+
+    bool JsonFloatArrayReader::ReadJson(const uint8_t* text, size_t size)
+    {
+        Reset();
+        json::sax_parse(text, text + size, this);
+        return mDone && !mFailed;
+    }
+
+    bool JsonFloatArrayReader::ReadCbor(const uint8_t* data, size_t size)
+    {
+        Reset();
+        json::sax_parse(nlohmann::detail::input_adapter(data, size), this,
+            json::input_format_t::cbor);
+        return mDone && !mFailed;
+    }
+
+    size_t JsonFloatArrayReader::GetCount() const
+    {
+        return mCount;
+    }
+
+    bool JsonFloatArrayReader::WasFound() const
+    {
+        return mFound;
+    }
+
+    // Returning false from a callback stops the parser, so the rest of the
+    // document is never read once the target is complete
+    bool JsonFloatArrayReader::Finish(bool completed)
+    {
+        mDone = true;
+        mFailed = !completed;
+        return false;
+    }
+
+    bool JsonFloatArrayReader::AddNumber(float value)
+    {
+        // A lone number is not an array
+        if (mArmed) return OtherValue();
+        if (mTargetDepth >= 0 && !mTargetIsObject)
+        {
+            if (mCount >= mCapacity) return Finish(false);
+            mData[mCount++] = value;
+        }
+        mMember = JsonFloatArrayMember_None;
+        return true;
+    }
+
+    bool JsonFloatArrayReader::SetExpectedCount(uint64_t count)
+    {
+        mHasExpectedCount = true;
+        mExpectedCount = count;
+        mMember = JsonFloatArrayMember_None;
+        return true;
+    }
+
+    // The members of a base64 object may come in any order, so it is only
+    // checked once it closes
+    bool JsonFloatArrayReader::FinishObject()
+    {
+        return Finish(mHasData && mIsBase64 && (!mHasExpectedCount || mExpectedCount == mCount));
+    }
+
+    bool JsonFloatArrayReader::OtherValue()
+    {
+        if (mArmed)
+        {
+            mFound = true;
+            return Finish(false);
+        }
+        if (mTargetDepth >= 0 && (!mTargetIsObject || mMember != JsonFloatArrayMember_None)) return Finish(false);
+        return true;
+    }
+
+    bool JsonFloatArrayReader::null()
+    {
+        return OtherValue();
+    }
+
+    bool JsonFloatArrayReader::boolean(bool)
+    {
+        return OtherValue();
+    }
+
+    bool JsonFloatArrayReader::number_integer(number_integer_t val)
+    {
+        if (mMember == JsonFloatArrayMember_Floats)
+        {
+            return val >= 0 ? SetExpectedCount(static_cast<uint64_t>(val)) : Finish(false);
+        }
+        return AddNumber(static_cast<float>(val));
+    }
+
+    bool JsonFloatArrayReader::number_unsigned(number_unsigned_t val)
+    {
+        if (mMember == JsonFloatArrayMember_Floats) return SetExpectedCount(val);
+        return AddNumber(static_cast<float>(val));
+    }
+
+    bool JsonFloatArrayReader::number_float(number_float_t val, const string_t&)
+    {
+        if (mMember == JsonFloatArrayMember_Floats) return Finish(false);
+        return AddNumber(static_cast<float>(val));
+    }
+
+    bool JsonFloatArrayReader::string(string_t& val)
+    {
+        if (mMember == JsonFloatArrayMember_Encoding)
+        {
+            mIsBase64 = val == "base64";
+            mMember = JsonFloatArrayMember_None;
+            return true;
+        }
+        if (mMember == JsonFloatArrayMember_Data)
+        {
+            size_t bytes = JsonSerialization::GetDecodedBase64Size(val);
+            if (mHasData || val.size() % 4 != 0 || bytes % sizeof(float) != 0 ||
+                bytes > mCapacity * sizeof(float)) return Finish(false);
+            if (bytes > 0 &&
+                JsonSerialization::DecodeBase64(val, reinterpret_cast<uint8_t*>(mData), bytes) != bytes)
+            {
+                return Finish(false);
+            }
+            mCount = bytes / sizeof(float);
+            JsonSerialization::ConvertLittleEndianFloats(mData, mCount);
+            mHasData = true;
+            mMember = JsonFloatArrayMember_None;
+            return true;
+        }
+        return OtherValue();
+    }
+
+    bool JsonFloatArrayReader::start_object(std::size_t)
+    {
+        if (mArmed)
+        {
+            mArmed = false;
+            mFound = true;
+            mTargetIsObject = true;
+            mTargetDepth = mDepth;
+        }
+        else if (mTargetDepth >= 0 && (!mTargetIsObject || mMember != JsonFloatArrayMember_None))
+        {
+            return Finish(false);
+        }
+        mDepth++;
+        return true;
+    }
+
+    bool JsonFloatArrayReader::key(string_t& val)
+    {
+        if (mTargetIsObject)
+        {
+            mMember = JsonFloatArrayMember_None;
+            if (mDepth == mTargetDepth + 1)
+            {
+                if (val == "data")          mMember = JsonFloatArrayMember_Data;
+                else if (val == "encoding") mMember = JsonFloatArrayMember_Encoding;
+                else if (val == "floats")   mMember = JsonFloatArrayMember_Floats;
+            }
+        }
+        else if (!mFound && val == mKey)
+        {
+            mArmed = true;
+        }
+        return true;
+    }
+
+    bool JsonFloatArrayReader::end_object()
+    {
+        mDepth--;
+        if (mTargetIsObject && mDepth == mTargetDepth) return FinishObject();
+        return true;
+    }
+
+    bool JsonFloatArrayReader::start_array(std::size_t)
+    {
+        if (mArmed)
+        {
+            mArmed = false;
+            mFound = true;
+            mTargetDepth = mDepth;
+        }
+        else if (mTargetIsObject && mMember != JsonFloatArrayMember_None)
+        {
+            return Finish(false);
+        }
+        mDepth++;
+        return true;
+    }
+
+    bool JsonFloatArrayReader::end_array()
+    {
+        mDepth--;
+        if (!mTargetIsObject && mDepth == mTargetDepth) return Finish(true);
+        return true;
+    }
+
+    bool JsonFloatArrayReader::parse_error(std::size_t position, const std::string&,
+                                           const nlohmann::detail::exception& ex)
+    {
+        warn("JsonFloatArrayReader: Parse error at {}: {}", position, ex.what());
+        mDone = true;
+        mFailed = true;
+        return false;
+    }
+}
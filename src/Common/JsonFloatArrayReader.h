@@ -0,0 +1,117 @@
+/*
+ * JsonFloatArrayReader.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "JsonSerialization.h"
+
+using std::string;
+using std::vector;
+
+namespace octronic
+{
+    /** @brief Member of a base64 target object whose value comes next. */
+    enum JsonFloatArrayMember
+    {
+        JsonFloatArrayMember_None,
+        JsonFloatArrayMember_Data,
+        JsonFloatArrayMember_Encoding,
+        JsonFloatArrayMember_Floats
+    };
+
+    /**
+     * @brief Streams one float array out of a JSON (or CBOR) document
+     * without building a DOM. The value of the first member named key,
+     * either a number array (nested arrays are flattened) or a base64
+     * object as written by JsonSerialization::FloatsToJson, is written
+     * straight into caller-owned storage. Any other value, or a base64
+     * object whose floats member disagrees with its data, fails the read.
+     * Parsing stops as soon as that value ends.
+     */
+    class JsonFloatArrayReader : public nlohmann::json_sax<json>
+    {
+    public:
+        JsonFloatArrayReader(const std::string& key, float* data, size_t capacity);
+
+        bool ReadJson(const uint8_t* text, size_t size);
+        bool ReadCbor(const uint8_t* data, size_t size);
+
+        /** @brief Floats written by the last Read. */
+        size_t GetCount() const;
+        bool WasFound() const;
+
+        /**
+         * @brief Fills a preallocated vector of float-only elements,
+         * resizing it down to what was read. Never allocates.
+         */
+        template <typename T>
+        static bool Read(const uint8_t* text, size_t size, const std::string& key, vector<T>& values)
+        {
+            static_assert(sizeof(T) % sizeof(float) == 0, "Read needs float-only elements");
+            const size_t components = sizeof(T) / sizeof(float);
+            if (values.empty()) return false;
+            JsonFloatArrayReader reader(key, reinterpret_cast<float*>(&values[0]), values.size() * components);
+            if (!reader.ReadJson(text, size) || reader.GetCount() % components != 0) return false;
+            values.resize(reader.GetCount() / components);
+            return true;
+        }
+
+        // json_sax
+        bool null() override;
+        bool boolean(bool val) override;
+        bool number_integer(number_integer_t val) override;
+        bool number_unsigned(number_unsigned_t val) override;
+        bool number_float(number_float_t val, const string_t& s) override;
+        bool string(string_t& val) override;
+        bool start_object(std::size_t elements) override;
+        bool key(string_t& val) override;
+        bool end_object() override;
+        bool start_array(std::size_t elements) override;
+        bool end_array() override;
+        bool parse_error(std::size_t position, const std::string& last_token,
+                         const nlohmann::detail::exception& ex) override;
+
+    protected:
+        void Reset();
+        bool Finish(bool completed);
+        bool AddNumber(float value);
+        bool SetExpectedCount(uint64_t count);
+        bool FinishObject();
+        bool OtherValue();
+
+    private:
+        std::string mKey;
+        float* mData;
+        size_t mCapacity;
+        size_t mCount;
+
+        int mDepth;
+        // The next value is the target
+        bool mArmed;
+        // Depth at which the target array or object was opened, or -1
+        int mTargetDepth;
+        bool mTargetIsObject;
+        JsonFloatArrayMember mMember;
+        bool mHasData;
+        bool mIsBase64;
+        bool mHasExpectedCount;
+        uint64_t mExpectedCount;
+        bool mFound;
+        bool mDone;
+        bool mFailed;
+    };
+}
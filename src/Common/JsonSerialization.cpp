@@ -16,6 +16,74 @@
  */
 #include "JsonSerialization.h"
 
+#include <algorithm>
+#include <cstring>
+
+// Encoded floats are little-endian; big-endian hosts swap them
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    #define JSON_FLOATS_SWAP_BYTES
+#endif
+
+namespace
+{
+    const char BASE64_ALPHABET[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    // Reverse of BASE64_ALPHABET, -1 for bytes outside it
+    struct Base64Table
+    {
+        int8_t values[256];
+        Base64Table()
+        {
+            memset(values, -1, sizeof(values));
+            for (int i = 0; i < 64; i++) values[static_cast<uint8_t>(BASE64_ALPHABET[i])] = static_cast<int8_t>(i);
+        }
+    };
+
+    const Base64Table BASE64_TABLE;
+
+    const uint8_t CBOR_TAG_FLOAT32_LE = 85;
+
+    size_t CountNumbers(const json& js)
+    {
+        if (js.is_number()) return 1;
+        if (!js.is_array()) return 0;
+        size_t count = 0;
+        for (const json& element : js) count += CountNumbers(element);
+        return count;
+    }
+
+    bool FlattenNumbers(const json& js, float* data, size_t capacity, size_t& count)
+    {
+        if (js.is_number())
+        {
+            if (count >= capacity) return false;
+            data[count++] = js.get<float>();
+            return true;
+        }
+        if (!js.is_array()) return false;
+        for (const json& element : js)
+        {
+            if (!FlattenNumbers(element, data, capacity, count)) return false;
+        }
+        return true;
+    }
+
+    bool IsBase64Object(const json& js)
+    {
+        return js.is_object() && js.count("encoding") && js["encoding"] == "base64" &&
+            js.count("data") && js["data"].is_string();
+    }
+
+    // The floats member is optional, but must agree with data when present
+    bool IsBase64CountValid(const json& js, size_t count)
+    {
+        if (!js.count("floats")) return true;
+        const json& floats = js["floats"];
+        return floats.is_number_unsigned() && floats.get<uint64_t>() == count;
+    }
+}
+
 namespace octronic
 {
     JsonSerialization::JsonSerialization() {}
@@ -82,4 +150,189 @@ namespace octronic
         j.push_back(v.w);
         return j;
     }
+
+    json JsonSerialization::FloatsToJson(const float* data, size_t count, JsonArrayEncoding encoding)
+    {
+        if (encoding == JsonArray_Numbers)
+        {
+            json j = json::array();
+            j.get_ref<json::array_t&>().reserve(count);
+            for (size_t i = 0; i < count; i++) j.push_back(data[i]);
+            return j;
+        }
+
+#ifdef JSON_FLOATS_SWAP_BYTES
+        vector<float> little(data, data + count);
+        ConvertLittleEndianFloats(little.data(), count);
+        data = little.data();
+#endif
+        json j;
+        j["encoding"] = "base64";
+        j["floats"] = count;
+        j["data"] = EncodeBase64(reinterpret_cast<const uint8_t*>(data), count * sizeof(float));
+        return j;
+    }
+
+    size_t JsonSerialization::GetFloatCount(const json& js)
+    {
+        if (IsBase64Object(js))
+        {
+            return GetDecodedBase64Size(js["data"].get_ref<const string&>()) / sizeof(float);
+        }
+        return js.is_array() ? CountNumbers(js) : 0;
+    }
+
+    bool JsonSerialization::JsonToFloats(const json& js, float* data, size_t capacity, size_t& count)
+    {
+        count = 0;
+        if (IsBase64Object(js))
+        {
+            const string& text = js["data"].get_ref<const string&>();
+            size_t bytes = GetDecodedBase64Size(text);
+            if (text.size() % 4 != 0 || bytes % sizeof(float) != 0 || bytes > capacity * sizeof(float) ||
+                !IsBase64CountValid(js, bytes / sizeof(float))) return false;
+            if (bytes > 0 && DecodeBase64(text, reinterpret_cast<uint8_t*>(data), bytes) != bytes) return false;
+            count = bytes / sizeof(float);
+            ConvertLittleEndianFloats(data, count);
+            return true;
+        }
+        // Anything but a number array, such as a bare string or number, or
+        // an object that is not a base64 array, is malformed
+        return js.is_array() && FlattenNumbers(js, data, capacity, count);
+    }
+
+    void JsonSerialization::FloatsToCbor(const float* data, size_t count, vector<uint8_t>& out)
+    {
+        uint64_t bytes = count * sizeof(float);
+        out.clear();
+        out.reserve(bytes + 11);
+        out.push_back(0xd8); // tag, one-byte number follows
+        out.push_back(CBOR_TAG_FLOAT32_LE);
+
+        // Byte string head with the shortest length encoding
+        if (bytes < 24)
+        {
+            out.push_back(static_cast<uint8_t>(0x40 | bytes));
+        }
+        else
+        {
+            int width = bytes <= 0xff ? 1 : bytes <= 0xffff ? 2 : bytes <= 0xffffffffULL ? 4 : 8;
+            out.push_back(static_cast<uint8_t>(0x40 | (width == 1 ? 24 : width == 2 ? 25 : width == 4 ? 26 : 27)));
+            for (int i = width - 1; i >= 0; i--) out.push_back(static_cast<uint8_t>(bytes >> (i * 8)));
+        }
+
+        size_t start = out.size();
+        out.resize(start + static_cast<size_t>(bytes));
+        if (bytes > 0)
+        {
+            memcpy(&out[start], data, static_cast<size_t>(bytes));
+            ConvertLittleEndianFloats(&out[start], count);
+        }
+    }
+
+    bool JsonSerialization::CborToFloats(const uint8_t* data, size_t size, vector<float>& out)
+    {
+        size_t pos = 0;
+        // The tag is optional; a bare byte string is accepted too
+        if (size >= 2 && data[0] == 0xd8)
+        {
+            if (data[1] != CBOR_TAG_FLOAT32_LE) return false;
+            pos = 2;
+        }
+        if (pos >= size || (data[pos] & 0xe0) != 0x40) return false;
+
+        uint8_t info = data[pos++] & 0x1f;
+        uint64_t bytes = info;
+        if (info >= 24)
+        {
+            if (info > 27) return false;
+            size_t width = static_cast<size_t>(1) << (info - 24);
+            if (pos + width > size) return false;
+            bytes = 0;
+            for (size_t i = 0; i < width; i++) bytes = (bytes << 8) | data[pos++];
+        }
+        if (bytes % sizeof(float) != 0 || bytes > size - pos) return false;
+
+        out.resize(static_cast<size_t>(bytes / sizeof(float)));
+        if (bytes > 0)
+        {
+            memcpy(&out[0], data + pos, static_cast<size_t>(bytes));
+            ConvertLittleEndianFloats(&out[0], out.size());
+        }
+        return true;
+    }
+
+    void JsonSerialization::ConvertLittleEndianFloats(void* data, size_t count)
+    {
+#ifdef JSON_FLOATS_SWAP_BYTES
+        uint8_t* bytes = static_cast<uint8_t*>(data);
+        for (size_t i = 0; i < count; i++, bytes += sizeof(float))
+        {
+            std::swap(bytes[0], bytes[3]);
+            std::swap(bytes[1], bytes[2]);
+        }
+#else
+        (void)data;
+        (void)count;
+#endif
+    }
+
+    string JsonSerialization::EncodeBase64(const uint8_t* data, size_t size)
+    {
+        string text;
+        text.resize((size + 2) / 3 * 4);
+        char* dst = &text[0];
+        size_t i = 0;
+        for (; i + 3 <= size; i += 3)
+        {
+            uint32_t v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+            *dst++ = BASE64_ALPHABET[(v >> 18) & 63];
+            *dst++ = BASE64_ALPHABET[(v >> 12) & 63];
+            *dst++ = BASE64_ALPHABET[(v >> 6) & 63];
+            *dst++ = BASE64_ALPHABET[v & 63];
+        }
+        if (i < size)
+        {
+            uint32_t v = data[i] << 16;
+            if (i + 1 < size) v |= data[i + 1] << 8;
+            *dst++ = BASE64_ALPHABET[(v >> 18) & 63];
+            *dst++ = BASE64_ALPHABET[(v >> 12) & 63];
+            *dst++ = i + 1 < size ? BASE64_ALPHABET[(v >> 6) & 63] : '=';
+            *dst++ = '=';
+        }
+        return text;
+    }
+
+    size_t JsonSerialization::GetDecodedBase64Size(const string& text)
+    {
+        if (text.size() % 4 != 0) return 0;
+        size_t size = text.size() / 4 * 3;
+        if (!text.empty() && text[text.size() - 1] == '=') size--;
+        if (text.size() > 1 && text[text.size() - 2] == '=') size--;
+        return size;
+    }
+
+    size_t JsonSerialization::DecodeBase64(const string& text, uint8_t* data, size_t capacity)
+    {
+        size_t size = GetDecodedBase64Size(text);
+        if (size == 0 || size > capacity) return 0;
+
+        const int8_t* table = BASE64_TABLE.values;
+        size_t written = 0;
+        for (size_t i = 0; i < text.size(); i += 4)
+        {
+            // Padding is only valid at the end, and "x=" never is
+            bool last = i + 4 == text.size();
+            int a = table[static_cast<uint8_t>(text[i])];
+            int b = table[static_cast<uint8_t>(text[i + 1])];
+            int c = last && text[i + 2] == '=' && text[i + 3] == '=' ? 0 : table[static_cast<uint8_t>(text[i + 2])];
+            int d = last && text[i + 3] == '=' ? 0 : table[static_cast<uint8_t>(text[i + 3])];
+            if ((a | b | c | d) < 0) return 0;
+
+            uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+            uint8_t bytes[3] = { static_cast<uint8_t>(v >> 16), static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v) };
+            for (int k = 0; k < 3 && written < size; k++) data[written++] = bytes[k];
+        }
+        return written;
+    }
 }
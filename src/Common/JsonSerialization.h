@@ -16,18 +16,32 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <string>
+#include <vector>
 #include <json.hh>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 
 using nlohmann::json;
+using std::string;
+using std::vector;
 using glm::vec2;
 using glm::vec3;
 using glm::vec4;
 
 namespace octronic
 {
+    enum JsonArrayEncoding
+    {
+        // [x, y, z, ...], one JSON node per float
+        JsonArray_Numbers,
+        // {"encoding": "base64", "floats": n, "data": "..."}, the floats
+        // as little-endian IEEE 754 bytes in one string, whatever the host
+        JsonArray_Base64
+    };
+
 	class JsonSerialization
 	{
 	public:
@@ -44,6 +58,63 @@ namespace octronic
         vec4 JsonToVec4(const json& js);
         json Vec4ToJson(const vec4& v);
 
+        /**
+         * @brief Bulk conversion of contiguous floats. Readers accept
+         * either encoding, and number arrays flat or nested ([[x,y],...]),
+         * and fail on any other value or a floats count that disagrees
+         * with the base64 data.
+         */
+        static json FloatsToJson(const float* data, size_t count,
+            JsonArrayEncoding encoding = JsonArray_Base64);
+        /** @return Number of floats js holds, or 0 if it holds none. */
+        static size_t GetFloatCount(const json& js);
+        /** @brief Fills up to capacity floats, setting count to how many. */
+        static bool JsonToFloats(const json& js, float* data, size_t capacity, size_t& count);
+
+        /**
+         * @brief Any array of float-only structs: vec2/3/4, WidgetVertex.
+         * Elements are copied as one block, with no per-element nodes.
+         */
+        template <typename T>
+        static json ArrayToJson(const vector<T>& values, JsonArrayEncoding encoding = JsonArray_Base64)
+        {
+            static_assert(sizeof(T) % sizeof(float) == 0, "ArrayToJson needs float-only elements");
+            return FloatsToJson(values.empty() ? nullptr : reinterpret_cast<const float*>(values.data()),
+                values.size() * (sizeof(T) / sizeof(float)), encoding);
+        }
+
+        template <typename T>
+        static bool JsonToArray(const json& js, vector<T>& values)
+        {
+            static_assert(sizeof(T) % sizeof(float) == 0, "JsonToArray needs float-only elements");
+            const size_t components = sizeof(T) / sizeof(float);
+            size_t floats = GetFloatCount(js);
+            if (floats % components != 0) return false;
+            values.resize(floats / components);
+            size_t count = 0;
+            float* data = values.empty() ? nullptr : reinterpret_cast<float*>(&values[0]);
+            return JsonToFloats(js, data, floats, count) && count == floats;
+        }
+
+        /**
+         * @brief RFC 8746 typed array: tag 85 (float32, little-endian)
+         * around one CBOR byte string, for binary transports.
+         */
+        static void FloatsToCbor(const float* data, size_t count, vector<uint8_t>& out);
+        static bool CborToFloats(const uint8_t* data, size_t size, vector<float>& out);
+
+        /**
+         * @brief Converts count floats in place between host byte order
+         * and the little-endian order of the base64 and CBOR encodings.
+         * Does nothing on little-endian hosts.
+         */
+        static void ConvertLittleEndianFloats(void* data, size_t count);
+
+        static string EncodeBase64(const uint8_t* data, size_t size);
+        /** @return Bytes written, or 0 on malformed input or overflow. */
+        static size_t DecodeBase64(const string& text, uint8_t* data, size_t capacity);
+        static size_t GetDecodedBase64Size(const string& text);
+
 	};
 }
 
@@ -0,0 +1,201 @@
+/*
+* MappedFile
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "Logger.h"
+
+namespace Coconut
+{
+    MappedFile::MappedFile()
+        : mData(nullptr),
+          mSize(0)
+#ifdef _WIN32
+        , mFileHandle(nullptr),
+          mMappingHandle(nullptr)
+#endif
+    {
+    }
+
+    MappedFile::MappedFile(const string& path)
+        : MappedFile()
+    {
+        Map(path);
+    }
+
+    MappedFile::MappedFile(MappedFile&& other)
+        : MappedFile()
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other)
+    {
+        if (this != &other)
+        {
+            Unmap();
+            mData = other.mData;
+            mSize = other.mSize;
+            other.mData = nullptr;
+            other.mSize = 0;
+#ifdef _WIN32
+            mFileHandle = other.mFileHandle;
+            mMappingHandle = other.mMappingHandle;
+            other.mFileHandle = nullptr;
+            other.mMappingHandle = nullptr;
+#endif
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        Unmap();
+    }
+
+    bool MappedFile::Map(const string& path)
+    {
+        Unmap();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            debug("MappedFile: Unable to open {}", path);
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        {
+            error("MappedFile: Unable to map empty file {}", path);
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr)
+        {
+            error("MappedFile: Unable to create mapping for {}", path);
+            CloseHandle(file);
+            return false;
+        }
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr)
+        {
+            error("MappedFile: Unable to map view of {}", path);
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        mFileHandle = file;
+        mMappingHandle = mapping;
+        mData = static_cast<const uint8_t*>(view);
+        mSize = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            debug("MappedFile: Unable to open {}", path);
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            error("MappedFile: Unable to map empty file {}", path);
+            close(fd);
+            return false;
+        }
+
+        void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        // The mapping holds its own reference to the file
+        close(fd);
+
+        if (addr == MAP_FAILED)
+        {
+            error("MappedFile: mmap failed for {}", path);
+            return false;
+        }
+
+        mData = static_cast<const uint8_t*>(addr);
+        mSize = static_cast<size_t>(st.st_size);
+#endif
+        debug("MappedFile: Mapped {} ({} bytes)", path, mSize);
+        return true;
+    }
+
+    void MappedFile::Unmap()
+    {
+        if (mData == nullptr) return;
+#ifdef _WIN32
+        UnmapViewOfFile(mData);
+        CloseHandle(static_cast<HANDLE>(mMappingHandle));
+        CloseHandle(static_cast<HANDLE>(mFileHandle));
+        mMappingHandle = nullptr;
+        mFileHandle = nullptr;
+#else
+        munmap(const_cast<uint8_t*>(mData), mSize);
+#endif
+        mData = nullptr;
+        mSize = 0;
+    }
+
+    void MappedFile::Prefetch() const
+    {
+        if (mData == nullptr) return;
+#ifndef _WIN32
+        void* addr = const_cast<uint8_t*>(mData);
+        posix_madvise(addr, mSize, POSIX_MADV_SEQUENTIAL);
+        posix_madvise(addr, mSize, POSIX_MADV_WILLNEED);
+#endif
+    }
+
+    bool MappedFile::IsMapped() const
+    {
+        return mData != nullptr;
+    }
+
+    const uint8_t* MappedFile::Data() const
+    {
+        return mData;
+    }
+
+    size_t MappedFile::Size() const
+    {
+        return mSize;
+    }
+}
@@ -0,0 +1,66 @@
+/*
+* MappedFile
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using std::string;
+
+namespace Coconut
+{
+    /**
+    * @brief Read-only memory mapping of a whole file. The mapping is
+    * released when the object is destroyed. Move-only.
+    */
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        explicit MappedFile(const string& path);
+        MappedFile(MappedFile&& other);
+        MappedFile& operator=(MappedFile&& other);
+        ~MappedFile();
+
+        bool Map(const string& path);
+        void Unmap();
+
+        /**
+        * @brief Hints that the whole mapping will be read front to back so
+        * the kernel can fault it in with one sequential read-ahead.
+        */
+        void Prefetch() const;
+
+        bool IsMapped() const;
+        const uint8_t* Data() const;
+        size_t Size() const;
+
+    private:
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+    private:
+        const uint8_t* mData;
+        size_t mSize;
+#ifdef _WIN32
+        void* mFileHandle;
+        void* mMappingHandle;
+#endif
+    };
+}
@@ -0,0 +1,80 @@
+/*
+ * MemoryPool.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "MemoryPool.h"
+
+#include <algorithm>
+
+namespace octronic
+{
+    // Every block is aligned as ::operator new aligns the chunk
+    static const size_t MemoryPoolAlignment = alignof(std::max_align_t);
+
+    MemoryPool::MemoryPool(size_t blockSize, size_t blocksPerChunk)
+        : mBlockSize((std::max(blockSize, sizeof(FreeBlock)) + MemoryPoolAlignment - 1) & ~(MemoryPoolAlignment - 1)),
+          mBlocksPerChunk(blocksPerChunk > 0 ? blocksPerChunk : 1),
+          mFree(nullptr),
+          mLive(0)
+    {
+    }
+
+    MemoryPool::~MemoryPool()
+    {
+        for (uint8_t* chunk : mChunks) ::operator delete(chunk);
+    }
+
+    void* MemoryPool::Allocate()
+    {
+        if (mFree == nullptr)
+        {
+            uint8_t* chunk = static_cast<uint8_t*>(::operator new(mBlockSize * mBlocksPerChunk));
+            mChunks.push_back(chunk);
+            // Thread the new blocks onto the free list, first block on top
+            for (size_t i = mBlocksPerChunk; i-- > 0;)
+            {
+                FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + i * mBlockSize);
+                block->next = mFree;
+                mFree = block;
+            }
+        }
+        FreeBlock* block = mFree;
+        mFree = block->next;
+        mLive++;
+        return block;
+    }
+
+    void MemoryPool::Free(void* block)
+    {
+        if (block == nullptr) return;
+        FreeBlock* freed = static_cast<FreeBlock*>(block);
+        freed->next = mFree;
+        mFree = freed;
+        mLive--;
+    }
+
+    size_t MemoryPool::GetBlockSize() const
+    {
+        return mBlockSize;
+    }
+
+    size_t MemoryPool::GetLiveCount() const
+    {
+        return mLive;
+    }
+
+    size_t MemoryPool::GetChunkCount() const
+    {
+        return mChunks.size();
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * MemoryPool.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+using std::vector;
+
+#define MEMORY_POOL_BLOCKS_PER_CHUNK 64
+
+namespace octronic
+{
+    /**
+     * @brief Fixed-size blocks carved from chunks of blocksPerChunk, with
+     * freed blocks kept on a free list for reuse. Chunks are only returned
+     * when the pool is destroyed, so once a pool has grown to its working
+     * set, Allocate and Free never reach the heap. Blocks are aligned for
+     * any type. Not thread safe.
+     */
+    class MemoryPool
+    {
+    public:
+        MemoryPool(size_t blockSize, size_t blocksPerChunk = MEMORY_POOL_BLOCKS_PER_CHUNK);
+        ~MemoryPool();
+
+        void* Allocate();
+        void Free(void* block);
+
+        size_t GetBlockSize() const;
+        size_t GetLiveCount() const;
+        size_t GetChunkCount() const;
+
+    private:
+        MemoryPool(const MemoryPool&);
+        MemoryPool& operator=(const MemoryPool&);
+
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        size_t mBlockSize;
+        size_t mBlocksPerChunk;
+        vector<uint8_t*> mChunks;
+        FreeBlock* mFree;
+        size_t mLive;
+    };
+
+    /**
+     * @brief Standard allocator that takes single-object allocations, such
+     * as the nodes of a list or unordered_map, from a MemoryPool shared by
+     * every PoolAllocator of the same T. Arrays (hash buckets) still come
+     * from the heap. Render thread only.
+     */
+    template <typename T>
+    class PoolAllocator
+    {
+    public:
+        typedef T value_type;
+
+        PoolAllocator() {}
+        template <typename U>
+        PoolAllocator(const PoolAllocator<U>&) {}
+
+        T* allocate(size_t count)
+        {
+            if (count == 1) return static_cast<T*>(GetPool().Allocate());
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+
+        void deallocate(T* pointer, size_t count)
+        {
+            if (count == 1) GetPool().Free(pointer);
+            else ::operator delete(pointer);
+        }
+
+        template <typename U>
+        bool operator==(const PoolAllocator<U>&) const { return true; }
+        template <typename U>
+        bool operator!=(const PoolAllocator<U>&) const { return false; }
+
+    private:
+        static MemoryPool& GetPool()
+        {
+            static MemoryPool pool(sizeof(T));
+            return pool;
+        }
+    };
+}
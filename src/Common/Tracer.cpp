@@ -0,0 +1,299 @@
+/*
+ * Tracer.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "Tracer.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Logger.h"
+
+using std::atomic;
+using std::lock_guard;
+using std::mutex;
+using std::unique_ptr;
+using std::vector;
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+// Bounds memory when per-frame zones run for a long time
+#define TRACER_MAX_EVENTS_PER_THREAD (1 << 20)
+
+namespace octronic
+{
+    struct TraceEvent
+    {
+        const char* name;
+        string detail;
+        uint64_t start;
+        uint64_t duration;
+    };
+
+    struct TraceThreadBuffer
+    {
+        uint32_t id;
+        string name;
+        mutex lock;
+        vector<TraceEvent> events;
+        size_t dropped;
+    };
+
+    static atomic<bool> TracingEnabled(false);
+    static volatile sig_atomic_t WriteRequested = 0;
+
+    // Registry of every thread that has recorded a zone. Buffers outlive
+    // their threads so a late export still sees them.
+    struct TraceRegistry
+    {
+        mutex lock;
+        vector<unique_ptr<TraceThreadBuffer>> buffers;
+        steady_clock::time_point epoch;
+        string outputPath;
+    };
+
+    static TraceRegistry& Registry()
+    {
+        static TraceRegistry registry;
+        return registry;
+    }
+
+    static thread_local TraceThreadBuffer* ThreadBuffer = nullptr;
+
+    static TraceThreadBuffer* GetThreadBuffer()
+    {
+        if (ThreadBuffer == nullptr)
+        {
+            TraceRegistry& registry = Registry();
+            lock_guard<mutex> lock(registry.lock);
+            unique_ptr<TraceThreadBuffer> buffer(new TraceThreadBuffer());
+            buffer->id = static_cast<uint32_t>(registry.buffers.size() + 1);
+            buffer->dropped = 0;
+            ThreadBuffer = buffer.get();
+            registry.buffers.push_back(std::move(buffer));
+        }
+        return ThreadBuffer;
+    }
+
+#ifndef _WIN32
+    static void OnTraceSignal(int)
+    {
+        Tracer::RequestWrite();
+    }
+#endif
+
+    static void AppendEscaped(string& out, const string& text)
+    {
+        for (char c : text)
+        {
+            switch (c)
+            {
+                case '"':  out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n";  break;
+                case '\t': out += "\\t";  break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        char code[8];
+                        snprintf(code, sizeof(code), "\\u%04x", c);
+                        out += code;
+                    }
+                    else
+                    {
+                        out += c;
+                    }
+            }
+        }
+    }
+
+    // Chrome wants microseconds; keep the nanoseconds as the fraction
+    static void AppendMicroseconds(string& out, uint64_t ns)
+    {
+        char text[32];
+        snprintf(text, sizeof(text), "%llu.%03u",
+            static_cast<unsigned long long>(ns / 1000), static_cast<unsigned>(ns % 1000));
+        out += text;
+    }
+
+    void Tracer::Enable(const string& outputPath)
+    {
+        TraceRegistry& registry = Registry();
+        {
+            lock_guard<mutex> lock(registry.lock);
+            registry.epoch = steady_clock::now();
+            registry.outputPath = outputPath;
+        }
+#ifndef _WIN32
+        signal(SIGUSR1, OnTraceSignal);
+#endif
+        TracingEnabled = true;
+        info("Tracer: Recording, writing to {} on exit or SIGUSR1", outputPath);
+    }
+
+    void Tracer::Disable()
+    {
+        TracingEnabled = false;
+    }
+
+    bool Tracer::IsEnabled()
+    {
+        return TracingEnabled.load(std::memory_order_relaxed);
+    }
+
+    uint64_t Tracer::Now()
+    {
+        return static_cast<uint64_t>(
+            duration_cast<nanoseconds>(steady_clock::now() - Registry().epoch).count());
+    }
+
+    void Tracer::Record(const char* name, const string* detail, uint64_t start, uint64_t end)
+    {
+        TraceThreadBuffer* buffer = GetThreadBuffer();
+        lock_guard<mutex> lock(buffer->lock);
+        if (buffer->events.size() >= TRACER_MAX_EVENTS_PER_THREAD)
+        {
+            buffer->dropped++;
+            return;
+        }
+        buffer->events.push_back(TraceEvent());
+        TraceEvent& event = buffer->events.back();
+        event.name = name;
+        if (detail != nullptr) event.detail = *detail;
+        event.start = start;
+        event.duration = end - start;
+    }
+
+    void Tracer::SetThreadName(const string& name)
+    {
+        TraceThreadBuffer* buffer = GetThreadBuffer();
+        lock_guard<mutex> lock(buffer->lock);
+        buffer->name = name;
+    }
+
+    bool Tracer::WriteChromeTrace()
+    {
+        string path;
+        {
+            TraceRegistry& registry = Registry();
+            lock_guard<mutex> lock(registry.lock);
+            path = registry.outputPath;
+        }
+        if (path.empty()) return false;
+        return WriteChromeTrace(path);
+    }
+
+    bool Tracer::WriteChromeTrace(const string& path)
+    {
+        string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        size_t eventCount = 0;
+        size_t dropped = 0;
+        bool first = true;
+
+        TraceRegistry& registry = Registry();
+        lock_guard<mutex> registryLock(registry.lock);
+        for (auto& buffer : registry.buffers)
+        {
+            lock_guard<mutex> lock(buffer->lock);
+            string tid = std::to_string(buffer->id);
+
+            if (!buffer->name.empty())
+            {
+                if (!first) json += ',';
+                first = false;
+                json += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + tid + ",\"args\":{\"name\":\"";
+                AppendEscaped(json, buffer->name);
+                json += "\"}}";
+            }
+
+            for (const TraceEvent& event : buffer->events)
+            {
+                if (!first) json += ',';
+                first = false;
+                json += "\n{\"ph\":\"X\",\"pid\":1,\"tid\":" + tid + ",\"name\":\"";
+                AppendEscaped(json, event.name);
+                json += "\",\"ts\":";
+                AppendMicroseconds(json, event.start);
+                json += ",\"dur\":";
+                AppendMicroseconds(json, event.duration);
+                if (!event.detail.empty())
+                {
+                    json += ",\"args\":{\"detail\":\"";
+                    AppendEscaped(json, event.detail);
+                    json += "\"}";
+                }
+                json += '}';
+            }
+            eventCount += buffer->events.size();
+            dropped += buffer->dropped;
+        }
+        json += "\n]}\n";
+
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            error("Tracer: Unable to open {} for writing", path);
+            return false;
+        }
+        bool written = fwrite(json.data(), 1, json.size(), file) == json.size();
+        fclose(file);
+
+        if (written)
+        {
+            info("Tracer: Wrote {} zones from {} threads to {}", eventCount, registry.buffers.size(), path);
+        }
+        if (dropped > 0)
+        {
+            warn("Tracer: {} zones were dropped after the per-thread limit", dropped);
+        }
+        return written;
+    }
+
+    void Tracer::RequestWrite()
+    {
+        WriteRequested = 1;
+    }
+
+    void Tracer::WritePendingRequest()
+    {
+        if (WriteRequested == 0) return;
+        WriteRequested = 0;
+        WriteChromeTrace();
+    }
+
+    TraceScope::TraceScope(const char* name)
+        : mName(name),
+          mActive(Tracer::IsEnabled()),
+          mStart(mActive ? Tracer::Now() : 0)
+    {
+    }
+
+    TraceScope::TraceScope(const char* name, const string& detail)
+        : mName(name),
+          mActive(Tracer::IsEnabled()),
+          mStart(mActive ? Tracer::Now() : 0)
+    {
+        if (mActive) mDetail = detail;
+    }
+
+    TraceScope::~TraceScope()
+    {
+        if (!mActive || !Tracer::IsEnabled()) return;
+        Tracer::Record(mName, mDetail.empty() ? nullptr : &mDetail, mStart, Tracer::Now());
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * Tracer.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+using std::string;
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+/**
+ * Times the enclosing scope as a named zone. name must be a string literal
+ * or otherwise outlive the trace. Costs one branch while tracing is off.
+ */
+#define TRACE_SCOPE(name) \
+    octronic::TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+
+/**
+ * As TRACE_SCOPE, with a per-instance detail string (e.g. a file name)
+ * shown in the zone's arguments.
+ */
+#define TRACE_SCOPE_DETAIL(name, detail) \
+    octronic::TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name, detail)
+
+namespace octronic
+{
+    /**
+     * @brief Records timed zones into per-thread buffers and exports them
+     * as Chrome trace-event JSON (chrome://tracing, Perfetto). Timestamps
+     * are nanoseconds on the steady clock since the tracer was enabled.
+     */
+    class Tracer
+    {
+    public:
+        /**
+         * @brief Starts recording. outputPath is where WriteChromeTrace()
+         * and on-demand requests write to.
+         */
+        static void Enable(const string& outputPath);
+        static void Disable();
+        static bool IsEnabled();
+
+        static uint64_t Now();
+        static void Record(const char* name, const string* detail, uint64_t start, uint64_t end);
+
+        /**
+         * @brief Names the calling thread in the exported trace.
+         */
+        static void SetThreadName(const string& name);
+
+        static bool WriteChromeTrace();
+        static bool WriteChromeTrace(const string& path);
+
+        /**
+         * @brief Asks for a trace to be written at the next
+         * WritePendingRequest. Async-signal-safe; SIGUSR1 calls it on POSIX.
+         */
+        static void RequestWrite();
+        static void WritePendingRequest();
+    };
+
+    class TraceScope
+    {
+    public:
+        explicit TraceScope(const char* name);
+        TraceScope(const char* name, const string& detail);
+        ~TraceScope();
+
+    private:
+        TraceScope(const TraceScope&);
+        TraceScope& operator=(const TraceScope&);
+
+        const char* mName;
+        bool mActive;
+        uint64_t mStart;
+        string mDetail;
+    };
+}
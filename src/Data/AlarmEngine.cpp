@@ -0,0 +1,280 @@
+/*
+ * AlarmEngine.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "AlarmEngine.h"
+
+#include <limits>
+#include "DataChannel.h"
+#include "../Common/Logger.h"
+#include "../Common/Tracer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define ALARM_ENGINE_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define ALARM_ENGINE_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace octronic
+{
+    AlarmLimits::AlarmLimits()
+        : lowCritical(-std::numeric_limits<float>::infinity()),
+          lowWarning(-std::numeric_limits<float>::infinity()),
+          highWarning(std::numeric_limits<float>::infinity()),
+          highCritical(std::numeric_limits<float>::infinity()),
+          hysteresis(0.0f)
+    {
+    }
+
+    // Same compares as the vector paths: a NaN value is in no band
+    static inline int32_t ClassifyLevel(float value, float lowCritical, float lowWarning,
+        float highWarning, float highCritical, float hysteresis, int32_t level)
+    {
+        float warningRelax = level > AlarmLevel_Normal ? hysteresis : 0.0f;
+        float criticalRelax = level > AlarmLevel_Warning ? hysteresis : 0.0f;
+        int32_t warning = (value >= highWarning - warningRelax || value <= lowWarning + warningRelax) ? 1 : 0;
+        int32_t critical = (value >= highCritical - criticalRelax || value <= lowCritical + criticalRelax) ? 1 : 0;
+        return warning + critical;
+    }
+
+    static inline void AddEvent(vector<AlarmEvent>& events, size_t alarm, int32_t previous, int32_t level)
+    {
+        AlarmEvent event;
+        event.alarm = static_cast<uint32_t>(alarm);
+        event.channel = nullptr;
+        event.previous = static_cast<AlarmLevel>(previous);
+        event.level = static_cast<AlarmLevel>(level);
+        events.push_back(event);
+    }
+
+    AlarmEngine::AlarmEngine()
+    {
+    }
+
+    int AlarmEngine::Add(DataChannel* channel, const AlarmLimits& limits)
+    {
+        if (channel == nullptr) return -1;
+        if (!(limits.lowCritical <= limits.lowWarning &&
+              limits.lowWarning <= limits.highWarning &&
+              limits.highWarning <= limits.highCritical &&
+              limits.hysteresis >= 0.0f))
+        {
+            error("AlarmEngine: Limits of '{}' are not ordered", channel->GetName());
+            return -1;
+        }
+
+        int alarm = Find(channel);
+        if (alarm < 0)
+        {
+            alarm = static_cast<int>(mChannels.size());
+            uint32_t id = channel->GetId();
+            if (mAlarmByChannel.size() <= id) mAlarmByChannel.resize(id + 1, -1);
+            mAlarmByChannel[id] = alarm;
+            mChannels.push_back(channel);
+            mValues.push_back(0.0f);
+            mLowCritical.push_back(0.0f);
+            mLowWarning.push_back(0.0f);
+            mHighWarning.push_back(0.0f);
+            mHighCritical.push_back(0.0f);
+            mHysteresis.push_back(0.0f);
+            mLevels.push_back(AlarmLevel_Normal);
+            mHandlers.push_back(vector<AlarmHandler>());
+        }
+
+        mLowCritical[alarm] = limits.lowCritical;
+        mLowWarning[alarm] = limits.lowWarning;
+        mHighWarning[alarm] = limits.highWarning;
+        mHighCritical[alarm] = limits.highCritical;
+        mHysteresis[alarm] = limits.hysteresis;
+        debug("AlarmEngine: Alarm {} on '{}'", alarm, channel->GetName());
+        return alarm;
+    }
+
+    int AlarmEngine::Find(const DataChannel* channel) const
+    {
+        if (channel == nullptr || channel->GetId() >= mAlarmByChannel.size()) return -1;
+        return mAlarmByChannel[channel->GetId()];
+    }
+
+    bool AlarmEngine::Subscribe(const DataChannel* channel, AlarmHandler handler)
+    {
+        int alarm = Find(channel);
+        if (alarm < 0) return false;
+        mHandlers[alarm].push_back(handler);
+        // Bring a late subscriber up to date
+        if (mLevels[alarm] != AlarmLevel_Normal)
+        {
+            AlarmEvent event;
+            event.alarm = static_cast<uint32_t>(alarm);
+            event.channel = mChannels[alarm];
+            event.previous = AlarmLevel_Normal;
+            event.level = static_cast<AlarmLevel>(mLevels[alarm]);
+            handler(event);
+        }
+        return true;
+    }
+
+    void AlarmEngine::Clear()
+    {
+        mChannels.clear();
+        mValues.clear();
+        mLowCritical.clear();
+        mLowWarning.clear();
+        mHighWarning.clear();
+        mHighCritical.clear();
+        mHysteresis.clear();
+        mLevels.clear();
+        mHandlers.clear();
+        mAlarmByChannel.clear();
+        mEvents.clear();
+    }
+
+    size_t AlarmEngine::Evaluate()
+    {
+        mEvents.clear();
+        if (mChannels.empty()) return 0;
+        TRACE_SCOPE("AlarmEngine::Evaluate");
+
+        const float noValue = std::numeric_limits<float>::quiet_NaN();
+        for (size_t i = 0; i < mChannels.size(); i++)
+        {
+            DataSample sample;
+            mValues[i] = mChannels[i]->GetLatest(sample) ? sample.value : noValue;
+        }
+
+        EvaluateLevels(mValues.data(), mLowCritical.data(), mLowWarning.data(),
+            mHighWarning.data(), mHighCritical.data(), mHysteresis.data(),
+            mLevels.data(), mLevels.size(), mEvents);
+
+        for (AlarmEvent& event : mEvents)
+        {
+            event.channel = mChannels[event.alarm];
+            for (const AlarmHandler& handler : mHandlers[event.alarm]) handler(event);
+        }
+        return mEvents.size();
+    }
+
+    void AlarmEngine::EvaluateLevels(const float* values, const float* lowCritical, const float* lowWarning,
+        const float* highWarning, const float* highCritical, const float* hysteresis,
+        int32_t* levels, size_t count, vector<AlarmEvent>& events)
+    {
+        size_t i = 0;
+#if defined(ALARM_ENGINE_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi32(1);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 value = _mm_loadu_ps(values + i);
+            __m128 band = _mm_loadu_ps(hysteresis + i);
+            __m128i level = _mm_loadu_si128(reinterpret_cast<const __m128i*>(levels + i));
+
+            // Relax a threshold by the hysteresis while its level is held
+            __m128 warningRelax = _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(level, zero)), band);
+            __m128 criticalRelax = _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(level, one)), band);
+            __m128 warning = _mm_or_ps(
+                _mm_cmpge_ps(value, _mm_sub_ps(_mm_loadu_ps(highWarning + i), warningRelax)),
+                _mm_cmple_ps(value, _mm_add_ps(_mm_loadu_ps(lowWarning + i), warningRelax)));
+            __m128 critical = _mm_or_ps(
+                _mm_cmpge_ps(value, _mm_sub_ps(_mm_loadu_ps(highCritical + i), criticalRelax)),
+                _mm_cmple_ps(value, _mm_add_ps(_mm_loadu_ps(lowCritical + i), criticalRelax)));
+
+            // Masks are -1, so 0 - warning - critical counts the bands
+            __m128i next = _mm_sub_epi32(_mm_sub_epi32(zero, _mm_castps_si128(warning)), _mm_castps_si128(critical));
+            int changed = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(next, level))) ^ 0xF;
+            if (changed != 0)
+            {
+                int32_t previous[4];
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(previous), level);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(levels + i), next);
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    if (changed & (1 << lane)) AddEvent(events, i + lane, previous[lane], levels[i + lane]);
+                }
+            }
+        }
+#elif defined(ALARM_ENGINE_NEON)
+        const int32x4_t zero = vdupq_n_s32(0);
+        const int32x4_t one = vdupq_n_s32(1);
+        for (; i + 4 <= count; i += 4)
+        {
+            float32x4_t value = vld1q_f32(values + i);
+            uint32x4_t band = vreinterpretq_u32_f32(vld1q_f32(hysteresis + i));
+            int32x4_t level = vld1q_s32(levels + i);
+
+            float32x4_t warningRelax = vreinterpretq_f32_u32(vandq_u32(vcgtq_s32(level, zero), band));
+            float32x4_t criticalRelax = vreinterpretq_f32_u32(vandq_u32(vcgtq_s32(level, one), band));
+            uint32x4_t warning = vorrq_u32(
+                vcgeq_f32(value, vsubq_f32(vld1q_f32(highWarning + i), warningRelax)),
+                vcleq_f32(value, vaddq_f32(vld1q_f32(lowWarning + i), warningRelax)));
+            uint32x4_t critical = vorrq_u32(
+                vcgeq_f32(value, vsubq_f32(vld1q_f32(highCritical + i), criticalRelax)),
+                vcleq_f32(value, vaddq_f32(vld1q_f32(lowCritical + i), criticalRelax)));
+
+            int32x4_t next = vsubq_s32(vsubq_s32(zero, vreinterpretq_s32_u32(warning)), vreinterpretq_s32_u32(critical));
+            uint32x4_t differs = vmvnq_u32(vceqq_s32(next, level));
+            uint32x2_t any = vorr_u32(vget_low_u32(differs), vget_high_u32(differs));
+            if (vget_lane_u32(vpmax_u32(any, any), 0) != 0)
+            {
+                int32_t previous[4];
+                vst1q_s32(previous, level);
+                vst1q_s32(levels + i, next);
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    if (levels[i + lane] != previous[lane]) AddEvent(events, i + lane, previous[lane], levels[i + lane]);
+                }
+            }
+        }
+#endif
+        for (; i < count; i++)
+        {
+            int32_t next = ClassifyLevel(values[i], lowCritical[i], lowWarning[i],
+                highWarning[i], highCritical[i], hysteresis[i], levels[i]);
+            if (next != levels[i])
+            {
+                AddEvent(events, i, levels[i], next);
+                levels[i] = next;
+            }
+        }
+    }
+
+    size_t AlarmEngine::GetAlarmCount() const
+    {
+        return mChannels.size();
+    }
+
+    AlarmLevel AlarmEngine::GetLevel(size_t alarm) const
+    {
+        return alarm < mLevels.size() ? static_cast<AlarmLevel>(mLevels[alarm]) : AlarmLevel_Normal;
+    }
+
+    AlarmLimits AlarmEngine::GetLimits(size_t alarm) const
+    {
+        AlarmLimits limits;
+        if (alarm >= mChannels.size()) return limits;
+        limits.lowCritical = mLowCritical[alarm];
+        limits.lowWarning = mLowWarning[alarm];
+        limits.highWarning = mHighWarning[alarm];
+        limits.highCritical = mHighCritical[alarm];
+        limits.hysteresis = mHysteresis[alarm];
+        return limits;
+    }
+
+    const vector<AlarmEvent>& AlarmEngine::GetEvents() const
+    {
+        return mEvents;
+    }
+}
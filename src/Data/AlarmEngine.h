@@ -0,0 +1,134 @@
+/*
+ * AlarmEngine.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+using std::function;
+using std::vector;
+
+namespace octronic
+{
+    class DataChannel;
+
+    enum AlarmLevel
+    {
+        AlarmLevel_Normal   = 0,
+        AlarmLevel_Warning  = 1,
+        AlarmLevel_Critical = 2
+    };
+
+    /**
+     * @brief Limits of one channel. A level is entered when the value
+     * reaches its threshold and left once the value is back by more than
+     * hysteresis. Unused thresholds are infinite. Thresholds must be
+     * ordered lowCritical <= lowWarning <= highWarning <= highCritical.
+     */
+    struct AlarmLimits
+    {
+        AlarmLimits();
+
+        float lowCritical;
+        float lowWarning;
+        float highWarning;
+        float highCritical;
+        float hysteresis;
+    };
+
+    struct AlarmEvent
+    {
+        uint32_t alarm;
+        DataChannel* channel;
+        AlarmLevel previous;
+        AlarmLevel level;
+    };
+
+    typedef function<void(const AlarmEvent&)> AlarmHandler;
+
+    /**
+     * @brief Evaluates the latest value of every alarmed channel against
+     * its limits, once per frame after the drain.
+     *
+     * Limits and levels are kept as structure-of-arrays so a tick is a run
+     * of 4-wide compares (SSE2 or NEON, scalar otherwise) with no per-alarm
+     * branching. Handlers are only called for alarms whose level changed,
+     * so a dashboard where nothing crosses a limit does no per-widget work.
+     *
+     * Render thread only. A channel without a value yet is Normal.
+     */
+    class AlarmEngine
+    {
+    public:
+        AlarmEngine();
+
+        /**
+         * @brief Adds an alarm on channel, or replaces the limits of its
+         * existing one.
+         * @return The alarm index, or -1 if the limits are not ordered.
+         */
+        int Add(DataChannel* channel, const AlarmLimits& limits);
+
+        /** @return The channel's alarm index, or -1. */
+        int Find(const DataChannel* channel) const;
+
+        /**
+         * @brief Calls handler on every level change of channel's alarm.
+         * @return false if channel has no alarm.
+         */
+        bool Subscribe(const DataChannel* channel, AlarmHandler handler);
+
+        void Clear();
+
+        /**
+         * @brief Gathers latest values, updates every level and dispatches
+         * the transitions.
+         * @return The number of transitions.
+         */
+        size_t Evaluate();
+
+        size_t GetAlarmCount() const;
+        AlarmLevel GetLevel(size_t alarm) const;
+        AlarmLimits GetLimits(size_t alarm) const;
+
+        /** @brief Transitions found by the last Evaluate. */
+        const vector<AlarmEvent>& GetEvents() const;
+
+        /**
+         * @brief The level kernel, exposed for testing: updates levels[i]
+         * from values[i] and the limits, appending an event (alarm i,
+         * channel unset) for every level that changes.
+         */
+        static void EvaluateLevels(const float* values, const float* lowCritical, const float* lowWarning,
+            const float* highWarning, const float* highCritical, const float* hysteresis,
+            int32_t* levels, size_t count, vector<AlarmEvent>& events);
+
+    private:
+        vector<DataChannel*> mChannels;
+        vector<float> mValues;
+        vector<float> mLowCritical;
+        vector<float> mLowWarning;
+        vector<float> mHighWarning;
+        vector<float> mHighCritical;
+        vector<float> mHysteresis;
+        vector<int32_t> mLevels;
+        vector<vector<AlarmHandler>> mHandlers;
+        // Alarm index by channel id, -1 for none
+        vector<int32_t> mAlarmByChannel;
+        vector<AlarmEvent> mEvents;
+    };
+}
@@ -0,0 +1,56 @@
+/*
+ * CacheAligned.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+    #include <malloc.h>
+#endif
+#include "DataSample.h"
+
+namespace octronic
+{
+    /**
+     * @brief Base for classes with alignas(DATA_CACHE_LINE_SIZE) members.
+     * C++11 operator new only aligns to alignof(max_align_t), which would
+     * put those members back on shared cache lines, so heap instances are
+     * allocated with posix_memalign, or _aligned_malloc on Windows, instead.
+     */
+    struct CacheAligned
+    {
+        static void* operator new(size_t size)
+        {
+#ifdef _WIN32
+            void* memory = _aligned_malloc(size, DATA_CACHE_LINE_SIZE);
+            if (memory == nullptr) throw std::bad_alloc();
+#else
+            void* memory = nullptr;
+            if (posix_memalign(&memory, DATA_CACHE_LINE_SIZE, size) != 0) throw std::bad_alloc();
+#endif
+            return memory;
+        }
+
+        static void operator delete(void* memory)
+        {
+#ifdef _WIN32
+            _aligned_free(memory);
+#else
+            free(memory);
+#endif
+        }
+    };
+}
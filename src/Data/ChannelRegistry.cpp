@@ -0,0 +1,81 @@
+/*
+ * ChannelRegistry.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "ChannelRegistry.h"
+
+#include "../Common/Logger.h"
+
+using std::lock_guard;
+
+namespace octronic
+{
+    ChannelRegistry::ChannelRegistry()
+        : mChannelCount(0)
+    {
+    }
+
+    DataChannel* ChannelRegistry::Create(const string& name,
+        DataChannelProducers producers, size_t capacity)
+    {
+        lock_guard<mutex> lock(mMutex);
+        auto existing = mChannelsByName.find(name);
+        if (existing != mChannelsByName.end()) return existing->second;
+
+        uint32_t id = mChannelCount.load(std::memory_order_relaxed);
+        if (id >= CHANNEL_REGISTRY_MAX_CHANNELS)
+        {
+            error("ChannelRegistry: Cannot create '{}', all {} channels are in use",
+                  name, CHANNEL_REGISTRY_MAX_CHANNELS);
+            return nullptr;
+        }
+
+        DataChannel* channel = new DataChannel(id, name, producers, capacity);
+        mChannels[id].reset(channel);
+        mChannelsByName[name] = channel;
+        // Publish only once the slot is filled
+        mChannelCount.store(id + 1, std::memory_order_release);
+        debug("ChannelRegistry: Created channel {} '{}' ({} producer)", id, name,
+              producers == DataChannel_SingleProducer ? "single" : "multi");
+        return channel;
+    }
+
+    DataChannel* ChannelRegistry::Find(const string& name) const
+    {
+        lock_guard<mutex> lock(mMutex);
+        auto itr = mChannelsByName.find(name);
+        return itr == mChannelsByName.end() ? nullptr : itr->second;
+    }
+
+    DataChannel* ChannelRegistry::Find(uint32_t id) const
+    {
+        if (id >= mChannelCount.load(std::memory_order_acquire)) return nullptr;
+        return mChannels[id].get();
+    }
+
+    size_t ChannelRegistry::GetChannelCount() const
+    {
+        return mChannelCount.load(std::memory_order_acquire);
+    }
+
+    size_t ChannelRegistry::DrainAll()
+    {
+        uint32_t count = mChannelCount.load(std::memory_order_acquire);
+        size_t total = 0;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            total += mChannels[i]->Drain();
+        }
+        return total;
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * ChannelRegistry.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "DataChannel.h"
+
+using std::atomic;
+using std::map;
+using std::mutex;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+#define CHANNEL_REGISTRY_MAX_CHANNELS 4096
+
+namespace octronic
+{
+    /**
+     * @brief Owns every DataChannel. Channels are never destroyed while
+     * the registry lives, so the pointers handed out stay valid for
+     * producers and widgets alike. Ids are dense, starting at 0, for
+     * ingest paths that address channels by number; Find by id and
+     * DrainAll are lock-free, only creation and name lookup take a mutex.
+     */
+    class ChannelRegistry
+    {
+    public:
+        ChannelRegistry();
+
+        /**
+         * @brief Returns the named channel, creating it if needed. The
+         * producer mode and capacity of an existing channel are kept.
+         */
+        DataChannel* Create(const string& name,
+            DataChannelProducers producers = DataChannel_MultiProducer,
+            size_t capacity = DATA_CHANNEL_DEFAULT_CAPACITY);
+
+        DataChannel* Find(const string& name) const;
+        DataChannel* Find(uint32_t id) const;
+        size_t GetChannelCount() const;
+
+        /**
+         * @brief Render thread, once per frame before widgets update.
+         * @return The total number of samples drained.
+         */
+        size_t DrainAll();
+
+    private:
+        mutable mutex mMutex;
+        unique_ptr<DataChannel> mChannels[CHANNEL_REGISTRY_MAX_CHANNELS];
+        atomic<uint32_t> mChannelCount;
+        map<string, DataChannel*> mChannelsByName;
+    };
+}
@@ -0,0 +1,112 @@
+/*
+ * DataChannel.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "DataChannel.h"
+
+namespace octronic
+{
+    DataChannel::DataChannel(uint32_t id, const string& name, DataChannelProducers producers, size_t capacity)
+        : mId(id),
+          mName(name),
+          mDropped(0)
+    {
+        if (producers == DataChannel_SingleProducer)
+        {
+            mSpscRing.reset(new SpscRing<DataSample>(capacity));
+            mFrameSamples.reserve(mSpscRing->GetCapacity());
+        }
+        else
+        {
+            mMpscRing.reset(new MpscRing<DataSample>(capacity));
+            mFrameSamples.reserve(mMpscRing->GetCapacity());
+        }
+    }
+
+    uint32_t DataChannel::GetId() const
+    {
+        return mId;
+    }
+
+    const string& DataChannel::GetName() const
+    {
+        return mName;
+    }
+
+    size_t DataChannel::GetCapacity() const
+    {
+        return mSpscRing ? mSpscRing->GetCapacity() : mMpscRing->GetCapacity();
+    }
+
+    bool DataChannel::Push(const DataSample& sample)
+    {
+        // A single producer is the latest value's only writer
+        if (mSpscRing) mLatest.Store(sample);
+        bool queued = mSpscRing ? mSpscRing->TryPush(sample) : mMpscRing->TryPush(sample);
+        if (!queued) mDropped.fetch_add(1, std::memory_order_relaxed);
+        return queued;
+    }
+
+    bool DataChannel::Push(double timestamp, float value)
+    {
+        DataSample sample;
+        sample.timestamp = timestamp;
+        sample.value = value;
+        sample.reserved = 0;
+        return Push(sample);
+    }
+
+    size_t DataChannel::Drain()
+    {
+        mFrameSamples.clear();
+        size_t maxItems = GetCapacity();
+        size_t count = mSpscRing ?
+            mSpscRing->PopBatch(mFrameSamples, maxItems) :
+            mMpscRing->PopBatch(mFrameSamples, maxItems);
+        if (mHistory && count > 0) mHistory->Append(mFrameSamples.data(), count);
+        // With several producers the render thread is the only writer
+        if (mMpscRing && count > 0) mLatest.Store(mFrameSamples[count - 1]);
+        return count;
+    }
+
+    void DataChannel::EnableHistory(size_t capacity)
+    {
+        if (mHistory && mHistory->GetCapacity() >= capacity) return;
+        mHistory.reset(new MinMaxPyramid(capacity));
+    }
+
+    const MinMaxPyramid* DataChannel::GetHistory() const
+    {
+        return mHistory.get();
+    }
+
+    const vector<DataSample>& DataChannel::GetFrameSamples() const
+    {
+        return mFrameSamples;
+    }
+
+    bool DataChannel::GetLatest(DataSample& sample) const
+    {
+        return mLatest.Load(sample);
+    }
+
+    uint64_t DataChannel::GetVersion() const
+    {
+        return mLatest.GetVersion();
+    }
+
+    uint64_t DataChannel::GetDroppedCount() const
+    {
+        return mDropped.load(std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * DataChannel.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "CacheAligned.h"
+#include "DataSample.h"
+#include "LatestValue.h"
+#include "MinMaxPyramid.h"
+#include "MpscRing.h"
+#include "SpscRing.h"
+
+using std::atomic;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+#define DATA_CHANNEL_DEFAULT_CAPACITY 1024
+
+namespace octronic
+{
+    enum DataChannelProducers
+    {
+        DataChannel_SingleProducer,
+        DataChannel_MultiProducer
+    };
+
+    /**
+     * @brief A named stream of samples from acquisition threads to the
+     * renderer. Push never blocks: when the ring is full the sample is
+     * dropped from the history and counted. The render thread drains the
+     * ring once per frame with Drain; widgets then read GetFrameSamples
+     * and GetLatest.
+     *
+     * GetLatest's value has one writer. With a single producer that is
+     * the producer, on every Push, so even a dropped sample becomes the
+     * latest value. With several it is the render thread, which publishes
+     * the last drained sample in Drain.
+     */
+    class DataChannel : public CacheAligned
+    {
+    public:
+        DataChannel(uint32_t id, const string& name, DataChannelProducers producers, size_t capacity);
+
+        uint32_t GetId() const;
+        const string& GetName() const;
+        /** @brief Samples the ring holds between drains. */
+        size_t GetCapacity() const;
+
+        // Producer side ########################################################
+
+        bool Push(const DataSample& sample);
+        bool Push(double timestamp, float value);
+
+        // Consumer side, render thread ########################################
+
+        /**
+         * @brief Moves everything queued since the last call into the frame
+         * sample buffer.
+         * @return The number of samples drained.
+         */
+        size_t Drain();
+
+        const vector<DataSample>& GetFrameSamples() const;
+        bool GetLatest(DataSample& sample) const;
+        uint64_t GetVersion() const;
+        uint64_t GetDroppedCount() const;
+
+        /**
+         * @brief Keeps a min/max pyramid of the last capacity samples,
+         * extended by every Drain. Used by plots of long time ranges.
+         */
+        void EnableHistory(size_t capacity);
+        const MinMaxPyramid* GetHistory() const;
+
+    private:
+        uint32_t mId;
+        string mName;
+        unique_ptr<SpscRing<DataSample>> mSpscRing;
+        unique_ptr<MpscRing<DataSample>> mMpscRing;
+        LatestValue<DataSample> mLatest;
+        atomic<uint64_t> mDropped;
+        vector<DataSample> mFrameSamples;
+        unique_ptr<MinMaxPyramid> mHistory;
+    };
+}
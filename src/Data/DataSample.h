@@ -0,0 +1,36 @@
+/*
+ * DataSample.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// Keeps producer and consumer indices on separate cache lines
+#define DATA_CACHE_LINE_SIZE 64
+
+namespace octronic
+{
+    /**
+     * @brief One reading of a channel. timestamp is in seconds on the
+     * producer's clock.
+     */
+    struct DataSample
+    {
+        double timestamp;
+        float value;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(DataSample) == 16, "DataSample must be 16 bytes");
+}
@@ -0,0 +1,102 @@
+/*
+ * LatestValue.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include "DataSample.h"
+
+using std::atomic;
+
+namespace octronic
+{
+    /**
+     * @brief The most recent value, published by one writer to any number
+     * of readers. Store fills whichever of two slots readers are not
+     * pointed at and then publishes it, so a writer stalled mid-store
+     * leaves the previous value readable: readers never wait on it, and
+     * only retry if the writer laps them twice during one copy.
+     *
+     * Single writer: concurrent Stores to one LatestValue are not
+     * supported. T must be trivially copyable and a multiple of 8 bytes.
+     */
+    template <typename T>
+    class LatestValue
+    {
+    public:
+        LatestValue()
+            : mVersion(0),
+              mWriting(0)
+        {
+            for (size_t s = 0; s < 2; s++)
+            {
+                for (size_t i = 0; i < WordCount; i++) mSlots[s][i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        void Store(const T& value)
+        {
+            uint64_t words[WordCount];
+            memcpy(words, &value, sizeof(T));
+
+            // Announce the store before touching the slot it overwrites
+            uint64_t version = mVersion.load(std::memory_order_relaxed) + 1;
+            mWriting.store(version, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            atomic<uint64_t>* slot = mSlots[version & 1];
+            for (size_t i = 0; i < WordCount; i++) slot[i].store(words[i], std::memory_order_relaxed);
+            mVersion.store(version, std::memory_order_release);
+        }
+
+        /**
+         * @brief Returns false if nothing has been stored yet.
+         */
+        bool Load(T& value) const
+        {
+            uint64_t words[WordCount];
+            uint64_t version;
+            for (;;)
+            {
+                version = mVersion.load(std::memory_order_acquire);
+                if (version == 0) return false;
+                const atomic<uint64_t>* slot = mSlots[version & 1];
+                for (size_t i = 0; i < WordCount; i++) words[i] = slot[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                // The slot is next written by store version + 2
+                if (mWriting.load(std::memory_order_relaxed) < version + 2) break;
+            }
+            memcpy(&value, words, sizeof(T));
+            return true;
+        }
+
+        /**
+         * @brief Number of completed stores, so a reader can tell whether
+         * anything changed since it last looked.
+         */
+        uint64_t GetVersion() const
+        {
+            return mVersion.load(std::memory_order_acquire);
+        }
+
+    private:
+        static const size_t WordCount = sizeof(T) / sizeof(uint64_t);
+        static_assert(sizeof(T) % sizeof(uint64_t) == 0, "LatestValue needs a multiple of 8 bytes");
+
+        alignas(DATA_CACHE_LINE_SIZE) atomic<uint64_t> mVersion;
+        atomic<uint64_t> mWriting;
+        atomic<uint64_t> mSlots[2][WordCount];
+    };
+}
@@ -0,0 +1,270 @@
+/*
+ * Lttb.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "Lttb.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define LTTB_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define LTTB_NEON
+    #include <arm_neon.h>
+#endif
+
+using std::atomic;
+using std::thread;
+
+namespace octronic
+{
+    /**
+     * Sums timestamps and values of a bucket in two interleaved lanes (even
+     * and odd samples), matching the SSE2 accumulator order.
+     */
+    static void SumBucket(const DataSample* s, size_t count, double& sumT, double& sumV)
+    {
+        size_t i = 0;
+#if defined(LTTB_SSE2)
+        __m128d t = _mm_setzero_pd();
+        __m128d v = _mm_setzero_pd();
+        for (; i + 2 <= count; i += 2)
+        {
+            __m128d ts = _mm_loadh_pd(_mm_load_sd(&s[i].timestamp), &s[i + 1].timestamp);
+            t = _mm_add_pd(t, ts);
+            v = _mm_add_pd(v, _mm_set_pd(s[i + 1].value, s[i].value));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, t);
+        sumT = lanes[0] + lanes[1];
+        _mm_storeu_pd(lanes, v);
+        sumV = lanes[0] + lanes[1];
+#else
+        double t0 = 0.0, t1 = 0.0, v0 = 0.0, v1 = 0.0;
+        for (; i + 2 <= count; i += 2)
+        {
+            t0 += s[i].timestamp;
+            t1 += s[i + 1].timestamp;
+            v0 += s[i].value;
+            v1 += s[i + 1].value;
+        }
+        sumT = t0 + t1;
+        sumV = v0 + v1;
+#endif
+        for (; i < count; i++)
+        {
+            sumT += s[i].timestamp;
+            sumV += s[i].value;
+        }
+    }
+
+    /**
+     * Index in [first, end) of the sample forming the largest triangle with
+     * a and c, the first one on ties. Areas are doubled and relative to a,
+     * in single precision.
+     */
+    static size_t LargestTriangle(const DataSample* s, size_t first, size_t end,
+        double ax, float ay, float kx, float ky)
+    {
+        size_t best = first;
+        float bestArea = -1.0f;
+        size_t i = first;
+
+#if defined(LTTB_SSE2)
+        if (end - first >= 8)
+        {
+            const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+            const __m128d vax = _mm_set1_pd(ax);
+            const __m128 vay = _mm_set1_ps(ay);
+            const __m128 vkx = _mm_set1_ps(kx);
+            const __m128 vky = _mm_set1_ps(ky);
+            __m128 areas = _mm_set1_ps(-1.0f);
+            __m128i indices = _mm_setzero_si128();
+            __m128i index = _mm_set_epi32(3, 2, 1, 0);
+
+            for (; i + 4 <= end; i += 4)
+            {
+                const DataSample* p = s + i;
+                __m128d t01 = _mm_loadh_pd(_mm_load_sd(&p[0].timestamp), &p[1].timestamp);
+                __m128d t23 = _mm_loadh_pd(_mm_load_sd(&p[2].timestamp), &p[3].timestamp);
+                __m128 dx = _mm_movelh_ps(
+                    _mm_cvtpd_ps(_mm_sub_pd(t01, vax)),
+                    _mm_cvtpd_ps(_mm_sub_pd(t23, vax)));
+
+                // Each sample loads as (ts lo, ts hi, value, reserved)
+                __m128 s01 = _mm_shuffle_ps(_mm_loadu_ps(reinterpret_cast<const float*>(p)),
+                    _mm_loadu_ps(reinterpret_cast<const float*>(p + 1)), _MM_SHUFFLE(2, 2, 2, 2));
+                __m128 s23 = _mm_shuffle_ps(_mm_loadu_ps(reinterpret_cast<const float*>(p + 2)),
+                    _mm_loadu_ps(reinterpret_cast<const float*>(p + 3)), _MM_SHUFFLE(2, 2, 2, 2));
+                __m128 dy = _mm_sub_ps(_mm_shuffle_ps(s01, s23, _MM_SHUFFLE(2, 0, 2, 0)), vay);
+
+                __m128 area = _mm_and_ps(_mm_sub_ps(_mm_mul_ps(vkx, dy), _mm_mul_ps(dx, vky)), signMask);
+                __m128 greater = _mm_cmpgt_ps(area, areas);
+                areas = _mm_or_ps(_mm_and_ps(greater, area), _mm_andnot_ps(greater, areas));
+                __m128i take = _mm_castps_si128(greater);
+                indices = _mm_or_si128(_mm_and_si128(take, index), _mm_andnot_si128(take, indices));
+                index = _mm_add_epi32(index, _mm_set1_epi32(4));
+            }
+
+            float laneAreas[4];
+            int32_t laneIndices[4];
+            _mm_storeu_ps(laneAreas, areas);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(laneIndices), indices);
+            for (int lane = 0; lane < 4; lane++)
+            {
+                size_t candidate = first + static_cast<size_t>(laneIndices[lane]);
+                if (laneAreas[lane] > bestArea ||
+                    (laneAreas[lane] == bestArea && candidate < best))
+                {
+                    bestArea = laneAreas[lane];
+                    best = candidate;
+                }
+            }
+        }
+#elif defined(LTTB_NEON)
+        if (end - first >= 8)
+        {
+            const float32x4_t vay = vdupq_n_f32(ay);
+            const float32x4_t vkx = vdupq_n_f32(kx);
+            const float32x4_t vky = vdupq_n_f32(ky);
+            float32x4_t areas = vdupq_n_f32(-1.0f);
+            uint32x4_t indices = vdupq_n_u32(0);
+            const uint32_t start[4] = { 0, 1, 2, 3 };
+            uint32x4_t index = vld1q_u32(start);
+
+            for (; i + 4 <= end; i += 4)
+            {
+                const DataSample* p = s + i;
+                float offsets[4] = {
+                    static_cast<float>(p[0].timestamp - ax), static_cast<float>(p[1].timestamp - ax),
+                    static_cast<float>(p[2].timestamp - ax), static_cast<float>(p[3].timestamp - ax) };
+                float32x4_t dx = vld1q_f32(offsets);
+
+                // De-interleaves (ts lo, ts hi, value, reserved)
+                float32x4x4_t fields = vld4q_f32(reinterpret_cast<const float*>(p));
+                float32x4_t dy = vsubq_f32(fields.val[2], vay);
+
+                float32x4_t area = vabsq_f32(vsubq_f32(vmulq_f32(vkx, dy), vmulq_f32(dx, vky)));
+                uint32x4_t greater = vcgtq_f32(area, areas);
+                areas = vbslq_f32(greater, area, areas);
+                indices = vbslq_u32(greater, index, indices);
+                index = vaddq_u32(index, vdupq_n_u32(4));
+            }
+
+            float laneAreas[4];
+            uint32_t laneIndices[4];
+            vst1q_f32(laneAreas, areas);
+            vst1q_u32(laneIndices, indices);
+            for (int lane = 0; lane < 4; lane++)
+            {
+                size_t candidate = first + laneIndices[lane];
+                if (laneAreas[lane] > bestArea ||
+                    (laneAreas[lane] == bestArea && candidate < best))
+                {
+                    bestArea = laneAreas[lane];
+                    best = candidate;
+                }
+            }
+        }
+#endif
+        for (; i < end; i++)
+        {
+            float dx = static_cast<float>(s[i].timestamp - ax);
+            float dy = s[i].value - ay;
+            float area = std::fabs(kx * dy - dx * ky);
+            if (area > bestArea)
+            {
+                bestArea = area;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    size_t Lttb::Downsample(const DataSample* samples, size_t count, size_t target,
+        vector<DataSample>& out)
+    {
+        out.clear();
+        if (count == 0) return 0;
+        if (target >= count || target < 3)
+        {
+            out.assign(samples, samples + count);
+            return count;
+        }
+
+        out.reserve(target);
+        out.push_back(samples[0]);
+
+        // Bucket b (0-based) covers [floor(b * every) + 1, floor((b + 1) * every) + 1)
+        double every = static_cast<double>(count - 2) / (target - 2);
+        size_t a = 0;
+        for (size_t b = 0; b + 2 < target; b++)
+        {
+            size_t first = static_cast<size_t>(b * every) + 1;
+            size_t end = static_cast<size_t>((b + 1) * every) + 1;
+
+            // Third vertex: the average of the next bucket, or the last sample
+            size_t nextEnd = std::min(static_cast<size_t>((b + 2) * every) + 1, count);
+            double avgT;
+            double avgV;
+            if (b + 3 < target && nextEnd > end)
+            {
+                SumBucket(samples + end, nextEnd - end, avgT, avgV);
+                avgT /= (nextEnd - end);
+                avgV /= (nextEnd - end);
+            }
+            else
+            {
+                avgT = samples[count - 1].timestamp;
+                avgV = samples[count - 1].value;
+            }
+
+            double ax = samples[a].timestamp;
+            float ay = samples[a].value;
+            a = LargestTriangle(samples, first, end, ax, ay,
+                static_cast<float>(avgT - ax), static_cast<float>(avgV - ay));
+            out.push_back(samples[a]);
+        }
+
+        out.push_back(samples[count - 1]);
+        return out.size();
+    }
+
+    void Lttb::DownsampleAll(const vector<LttbJob>& jobs, unsigned threadCount)
+    {
+        if (threadCount == 0) threadCount = std::max(1u, thread::hardware_concurrency());
+        threadCount = std::min<unsigned>(threadCount, static_cast<unsigned>(jobs.size()));
+
+        atomic<size_t> next(0);
+        auto worker = [&jobs, &next]()
+        {
+            for (size_t i = next++; i < jobs.size(); i = next++)
+            {
+                const LttbJob& job = jobs[i];
+                Downsample(job.samples, job.count, job.target, *job.out);
+            }
+        };
+
+        // The calling thread works too, so one thread means no spawning
+        vector<thread> workers;
+        for (unsigned i = 1; i < threadCount; i++) workers.emplace_back(worker);
+        worker();
+        for (thread& t : workers) t.join();
+    }
+}
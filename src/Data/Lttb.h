@@ -0,0 +1,62 @@
+/*
+ * Lttb.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "DataSample.h"
+
+using std::vector;
+
+namespace octronic
+{
+    struct LttbJob
+    {
+        const DataSample* samples;
+        size_t count;
+        size_t target;
+        vector<DataSample>* out;
+    };
+
+    /**
+     * @brief Largest-Triangle-Three-Buckets downsampling. Keeps the first
+     * and last sample and, from each of target - 2 equal buckets in
+     * between, the sample forming the largest triangle with the previously
+     * kept sample and the average of the next bucket. Unlike a min/max
+     * envelope the result is a plain polyline that follows the shape of
+     * the signal.
+     *
+     * The bucket average and triangle area loops have SSE2 and NEON paths;
+     * the scalar fallback selects the same samples.
+     */
+    class Lttb
+    {
+    public:
+        /**
+         * @brief Downsamples count time-ordered samples to at most target
+         * samples. Inputs with count <= target, or target < 3, are copied.
+         * @return The number of samples written to out.
+         */
+        static size_t Downsample(const DataSample* samples, size_t count, size_t target,
+            vector<DataSample>& out);
+
+        /**
+         * @brief Runs Downsample for each job, spread over up to threadCount
+         * worker threads (0 uses one per hardware thread). Blocks until all
+         * jobs are done. Jobs must write to distinct outputs.
+         */
+        static void DownsampleAll(const vector<LttbJob>& jobs, unsigned threadCount = 0);
+    };
+}
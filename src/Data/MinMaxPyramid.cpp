@@ -0,0 +1,301 @@
+/*
+ * MinMaxPyramid.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "MinMaxPyramid.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define MIN_MAX_PYRAMID_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define MIN_MAX_PYRAMID_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace octronic
+{
+    // Same operand order as minps/maxps, so every path agrees on NaNs
+    static inline float MinF(float a, float b) { return a < b ? a : b; }
+    static inline float MaxF(float a, float b) { return a > b ? a : b; }
+
+    MinMaxPyramid::MinMaxPyramid(size_t capacity)
+        : mCapacity(MIN_MAX_PYRAMID_MIN_LEVEL_SIZE * 2),
+          mEnd(0)
+    {
+        while (mCapacity < capacity) mCapacity <<= 1;
+        mMask = mCapacity - 1;
+        mValues.resize(mCapacity);
+        mTimestamps.resize(mCapacity);
+
+        for (size_t size = mCapacity >> 1; size >= MIN_MAX_PYRAMID_MIN_LEVEL_SIZE; size >>= 1)
+        {
+            Level level;
+            level.mins.resize(size);
+            level.maxs.resize(size);
+            level.built = 0;
+            level.mask = size - 1;
+            mLevels.push_back(level);
+        }
+    }
+
+    void MinMaxPyramid::Append(const DataSample* samples, size_t count)
+    {
+        // Half the capacity at a time, so every level still holds the
+        // source entries of the buckets BuildLevels is about to fill
+        size_t chunk = mCapacity / 2;
+        while (count > 0)
+        {
+            size_t n = std::min(count, chunk);
+            for (size_t i = 0; i < n; i++, mEnd++)
+            {
+                mValues[mEnd & mMask] = samples[i].value;
+                mTimestamps[mEnd & mMask] = samples[i].timestamp;
+            }
+            BuildLevels();
+            samples += n;
+            count -= n;
+        }
+    }
+
+    void MinMaxPyramid::BuildLevels()
+    {
+        for (size_t k = 1; k <= mLevels.size(); k++)
+        {
+            Level& level = mLevels[k - 1];
+            const float* srcMin = k == 1 ? mValues.data() : mLevels[k - 2].mins.data();
+            const float* srcMax = k == 1 ? mValues.data() : mLevels[k - 2].maxs.data();
+            uint64_t target = mEnd >> k;
+
+            // Buckets never straddle the source ring's wrap point since
+            // both rings are powers of two and source index = 2 * bucket
+            while (level.built < target)
+            {
+                size_t dst = static_cast<size_t>(level.built & level.mask);
+                size_t run = static_cast<size_t>(std::min<uint64_t>(target - level.built, level.mask + 1 - dst));
+                ReducePairs(srcMin + dst * 2, srcMax + dst * 2, run,
+                    level.mins.data() + dst, level.maxs.data() + dst);
+                level.built += run;
+            }
+        }
+    }
+
+    void MinMaxPyramid::Clear()
+    {
+        mEnd = 0;
+        for (Level& level : mLevels) level.built = 0;
+    }
+
+    size_t MinMaxPyramid::GetCapacity() const
+    {
+        return mCapacity;
+    }
+
+    size_t MinMaxPyramid::GetLevelCount() const
+    {
+        return mLevels.size() + 1;
+    }
+
+    uint64_t MinMaxPyramid::GetFirstIndex() const
+    {
+        return mEnd > mCapacity ? mEnd - mCapacity : 0;
+    }
+
+    uint64_t MinMaxPyramid::GetEndIndex() const
+    {
+        return mEnd;
+    }
+
+    double MinMaxPyramid::GetTimestamp(uint64_t index) const
+    {
+        return mTimestamps[index & mMask];
+    }
+
+    float MinMaxPyramid::GetValue(uint64_t index) const
+    {
+        return mValues[index & mMask];
+    }
+
+    uint64_t MinMaxPyramid::FindIndex(double timestamp) const
+    {
+        uint64_t low = GetFirstIndex();
+        uint64_t high = mEnd;
+        while (low < high)
+        {
+            uint64_t mid = low + (high - low) / 2;
+            if (GetTimestamp(mid) < timestamp) low = mid + 1;
+            else high = mid;
+        }
+        return low;
+    }
+
+    void MinMaxPyramid::ReduceRange(uint64_t first, uint64_t end, size_t level, float& min, float& max) const
+    {
+        if (level > 0)
+        {
+            const Level& l = mLevels[level - 1];
+            size_t size = l.mask + 1;
+            uint64_t bucket = std::max<uint64_t>(first >> level, l.built > size ? l.built - size : 0);
+            uint64_t bucketEnd = std::min<uint64_t>((end + (1ull << level) - 1) >> level, l.built);
+
+            while (bucket < bucketEnd)
+            {
+                size_t start = static_cast<size_t>(bucket & l.mask);
+                size_t run = static_cast<size_t>(std::min<uint64_t>(bucketEnd - bucket, size - start));
+                ReduceMinMax(l.mins.data() + start, l.maxs.data() + start, run, min, max);
+                bucket += run;
+            }
+
+            // Samples newer than the last complete bucket come from level 0
+            first = std::max(first, l.built << level);
+            if (first >= end) return;
+        }
+
+        while (first < end)
+        {
+            size_t start = static_cast<size_t>(first & mMask);
+            size_t run = static_cast<size_t>(std::min<uint64_t>(end - first, mCapacity - start));
+            ReduceMinMax(mValues.data() + start, mValues.data() + start, run, min, max);
+            first += run;
+        }
+    }
+
+    size_t MinMaxPyramid::Query(uint64_t first, uint64_t end, size_t bucketCount, vector<MinMaxBucket>& out) const
+    {
+        out.clear();
+        first = std::max(first, GetFirstIndex());
+        end = std::min(end, mEnd);
+        if (first >= end || bucketCount == 0) return 0;
+
+        uint64_t span = end - first;
+        if (span <= bucketCount)
+        {
+            out.resize(static_cast<size_t>(span));
+            for (size_t i = 0; i < out.size(); i++)
+            {
+                out[i].timestamp = GetTimestamp(first + i);
+                out[i].min = out[i].max = GetValue(first + i);
+            }
+            return out.size();
+        }
+
+        // Coarsest level whose buckets are no wider than one output run
+        size_t level = 0;
+        while (level < mLevels.size() && (2ull << level) <= span / bucketCount) level++;
+
+        out.resize(bucketCount);
+        for (size_t i = 0; i < bucketCount; i++)
+        {
+            uint64_t a = first + span * i / bucketCount;
+            uint64_t b = first + span * (i + 1) / bucketCount;
+            MinMaxBucket& bucket = out[i];
+            bucket.timestamp = GetTimestamp(a);
+            bucket.min = std::numeric_limits<float>::max();
+            bucket.max = -std::numeric_limits<float>::max();
+            ReduceRange(a, b, level, bucket.min, bucket.max);
+        }
+        return bucketCount;
+    }
+
+    size_t MinMaxPyramid::QueryTime(double startTime, double endTime, size_t bucketCount, vector<MinMaxBucket>& out) const
+    {
+        uint64_t first = FindIndex(startTime);
+        if (first > GetFirstIndex()) first--;
+        uint64_t end = FindIndex(endTime);
+        while (end < mEnd && GetTimestamp(end) <= endTime) end++;
+        return Query(first, end, bucketCount, out);
+    }
+
+    // Kernels #################################################################
+
+    void MinMaxPyramid::ReduceMinMax(const float* mins, const float* maxs, size_t count, float& min, float& max)
+    {
+        size_t i = 0;
+#if defined(MIN_MAX_PYRAMID_SSE2)
+        if (count >= 8)
+        {
+            __m128 vmin = _mm_set1_ps(min);
+            __m128 vmax = _mm_set1_ps(max);
+            for (; i + 4 <= count; i += 4)
+            {
+                vmin = _mm_min_ps(vmin, _mm_loadu_ps(mins + i));
+                vmax = _mm_max_ps(vmax, _mm_loadu_ps(maxs + i));
+            }
+            vmin = _mm_min_ps(vmin, _mm_shuffle_ps(vmin, vmin, _MM_SHUFFLE(1, 0, 3, 2)));
+            vmin = _mm_min_ps(vmin, _mm_shuffle_ps(vmin, vmin, _MM_SHUFFLE(2, 3, 0, 1)));
+            vmax = _mm_max_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+            vmax = _mm_max_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+            min = _mm_cvtss_f32(vmin);
+            max = _mm_cvtss_f32(vmax);
+        }
+#elif defined(MIN_MAX_PYRAMID_NEON)
+        if (count >= 8)
+        {
+            float32x4_t vmin = vdupq_n_f32(min);
+            float32x4_t vmax = vdupq_n_f32(max);
+            for (; i + 4 <= count; i += 4)
+            {
+                vmin = vminq_f32(vmin, vld1q_f32(mins + i));
+                vmax = vmaxq_f32(vmax, vld1q_f32(maxs + i));
+            }
+            float32x2_t pmin = vpmin_f32(vget_low_f32(vmin), vget_high_f32(vmin));
+            float32x2_t pmax = vpmax_f32(vget_low_f32(vmax), vget_high_f32(vmax));
+            min = vget_lane_f32(vpmin_f32(pmin, pmin), 0);
+            max = vget_lane_f32(vpmax_f32(pmax, pmax), 0);
+        }
+#endif
+        for (; i < count; i++)
+        {
+            min = MinF(min, mins[i]);
+            max = MaxF(max, maxs[i]);
+        }
+    }
+
+    void MinMaxPyramid::ReducePairs(const float* srcMin, const float* srcMax, size_t pairCount,
+        float* dstMin, float* dstMax)
+    {
+        size_t i = 0;
+#if defined(MIN_MAX_PYRAMID_SSE2)
+        for (; i + 4 <= pairCount; i += 4)
+        {
+            __m128 a = _mm_loadu_ps(srcMin + i * 2);
+            __m128 b = _mm_loadu_ps(srcMin + i * 2 + 4);
+            _mm_storeu_ps(dstMin + i, _mm_min_ps(
+                _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+            a = _mm_loadu_ps(srcMax + i * 2);
+            b = _mm_loadu_ps(srcMax + i * 2 + 4);
+            _mm_storeu_ps(dstMax + i, _mm_max_ps(
+                _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)),
+                _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+        }
+#elif defined(MIN_MAX_PYRAMID_NEON)
+        for (; i + 4 <= pairCount; i += 4)
+        {
+            float32x4x2_t mins = vld2q_f32(srcMin + i * 2);
+            float32x4x2_t maxs = vld2q_f32(srcMax + i * 2);
+            vst1q_f32(dstMin + i, vminq_f32(mins.val[0], mins.val[1]));
+            vst1q_f32(dstMax + i, vmaxq_f32(maxs.val[0], maxs.val[1]));
+        }
+#endif
+        for (; i < pairCount; i++)
+        {
+            dstMin[i] = MinF(srcMin[i * 2], srcMin[i * 2 + 1]);
+            dstMax[i] = MaxF(srcMax[i * 2], srcMax[i * 2 + 1]);
+        }
+    }
+}
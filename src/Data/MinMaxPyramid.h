@@ -0,0 +1,128 @@
+/*
+ * MinMaxPyramid.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "DataSample.h"
+
+using std::vector;
+
+#define MIN_MAX_PYRAMID_MIN_LEVEL_SIZE 16
+
+namespace octronic
+{
+    struct MinMaxBucket
+    {
+        double timestamp;
+        float min;
+        float max;
+    };
+
+    /**
+     * @brief Multi-resolution min/max history of a channel, used to draw
+     * long time ranges with a vertex count bounded by the screen width.
+     *
+     * Level 0 is a ring of the last capacity raw samples. Level k holds the
+     * min and max of each aligned run of 2^k samples, in its own ring of
+     * capacity >> k buckets. Samples are addressed by their absolute index
+     * since the first Append. Levels are extended incrementally: appending n
+     * samples builds only the buckets they complete, so the cost is O(n).
+     *
+     * Not thread safe; the owning channel appends and widgets query on the
+     * render thread.
+     */
+    class MinMaxPyramid
+    {
+    public:
+        /**
+         * @param capacity Raw samples retained, rounded up to a power of two.
+         */
+        explicit MinMaxPyramid(size_t capacity);
+
+        void Append(const DataSample* samples, size_t count);
+        void Clear();
+
+        size_t GetCapacity() const;
+        size_t GetLevelCount() const;
+
+        /** @brief Index of the oldest retained sample. */
+        uint64_t GetFirstIndex() const;
+        /** @brief One past the index of the newest sample. */
+        uint64_t GetEndIndex() const;
+
+        double GetTimestamp(uint64_t index) const;
+        float GetValue(uint64_t index) const;
+
+        /**
+         * @brief Index of the first retained sample with timestamp >= time,
+         * or GetEndIndex() if there is none. Timestamps must be
+         * non-decreasing.
+         */
+        uint64_t FindIndex(double timestamp) const;
+
+        /**
+         * @brief Splits samples [first, end) into at most bucketCount equal
+         * runs and writes each run's min and max, read from the coarsest
+         * level whose buckets fit in a run. Runs are widened to that level's
+         * bucket boundaries, so a bucket may include up to one bucket width
+         * of neighbouring samples. Ranges shorter than bucketCount are
+         * returned as raw samples.
+         * @return The number of buckets written.
+         */
+        size_t Query(uint64_t first, uint64_t end, size_t bucketCount, vector<MinMaxBucket>& out) const;
+
+        /**
+         * @brief Query over [startTime, endTime], starting one sample before
+         * startTime so a plotted line enters from the left edge.
+         */
+        size_t QueryTime(double startTime, double endTime, size_t bucketCount, vector<MinMaxBucket>& out) const;
+
+        /**
+         * @brief Folds count min/max pairs into min and max, which must be
+         * initialised by the caller.
+         */
+        static void ReduceMinMax(const float* mins, const float* maxs, size_t count, float& min, float& max);
+
+        /**
+         * @brief Writes the min and max of each adjacent pair of entries:
+         * dstMin[i] = min(srcMin[2i], srcMin[2i+1]), likewise for max.
+         */
+        static void ReducePairs(const float* srcMin, const float* srcMax, size_t pairCount,
+            float* dstMin, float* dstMax);
+
+    protected:
+        struct Level
+        {
+            vector<float> mins;
+            vector<float> maxs;
+            uint64_t built;
+            size_t mask;
+        };
+
+        void BuildLevels();
+        void ReduceRange(uint64_t first, uint64_t end, size_t level, float& min, float& max) const;
+
+    private:
+        size_t mCapacity;
+        size_t mMask;
+        vector<float> mValues;
+        vector<double> mTimestamps;
+        uint64_t mEnd;
+        // mLevels[k - 1] is level k
+        vector<Level> mLevels;
+    };
+}
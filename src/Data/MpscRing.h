@@ -0,0 +1,133 @@
+/*
+ * MpscRing.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CacheAligned.h"
+
+using std::atomic;
+using std::vector;
+
+namespace octronic
+{
+    /**
+     * @brief Bounded lock-free ring for many producers and one consumer,
+     * after Dmitry Vyukov's bounded queue. Each cell carries a sequence
+     * number, so producers only contend on one fetch position and never
+     * wait for each other or for the consumer. Capacity is rounded up to a
+     * power of two.
+     */
+    template <typename T>
+    class MpscRing : public CacheAligned
+    {
+    public:
+        explicit MpscRing(size_t capacity)
+            : mHead(0),
+              mTail(0)
+        {
+            size_t size = 1;
+            while (size < capacity) size <<= 1;
+            mCells = vector<Cell>(size);
+            for (size_t i = 0; i < size; i++)
+            {
+                mCells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            mMask = size - 1;
+        }
+
+        /**
+         * @brief Producer side, any thread. Returns false when full.
+         */
+        bool TryPush(const T& item)
+        {
+            size_t position = mHead.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell& cell = mCells[position & mMask];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (difference == 0)
+                {
+                    if (mHead.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        cell.item = item;
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = mHead.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @brief Consumer side, one thread only.
+         */
+        bool TryPop(T& item)
+        {
+            size_t position = mTail.load(std::memory_order_relaxed);
+            Cell& cell = mCells[position & mMask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence != position + 1) return false;
+            item = cell.item;
+            cell.sequence.store(position + mMask + 1, std::memory_order_release);
+            mTail.store(position + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        size_t PopBatch(vector<T>& out, size_t maxItems)
+        {
+            size_t count = 0;
+            T item;
+            while (count < maxItems && TryPop(item))
+            {
+                out.push_back(item);
+                count++;
+            }
+            return count;
+        }
+
+        size_t GetCapacity() const
+        {
+            return mMask + 1;
+        }
+
+    private:
+        MpscRing(const MpscRing&);
+        MpscRing& operator=(const MpscRing&);
+
+        struct Cell
+        {
+            Cell() : sequence(0), item() {}
+            Cell(const Cell& other) : sequence(other.sequence.load()), item(other.item) {}
+            atomic<size_t> sequence;
+            T item;
+        };
+
+        alignas(DATA_CACHE_LINE_SIZE) atomic<size_t> mHead;
+        alignas(DATA_CACHE_LINE_SIZE) atomic<size_t> mTail;
+        alignas(DATA_CACHE_LINE_SIZE) vector<Cell> mCells;
+        size_t mMask;
+    };
+}
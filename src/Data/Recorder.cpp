@@ -0,0 +1,359 @@
+/*
+ * Recorder.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "Recorder.h"
+
+#include <algorithm>
+#include <cstring>
+#include "ChannelRegistry.h"
+#include "../Common/Logger.h"
+#include "../Common/Tracer.h"
+
+namespace octronic
+{
+    Recorder::Recorder()
+        : mFile(nullptr),
+          mOffset(0),
+          mFailed(false),
+          mSampleCount(0),
+          mPreviousIndex(0),
+          mChunksSinceIndex(0),
+          mRunning(false)
+    {
+    }
+
+    Recorder::~Recorder()
+    {
+        Stop();
+    }
+
+    bool Recorder::Start(const string& path, const ChannelRegistry& registry)
+    {
+        Stop();
+        debug("Recorder: {} {}", __FUNCTION__, path);
+
+        mFile = fopen(path.c_str(), "wb");
+        if (mFile == nullptr)
+        {
+            error("Recorder: Unable to open {}", path);
+            return false;
+        }
+
+        RecordingHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, RECORDING_MAGIC, 4);
+        header.version = RECORDING_VERSION;
+        if (fwrite(&header, sizeof(header), 1, mFile) != 1)
+        {
+            error("Recorder: Unable to write {}", path);
+            fclose(mFile);
+            mFile = nullptr;
+            return false;
+        }
+
+        mPath = path;
+        mOffset = sizeof(header);
+        mFailed = false;
+        mChunk = Chunk();
+        mChunk.samples.reserve(RECORDING_CHUNK_SAMPLES);
+        mKnownChannels.clear();
+        // Drops from before the recording started are not its concern
+        uint32_t channelCount = static_cast<uint32_t>(registry.GetChannelCount());
+        mDropBase.assign(channelCount, 0);
+        mDropped.assign(channelCount, 0);
+        for (uint32_t id = 0; id < channelCount; id++)
+        {
+            const DataChannel* channel = registry.Find(id);
+            if (channel != nullptr) mDropBase[id] = channel->GetDroppedCount();
+        }
+        mSampleCount = 0;
+        mIndex.clear();
+        mPreviousIndex = 0;
+        mChunksSinceIndex = 0;
+        mRunning = true;
+        mThread = thread(&Recorder::Run, this);
+        info("Recorder: Recording to {}", path);
+        return true;
+    }
+
+    void Recorder::Stop()
+    {
+        if (!mRunning) return;
+        debug("Recorder: {}", __FUNCTION__);
+
+        if (!mChunk.samples.empty() || !mChunk.channels.empty() || !mChunk.drops.empty()) Submit();
+        {
+            std::lock_guard<mutex> lock(mMutex);
+            mRunning = false;
+        }
+        mCondition.notify_one();
+        if (mThread.joinable()) mThread.join();
+
+        // The thread has drained the queue; finish on this one
+        bool ok = !mFailed && WriteIndex();
+        if (ok)
+        {
+            RecordingTrailer trailer;
+            memset(&trailer, 0, sizeof(trailer));
+            trailer.lastIndex = mPreviousIndex;
+            trailer.sampleCount = mSampleCount;
+            memcpy(trailer.magic, RECORDING_TRAILER_MAGIC, 4);
+            trailer.version = RECORDING_VERSION;
+            ok = fwrite(&trailer, sizeof(trailer), 1, mFile) == 1;
+        }
+        ok = fclose(mFile) == 0 && ok;
+        mFile = nullptr;
+
+        if (ok) info("Recorder: {} samples written to {}", mSampleCount, mPath);
+        else error("Recorder: {} is incomplete", mPath);
+        if (GetDroppedCount() > 0)
+        {
+            warn("Recorder: Full channels dropped {} samples before they could be recorded", GetDroppedCount());
+        }
+    }
+
+    bool Recorder::IsRecording() const
+    {
+        return mRunning;
+    }
+
+    uint64_t Recorder::GetSampleCount() const
+    {
+        return mSampleCount;
+    }
+
+    uint64_t Recorder::GetDroppedCount() const
+    {
+        uint64_t dropped = 0;
+        for (uint64_t count : mDropped) dropped += count;
+        return dropped;
+    }
+
+    void Recorder::DefineChannel(uint32_t id, const string& name)
+    {
+        if (mKnownChannels[id]) return;
+        mChunk.channels.push_back(std::make_pair(id, name));
+        mKnownChannels[id] = true;
+    }
+
+    void Recorder::Capture(const ChannelRegistry& registry)
+    {
+        if (!mRunning) return;
+        TRACE_SCOPE("Recorder::Capture");
+
+        mFrame.clear();
+        uint32_t channelCount = static_cast<uint32_t>(registry.GetChannelCount());
+        if (mKnownChannels.size() < channelCount) mKnownChannels.resize(channelCount, false);
+        // Channels created since Start have dropped nothing before it
+        if (mDropBase.size() < channelCount)
+        {
+            mDropBase.resize(channelCount, 0);
+            mDropped.resize(channelCount, 0);
+        }
+
+        for (uint32_t id = 0; id < channelCount; id++)
+        {
+            const DataChannel* channel = registry.Find(id);
+            if (channel == nullptr) continue;
+
+            uint64_t dropped = channel->GetDroppedCount() - mDropBase[id];
+            if (dropped != mDropped[id])
+            {
+                DefineChannel(id, channel->GetName());
+                auto itr = std::find_if(mChunk.drops.begin(), mChunk.drops.end(),
+                    [id](const RecordingDrops& drops)
+                    {
+                        return drops.channel == id;
+                    });
+                if (itr == mChunk.drops.end())
+                {
+                    RecordingDrops drops;
+                    drops.channel = id;
+                    drops.reserved = 0;
+                    itr = mChunk.drops.insert(mChunk.drops.end(), drops);
+                }
+                itr->dropped = dropped;
+                mDropped[id] = dropped;
+            }
+
+            const vector<DataSample>& samples = channel->GetFrameSamples();
+            if (samples.empty()) continue;
+
+            DefineChannel(id, channel->GetName());
+            for (const DataSample& sample : samples)
+            {
+                RecordingSample s;
+                s.channel = id;
+                s.value = sample.value;
+                s.timestamp = sample.timestamp;
+                mFrame.push_back(s);
+            }
+        }
+        if (mFrame.empty()) return;
+
+        // Interleave the channels so replay can feed them in time order
+        std::stable_sort(mFrame.begin(), mFrame.end(),
+            [](const RecordingSample& a, const RecordingSample& b)
+            {
+                return a.timestamp < b.timestamp;
+            });
+
+        size_t next = 0;
+        while (next < mFrame.size())
+        {
+            size_t take = std::min(mFrame.size() - next,
+                static_cast<size_t>(RECORDING_CHUNK_SAMPLES) - mChunk.samples.size());
+            mChunk.samples.insert(mChunk.samples.end(), mFrame.begin() + next, mFrame.begin() + next + take);
+            next += take;
+            if (mChunk.samples.size() == RECORDING_CHUNK_SAMPLES) Submit();
+        }
+        mSampleCount += mFrame.size();
+    }
+
+    void Recorder::Submit()
+    {
+        {
+            std::lock_guard<mutex> lock(mMutex);
+            mQueue.push_back(std::move(mChunk));
+        }
+        mCondition.notify_one();
+        mChunk = Chunk();
+        mChunk.samples.reserve(RECORDING_CHUNK_SAMPLES);
+    }
+
+    void Recorder::Run()
+    {
+        Tracer::SetThreadName("Recorder");
+        debug("Recorder: Thread started");
+        std::unique_lock<mutex> lock(mMutex);
+        while (true)
+        {
+            mCondition.wait(lock, [this] { return !mQueue.empty() || !mRunning; });
+            if (mQueue.empty()) break;
+
+            Chunk chunk = std::move(mQueue.front());
+            mQueue.pop_front();
+            lock.unlock();
+            if (!mFailed && !WriteChunk(chunk))
+            {
+                error("Recorder: Write to {} failed, recording stopped", mPath);
+                mFailed = true;
+            }
+            lock.lock();
+        }
+        debug("Recorder: Thread finished");
+    }
+
+    bool Recorder::WriteChunk(const Chunk& chunk)
+    {
+        TRACE_SCOPE("Recorder::WriteChunk");
+        if (!chunk.channels.empty())
+        {
+            vector<uint8_t> payload;
+            for (const auto& channel : chunk.channels)
+            {
+                RecordingChannel c;
+                c.id = channel.first;
+                c.nameLength = static_cast<uint32_t>(channel.second.size());
+                const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&c);
+                payload.insert(payload.end(), bytes, bytes + sizeof(c));
+                payload.insert(payload.end(), channel.second.begin(), channel.second.end());
+            }
+            payload.resize((payload.size() + RECORDING_ALIGNMENT - 1) & ~static_cast<size_t>(RECORDING_ALIGNMENT - 1), 0);
+            if (!WriteBlock(RecordingBlock_Channels, static_cast<uint32_t>(chunk.channels.size()),
+                payload.data(), payload.size(), 0.0, 0.0, 0))
+            {
+                return false;
+            }
+        }
+
+        if (!chunk.drops.empty())
+        {
+            if (!WriteBlock(RecordingBlock_Drops, static_cast<uint32_t>(chunk.drops.size()),
+                chunk.drops.data(), chunk.drops.size() * sizeof(RecordingDrops), 0.0, 0.0, 0))
+            {
+                return false;
+            }
+        }
+
+        if (!chunk.samples.empty())
+        {
+            if (!WriteBlock(RecordingBlock_Samples, static_cast<uint32_t>(chunk.samples.size()),
+                chunk.samples.data(), chunk.samples.size() * sizeof(RecordingSample),
+                chunk.samples.front().timestamp, chunk.samples.back().timestamp, 0))
+            {
+                return false;
+            }
+            if (++mChunksSinceIndex == RECORDING_INDEX_INTERVAL) return WriteIndex();
+        }
+        return true;
+    }
+
+    bool Recorder::WriteBlock(RecordingBlockType type, uint32_t count,
+        const void* payload, size_t size, double first, double last, uint64_t previousIndex)
+    {
+        RecordingBlockHeader header;
+        memset(&header, 0, sizeof(header));
+        header.type = type;
+        header.count = count;
+        header.size = size;
+        header.firstTimestamp = first;
+        header.lastTimestamp = last;
+        header.previousIndex = previousIndex;
+
+        if (type != RecordingBlock_Index)
+        {
+            RecordingIndexEntry entry;
+            entry.offset = mOffset;
+            entry.type = type;
+            entry.count = count;
+            entry.firstTimestamp = first;
+            entry.lastTimestamp = last;
+            mIndex.push_back(entry);
+        }
+
+        if (fwrite(&header, sizeof(header), 1, mFile) != 1) return false;
+        if (size > 0 && fwrite(payload, 1, size, mFile) != size) return false;
+        mOffset += sizeof(header) + size;
+        return true;
+    }
+
+    bool Recorder::WriteIndex()
+    {
+        if (mIndex.empty()) return true;
+
+        double first = 0.0;
+        double last = 0.0;
+        bool anySamples = false;
+        for (const RecordingIndexEntry& entry : mIndex)
+        {
+            if (entry.type != RecordingBlock_Samples) continue;
+            if (!anySamples) first = entry.firstTimestamp;
+            last = entry.lastTimestamp;
+            anySamples = true;
+        }
+
+        uint64_t offset = mOffset;
+        if (!WriteBlock(RecordingBlock_Index, static_cast<uint32_t>(mIndex.size()),
+            mIndex.data(), mIndex.size() * sizeof(RecordingIndexEntry), first, last, mPreviousIndex))
+        {
+            return false;
+        }
+        mPreviousIndex = offset;
+        mIndex.clear();
+        mChunksSinceIndex = 0;
+        // Let a crash lose at most the chunks since this index
+        return fflush(mFile) == 0;
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * Recorder.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "RecordingFormat.h"
+
+using std::atomic;
+using std::condition_variable;
+using std::deque;
+using std::mutex;
+using std::pair;
+using std::string;
+using std::thread;
+using std::vector;
+
+namespace octronic
+{
+    class ChannelRegistry;
+
+    /**
+     * @brief Records every sample the render thread drains into an append
+     * only log (see RecordingFormat.h). Capture only copies the frame's
+     * samples into the current chunk; full chunks are written, and index
+     * blocks added, on the recorder's own thread so the frame never waits
+     * on the disk. Samples a channel dropped before the drain are not seen
+     * by the dashboard either and are not recorded, but each channel's
+     * running drop count is, so a replay can tell what the log is missing.
+     */
+    class Recorder
+    {
+    public:
+        Recorder();
+        ~Recorder();
+
+        bool Start(const string& path, const ChannelRegistry& registry);
+        /** @brief Flushes the open chunk and writes the final index. */
+        void Stop();
+        bool IsRecording() const;
+
+        /** @brief Render thread, after ChannelRegistry::DrainAll. */
+        void Capture(const ChannelRegistry& registry);
+
+        uint64_t GetSampleCount() const;
+        /** @brief Samples the channels dropped while recording. */
+        uint64_t GetDroppedCount() const;
+
+    protected:
+        struct Chunk
+        {
+            vector<pair<uint32_t, string>> channels;
+            vector<RecordingDrops> drops;
+            vector<RecordingSample> samples;
+        };
+
+        void Run();
+        void Submit();
+        void DefineChannel(uint32_t id, const string& name);
+        bool WriteChunk(const Chunk& chunk);
+        bool WriteBlock(RecordingBlockType type, uint32_t count,
+            const void* payload, size_t size, double first, double last, uint64_t previousIndex);
+        bool WriteIndex();
+
+    private:
+        string mPath;
+        FILE* mFile;
+        uint64_t mOffset;
+        bool mFailed;
+
+        // Render thread
+        Chunk mChunk;
+        vector<RecordingSample> mFrame;
+        vector<bool> mKnownChannels;
+        // Each channel's drop count at Start, and the count since last recorded
+        vector<uint64_t> mDropBase;
+        vector<uint64_t> mDropped;
+        uint64_t mSampleCount;
+
+        // Recorder thread
+        vector<RecordingIndexEntry> mIndex;
+        uint64_t mPreviousIndex;
+        size_t mChunksSinceIndex;
+
+        mutex mMutex;
+        condition_variable mCondition;
+        deque<Chunk> mQueue;
+        atomic<bool> mRunning;
+        thread mThread;
+    };
+}
@@ -0,0 +1,138 @@
+/*
+ * RecordingFormat.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * On-disk layout of a channel recording (.pdrec), written by Recorder and
+ * read by ReplayDriver. Fields are in the byte order of the host that
+ * wrote them; a recording from a host of the other byte order fails the
+ * version check. The file is append only:
+ *
+ *     RecordingHeader
+ *     blocks, each a RecordingBlockHeader followed by size payload bytes
+ *     RecordingTrailer             only if the recorder was closed cleanly
+ *
+ * Payloads are padded to RECORDING_ALIGNMENT so every block, and every
+ * sample's timestamp, is 8-byte aligned in the mapped file.
+ *
+ * Block payloads:
+ *
+ *     Channels   RecordingChannel[count], each followed by nameLength bytes
+ *     Drops      RecordingDrops[count], the samples each channel's ring has
+ *                dropped since recording began, for channels whose count
+ *                changed since the previous Drops block (version 2)
+ *     Samples    RecordingSample[count], one frame's drained samples after
+ *                another, each frame sorted by timestamp
+ *     Index      RecordingIndexEntry[count] for every other block, Channels,
+ *                Drops and Samples, written since the previous Index block
+ *
+ * A channel is always defined before the first Samples or Drops block that
+ * uses it.
+ * Every RECORDING_INDEX_INTERVAL chunks, and once more on close, an Index
+ * block is written; each points back at the one before it (previousIndex)
+ * and the trailer points at the last, so a cleanly closed recording can be
+ * indexed without touching sample data. A recording cut short by a crash
+ * has no trailer and is recovered by walking the block headers from the
+ * front, stopping at the first incomplete block.
+ */
+
+#define RECORDING_MAGIC          "PDRC"
+#define RECORDING_TRAILER_MAGIC  "PDRE"
+#define RECORDING_VERSION        2
+// Version 1 has no Drops blocks and is otherwise the same
+#define RECORDING_MIN_VERSION    1
+#define RECORDING_EXTENSION      ".pdrec"
+#define RECORDING_ALIGNMENT      8
+// 4096 samples, 64KiB per chunk
+#define RECORDING_CHUNK_SAMPLES  4096
+#define RECORDING_INDEX_INTERVAL 64
+
+namespace octronic
+{
+    enum RecordingBlockType
+    {
+        RecordingBlock_Channels = 1,
+        RecordingBlock_Samples  = 2,
+        RecordingBlock_Index    = 3,
+        RecordingBlock_Drops    = 4
+    };
+
+    struct RecordingHeader
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t flags;
+        uint32_t reserved;
+    };
+
+    struct RecordingBlockHeader
+    {
+        uint32_t type;
+        uint32_t count;
+        uint64_t size;
+        // Samples: first and last sample. Index: first and last indexed chunk
+        double   firstTimestamp;
+        double   lastTimestamp;
+        // Index only: offset of the previous Index block, 0 for the first
+        uint64_t previousIndex;
+    };
+
+    struct RecordingChannel
+    {
+        uint32_t id;
+        uint32_t nameLength;
+    };
+
+    struct RecordingDrops
+    {
+        uint32_t channel;
+        uint32_t reserved;
+        uint64_t dropped;
+    };
+
+    struct RecordingSample
+    {
+        uint32_t channel;
+        float    value;
+        double   timestamp;
+    };
+
+    struct RecordingIndexEntry
+    {
+        uint64_t offset;
+        uint32_t type;
+        uint32_t count;
+        double   firstTimestamp;
+        double   lastTimestamp;
+    };
+
+    struct RecordingTrailer
+    {
+        uint64_t lastIndex;
+        uint64_t sampleCount;
+        char     magic[4];
+        uint32_t version;
+    };
+
+    static_assert(sizeof(RecordingHeader) == 16, "RecordingHeader must be packed");
+    static_assert(sizeof(RecordingBlockHeader) == 40, "RecordingBlockHeader must be packed");
+    static_assert(sizeof(RecordingChannel) == 8, "RecordingChannel must be packed");
+    static_assert(sizeof(RecordingDrops) == 16, "RecordingDrops must be packed");
+    static_assert(sizeof(RecordingSample) == 16, "RecordingSample must be packed");
+    static_assert(sizeof(RecordingIndexEntry) == 32, "RecordingIndexEntry must be packed");
+    static_assert(sizeof(RecordingTrailer) == 24, "RecordingTrailer must be packed");
+}
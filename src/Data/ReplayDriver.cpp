@@ -0,0 +1,372 @@
+/*
+ * ReplayDriver.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "ReplayDriver.h"
+
+#include <algorithm>
+#include <cstring>
+#include "ChannelRegistry.h"
+#include "../Common/Logger.h"
+#include "../Common/Tracer.h"
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+namespace octronic
+{
+    ReplayDriver::ReplayDriver()
+        : mSampleCount(0),
+          mSpeed(1.0),
+          mChunk(0),
+          mSample(0),
+          mPosition(0.0),
+          mWallStartPosition(0.0),
+          mReplayed(0),
+          mDropped(0),
+          mPacedFrames(0)
+    {
+    }
+
+    bool ReplayDriver::Open(const string& path)
+    {
+        debug("ReplayDriver: {} {}", __FUNCTION__, path);
+        Close();
+
+        if (!mFile.Map(path))
+        {
+            error("ReplayDriver: Unable to open {}", path);
+            return false;
+        }
+
+        const uint8_t* data = mFile.Data();
+        size_t size = mFile.Size();
+        auto header = reinterpret_cast<const RecordingHeader*>(data);
+        if (size < sizeof(RecordingHeader) ||
+            memcmp(header->magic, RECORDING_MAGIC, 4) != 0 ||
+            header->version < RECORDING_MIN_VERSION || header->version > RECORDING_VERSION)
+        {
+            error("ReplayDriver: {} is not a version {} to {} recording", path,
+                RECORDING_MIN_VERSION, RECORDING_VERSION);
+            Close();
+            return false;
+        }
+
+        bool indexed = false;
+        if (size >= sizeof(RecordingHeader) + sizeof(RecordingTrailer))
+        {
+            auto trailer = reinterpret_cast<const RecordingTrailer*>(data + size - sizeof(RecordingTrailer));
+            if (memcmp(trailer->magic, RECORDING_TRAILER_MAGIC, 4) == 0 &&
+                trailer->version == header->version)
+            {
+                indexed = ReadIndex(trailer->lastIndex);
+                if (!indexed)
+                {
+                    mChunks.clear();
+                    mChannelNames.clear();
+                    mRecordedDrops.clear();
+                    mSampleCount = 0;
+                }
+            }
+        }
+        if (!indexed)
+        {
+            warn("ReplayDriver: {} was not closed cleanly, scanning blocks", path);
+            if (!ScanBlocks())
+            {
+                Close();
+                return false;
+            }
+        }
+
+        info("ReplayDriver: {} has {} samples on {} channels, {:.1f}s",
+            path, mSampleCount, mChannelNames.size(), GetEndTime() - GetStartTime());
+        if (GetRecordedDropCount() > 0)
+        {
+            warn("ReplayDriver: {} lacks {} samples that full channels dropped while recording",
+                path, GetRecordedDropCount());
+        }
+        return true;
+    }
+
+    void ReplayDriver::Close()
+    {
+        mChunks.clear();
+        mChannelNames.clear();
+        mChannels.clear();
+        mRecordedDrops.clear();
+        mSampleCount = 0;
+        mChunk = 0;
+        mSample = 0;
+        mReplayed = 0;
+        mDropped = 0;
+        mPacedFrames = 0;
+        mFile.Unmap();
+    }
+
+    bool ReplayDriver::IsOpen() const
+    {
+        return mFile.IsMapped();
+    }
+
+    bool ReplayDriver::ReadIndex(uint64_t lastIndex)
+    {
+        const uint8_t* data = mFile.Data();
+        size_t size = mFile.Size();
+
+        // Walk the chain back to the first index, then add blocks in file order
+        vector<uint64_t> indices;
+        uint64_t offset = lastIndex;
+        while (offset != 0)
+        {
+            // Offsets come from the file, so compare differences that cannot wrap
+            if (offset % RECORDING_ALIGNMENT != 0 || offset > size ||
+                sizeof(RecordingBlockHeader) > size - offset) return false;
+            auto header = reinterpret_cast<const RecordingBlockHeader*>(data + offset);
+            if (header->type != RecordingBlock_Index ||
+                header->size != static_cast<uint64_t>(header->count) * sizeof(RecordingIndexEntry) ||
+                header->size > size - offset - sizeof(RecordingBlockHeader) ||
+                header->previousIndex >= offset) return false;
+            indices.push_back(offset);
+            offset = header->previousIndex;
+        }
+
+        for (auto itr = indices.rbegin(); itr != indices.rend(); itr++)
+        {
+            auto header = reinterpret_cast<const RecordingBlockHeader*>(data + *itr);
+            auto entries = reinterpret_cast<const RecordingIndexEntry*>(header + 1);
+            for (uint32_t i = 0; i < header->count; i++)
+            {
+                if (entries[i].offset >= *itr || !AddBlock(entries[i].offset)) return false;
+            }
+        }
+        return true;
+    }
+
+    bool ReplayDriver::ScanBlocks()
+    {
+        const uint8_t* data = mFile.Data();
+        size_t size = mFile.Size();
+        uint64_t offset = sizeof(RecordingHeader);
+        while (offset + sizeof(RecordingBlockHeader) <= size)
+        {
+            auto header = reinterpret_cast<const RecordingBlockHeader*>(data + offset);
+            // A torn write at the tail ends the recording
+            if (header->size > size - offset - sizeof(RecordingBlockHeader)) break;
+            if (header->type != RecordingBlock_Index && !AddBlock(offset)) break;
+            offset += sizeof(RecordingBlockHeader) + header->size;
+        }
+        if (mChunks.empty())
+        {
+            error("ReplayDriver: Recording holds no samples");
+            return false;
+        }
+        return true;
+    }
+
+    bool ReplayDriver::AddBlock(uint64_t offset)
+    {
+        const uint8_t* data = mFile.Data();
+        size_t size = mFile.Size();
+        if (offset % RECORDING_ALIGNMENT != 0 || offset > size ||
+            sizeof(RecordingBlockHeader) > size - offset) return false;
+
+        auto header = reinterpret_cast<const RecordingBlockHeader*>(data + offset);
+        const uint8_t* payload = data + offset + sizeof(RecordingBlockHeader);
+        if (header->size > size - offset - sizeof(RecordingBlockHeader)) return false;
+
+        if (header->type == RecordingBlock_Channels)
+        {
+            size_t read = 0;
+            for (uint32_t i = 0; i < header->count; i++)
+            {
+                RecordingChannel channel;
+                if (sizeof(channel) > header->size - read) return false;
+                memcpy(&channel, payload + read, sizeof(channel));
+                read += sizeof(channel);
+                if (channel.nameLength > header->size - read ||
+                    channel.id >= CHANNEL_REGISTRY_MAX_CHANNELS) return false;
+                if (mChannelNames.size() <= channel.id) mChannelNames.resize(channel.id + 1);
+                mChannelNames[channel.id].assign(reinterpret_cast<const char*>(payload + read), channel.nameLength);
+                read += channel.nameLength;
+            }
+            return true;
+        }
+
+        if (header->type == RecordingBlock_Drops)
+        {
+            if (header->size != static_cast<uint64_t>(header->count) * sizeof(RecordingDrops)) return false;
+            // Counts only grow, so the last block for a channel has its total
+            for (uint32_t i = 0; i < header->count; i++)
+            {
+                RecordingDrops drops;
+                memcpy(&drops, payload + i * sizeof(drops), sizeof(drops));
+                if (drops.channel >= CHANNEL_REGISTRY_MAX_CHANNELS) return false;
+                if (mRecordedDrops.size() <= drops.channel) mRecordedDrops.resize(drops.channel + 1, 0);
+                mRecordedDrops[drops.channel] = std::max(mRecordedDrops[drops.channel], drops.dropped);
+            }
+            return true;
+        }
+
+        if (header->type == RecordingBlock_Samples)
+        {
+            if (header->size != static_cast<uint64_t>(header->count) * sizeof(RecordingSample)) return false;
+            if (header->count == 0) return true;
+            Chunk chunk;
+            chunk.samples = reinterpret_cast<const RecordingSample*>(payload);
+            chunk.count = header->count;
+            chunk.firstTimestamp = header->firstTimestamp;
+            chunk.lastTimestamp = header->lastTimestamp;
+            mChunks.push_back(chunk);
+            mSampleCount += header->count;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool ReplayDriver::Start(ChannelRegistry& registry, double speed)
+    {
+        if (!IsOpen()) return false;
+
+        mChannels.assign(mChannelNames.size(), nullptr);
+        for (size_t i = 0; i < mChannelNames.size(); i++)
+        {
+            if (!mChannelNames[i].empty()) mChannels[i] = registry.Create(mChannelNames[i]);
+        }
+        mFramePushes.assign(mChannels.size(), 0);
+        mSpeed = std::max(0.0, speed);
+        mReplayed = 0;
+        mDropped = 0;
+        mPacedFrames = 0;
+        Seek(GetStartTime());
+        if (mSpeed > 0.0) info("ReplayDriver: Replaying at {}x", mSpeed);
+        else info("ReplayDriver: Replaying as fast as possible");
+        return true;
+    }
+
+    void ReplayDriver::Seek(double time)
+    {
+        auto itr = std::lower_bound(mChunks.begin(), mChunks.end(), time,
+            [](const Chunk& chunk, double t)
+            {
+                return chunk.lastTimestamp < t;
+            });
+        mChunk = static_cast<size_t>(itr - mChunks.begin());
+        mSample = 0;
+        if (mChunk < mChunks.size())
+        {
+            const Chunk& chunk = mChunks[mChunk];
+            while (mSample < chunk.count && chunk.samples[mSample].timestamp < time) mSample++;
+        }
+        mPosition = time;
+        mWallStartPosition = time;
+        mWallStart = steady_clock::now();
+    }
+
+    size_t ReplayDriver::Poll()
+    {
+        if (IsFinished()) return 0;
+        TRACE_SCOPE("ReplayDriver::Poll");
+
+        if (mSpeed > 0.0)
+        {
+            double elapsed = duration<double>(steady_clock::now() - mWallStart).count();
+            mPosition = mWallStartPosition + elapsed * mSpeed;
+        }
+        else
+        {
+            mPosition += REPLAY_FAST_FRAME_STEP;
+        }
+
+        std::fill(mFramePushes.begin(), mFramePushes.end(), 0);
+        size_t pushed = 0;
+        bool paced = false;
+        while (mChunk < mChunks.size() && !paced)
+        {
+            const Chunk& chunk = mChunks[mChunk];
+            while (mSample < chunk.count)
+            {
+                const RecordingSample& sample = chunk.samples[mSample];
+                if (sample.timestamp > mPosition) break;
+                if (sample.channel < mChannels.size() && mChannels[sample.channel] != nullptr)
+                {
+                    // The ring is drained every frame; stop before overfilling it
+                    DataChannel* channel = mChannels[sample.channel];
+                    if (mFramePushes[sample.channel] == channel->GetCapacity())
+                    {
+                        paced = true;
+                        break;
+                    }
+                    mFramePushes[sample.channel]++;
+                    if (channel->Push(sample.timestamp, sample.value)) pushed++;
+                    else mDropped++;
+                }
+                mSample++;
+            }
+            if (mSample < chunk.count) break;
+            mChunk++;
+            mSample = 0;
+        }
+        if (paced) mPacedFrames++;
+        mReplayed += pushed;
+        return pushed;
+    }
+
+    bool ReplayDriver::IsFinished() const
+    {
+        return mChunk >= mChunks.size();
+    }
+
+    double ReplayDriver::GetStartTime() const
+    {
+        return mChunks.empty() ? 0.0 : mChunks.front().firstTimestamp;
+    }
+
+    double ReplayDriver::GetEndTime() const
+    {
+        return mChunks.empty() ? 0.0 : mChunks.back().lastTimestamp;
+    }
+
+    uint64_t ReplayDriver::GetSampleCount() const
+    {
+        return mSampleCount;
+    }
+
+    uint64_t ReplayDriver::GetReplayedCount() const
+    {
+        return mReplayed;
+    }
+
+    uint64_t ReplayDriver::GetRecordedDropCount() const
+    {
+        uint64_t dropped = 0;
+        for (uint64_t count : mRecordedDrops) dropped += count;
+        return dropped;
+    }
+
+    uint64_t ReplayDriver::GetDroppedCount() const
+    {
+        return mDropped;
+    }
+
+    uint64_t ReplayDriver::GetPacedFrameCount() const
+    {
+        return mPacedFrames;
+    }
+
+    size_t ReplayDriver::GetChunkCount() const
+    {
+        return mChunks.size();
+    }
+}
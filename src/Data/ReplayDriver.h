@@ -0,0 +1,121 @@
+/*
+ * ReplayDriver.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "../Common/MappedFile.h"
+#include "RecordingFormat.h"
+
+using std::string;
+using std::vector;
+using Coconut::MappedFile;
+
+// Recording time advanced per frame when replaying as fast as possible
+#define REPLAY_FAST_FRAME_STEP (1.0 / 60.0)
+
+namespace octronic
+{
+    class ChannelRegistry;
+    class DataChannel;
+
+    /**
+     * @brief Feeds a recording (see RecordingFormat.h) back into the data
+     * channels, on the render thread, once per frame before the drain.
+     *
+     * At speed s > 0 the recording plays at s times real time. At speed 0
+     * it plays as fast as the dashboard renders: every frame advances the
+     * recording by REPLAY_FAST_FRAME_STEP, whatever the frame took, so each
+     * run feeds the same samples into the same frames.
+     *
+     * A frame never pushes more samples into a channel than its ring
+     * holds. Samples past that wait for the next frame, so a burst in the
+     * recording is spread over frames rather than dropped.
+     */
+    class ReplayDriver
+    {
+    public:
+        ReplayDriver();
+
+        bool Open(const string& path);
+        void Close();
+        bool IsOpen() const;
+
+        /**
+         * @brief Creates (or finds) the recorded channels in the registry
+         * and starts playback from the beginning.
+         */
+        bool Start(ChannelRegistry& registry, double speed = 1.0);
+
+        /** @brief Moves playback to the first sample at or after time. */
+        void Seek(double time);
+
+        /**
+         * @brief Pushes every sample due by now, as far as the channels
+         * have room.
+         * @return The number of samples the channels accepted.
+         */
+        size_t Poll();
+
+        bool IsFinished() const;
+
+        double GetStartTime() const;
+        double GetEndTime() const;
+        uint64_t GetSampleCount() const;
+        uint64_t GetReplayedCount() const;
+        /** @brief Samples the channels dropped while the recording was made, so it lacks. */
+        uint64_t GetRecordedDropCount() const;
+        /** @brief Pushes that found the ring full anyway, e.g. when another producer shares the channel. */
+        uint64_t GetDroppedCount() const;
+        /** @brief Polls that held samples back for a later frame. */
+        uint64_t GetPacedFrameCount() const;
+        size_t GetChunkCount() const;
+
+    protected:
+        struct Chunk
+        {
+            const RecordingSample* samples;
+            uint32_t count;
+            double firstTimestamp;
+            double lastTimestamp;
+        };
+
+        bool ReadIndex(uint64_t lastIndex);
+        bool ScanBlocks();
+        bool AddBlock(uint64_t offset);
+
+    private:
+        MappedFile mFile;
+        vector<Chunk> mChunks;
+        vector<string> mChannelNames;
+        vector<DataChannel*> mChannels;
+        uint64_t mSampleCount;
+        // Per channel, from the recording's Drops blocks
+        vector<uint64_t> mRecordedDrops;
+
+        double mSpeed;
+        size_t mChunk;
+        uint32_t mSample;
+        double mPosition;
+        std::chrono::steady_clock::time_point mWallStart;
+        double mWallStartPosition;
+        uint64_t mReplayed;
+        uint64_t mDropped;
+        uint64_t mPacedFrames;
+        // Samples pushed into each channel by the current Poll
+        vector<size_t> mFramePushes;
+    };
+}
@@ -0,0 +1,210 @@
+/*
+ * ShmIngest.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "ShmIngest.h"
+
+#include "ChannelRegistry.h"
+#include "../Common/Logger.h"
+#include "../Common/Time.h"
+#include "../Common/Tracer.h"
+
+#define SHM_INGEST_RETRY_MS 1000
+
+namespace octronic
+{
+    ShmIngest::ShmIngest()
+        : mEnabled(false),
+          mRing(nullptr),
+          mMappedSize(0),
+          mCapacity(0),
+          mGeneration(0),
+          mCursor(0),
+          mLost(0),
+          mDropped(0),
+          mNextAttachTime(0)
+    {
+    }
+
+    ShmIngest::~ShmIngest()
+    {
+        Stop();
+    }
+
+    void ShmIngest::Start(const string& name)
+    {
+        mName = name;
+        mEnabled = true;
+        mNextAttachTime = 0;
+        info("ShmIngest: Reading shared memory ring {}", mName);
+    }
+
+    void ShmIngest::Stop()
+    {
+        mEnabled = false;
+        Detach();
+    }
+
+    bool ShmIngest::IsAttached() const
+    {
+        return mRing != nullptr;
+    }
+
+    uint64_t ShmIngest::GetLostCount() const
+    {
+        return mLost;
+    }
+
+    uint64_t ShmIngest::GetDroppedCount() const
+    {
+        return mDropped;
+    }
+
+    bool ShmIngest::Attach()
+    {
+#ifdef _WIN32
+        return false;
+#else
+        int fd = shm_open(mName.c_str(), O_RDONLY, 0);
+        if (fd < 0) return false;
+
+        struct stat status;
+        if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(ShmRingHeader))
+        {
+            close(fd);
+            return false;
+        }
+
+        size_t size = static_cast<size_t>(status.st_size);
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) return false;
+
+        // The producer can rewrite the header at any time, so the capacity
+        // is read once and that copy is what gets checked and used
+        auto ring = static_cast<const ShmRingHeader*>(mapping);
+        uint32_t capacity = __atomic_load_n(&ring->capacity, __ATOMIC_RELAXED);
+        if (__atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC ||
+            !shm_ring_is_valid(ring, size) ||
+            capacity == 0 || (capacity & (capacity - 1)) != 0 || shm_ring_size(capacity) > size)
+        {
+            munmap(mapping, size);
+            return false;
+        }
+
+        mRing = ring;
+        mMappedSize = size;
+        mCapacity = capacity;
+        mGeneration = ring->generation;
+        mCursor = __atomic_load_n(&ring->writeIndex, __ATOMIC_ACQUIRE);
+        mChannels.clear();
+        info("ShmIngest: Attached to {} ({} slots)", mName, mCapacity);
+        return true;
+#endif
+    }
+
+    void ShmIngest::Detach()
+    {
+#ifndef _WIN32
+        if (mRing != nullptr)
+        {
+            munmap(const_cast<ShmRingHeader*>(mRing), mMappedSize);
+            mRing = nullptr;
+            mMappedSize = 0;
+            mCapacity = 0;
+            mChannels.clear();
+        }
+#endif
+    }
+
+    void ShmIngest::ResolveChannels(ChannelRegistry& registry)
+    {
+        uint32_t count = __atomic_load_n(&mRing->channelCount, __ATOMIC_ACQUIRE);
+        if (count > SHM_RING_MAX_CHANNELS) count = SHM_RING_MAX_CHANNELS;
+        while (mChannels.size() < count)
+        {
+            const char* name = mRing->channelNames[mChannels.size()];
+            string channelName(name, strnlen(name, SHM_RING_NAME_LENGTH));
+            mChannels.push_back(registry.Create(channelName));
+        }
+    }
+
+    size_t ShmIngest::Poll(ChannelRegistry& registry)
+    {
+        if (!mEnabled) return 0;
+        TRACE_SCOPE("ShmIngest::Poll");
+
+        if (mRing == nullptr)
+        {
+            long now = Time::GetCurrentTime();
+            if (now < mNextAttachTime) return 0;
+            mNextAttachTime = now + SHM_INGEST_RETRY_MS;
+            if (!Attach()) return 0;
+        }
+
+        // The producer restarted, possibly with another capacity
+        if (__atomic_load_n(&mRing->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC ||
+            mRing->generation != mGeneration)
+        {
+            info("ShmIngest: Producer on {} restarted, reattaching", mName);
+            Detach();
+            if (!Attach()) return 0;
+        }
+
+        ResolveChannels(registry);
+
+        const uint64_t capacity = mCapacity;
+        const uint64_t mask = capacity - 1;
+        const ShmRingSlot* slots = shm_ring_slots_const(mRing);
+        uint64_t write = __atomic_load_n(&mRing->writeIndex, __ATOMIC_ACQUIRE);
+
+        if (write - mCursor > capacity)
+        {
+            mLost += write - mCursor - capacity;
+            mCursor = write - capacity;
+        }
+
+        size_t accepted = 0;
+        for (; mCursor < write; mCursor++)
+        {
+            const ShmRingSlot* slot = &slots[mCursor & mask];
+            uint64_t before = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+            if (before != mCursor + 1)
+            {
+                mLost++;
+                continue;
+            }
+
+            DataSample sample;
+            uint32_t channel = __atomic_load_n(&slot->channel, __ATOMIC_RELAXED);
+            __atomic_load(&slot->timestamp, &sample.timestamp, __ATOMIC_RELAXED);
+            __atomic_load(&slot->value, &sample.value, __ATOMIC_RELAXED);
+            sample.reserved = 0;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) != before)
+            {
+                mLost++;
+                continue;
+            }
+
+            // A channel registered after the last resolve
+            if (channel >= mChannels.size()) ResolveChannels(registry);
+            if (channel < mChannels.size() && mChannels[channel] != nullptr)
+            {
+                if (mChannels[channel]->Push(sample)) accepted++;
+                else mDropped++;
+            }
+        }
+        return accepted;
+    }
+}
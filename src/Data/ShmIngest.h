@@ -0,0 +1,77 @@
+/*
+ * ShmIngest.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ShmRing.h"
+
+using std::string;
+using std::vector;
+
+namespace octronic
+{
+    class ChannelRegistry;
+    class DataChannel;
+
+    /**
+     * @brief Reads samples from a shared-memory ring (see ShmRing.h)
+     * written by an external producer process. The ring is mapped read-only
+     * and slots are read in place once per frame on the render thread;
+     * attaching is retried while the producer is absent.
+     */
+    class ShmIngest
+    {
+    public:
+        ShmIngest();
+        ~ShmIngest();
+
+        void Start(const string& name);
+        void Stop();
+        bool IsAttached() const;
+
+        /**
+         * @brief Forwards every sample published since the last call into
+         * its data channel.
+         * @return The number of samples the channels accepted.
+         */
+        size_t Poll(ChannelRegistry& registry);
+
+        /** @brief Samples overwritten or torn before they could be read. */
+        uint64_t GetLostCount() const;
+        /** @brief Samples read but dropped because their channel was full. */
+        uint64_t GetDroppedCount() const;
+
+    protected:
+        bool Attach();
+        void Detach();
+        void ResolveChannels(ChannelRegistry& registry);
+
+    private:
+        string mName;
+        bool mEnabled;
+        const ShmRingHeader* mRing;
+        size_t mMappedSize;
+        // Validated against mMappedSize in Attach; the header's copy is
+        // producer-writable and never read again
+        uint32_t mCapacity;
+        uint64_t mGeneration;
+        uint64_t mCursor;
+        uint64_t mLost;
+        uint64_t mDropped;
+        long mNextAttachTime;
+        vector<DataChannel*> mChannels;
+    };
+}
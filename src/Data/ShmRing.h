@@ -0,0 +1,196 @@
+/*
+ * ShmRing.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+/*
+ * Shared-memory sample ring for out-of-process producers. Plain C so that
+ * acquisition daemons can include it without the rest of PiDash; compiles
+ * as C99 or C++ with GCC or Clang.
+ *
+ * Layout of the POSIX shared memory object (native endianness):
+ *
+ *     ShmRingHeader                      4096 bytes
+ *     ShmRingSlot[capacity]              24 bytes each, capacity a power of 2
+ *
+ * Protocol, one producer process per ring:
+ *
+ *  - The producer creates the object, fills in the header with
+ *    shm_ring_init and registers channel names with shm_ring_add_channel.
+ *    A channel index in a slot refers to header.channelNames[index].
+ *  - Sample n goes to slot n & (capacity - 1). The producer sets the
+ *    slot's sequence to 0, writes the payload, sets sequence to n + 1
+ *    (release) and finally publishes writeIndex = n + 1 (release).
+ *  - Readers never write to the object. A reader keeps its own cursor,
+ *    reads slots [cursor, writeIndex) and accepts a slot only if its
+ *    sequence is cursor + 1 both before and after copying the payload.
+ *    Slots overwritten in the meantime are counted as lost. The producer
+ *    therefore never waits for a reader.
+ *  - A producer restart re-initialises the header with a new
+ *    generation; readers seeing a different generation resynchronise.
+ */
+
+#ifndef PIDASH_SHM_RING_H
+#define PIDASH_SHM_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <time.h>
+    #include <unistd.h>
+#endif
+
+#define SHM_RING_MAGIC            0x48534450u /* "PDSH" */
+#define SHM_RING_VERSION          1u
+#define SHM_RING_DEFAULT_NAME     "/pidash-ingest"
+#define SHM_RING_DEFAULT_CAPACITY 65536u
+#define SHM_RING_MAX_CHANNELS     64u
+#define SHM_RING_NAME_LENGTH      48u
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ShmRingSlot
+{
+    uint64_t sequence;   /* n + 1 once sample n is complete, 0 while written */
+    double   timestamp;  /* seconds, producer clock */
+    uint32_t channel;    /* index into ShmRingHeader.channelNames */
+    float    value;
+} ShmRingSlot;
+
+typedef struct ShmRingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t slotSize;
+    uint64_t generation;
+    uint32_t channelCount;   /* published with release after the name */
+    uint32_t reserved;
+    char     channelNames[SHM_RING_MAX_CHANNELS][SHM_RING_NAME_LENGTH];
+    uint8_t  padding0[4096 - 32 - SHM_RING_MAX_CHANNELS * SHM_RING_NAME_LENGTH - 64];
+    uint64_t writeIndex;     /* own cache line, written by the producer only */
+    uint8_t  padding1[56];
+} ShmRingHeader;
+
+typedef char ShmRingHeaderSizeCheck[sizeof(ShmRingHeader) == 4096 ? 1 : -1];
+typedef char ShmRingSlotSizeCheck[sizeof(ShmRingSlot) == 24 ? 1 : -1];
+
+static inline size_t shm_ring_size(uint32_t capacity)
+{
+    return sizeof(ShmRingHeader) + (size_t)capacity * sizeof(ShmRingSlot);
+}
+
+static inline ShmRingSlot* shm_ring_slots(ShmRingHeader* ring)
+{
+    return (ShmRingSlot*)(ring + 1);
+}
+
+static inline const ShmRingSlot* shm_ring_slots_const(const ShmRingHeader* ring)
+{
+    return (const ShmRingSlot*)(ring + 1);
+}
+
+/* Validates a mapped header against the size of its mapping */
+static inline int shm_ring_is_valid(const ShmRingHeader* ring, size_t mappedSize)
+{
+    if (mappedSize < sizeof(ShmRingHeader)) return 0;
+    if (ring->magic != SHM_RING_MAGIC || ring->version != SHM_RING_VERSION) return 0;
+    if (ring->slotSize != sizeof(ShmRingSlot)) return 0;
+    if (ring->capacity == 0 || (ring->capacity & (ring->capacity - 1)) != 0) return 0;
+    return shm_ring_size(ring->capacity) <= mappedSize;
+}
+
+/* Producer: capacity must be a power of two */
+static inline void shm_ring_init(ShmRingHeader* ring, uint32_t capacity, uint64_t generation)
+{
+    memset(ring, 0, shm_ring_size(capacity));
+    ring->version = SHM_RING_VERSION;
+    ring->capacity = capacity;
+    ring->slotSize = sizeof(ShmRingSlot);
+    ring->generation = generation;
+    __atomic_store_n(&ring->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+}
+
+/* Producer: returns the channel index, or -1 when the table is full */
+static inline int shm_ring_add_channel(ShmRingHeader* ring, const char* name)
+{
+    uint32_t count = ring->channelCount;
+    uint32_t i;
+    size_t length;
+    for (i = 0; i < count; i++)
+    {
+        if (strncmp(ring->channelNames[i], name, SHM_RING_NAME_LENGTH - 1) == 0) return (int)i;
+    }
+    if (count >= SHM_RING_MAX_CHANNELS) return -1;
+    /* Truncated to fit; the slot is always NUL terminated */
+    length = strnlen(name, SHM_RING_NAME_LENGTH - 1);
+    memcpy(ring->channelNames[count], name, length);
+    ring->channelNames[count][length] = '\0';
+    __atomic_store_n(&ring->channelCount, count + 1, __ATOMIC_RELEASE);
+    return (int)count;
+}
+
+/* Producer: never blocks; overwrites the oldest sample when readers lag */
+static inline void shm_ring_push(ShmRingHeader* ring, uint32_t channel, double timestamp, float value)
+{
+    uint64_t index = ring->writeIndex;
+    ShmRingSlot* slot = &shm_ring_slots(ring)[index & (ring->capacity - 1)];
+    __atomic_store_n(&slot->sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store(&slot->timestamp, &timestamp, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->channel, channel, __ATOMIC_RELAXED);
+    __atomic_store(&slot->value, &value, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->sequence, index + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->writeIndex, index + 1, __ATOMIC_RELEASE);
+}
+
+#ifndef _WIN32
+/* Producer: creates (or replaces) and maps the shared memory object */
+static inline ShmRingHeader* shm_ring_create(const char* name, uint32_t capacity)
+{
+    size_t size = shm_ring_size(capacity);
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    void* mapping;
+    struct timespec now;
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return NULL;
+    clock_gettime(CLOCK_REALTIME, &now);
+    shm_ring_init((ShmRingHeader*)mapping, capacity,
+        (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec);
+    return (ShmRingHeader*)mapping;
+}
+
+static inline void shm_ring_close(ShmRingHeader* ring)
+{
+    if (ring != NULL) munmap(ring, shm_ring_size(ring->capacity));
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PIDASH_SHM_RING_H */
@@ -0,0 +1,64 @@
+/*
+ * SocketIngestProtocol.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Wire format of the Unix domain socket ingest (native endianness, the
+ * socket is local). A connection carries a stream of frames, each a
+ * SocketIngestFrameHeader followed by size bytes of payload:
+ *
+ *     RegisterChannel  uint32_t channel, then the channel name
+ *                      (size - 4 bytes, no terminator, at most
+ *                      SOCKET_INGEST_MAX_NAME). Binds a
+ *                      connection-local channel number to a named
+ *                      dashboard channel.
+ *     Samples          size / 16 SocketIngestSample records, for channel
+ *                      numbers registered earlier on the same connection.
+ *
+ * A frame larger than SOCKET_INGEST_MAX_FRAME, of unknown type or with an
+ * over-long channel name closes the connection.
+ */
+
+#define SOCKET_INGEST_DEFAULT_PATH "/tmp/pidash-ingest.sock"
+#define SOCKET_INGEST_MAX_FRAME    (1 << 20)
+#define SOCKET_INGEST_MAX_NAME     64
+
+namespace octronic
+{
+    enum SocketIngestFrameType
+    {
+        SocketIngest_RegisterChannel = 1,
+        SocketIngest_Samples = 2
+    };
+
+    struct SocketIngestFrameHeader
+    {
+        uint32_t size;
+        uint16_t type;
+        uint16_t reserved;
+    };
+
+    struct SocketIngestSample
+    {
+        uint32_t channel;
+        float value;
+        double timestamp;
+    };
+
+    static_assert(sizeof(SocketIngestFrameHeader) == 8, "SocketIngestFrameHeader must be packed");
+    static_assert(sizeof(SocketIngestSample) == 16, "SocketIngestSample must be packed");
+}
@@ -0,0 +1,342 @@
+/*
+ * SocketIngestServer.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "SocketIngestServer.h"
+
+#ifdef __linux__
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include "ChannelRegistry.h"
+#include "../Common/Logger.h"
+#include "../Common/Time.h"
+#include "../Common/Tracer.h"
+
+#define SOCKET_INGEST_READ_SIZE  65536
+#define SOCKET_INGEST_MAX_EVENTS 32
+#define SOCKET_INGEST_STATS_MS   5000
+
+namespace octronic
+{
+    SocketIngestServer::SocketIngestServer()
+        : mRegistry(nullptr),
+          mListenFd(-1),
+          mEpollFd(-1),
+          mWakeFd(-1),
+          mRunning(false),
+          mSampleCount(0),
+          mDroppedCount(0)
+    {
+        debug("SocketIngestServer: Constructor");
+    }
+
+    SocketIngestServer::~SocketIngestServer()
+    {
+        debug("SocketIngestServer: Destructor");
+        Stop();
+    }
+
+    bool SocketIngestServer::Start(const string& path, ChannelRegistry& registry)
+    {
+        debug("SocketIngestServer: {}", __FUNCTION__);
+        if (mRunning) return true;
+#ifdef __linux__
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            error("SocketIngestServer: Socket path {} is too long", path);
+            return false;
+        }
+        strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+        mListenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (mListenFd < 0)
+        {
+            error("SocketIngestServer: socket failed: {}", strerror(errno));
+            return false;
+        }
+
+        // A stale socket file from a previous run would make bind fail
+        unlink(path.c_str());
+        if (bind(mListenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(mListenFd, 16) != 0)
+        {
+            error("SocketIngestServer: Unable to listen on {}: {}", path, strerror(errno));
+            close(mListenFd);
+            mListenFd = -1;
+            return false;
+        }
+
+        mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+        mWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = mListenFd;
+        epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mListenFd, &event);
+        event.data.fd = mWakeFd;
+        epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeFd, &event);
+
+        mPath = path;
+        mRegistry = &registry;
+        mRunning = true;
+        mThread = thread(&SocketIngestServer::Run, this);
+        info("SocketIngestServer: Listening on {}", path);
+        return true;
+#else
+        warn("SocketIngestServer: Not supported on this platform");
+        return false;
+#endif
+    }
+
+    void SocketIngestServer::Stop()
+    {
+        if (!mRunning) return;
+        debug("SocketIngestServer: {}", __FUNCTION__);
+        mRunning = false;
+#ifdef __linux__
+        uint64_t wake = 1;
+        if (write(mWakeFd, &wake, sizeof(wake)) < 0)
+        {
+            warn("SocketIngestServer: Unable to wake the server thread");
+        }
+        if (mThread.joinable()) mThread.join();
+
+        for (auto& connection : mConnections) close(connection.first);
+        mConnections.clear();
+        close(mListenFd);
+        close(mEpollFd);
+        close(mWakeFd);
+        unlink(mPath.c_str());
+#endif
+        mListenFd = -1;
+        mEpollFd = -1;
+        mWakeFd = -1;
+    }
+
+    bool SocketIngestServer::IsRunning() const
+    {
+        return mRunning;
+    }
+
+    uint64_t SocketIngestServer::GetSampleCount() const
+    {
+        return mSampleCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t SocketIngestServer::GetDroppedCount() const
+    {
+        return mDroppedCount.load(std::memory_order_relaxed);
+    }
+
+    void SocketIngestServer::Run()
+    {
+#ifdef __linux__
+        Tracer::SetThreadName("SocketIngest");
+        debug("SocketIngestServer: Thread started");
+        epoll_event events[SOCKET_INGEST_MAX_EVENTS];
+        long statsTime = Time::GetCurrentTime();
+        uint64_t statsSamples = 0;
+        uint64_t statsDropped = 0;
+
+        while (mRunning)
+        {
+            int count = epoll_wait(mEpollFd, events, SOCKET_INGEST_MAX_EVENTS, SOCKET_INGEST_STATS_MS);
+            for (int i = 0; i < count; i++)
+            {
+                int fd = events[i].data.fd;
+                if (fd == mWakeFd) continue;
+                if (fd == mListenFd)
+                {
+                    Accept();
+                    continue;
+                }
+
+                auto connection = mConnections.find(fd);
+                if (connection == mConnections.end()) continue;
+                if ((events[i].events & (EPOLLERR | EPOLLHUP)) && !(events[i].events & EPOLLIN))
+                {
+                    CloseConnection(fd);
+                }
+                else if (!Receive(fd, connection->second))
+                {
+                    CloseConnection(fd);
+                }
+            }
+
+            long now = Time::GetCurrentTime();
+            if (now - statsTime >= SOCKET_INGEST_STATS_MS)
+            {
+                uint64_t samples = GetSampleCount();
+                uint64_t dropped = GetDroppedCount();
+                if (samples != statsSamples || dropped != statsDropped)
+                {
+                    debug("SocketIngestServer: {:.0f} samples/s from {} connection(s), {} dropped by full channels",
+                          (samples - statsSamples) * 1000.0 / (now - statsTime), mConnections.size(),
+                          dropped - statsDropped);
+                }
+                statsSamples = samples;
+                statsDropped = dropped;
+                statsTime = now;
+            }
+        }
+        debug("SocketIngestServer: Thread stopped");
+#endif
+    }
+
+    void SocketIngestServer::Accept()
+    {
+#ifdef __linux__
+        for (;;)
+        {
+            int fd = accept4(mListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+
+            epoll_event event;
+            memset(&event, 0, sizeof(event));
+            event.events = EPOLLIN | EPOLLRDHUP;
+            event.data.fd = fd;
+            if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+            {
+                close(fd);
+                continue;
+            }
+
+            Connection& connection = mConnections[fd];
+            connection.buffer.resize(SOCKET_INGEST_READ_SIZE);
+            connection.used = 0;
+            debug("SocketIngestServer: Producer connected ({})", fd);
+        }
+#endif
+    }
+
+    bool SocketIngestServer::Receive(int fd, Connection& connection)
+    {
+#ifdef __linux__
+        TRACE_SCOPE("SocketIngestServer::Receive");
+        for (;;)
+        {
+            if (connection.buffer.size() - connection.used < SOCKET_INGEST_READ_SIZE)
+            {
+                connection.buffer.resize(connection.used + SOCKET_INGEST_READ_SIZE);
+            }
+
+            ssize_t length = read(fd, connection.buffer.data() + connection.used,
+                connection.buffer.size() - connection.used);
+            if (length > 0)
+            {
+                connection.used += static_cast<size_t>(length);
+                if (!ProcessFrames(connection)) return false;
+            }
+            else if (length == 0)
+            {
+                return false;
+            }
+            else
+            {
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            }
+        }
+#else
+        return false;
+#endif
+    }
+
+    bool SocketIngestServer::ProcessFrames(Connection& connection)
+    {
+        size_t offset = 0;
+        uint64_t samples = 0;
+        uint64_t dropped = 0;
+
+        while (connection.used - offset >= sizeof(SocketIngestFrameHeader))
+        {
+            SocketIngestFrameHeader header;
+            memcpy(&header, connection.buffer.data() + offset, sizeof(header));
+            if (header.size > SOCKET_INGEST_MAX_FRAME)
+            {
+                warn("SocketIngestServer: Frame of {} bytes exceeds the limit, closing", header.size);
+                return false;
+            }
+            if (connection.used - offset - sizeof(header) < header.size) break;
+
+            const uint8_t* payload = connection.buffer.data() + offset + sizeof(header);
+            if (header.type == SocketIngest_RegisterChannel)
+            {
+                if (header.size < sizeof(uint32_t)) return false;
+                uint32_t channel;
+                memcpy(&channel, payload, sizeof(channel));
+                if (channel >= CHANNEL_REGISTRY_MAX_CHANNELS) return false;
+                if (header.size - sizeof(channel) > SOCKET_INGEST_MAX_NAME)
+                {
+                    warn("SocketIngestServer: Channel name of {} bytes exceeds the limit, closing",
+                        header.size - sizeof(channel));
+                    return false;
+                }
+                string name(reinterpret_cast<const char*>(payload + sizeof(channel)),
+                    header.size - sizeof(channel));
+                if (connection.channels.size() <= channel) connection.channels.resize(channel + 1, nullptr);
+                connection.channels[channel] = mRegistry->Create(name);
+            }
+            else if (header.type == SocketIngest_Samples)
+            {
+                size_t count = header.size / sizeof(SocketIngestSample);
+                for (size_t i = 0; i < count; i++)
+                {
+                    SocketIngestSample sample;
+                    memcpy(&sample, payload + i * sizeof(sample), sizeof(sample));
+                    if (sample.channel < connection.channels.size() &&
+                        connection.channels[sample.channel] != nullptr)
+                    {
+                        if (connection.channels[sample.channel]->Push(sample.timestamp, sample.value)) samples++;
+                        else dropped++;
+                    }
+                }
+            }
+            else
+            {
+                warn("SocketIngestServer: Unknown frame type {}, closing", header.type);
+                return false;
+            }
+            offset += sizeof(header) + header.size;
+        }
+
+        // Keep the partial frame at the front of the buffer
+        if (offset > 0)
+        {
+            memmove(connection.buffer.data(), connection.buffer.data() + offset, connection.used - offset);
+            connection.used -= offset;
+        }
+        mSampleCount.fetch_add(samples, std::memory_order_relaxed);
+        mDroppedCount.fetch_add(dropped, std::memory_order_relaxed);
+        return true;
+    }
+
+    void SocketIngestServer::CloseConnection(int fd)
+    {
+#ifdef __linux__
+        debug("SocketIngestServer: Producer disconnected ({})", fd);
+        epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+#endif
+        mConnections.erase(fd);
+    }
+}
@@ -0,0 +1,86 @@
+/*
+ * SocketIngestServer.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SocketIngestProtocol.h"
+
+using std::atomic;
+using std::map;
+using std::string;
+using std::thread;
+using std::vector;
+
+namespace octronic
+{
+    class ChannelRegistry;
+    class DataChannel;
+
+    /**
+     * @brief Accepts sample batches (see SocketIngestProtocol.h) from local
+     * producers on a Unix domain socket and pushes them into data channels.
+     * All socket handling runs on the server's own thread with
+     * non-blocking sockets and epoll; the render thread only drains the
+     * channels as usual.
+     *
+     * Linux only. Start fails on other platforms.
+     */
+    class SocketIngestServer
+    {
+    public:
+        SocketIngestServer();
+        ~SocketIngestServer();
+
+        bool Start(const string& path, ChannelRegistry& registry);
+        void Stop();
+        bool IsRunning() const;
+
+        /** @brief Samples the channels accepted. */
+        uint64_t GetSampleCount() const;
+        /** @brief Samples received but dropped because their channel was full. */
+        uint64_t GetDroppedCount() const;
+
+    protected:
+        struct Connection
+        {
+            vector<uint8_t> buffer;
+            size_t used;
+            vector<DataChannel*> channels;
+        };
+
+        void Run();
+        void Accept();
+        bool Receive(int fd, Connection& connection);
+        bool ProcessFrames(Connection& connection);
+        void CloseConnection(int fd);
+
+    private:
+        string mPath;
+        ChannelRegistry* mRegistry;
+        int mListenFd;
+        int mEpollFd;
+        int mWakeFd;
+        atomic<bool> mRunning;
+        thread mThread;
+        map<int, Connection> mConnections;
+        atomic<uint64_t> mSampleCount;
+        atomic<uint64_t> mDroppedCount;
+    };
+}
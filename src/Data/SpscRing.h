@@ -0,0 +1,98 @@
+/*
+ * SpscRing.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include "CacheAligned.h"
+
+using std::atomic;
+using std::vector;
+
+namespace octronic
+{
+    /**
+     * @brief Bounded wait-free ring for exactly one producer thread and one
+     * consumer thread. Capacity is rounded up to a power of two.
+     */
+    template <typename T>
+    class SpscRing : public CacheAligned
+    {
+    public:
+        explicit SpscRing(size_t capacity)
+            : mHead(0),
+              mTail(0)
+        {
+            size_t size = 1;
+            while (size < capacity) size <<= 1;
+            mBuffer.resize(size);
+            mMask = size - 1;
+        }
+
+        /**
+         * @brief Producer side. Returns false, without blocking, when full.
+         */
+        bool TryPush(const T& item)
+        {
+            size_t head = mHead.load(std::memory_order_relaxed);
+            if (head - mTail.load(std::memory_order_acquire) > mMask) return false;
+            mBuffer[head & mMask] = item;
+            mHead.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool TryPop(T& item)
+        {
+            size_t tail = mTail.load(std::memory_order_relaxed);
+            if (tail == mHead.load(std::memory_order_acquire)) return false;
+            item = mBuffer[tail & mMask];
+            mTail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Consumer side. Appends up to maxItems to out with a single
+         * acquire/release pair.
+         * @return The number of items appended.
+         */
+        size_t PopBatch(vector<T>& out, size_t maxItems)
+        {
+            size_t tail = mTail.load(std::memory_order_relaxed);
+            size_t available = mHead.load(std::memory_order_acquire) - tail;
+            size_t count = available < maxItems ? available : maxItems;
+            for (size_t i = 0; i < count; i++)
+            {
+                out.push_back(mBuffer[(tail + i) & mMask]);
+            }
+            mTail.store(tail + count, std::memory_order_release);
+            return count;
+        }
+
+        size_t GetCapacity() const
+        {
+            return mMask + 1;
+        }
+
+    private:
+        SpscRing(const SpscRing&);
+        SpscRing& operator=(const SpscRing&);
+
+        alignas(DATA_CACHE_LINE_SIZE) atomic<size_t> mHead;
+        alignas(DATA_CACHE_LINE_SIZE) atomic<size_t> mTail;
+        alignas(DATA_CACHE_LINE_SIZE) vector<T> mBuffer;
+        size_t mMask;
+    };
+}
@@ -6,6 +6,7 @@
 #include "AppState.h"
 #include "Window.h"
 #include "Common/Logger.h"
+#include "Common/Tracer.h"
 
 using namespace octronic;
 
@@ -14,13 +15,24 @@ int main(int argc,char** argv)
     spdlog::set_level(spdlog::level::debug);
    	debug("Starting main");
     AppState s(argc, argv);
+
+    string tracePath;
+    if (s.GetArgumentValue("--trace", tracePath))
+    {
+        Tracer::Enable(tracePath);
+        Tracer::SetThreadName("Main");
+    }
+
     if (s.Init())
     {
-	    return s.Run();
+	    bool result = s.Run();
+        if (Tracer::IsEnabled()) Tracer::WriteChromeTrace();
+        return result;
     }
     else
     {
         error("Main: AppState Initialisation failed");
+        if (Tracer::IsEnabled()) Tracer::WriteChromeTrace();
     	exit(1);
     }
     exit(0);
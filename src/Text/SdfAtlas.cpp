@@ -0,0 +1,231 @@
+/*
+ * SdfAtlas.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "SdfAtlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "../Common/Logger.h"
+
+namespace octronic
+{
+    SdfAtlas::SdfAtlas()
+        : mWidth(0),
+          mHeight(0),
+          mSpread(0),
+          mLineHeight(0.0f),
+          mAscender(0.0f)
+    {
+        std::fill(mAsciiIndex, mAsciiIndex + 128, -1);
+    }
+
+    vector<uint32_t> SdfAtlas::AsciiCodepoints()
+    {
+        vector<uint32_t> codepoints;
+        for (uint32_t c = 32; c < 127; c++) codepoints.push_back(c);
+        return codepoints;
+    }
+
+    bool SdfAtlas::Build(const TrueTypeFont& font, const vector<uint32_t>& codepoints,
+        int pixelSize, int spread)
+    {
+        if (!font.IsLoaded() || pixelSize <= 0 || spread <= 0) return false;
+
+        float unitsPerEm = static_cast<float>(font.GetUnitsPerEm());
+        float scale = pixelSize / unitsPerEm;
+        mSpread = spread;
+        mGlyphs.clear();
+        mOtherIndex.clear();
+        std::fill(mAsciiIndex, mAsciiIndex + 128, -1);
+        mLineHeight = (font.GetAscender() - font.GetDescender() + font.GetLineGap()) / unitsPerEm;
+        mAscender = font.GetAscender() / unitsPerEm;
+
+        struct Pending
+        {
+            vector<FontContour> contours;
+            vec2 origin;
+            int x, y, width, height;
+        };
+        vector<Pending> pending(codepoints.size());
+
+        // Shelf-pack glyph boxes (padded by the spread) into rows
+        int penX = 1;
+        int penY = 1;
+        int rowHeight = 0;
+        for (size_t i = 0; i < codepoints.size(); i++)
+        {
+            uint16_t glyph = font.GetGlyphIndex(codepoints[i]);
+            int advance;
+            int leftBearing;
+            font.GetHorizontalMetrics(glyph, advance, leftBearing);
+
+            SdfGlyph g;
+            g.codepoint = codepoints[i];
+            g.advance = advance / unitsPerEm;
+            g.plane = vec4(0.0f);
+            g.uv = vec4(0.0f);
+
+            Pending& p = pending[i];
+            p.width = 0;
+            p.height = 0;
+            font.GetGlyphOutline(glyph, p.contours);
+
+            vec2 lo(std::numeric_limits<float>::max());
+            vec2 hi(-std::numeric_limits<float>::max());
+            for (const FontContour& contour : p.contours)
+            {
+                for (const vec2& point : contour)
+                {
+                    lo = glm::min(lo, point);
+                    hi = glm::max(hi, point);
+                }
+            }
+
+            if (!p.contours.empty())
+            {
+                int x0 = static_cast<int>(std::floor(lo.x * scale)) - spread;
+                int y0 = static_cast<int>(std::floor(lo.y * scale)) - spread;
+                int x1 = static_cast<int>(std::ceil(hi.x * scale)) + spread;
+                int y1 = static_cast<int>(std::ceil(hi.y * scale)) + spread;
+                p.width = x1 - x0;
+                p.height = y1 - y0;
+                p.origin = vec2(static_cast<float>(x0), static_cast<float>(y0));
+
+                if (penX + p.width + 1 > SDF_ATLAS_WIDTH)
+                {
+                    penX = 1;
+                    penY += rowHeight + 1;
+                    rowHeight = 0;
+                }
+                p.x = penX;
+                p.y = penY;
+                penX += p.width + 1;
+                rowHeight = std::max(rowHeight, p.height);
+
+                g.plane = vec4(x0, y0, x1, y1) / static_cast<float>(pixelSize);
+            }
+
+            if (g.codepoint < 128) mAsciiIndex[g.codepoint] = static_cast<int>(mGlyphs.size());
+            else mOtherIndex[g.codepoint] = mGlyphs.size();
+            mGlyphs.push_back(g);
+        }
+
+        mWidth = SDF_ATLAS_WIDTH;
+        mHeight = 1;
+        while (mHeight < penY + rowHeight + 1) mHeight <<= 1;
+        mPixels.assign(static_cast<size_t>(mWidth) * mHeight, 0);
+
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            const Pending& p = pending[i];
+            if (p.width == 0) continue;
+            RenderGlyph(p.contours, scale, p.origin, p.width, p.height,
+                &mPixels[static_cast<size_t>(p.y) * mWidth + p.x], mWidth);
+            mGlyphs[i].uv = vec4(
+                static_cast<float>(p.x) / mWidth, static_cast<float>(p.y) / mHeight,
+                static_cast<float>(p.x + p.width) / mWidth, static_cast<float>(p.y + p.height) / mHeight);
+        }
+
+        debug("SdfAtlas: {} glyphs in {}x{} at {}px", mGlyphs.size(), mWidth, mHeight, pixelSize);
+        return true;
+    }
+
+    void SdfAtlas::RenderGlyph(const vector<FontContour>& contours, float scale,
+        vec2 origin, int width, int height, uint8_t* dst, int stride) const
+    {
+        // Outline in pixel space, as a flat list of edges
+        vector<vec4> edges;
+        for (const FontContour& contour : contours)
+        {
+            for (size_t i = 0; i < contour.size(); i++)
+            {
+                vec2 a = contour[i] * scale - origin;
+                vec2 b = contour[(i + 1) % contour.size()] * scale - origin;
+                if (a != b) edges.push_back(vec4(a, b));
+            }
+        }
+
+        float range = 2.0f * mSpread;
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                vec2 p(x + 0.5f, y + 0.5f);
+                float nearest = std::numeric_limits<float>::max();
+                int winding = 0;
+                for (const vec4& e : edges)
+                {
+                    vec2 a(e.x, e.y);
+                    vec2 ab = vec2(e.z, e.w) - a;
+                    vec2 ap = p - a;
+                    float t = glm::clamp(glm::dot(ap, ab) / glm::dot(ab, ab), 0.0f, 1.0f);
+                    vec2 d = ap - ab * t;
+                    nearest = std::min(nearest, glm::dot(d, d));
+
+                    // Non-zero winding: signed crossings of a ray to +x
+                    float cross = ab.x * ap.y - ab.y * ap.x;
+                    if (a.y <= p.y && e.w > p.y && cross > 0.0f) winding++;
+                    else if (e.w <= p.y && a.y > p.y && cross < 0.0f) winding--;
+                }
+
+                float distance = std::sqrt(nearest);
+                if (winding == 0) distance = -distance;
+                float value = glm::clamp(0.5f + distance / range, 0.0f, 1.0f);
+                dst[y * stride + x] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+            }
+        }
+    }
+
+    const SdfGlyph* SdfAtlas::GetGlyph(uint32_t codepoint) const
+    {
+        if (codepoint < 128)
+        {
+            int index = mAsciiIndex[codepoint];
+            return index >= 0 ? &mGlyphs[index] : nullptr;
+        }
+        auto itr = mOtherIndex.find(codepoint);
+        return itr != mOtherIndex.end() ? &mGlyphs[itr->second] : nullptr;
+    }
+
+    size_t SdfAtlas::GetGlyphCount() const
+    {
+        return mGlyphs.size();
+    }
+
+    int SdfAtlas::GetWidth() const
+    {
+        return mWidth;
+    }
+
+    int SdfAtlas::GetHeight() const
+    {
+        return mHeight;
+    }
+
+    const vector<uint8_t>& SdfAtlas::GetPixels() const
+    {
+        return mPixels;
+    }
+
+    float SdfAtlas::GetLineHeight() const
+    {
+        return mLineHeight;
+    }
+
+    float SdfAtlas::GetAscender() const
+    {
+        return mAscender;
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * SdfAtlas.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "TrueTypeFont.h"
+
+using std::map;
+using std::vector;
+using glm::vec2;
+using glm::vec4;
+
+#define SDF_ATLAS_WIDTH 512
+
+namespace octronic
+{
+    /**
+     * @brief Placement of one glyph. Plane bounds are in ems relative to
+     * the pen position on the baseline; uv bounds are normalised atlas
+     * coordinates of the same rectangle.
+     */
+    struct SdfGlyph
+    {
+        uint32_t codepoint;
+        float advance;
+        vec4 plane; // left, bottom, right, top
+        vec4 uv;    // left, bottom, right, top
+    };
+
+    /**
+     * @brief Single-channel signed distance field atlas of a font's glyphs.
+     * Each texel holds 0.5 + distance / (2 * spread), distance in pixels at
+     * the baked size, positive inside. Sampled with a smoothstep around 0.5
+     * the glyphs stay sharp at any scale.
+     */
+    class SdfAtlas
+    {
+    public:
+        SdfAtlas();
+
+        /**
+         * @brief Rasterises the given code points at pixelSize pixels per
+         * em, with distances clamped to spread pixels.
+         */
+        bool Build(const TrueTypeFont& font, const vector<uint32_t>& codepoints,
+            int pixelSize = 32, int spread = 4);
+
+        /** @brief Printable ASCII, 32 to 126. */
+        static vector<uint32_t> AsciiCodepoints();
+
+        const SdfGlyph* GetGlyph(uint32_t codepoint) const;
+        size_t GetGlyphCount() const;
+
+        int GetWidth() const;
+        int GetHeight() const;
+        const vector<uint8_t>& GetPixels() const;
+
+        /** @brief Line advance in ems. */
+        float GetLineHeight() const;
+        float GetAscender() const;
+
+    protected:
+        void RenderGlyph(const vector<FontContour>& contours, float scale,
+            vec2 origin, int width, int height, uint8_t* dst, int stride) const;
+
+    private:
+        int mWidth;
+        int mHeight;
+        int mSpread;
+        vector<uint8_t> mPixels;
+        vector<SdfGlyph> mGlyphs;
+        // ASCII by direct index, the rest by map; values index mGlyphs
+        int mAsciiIndex[128];
+        map<uint32_t, size_t> mOtherIndex;
+        float mLineHeight;
+        float mAscender;
+    };
+}
@@ -0,0 +1,123 @@
+/*
+ * TextLayoutCache.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "TextLayoutCache.h"
+
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include "TextRenderer.h"
+
+namespace octronic
+{
+    bool TextLayoutCache::Key::operator==(const Key& other) const
+    {
+        return atlas == other.atlas && size == other.size && text == other.text;
+    }
+
+    size_t TextLayoutCache::KeyHash::operator()(const Key& key) const
+    {
+        uint32_t sizeBits;
+        memcpy(&sizeBits, &key.size, sizeof(sizeBits));
+        size_t hash = std::hash<string>()(key.text);
+        hash ^= std::hash<const void*>()(key.atlas) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        hash ^= std::hash<uint32_t>()(sizeBits) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+
+    TextLayoutCache::TextLayoutCache(size_t capacity)
+        : mCapacity(capacity > 0 ? capacity : 1),
+          mHits(0),
+          mMisses(0)
+    {
+        mIndex.reserve(mCapacity);
+    }
+
+    const TextLayout& TextLayoutCache::Get(const SdfAtlas& atlas, const string& text, float size)
+    {
+        Key key = { &atlas, size, text };
+        auto itr = mIndex.find(key);
+        if (itr != mIndex.end())
+        {
+            mHits++;
+            mEntries.splice(mEntries.begin(), mEntries, itr->second);
+            return itr->second->second;
+        }
+
+        mMisses++;
+        if (mEntries.size() >= mCapacity)
+        {
+            // Recycle the least recently used entry and its buffers
+            mIndex.erase(mEntries.back().first);
+            mEntries.splice(mEntries.begin(), mEntries, std::prev(mEntries.end()));
+            mEntries.front().first = key;
+        }
+        else
+        {
+            mEntries.emplace_front(key, TextLayout());
+        }
+        Build(atlas, text, size, mEntries.front().second);
+        mIndex[key] = mEntries.begin();
+        return mEntries.front().second;
+    }
+
+    void TextLayoutCache::Build(const SdfAtlas& atlas, const string& text, float size, TextLayout& layout)
+    {
+        layout.quads.clear();
+        layout.width = 0.0f;
+        vec2 pen(0.0f);
+        float lineHeight = atlas.GetLineHeight() * size;
+        const SdfGlyph* fallback = atlas.GetGlyph('?');
+
+        for (size_t i = 0; i < text.size();)
+        {
+            uint32_t codepoint = TextRenderer::NextCodepoint(text, i);
+            TextQuad quad = { pen, nullptr };
+            if (codepoint == '\n')
+            {
+                layout.width = glm::max(layout.width, pen.x);
+                pen = vec2(0.0f, pen.y - lineHeight);
+            }
+            else
+            {
+                quad.glyph = atlas.GetGlyph(codepoint);
+                if (quad.glyph == nullptr) quad.glyph = fallback;
+                if (quad.glyph != nullptr) pen.x += quad.glyph->advance * size;
+            }
+            layout.quads.push_back(quad);
+        }
+        layout.width = glm::max(layout.width, pen.x);
+    }
+
+    void TextLayoutCache::Clear()
+    {
+        mEntries.clear();
+        mIndex.clear();
+    }
+
+    size_t TextLayoutCache::GetSize() const
+    {
+        return mEntries.size();
+    }
+
+    size_t TextLayoutCache::GetHitCount() const
+    {
+        return mHits;
+    }
+
+    size_t TextLayoutCache::GetMissCount() const
+    {
+        return mMisses;
+    }
+}
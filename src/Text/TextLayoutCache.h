@@ -0,0 +1,100 @@
+/*
+ * TextLayoutCache.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "SdfAtlas.h"
+#include "../Common/MemoryPool.h"
+
+using std::list;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+#define TEXT_LAYOUT_CACHE_CAPACITY 256
+
+namespace octronic
+{
+    /**
+     * @brief One code point of a laid out string. The pen is the glyph's
+     * baseline origin in model units; glyph is null for line breaks and
+     * code points the atlas has no fallback for.
+     */
+    struct TextQuad
+    {
+        vec2 pen;
+        const SdfGlyph* glyph;
+    };
+
+    struct TextLayout
+    {
+        vector<TextQuad> quads;
+        float width;
+    };
+
+    /**
+     * @brief Layouts keyed by (atlas, size, string), least recently used
+     * evicted first. A hit skips UTF-8 decoding, glyph lookup and pen
+     * advance entirely.
+     *
+     * Once full, a miss reuses the evicted entry, glyph array and all, and
+     * the list and index nodes come from pools, so a readout whose value
+     * changes every frame does not allocate.
+     */
+    class TextLayoutCache
+    {
+    public:
+        TextLayoutCache(size_t capacity = TEXT_LAYOUT_CACHE_CAPACITY);
+
+        /** @brief The cached layout, building and inserting it on a miss. */
+        const TextLayout& Get(const SdfAtlas& atlas, const string& text, float size);
+
+        /** @brief Lays text out without touching the cache. */
+        static void Build(const SdfAtlas& atlas, const string& text, float size, TextLayout& layout);
+
+        void Clear();
+        size_t GetSize() const;
+        size_t GetHitCount() const;
+        size_t GetMissCount() const;
+
+    private:
+        struct Key
+        {
+            const SdfAtlas* atlas;
+            float size;
+            string text;
+            bool operator==(const Key& other) const;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+
+        typedef std::pair<Key, TextLayout> Entry;
+        typedef list<Entry, PoolAllocator<Entry>> EntryList;
+        typedef std::pair<const Key, EntryList::iterator> IndexEntry;
+
+        size_t mCapacity;
+        // Most recently used at the front
+        EntryList mEntries;
+        unordered_map<Key, EntryList::iterator, KeyHash, std::equal_to<Key>, PoolAllocator<IndexEntry>> mIndex;
+        size_t mHits;
+        size_t mMisses;
+    };
+}
@@ -0,0 +1,519 @@
+/*
+ * TextRenderer.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "TextRenderer.h"
+
+#include <cctype>
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+#include "../AppState.h"
+#include "../Common/Logger.h"
+#include "../Common/Time.h"
+#include "../Common/Tracer.h"
+#include "TrueTypeFont.h"
+
+namespace octronic
+{
+    TextRenderer::TextRenderer(AppState* state)
+        : mAppState(state),
+          mShaderProgram(0),
+          mAtlasTexture(0),
+          mVao(0),
+          mVbo(0),
+          mViewUniform(-1),
+          mProjectionUniform(-1),
+          mAtlasUniform(-1),
+          mTabularDigits(false),
+          mRunVao(0),
+          mRunVbo(0),
+          mRunBufferResized(false),
+          mRunGlyphUpdates(0)
+    {
+        debug("TextRenderer: Constructor");
+    }
+
+    TextRenderer::~TextRenderer()
+    {
+        debug("TextRenderer: Destructor");
+        if (mVao > 0) glDeleteVertexArrays(1, &mVao);
+        if (mVbo > 0) glDeleteBuffers(1, &mVbo);
+        if (mRunVao > 0) glDeleteVertexArrays(1, &mRunVao);
+        if (mRunVbo > 0) glDeleteBuffers(1, &mRunVbo);
+        if (mAtlasTexture > 0) glDeleteTextures(1, &mAtlasTexture);
+        if (mShaderProgram > 0) glDeleteProgram(mShaderProgram);
+    }
+
+    bool TextRenderer::Init(const string& fontPath)
+    {
+        TRACE_SCOPE("TextRenderer::Init");
+        debug("TextRenderer: {}", __FUNCTION__);
+        if (!LoadFont(fontPath)) return false;
+        if (!InitShader())       return false;
+        if (!InitBuffers())      return false;
+        return true;
+    }
+
+    bool TextRenderer::IsReady() const
+    {
+        return mAtlasTexture != 0 && mShaderProgram != 0;
+    }
+
+    bool TextRenderer::LoadFont(const string& fontPath)
+    {
+        auto start = Time::GetCurrentTime();
+        AssetView view;
+        vector<uint8_t> inflated;
+        MappedFile file;
+        if (!mAppState->GetAssetPack().Get(fontPath, view, inflated))
+        {
+            if (!file.Map(fontPath))
+            {
+                error("TextRenderer: Unable to open font {}", fontPath);
+                return false;
+            }
+            view.data = file.Data();
+            view.size = file.Size();
+        }
+
+        TrueTypeFont font;
+        if (!font.Parse(view.data, view.size) ||
+            !mAtlas.Build(font, SdfAtlas::AsciiCodepoints()))
+        {
+            error("TextRenderer: Unable to build glyph atlas from {}", fontPath);
+            return false;
+        }
+
+        // Tabular digits let a changed digit be rewritten without moving
+        // anything after it
+        mTabularDigits = true;
+        const SdfGlyph* zero = mAtlas.GetGlyph('0');
+        for (uint32_t digit = '0'; digit <= '9'; digit++)
+        {
+            const SdfGlyph* glyph = mAtlas.GetGlyph(digit);
+            if (zero == nullptr || glyph == nullptr || glyph->advance != zero->advance)
+            {
+                mTabularDigits = false;
+            }
+        }
+
+        glGenTextures(1, &mAtlasTexture);
+        glBindTexture(GL_TEXTURE_2D, mAtlasTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, mAtlas.GetWidth(), mAtlas.GetHeight(), 0,
+            GL_RED, GL_UNSIGNED_BYTE, mAtlas.GetPixels().data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        info("TextRenderer: Built {}x{} atlas of {} glyphs from {} in {}ms",
+             mAtlas.GetWidth(), mAtlas.GetHeight(), mAtlas.GetGlyphCount(), fontPath,
+             Time::GetCurrentTime() - start);
+        return !GLCheckError();
+    }
+
+    bool TextRenderer::InitBuffers()
+    {
+        glGenVertexArrays(1, &mVao);
+        glBindVertexArray(mVao);
+        glGenBuffers(1, &mVbo);
+        glBindBuffer(GL_ARRAY_BUFFER, mVbo);
+        InitVertexAttributes();
+
+        glGenVertexArrays(1, &mRunVao);
+        glBindVertexArray(mRunVao);
+        glGenBuffers(1, &mRunVbo);
+        glBindBuffer(GL_ARRAY_BUFFER, mRunVbo);
+        InitVertexAttributes();
+
+        glBindVertexArray(0);
+        return !GLCheckError();
+    }
+
+    void TextRenderer::InitVertexAttributes()
+    {
+        GLsizei stride = static_cast<GLsizei>(sizeof(TextVertex));
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(sizeof(float) * 3));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (GLvoid*)(sizeof(float) * 5));
+        glEnableVertexAttribArray(2);
+    }
+
+    uint32_t TextRenderer::NextCodepoint(const string& text, size_t& index)
+    {
+        uint8_t c = static_cast<uint8_t>(text[index++]);
+        if (c < 0x80) return c;
+
+        int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+        uint32_t codepoint = c & (0x3F >> extra);
+        for (int i = 0; i < extra && index < text.size(); i++)
+        {
+            codepoint = (codepoint << 6) | (static_cast<uint8_t>(text[index++]) & 0x3F);
+        }
+        return codepoint;
+    }
+
+    void TextRenderer::WriteQuad(TextVertex* dst, const vec2& pen, const SdfGlyph* glyph,
+        float size, const mat4& model, const vec4& colour)
+    {
+        if (glyph == nullptr || glyph->uv.z <= glyph->uv.x)
+        {
+            // Nothing to draw (space, line break); keep the slot degenerate
+            memset(dst, 0, sizeof(TextVertex) * 6);
+            return;
+        }
+
+        vec4 plane = glyph->plane * size;
+        vec3 corners[4] =
+        {
+            vec3(model * vec4(pen.x + plane.x, pen.y + plane.y, 0.0f, 1.0f)),
+            vec3(model * vec4(pen.x + plane.z, pen.y + plane.y, 0.0f, 1.0f)),
+            vec3(model * vec4(pen.x + plane.z, pen.y + plane.w, 0.0f, 1.0f)),
+            vec3(model * vec4(pen.x + plane.x, pen.y + plane.w, 0.0f, 1.0f))
+        };
+        vec2 uvs[4] =
+        {
+            vec2(glyph->uv.x, glyph->uv.y), vec2(glyph->uv.z, glyph->uv.y),
+            vec2(glyph->uv.z, glyph->uv.w), vec2(glyph->uv.x, glyph->uv.w)
+        };
+        static const int order[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int v = 0; v < 6; v++)
+        {
+            dst[v].position = corners[order[v]];
+            dst[v].uv = uvs[order[v]];
+            dst[v].colour = colour;
+        }
+    }
+
+    void TextRenderer::AddText(const string& text, const mat4& model, float size, const vec4& colour)
+    {
+        if (!IsReady()) return;
+        const TextLayout& layout = mLayoutCache.Get(mAtlas, text, size);
+        for (const TextQuad& quad : layout.quads)
+        {
+            if (quad.glyph == nullptr || quad.glyph->uv.z <= quad.glyph->uv.x) continue;
+            mVertices.resize(mVertices.size() + 6);
+            WriteQuad(&mVertices[mVertices.size() - 6], quad.pen, quad.glyph, size, model, colour);
+        }
+    }
+
+    float TextRenderer::MeasureText(const string& text, float size)
+    {
+        return mLayoutCache.Get(mAtlas, text, size).width;
+    }
+
+    int TextRenderer::CreateRun(size_t maxGlyphs)
+    {
+        if (!IsReady() || maxGlyphs == 0) return -1;
+
+        TextRun run;
+        run.first = mRunVertices.size() / 6;
+        run.capacity = maxGlyphs;
+        run.count = 0;
+        run.model = mat4(1.0f);
+        run.size = 0.0f;
+        run.colour = vec4(0.0f);
+        run.ascii = true;
+        run.visible = false;
+        run.dirtyBegin = 0;
+        run.dirtyEnd = 0;
+        mRuns.push_back(run);
+
+        mRunVertices.resize(mRunVertices.size() + maxGlyphs * 6);
+        mRunBufferResized = true;
+        return static_cast<int>(mRuns.size() - 1);
+    }
+
+    void TextRenderer::DrawRun(int handle, const string& text, const mat4& model, float size, const vec4& colour)
+    {
+        if (handle < 0 || static_cast<size_t>(handle) >= mRuns.size()) return;
+        TextRun& run = mRuns[handle];
+        run.visible = true;
+
+        if (size == run.size && colour == run.colour && model == run.model)
+        {
+            if (text == run.text) return;
+            if (PatchDigits(run, text)) return;
+        }
+
+        const TextLayout& layout = mLayoutCache.Get(mAtlas, text, size);
+        run.text = text;
+        run.model = model;
+        run.size = size;
+        run.colour = colour;
+        run.count = glm::min(layout.quads.size(), run.capacity);
+        run.pens.resize(run.count);
+        run.ascii = true;
+        for (char c : text)
+        {
+            if (static_cast<uint8_t>(c) >= 0x80) run.ascii = false;
+        }
+        for (size_t i = 0; i < run.count; i++)
+        {
+            run.pens[i] = layout.quads[i].pen;
+            UpdateRunQuad(run, i, layout.quads[i].glyph);
+        }
+    }
+
+    bool TextRenderer::PatchDigits(TextRun& run, const string& text)
+    {
+        if (!mTabularDigits || !run.ascii || text.size() != run.text.size()) return false;
+
+        // Any change other than digit for digit moves the pens
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            if (text[i] == run.text[i]) continue;
+            if (!isdigit(static_cast<uint8_t>(text[i])) ||
+                !isdigit(static_cast<uint8_t>(run.text[i])))
+            {
+                return false;
+            }
+        }
+
+        // ASCII, so byte i is quad i
+        for (size_t i = 0; i < run.count; i++)
+        {
+            if (text[i] == run.text[i]) continue;
+            UpdateRunQuad(run, i, mAtlas.GetGlyph(static_cast<uint8_t>(text[i])));
+        }
+        run.text = text;
+        return true;
+    }
+
+    void TextRenderer::UpdateRunQuad(TextRun& run, size_t index, const SdfGlyph* glyph)
+    {
+        WriteQuad(&mRunVertices[(run.first + index) * 6], run.pens[index], glyph,
+            run.size, run.model, run.colour);
+        if (run.dirtyBegin == run.dirtyEnd)
+        {
+            run.dirtyBegin = index;
+            run.dirtyEnd = index + 1;
+        }
+        else
+        {
+            run.dirtyBegin = glm::min(run.dirtyBegin, index);
+            run.dirtyEnd = glm::max(run.dirtyEnd, index + 1);
+        }
+        mRunGlyphUpdates++;
+    }
+
+    void TextRenderer::FlushRuns()
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, mRunVbo);
+        if (mRunBufferResized)
+        {
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(mRunVertices.size() * sizeof(TextVertex)),
+                &mRunVertices[0], GL_DYNAMIC_DRAW);
+            mRunBufferResized = false;
+        }
+
+        mDrawFirsts.clear();
+        mDrawCounts.clear();
+        for (TextRun& run : mRuns)
+        {
+            if (run.dirtyEnd > run.dirtyBegin && !mRunVertices.empty())
+            {
+                size_t first = (run.first + run.dirtyBegin) * 6;
+                glBufferSubData(GL_ARRAY_BUFFER,
+                    static_cast<GLintptr>(first * sizeof(TextVertex)),
+                    static_cast<GLsizeiptr>((run.dirtyEnd - run.dirtyBegin) * 6 * sizeof(TextVertex)),
+                    &mRunVertices[first]);
+            }
+            run.dirtyBegin = run.dirtyEnd = 0;
+
+            if (run.visible && run.count > 0)
+            {
+                mDrawFirsts.push_back(static_cast<GLint>(run.first * 6));
+                mDrawCounts.push_back(static_cast<GLsizei>(run.count * 6));
+            }
+            run.visible = false;
+        }
+
+        if (!mDrawFirsts.empty())
+        {
+            glBindVertexArray(mRunVao);
+            glMultiDrawArrays(GL_TRIANGLES, &mDrawFirsts[0], &mDrawCounts[0],
+                static_cast<GLsizei>(mDrawFirsts.size()));
+            glBindVertexArray(0);
+        }
+    }
+
+    void TextRenderer::Flush(const mat4& view, const mat4& projection)
+    {
+        if (mVertices.empty() && mRuns.empty()) return;
+        TRACE_SCOPE("TextRenderer::Flush");
+
+        glUseProgram(mShaderProgram);
+        glUniformMatrix4fv(mViewUniform, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(mProjectionUniform, 1, GL_FALSE, glm::value_ptr(projection));
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, mAtlasTexture);
+        glUniform1i(mAtlasUniform, 0);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        FlushRuns();
+
+        if (mVertices.empty())
+        {
+            GLCheckError();
+            return;
+        }
+
+        // Orphan and refill, so the driver never waits on last frame's draw
+        glBindBuffer(GL_ARRAY_BUFFER, mVbo);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(mVertices.size() * sizeof(TextVertex)),
+            &mVertices[0], GL_STREAM_DRAW);
+
+        glBindVertexArray(mVao);
+        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(mVertices.size()));
+        glBindVertexArray(0);
+        GLCheckError();
+
+        mVertices.clear();
+    }
+
+    const SdfAtlas& TextRenderer::GetAtlas() const
+    {
+        return mAtlas;
+    }
+
+    size_t TextRenderer::GetQueuedGlyphCount() const
+    {
+        return mVertices.size() / 6;
+    }
+
+    const TextLayoutCache& TextRenderer::GetLayoutCache() const
+    {
+        return mLayoutCache;
+    }
+
+    size_t TextRenderer::GetRunGlyphUpdateCount() const
+    {
+        return mRunGlyphUpdates;
+    }
+
+    bool TextRenderer::InitShader()
+    {
+        TRACE_SCOPE("TextRenderer::InitShader");
+        info("TextRenderer: {}", __FUNCTION__);
+
+        static string vertexShaderSource =
+            "#version 330 core\n"
+            "layout (location = 0) in vec3 in_position;\n"
+            "layout (location = 1) in vec2 in_uv;\n"
+            "layout (location = 2) in vec4 in_colour;\n"
+            "out vec2 TexCoord;\n"
+            "out vec4 Colour;\n"
+            "uniform mat4 view;\n"
+            "uniform mat4 projection;\n"
+            "void main () {\n"
+            "    gl_Position = projection * view * vec4(in_position, 1.0);\n"
+            "    TexCoord = in_uv;\n"
+            "    Colour = in_colour;\n"
+            "}";
+
+        // Premultiplied output, edge softness of about one screen pixel
+        static string fragmentShaderSource =
+            "#version 330 core\n"
+            "in vec2 TexCoord;\n"
+            "in vec4 Colour;\n"
+            "out vec4 FragColor;\n"
+            "uniform sampler2D atlas;\n"
+            "void main() {\n"
+            "    float distance = texture(atlas, TexCoord).r;\n"
+            "    float width = max(fwidth(distance) * 0.7, 0.001);\n"
+            "    float alpha = smoothstep(0.5 - width, 0.5 + width, distance) * Colour.a;\n"
+            "    FragColor = vec4(Colour.rgb * alpha, alpha);\n"
+            "}";
+
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+
+        // Compile shaders
+        GLint success;
+        GLchar infoLog[512];
+
+        // Vertex Shader
+        vertexShader = glCreateShader(GL_VERTEX_SHADER);
+        const char *vSource = vertexShaderSource.c_str();
+        glShaderSource(vertexShader, 1, &vSource, nullptr);
+        glCompileShader(vertexShader);
+
+        // Print compile errors if any
+        glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(vertexShader, 512, nullptr, infoLog);
+            error("TextRenderer: Vertex Shader Error {}", infoLog);
+            return false;
+        }
+
+        // Fragment Shader
+        fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        const char *fSource = fragmentShaderSource.c_str();
+        glShaderSource(fragmentShader, 1, &fSource, nullptr);
+        glCompileShader(fragmentShader);
+
+        // Print compile errors if any
+        glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(fragmentShader, 512, nullptr, infoLog);
+            error("TextRenderer: Fragment Shader Error {}", infoLog);
+            return false;
+        }
+
+        // Shader Program
+        mShaderProgram = glCreateProgram();
+        glAttachShader(mShaderProgram, vertexShader);
+        glAttachShader(mShaderProgram, fragmentShader);
+        glLinkProgram(mShaderProgram);
+
+        // Print linking errors if any
+        glGetProgramiv(mShaderProgram, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(mShaderProgram, 512, nullptr, infoLog);
+            error("TextRenderer: Shader Linking Error {}", infoLog);
+            return false;
+        }
+
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+
+        // Get Uniform Locations
+        mViewUniform = glGetUniformLocation(mShaderProgram, "view");
+        mProjectionUniform = glGetUniformLocation(mShaderProgram, "projection");
+        mAtlasUniform = glGetUniformLocation(mShaderProgram, "atlas");
+
+        GLCheckError();
+
+        if (mViewUniform != -1 && mProjectionUniform != -1 && mAtlasUniform != -1)
+        {
+            return true;
+        }
+        else
+        {
+            error("TextRenderer: Uniform Error V:{} P:{} A:{}",
+                  mViewUniform, mProjectionUniform, mAtlasUniform);
+            return false;
+        }
+    }
+}
@@ -0,0 +1,156 @@
+/*
+ * TextRenderer.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "../Common/GLHeader.h"
+#include "SdfAtlas.h"
+#include "TextLayoutCache.h"
+
+using std::string;
+using std::vector;
+using glm::mat4;
+using glm::vec2;
+using glm::vec3;
+using glm::vec4;
+
+#define TEXT_RENDERER_DEFAULT_FONT "Fonts/DroidSans/DroidSans.ttf"
+#define TEXT_RUN_DEFAULT_GLYPHS 32
+
+namespace octronic
+{
+    class AppState;
+
+    struct TextVertex
+    {
+        vec3 position;
+        vec2 uv;
+        vec4 colour;
+    };
+
+    /**
+     * @brief Draws all text of a frame in one call. The font is rasterised
+     * into an SdfAtlas once at Init; after that, AddText only lays strings
+     * out into world-space quads on the CPU and Flush uploads them into a
+     * single streamed vertex buffer. Nothing touches the atlas texture
+     * after Init.
+     *
+     * Text that stays on screen across frames should use a run instead:
+     * its quads live in a persistent buffer and only glyphs that changed
+     * are re-uploaded, so a readout whose digits tick costs a few vertices
+     * per frame however much text is showing.
+     */
+    class TextRenderer
+    {
+    public:
+        TextRenderer(AppState* state);
+        ~TextRenderer();
+
+        bool Init(const string& fontPath = TEXT_RENDERER_DEFAULT_FONT);
+        bool IsReady() const;
+
+        /**
+         * @brief Queues text with its baseline origin at model's origin,
+         * size ems tall in model units. '\n' starts a new line.
+         */
+        void AddText(const string& text, const mat4& model, float size, const vec4& colour);
+
+        /** @brief Width of the widest line in model units. */
+        float MeasureText(const string& text, float size);
+
+        /**
+         * @brief Reserves room for a retained run of up to maxGlyphs code
+         * points.
+         * @return The run handle, or -1 if the renderer is not ready.
+         */
+        int CreateRun(size_t maxGlyphs = TEXT_RUN_DEFAULT_GLYPHS);
+
+        /**
+         * @brief Draws a run this frame, updating it to the given text and
+         * placement first. When only digits changed, and the font's digits
+         * share one advance, just those quads are rewritten. Code points
+         * beyond the run's capacity are dropped.
+         */
+        void DrawRun(int run, const string& text, const mat4& model, float size, const vec4& colour);
+
+        /** @brief Draws and clears everything queued since the last Flush. */
+        void Flush(const mat4& view, const mat4& projection);
+
+        const SdfAtlas& GetAtlas() const;
+        size_t GetQueuedGlyphCount() const;
+        const TextLayoutCache& GetLayoutCache() const;
+        /** @brief Run glyphs rewritten since Init, for profiling. */
+        size_t GetRunGlyphUpdateCount() const;
+
+        /** @brief Decodes the UTF-8 sequence at index and advances it. */
+        static uint32_t NextCodepoint(const string& text, size_t& index);
+
+    protected:
+        bool LoadFont(const string& fontPath);
+        bool InitShader();
+        bool InitBuffers();
+        void InitVertexAttributes();
+
+        struct TextRun
+        {
+            size_t first;    // First quad in the run buffer
+            size_t capacity;
+            size_t count;
+            string text;
+            mat4 model;
+            float size;
+            vec4 colour;
+            bool ascii;
+            bool visible;
+            vector<vec2> pens;
+            // Quads to upload at the next Flush, [dirtyBegin, dirtyEnd)
+            size_t dirtyBegin;
+            size_t dirtyEnd;
+        };
+
+        bool PatchDigits(TextRun& run, const string& text);
+        void UpdateRunQuad(TextRun& run, size_t index, const SdfGlyph* glyph);
+        void FlushRuns();
+
+        /** @brief Writes the six vertices of one glyph quad, or a degenerate quad. */
+        static void WriteQuad(TextVertex* dst, const vec2& pen, const SdfGlyph* glyph,
+            float size, const mat4& model, const vec4& colour);
+
+    private:
+        AppState* mAppState;
+        SdfAtlas mAtlas;
+        GLuint mShaderProgram;
+        GLuint mAtlasTexture;
+        GLuint mVao;
+        GLuint mVbo;
+        GLint mViewUniform;
+        GLint mProjectionUniform;
+        GLint mAtlasUniform;
+        vector<TextVertex> mVertices;
+        TextLayoutCache mLayoutCache;
+        bool mTabularDigits;
+
+        GLuint mRunVao;
+        GLuint mRunVbo;
+        bool mRunBufferResized;
+        vector<TextRun> mRuns;
+        vector<TextVertex> mRunVertices;
+        vector<GLint> mDrawFirsts;
+        vector<GLsizei> mDrawCounts;
+        size_t mRunGlyphUpdates;
+    };
+}
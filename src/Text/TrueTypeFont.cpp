@@ -0,0 +1,486 @@
+/*
+ * TrueTypeFont.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "TrueTypeFont.h"
+
+#include <cstring>
+#include "../Common/Logger.h"
+
+// Segments per quadratic curve when flattening outlines
+#define TRUE_TYPE_CURVE_STEPS 8
+// Composite glyphs nesting deeper than this are treated as broken
+#define TRUE_TYPE_MAX_COMPOSITE_DEPTH 8
+
+namespace octronic
+{
+    enum GlyphFlags
+    {
+        GlyphFlag_OnCurve       = 0x01,
+        GlyphFlag_XShort        = 0x02,
+        GlyphFlag_YShort        = 0x04,
+        GlyphFlag_Repeat        = 0x08,
+        GlyphFlag_XSameOrPlus   = 0x10,
+        GlyphFlag_YSameOrPlus   = 0x20
+    };
+
+    enum CompositeFlags
+    {
+        Composite_ArgsAreWords  = 0x0001,
+        Composite_ArgsAreXY     = 0x0002,
+        Composite_Scale         = 0x0008,
+        Composite_MoreComponents = 0x0020,
+        Composite_XYScale       = 0x0040,
+        Composite_TwoByTwo      = 0x0080
+    };
+
+    TrueTypeFont::TrueTypeFont()
+        : mData(nullptr),
+          mSize(0),
+          mCmap(0),
+          mGlyf(0),
+          mLoca(0),
+          mHmtx(0),
+          mGlyphCount(0),
+          mHMetricCount(0),
+          mLongLoca(false),
+          mUnitsPerEm(0),
+          mAscender(0),
+          mDescender(0),
+          mLineGap(0)
+    {
+    }
+
+    // Big-endian reads, returning 0 past the end of the buffer
+    uint8_t TrueTypeFont::U8(uint32_t offset) const
+    {
+        return offset < mSize ? mData[offset] : 0;
+    }
+
+    uint16_t TrueTypeFont::U16(uint32_t offset) const
+    {
+        return static_cast<uint16_t>((U8(offset) << 8) | U8(offset + 1));
+    }
+
+    int16_t TrueTypeFont::S16(uint32_t offset) const
+    {
+        return static_cast<int16_t>(U16(offset));
+    }
+
+    uint32_t TrueTypeFont::U32(uint32_t offset) const
+    {
+        return (static_cast<uint32_t>(U16(offset)) << 16) | U16(offset + 2);
+    }
+
+    uint32_t TrueTypeFont::FindTable(const char* tag) const
+    {
+        uint16_t tableCount = U16(4);
+        for (uint16_t i = 0; i < tableCount; i++)
+        {
+            uint32_t entry = 12 + i * 16;
+            if (entry + 16 > mSize) break;
+            if (memcmp(mData + entry, tag, 4) == 0)
+            {
+                uint32_t offset = U32(entry + 8);
+                return offset < mSize ? offset : 0;
+            }
+        }
+        return 0;
+    }
+
+    bool TrueTypeFont::Parse(const uint8_t* data, size_t size)
+    {
+        mData = data;
+        mSize = size;
+        mCmap = 0;
+        if (data == nullptr || size < 12) return false;
+
+        uint32_t version = U32(0);
+        if (version != 0x00010000 && version != 0x74727565) // 1.0 or 'true'
+        {
+            error("TrueTypeFont: Not a TrueType font (version {:x})", version);
+            return false;
+        }
+
+        uint32_t head = FindTable("head");
+        uint32_t hhea = FindTable("hhea");
+        uint32_t maxp = FindTable("maxp");
+        uint32_t cmap = FindTable("cmap");
+        mGlyf = FindTable("glyf");
+        mLoca = FindTable("loca");
+        mHmtx = FindTable("hmtx");
+        if (!head || !hhea || !maxp || !cmap || !mGlyf || !mLoca || !mHmtx)
+        {
+            error("TrueTypeFont: Missing required tables");
+            return false;
+        }
+
+        mUnitsPerEm = U16(head + 18);
+        mLongLoca = S16(head + 50) != 0;
+        mAscender = S16(hhea + 4);
+        mDescender = S16(hhea + 6);
+        mLineGap = S16(hhea + 8);
+        mHMetricCount = U16(hhea + 34);
+        mGlyphCount = U16(maxp + 4);
+
+        // Prefer the Windows Unicode BMP subtable
+        uint16_t subtableCount = U16(cmap + 2);
+        for (uint16_t i = 0; i < subtableCount; i++)
+        {
+            uint32_t record = cmap + 4 + i * 8;
+            uint16_t platform = U16(record);
+            uint16_t encoding = U16(record + 2);
+            uint32_t subtable = cmap + U32(record + 4);
+            if (U16(subtable) != 4) continue;
+            if ((platform == 3 && encoding == 1) || platform == 0)
+            {
+                mCmap = subtable;
+                if (platform == 3) break;
+            }
+        }
+
+        if (mCmap == 0 || mUnitsPerEm == 0 || mHMetricCount == 0)
+        {
+            error("TrueTypeFont: No usable character map");
+            return false;
+        }
+        return true;
+    }
+
+    bool TrueTypeFont::IsLoaded() const
+    {
+        return mCmap != 0;
+    }
+
+    uint16_t TrueTypeFont::GetGlyphIndex(uint32_t codepoint) const
+    {
+        if (mCmap == 0 || codepoint > 0xFFFF) return 0;
+
+        uint16_t segCount = U16(mCmap + 6) / 2;
+        uint32_t endCodes = mCmap + 14;
+        uint32_t startCodes = endCodes + segCount * 2 + 2;
+        uint32_t idDeltas = startCodes + segCount * 2;
+        uint32_t idRangeOffsets = idDeltas + segCount * 2;
+
+        // Segments are sorted by end code
+        uint16_t low = 0;
+        uint16_t high = segCount;
+        while (low < high)
+        {
+            uint16_t mid = (low + high) / 2;
+            if (U16(endCodes + mid * 2) < codepoint) low = mid + 1;
+            else high = mid;
+        }
+        if (low >= segCount) return 0;
+
+        uint16_t start = U16(startCodes + low * 2);
+        if (codepoint < start) return 0;
+
+        uint16_t delta = U16(idDeltas + low * 2);
+        uint32_t rangeOffsetAt = idRangeOffsets + low * 2;
+        uint16_t rangeOffset = U16(rangeOffsetAt);
+        if (rangeOffset == 0)
+        {
+            return static_cast<uint16_t>(codepoint + delta);
+        }
+
+        uint16_t glyph = U16(rangeOffsetAt + rangeOffset + (codepoint - start) * 2);
+        return glyph == 0 ? 0 : static_cast<uint16_t>(glyph + delta);
+    }
+
+    uint16_t TrueTypeFont::GetGlyphCount() const
+    {
+        return mGlyphCount;
+    }
+
+    void TrueTypeFont::GetHorizontalMetrics(uint16_t glyph, int& advance, int& leftBearing) const
+    {
+        if (glyph < mHMetricCount)
+        {
+            advance = U16(mHmtx + glyph * 4);
+            leftBearing = S16(mHmtx + glyph * 4 + 2);
+        }
+        else
+        {
+            // Monospaced tail: the last advance, with bearings only
+            advance = U16(mHmtx + (mHMetricCount - 1) * 4);
+            leftBearing = S16(mHmtx + mHMetricCount * 4 + (glyph - mHMetricCount) * 2);
+        }
+    }
+
+    bool TrueTypeFont::GetGlyphRange(uint16_t glyph, uint32_t& offset, uint32_t& length) const
+    {
+        if (glyph >= mGlyphCount) return false;
+        uint32_t start;
+        uint32_t end;
+        if (mLongLoca)
+        {
+            start = U32(mLoca + glyph * 4);
+            end = U32(mLoca + glyph * 4 + 4);
+        }
+        else
+        {
+            start = U16(mLoca + glyph * 2) * 2u;
+            end = U16(mLoca + glyph * 2 + 2) * 2u;
+        }
+        if (end < start || mGlyf + end > mSize) return false;
+        offset = mGlyf + start;
+        length = end - start;
+        return true;
+    }
+
+    bool TrueTypeFont::GetGlyphOutline(uint16_t glyph, vector<FontContour>& contours) const
+    {
+        return ReadGlyph(glyph, 0, contours);
+    }
+
+    bool TrueTypeFont::ReadGlyph(uint16_t glyph, int depth, vector<FontContour>& contours) const
+    {
+        uint32_t offset;
+        uint32_t length;
+        if (!GetGlyphRange(glyph, offset, length)) return false;
+        if (length == 0) return true;
+
+        int contourCount = S16(offset);
+        if (contourCount >= 0)
+        {
+            return ReadSimpleGlyph(offset, length, contourCount, contours);
+        }
+        return ReadCompositeGlyph(offset, length, depth, contours);
+    }
+
+    /**
+     * Appends the quadratic from p0 through control c to p1 as line segments
+     * (p0 is already in the contour).
+     */
+    static void FlattenQuadratic(FontContour& contour, const vec2& p0, const vec2& c, const vec2& p1)
+    {
+        for (int i = 1; i <= TRUE_TYPE_CURVE_STEPS; i++)
+        {
+            float t = static_cast<float>(i) / TRUE_TYPE_CURVE_STEPS;
+            float u = 1.0f - t;
+            contour.push_back(u * u * p0 + 2.0f * u * t * c + t * t * p1);
+        }
+    }
+
+    bool TrueTypeFont::ReadSimpleGlyph(uint32_t offset, uint32_t length, int contourCount,
+        vector<FontContour>& contours) const
+    {
+        uint32_t end = offset + length;
+        uint32_t endPoints = offset + 10;
+        if (contourCount == 0) return true;
+
+        int pointCount = U16(endPoints + (contourCount - 1) * 2) + 1;
+        uint32_t cursor = endPoints + contourCount * 2;
+        cursor += 2 + U16(cursor); // instructions
+
+        // Flags, with run-length repeats
+        vector<uint8_t> flags(pointCount);
+        for (int i = 0; i < pointCount && cursor < end;)
+        {
+            uint8_t flag = U8(cursor++);
+            int repeat = (flag & GlyphFlag_Repeat) ? U8(cursor++) : 0;
+            for (int r = 0; r <= repeat && i < pointCount; r++) flags[i++] = flag;
+        }
+
+        // Coordinates are deltas, x then y
+        vector<vec2> points(pointCount);
+        int value = 0;
+        for (int i = 0; i < pointCount; i++)
+        {
+            uint8_t flag = flags[i];
+            if (flag & GlyphFlag_XShort)
+            {
+                int delta = U8(cursor++);
+                value += (flag & GlyphFlag_XSameOrPlus) ? delta : -delta;
+            }
+            else if (!(flag & GlyphFlag_XSameOrPlus))
+            {
+                value += S16(cursor);
+                cursor += 2;
+            }
+            points[i].x = static_cast<float>(value);
+        }
+        value = 0;
+        for (int i = 0; i < pointCount; i++)
+        {
+            uint8_t flag = flags[i];
+            if (flag & GlyphFlag_YShort)
+            {
+                int delta = U8(cursor++);
+                value += (flag & GlyphFlag_YSameOrPlus) ? delta : -delta;
+            }
+            else if (!(flag & GlyphFlag_YSameOrPlus))
+            {
+                value += S16(cursor);
+                cursor += 2;
+            }
+            points[i].y = static_cast<float>(value);
+        }
+        if (cursor > end) return false;
+
+        int first = 0;
+        for (int c = 0; c < contourCount; c++)
+        {
+            int last = U16(endPoints + c * 2);
+            if (last < first || last >= pointCount) return false;
+            int count = last - first + 1;
+
+            // Start on an on-curve point, or the implied midpoint of two
+            // off-curve points if there is none
+            int startIndex = -1;
+            for (int i = 0; i < count; i++)
+            {
+                if (flags[first + i] & GlyphFlag_OnCurve)
+                {
+                    startIndex = i;
+                    break;
+                }
+            }
+
+            FontContour contour;
+            vec2 start = startIndex >= 0 ? points[first + startIndex] :
+                (points[first] + points[last]) * 0.5f;
+            if (startIndex < 0) startIndex = 0;
+            contour.push_back(start);
+
+            vec2 current = start;
+            bool haveControl = false;
+            vec2 control;
+            int visited = startIndex >= 0 && (flags[first + startIndex] & GlyphFlag_OnCurve) ? 1 : 0;
+            for (int i = visited; i <= count; i++)
+            {
+                int index = first + (startIndex + i) % count;
+                const vec2& p = i == count ? start : points[index];
+                bool onCurve = i == count || (flags[index] & GlyphFlag_OnCurve);
+                if (onCurve)
+                {
+                    if (haveControl) FlattenQuadratic(contour, current, control, p);
+                    else contour.push_back(p);
+                    current = p;
+                    haveControl = false;
+                }
+                else if (haveControl)
+                {
+                    vec2 mid = (control + p) * 0.5f;
+                    FlattenQuadratic(contour, current, control, mid);
+                    current = mid;
+                    control = p;
+                }
+                else
+                {
+                    control = p;
+                    haveControl = true;
+                }
+            }
+
+            contours.push_back(contour);
+            first = last + 1;
+        }
+        return true;
+    }
+
+    bool TrueTypeFont::ReadCompositeGlyph(uint32_t offset, uint32_t length, int depth,
+        vector<FontContour>& contours) const
+    {
+        if (depth >= TRUE_TYPE_MAX_COMPOSITE_DEPTH) return false;
+        uint32_t end = offset + length;
+        uint32_t cursor = offset + 10;
+
+        uint16_t flags;
+        do
+        {
+            if (cursor + 4 > end) return false;
+            flags = U16(cursor);
+            uint16_t component = U16(cursor + 2);
+            cursor += 4;
+
+            float dx = 0.0f;
+            float dy = 0.0f;
+            if (flags & Composite_ArgsAreWords)
+            {
+                dx = S16(cursor);
+                dy = S16(cursor + 2);
+                cursor += 4;
+            }
+            else
+            {
+                dx = static_cast<int8_t>(U8(cursor));
+                dy = static_cast<int8_t>(U8(cursor + 1));
+                cursor += 2;
+            }
+
+            // 2.14 fixed point transform
+            float a = 1.0f, b = 0.0f, c = 0.0f, d = 1.0f;
+            if (flags & Composite_Scale)
+            {
+                a = d = S16(cursor) / 16384.0f;
+                cursor += 2;
+            }
+            else if (flags & Composite_XYScale)
+            {
+                a = S16(cursor) / 16384.0f;
+                d = S16(cursor + 2) / 16384.0f;
+                cursor += 4;
+            }
+            else if (flags & Composite_TwoByTwo)
+            {
+                a = S16(cursor) / 16384.0f;
+                b = S16(cursor + 2) / 16384.0f;
+                c = S16(cursor + 4) / 16384.0f;
+                d = S16(cursor + 6) / 16384.0f;
+                cursor += 8;
+            }
+
+            // Point-matched components are rare in Latin fonts; they are
+            // placed without an offset
+            if (!(flags & Composite_ArgsAreXY))
+            {
+                dx = 0.0f;
+                dy = 0.0f;
+            }
+
+            size_t firstNew = contours.size();
+            if (!ReadGlyph(component, depth + 1, contours)) return false;
+            for (size_t i = firstNew; i < contours.size(); i++)
+            {
+                for (vec2& p : contours[i])
+                {
+                    p = vec2(a * p.x + c * p.y + dx, b * p.x + d * p.y + dy);
+                }
+            }
+        }
+        while (flags & Composite_MoreComponents);
+        return true;
+    }
+
+    int TrueTypeFont::GetUnitsPerEm() const
+    {
+        return mUnitsPerEm;
+    }
+
+    int TrueTypeFont::GetAscender() const
+    {
+        return mAscender;
+    }
+
+    int TrueTypeFont::GetDescender() const
+    {
+        return mDescender;
+    }
+
+    int TrueTypeFont::GetLineGap() const
+    {
+        return mLineGap;
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * TrueTypeFont.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+using std::vector;
+using glm::vec2;
+
+namespace octronic
+{
+    /**
+     * @brief A closed polyline in font units. Quadratic segments are
+     * flattened when the outline is read.
+     */
+    typedef vector<vec2> FontContour;
+
+    /**
+     * @brief Minimal reader for TrueType (glyf) fonts: enough of cmap
+     * (format 4), hmtx, loca and glyf to lay out and rasterise BMP
+     * characters. Works in place on a caller-owned buffer, which must
+     * outlive the font.
+     */
+    class TrueTypeFont
+    {
+    public:
+        TrueTypeFont();
+
+        bool Parse(const uint8_t* data, size_t size);
+        bool IsLoaded() const;
+
+        /** @return The glyph for a code point, or 0 (.notdef). */
+        uint16_t GetGlyphIndex(uint32_t codepoint) const;
+        uint16_t GetGlyphCount() const;
+
+        void GetHorizontalMetrics(uint16_t glyph, int& advance, int& leftBearing) const;
+
+        /**
+         * @brief Appends the glyph's contours, with composite glyphs
+         * resolved. Empty glyphs such as space have no contours.
+         */
+        bool GetGlyphOutline(uint16_t glyph, vector<FontContour>& contours) const;
+
+        int GetUnitsPerEm() const;
+        int GetAscender() const;
+        int GetDescender() const;
+        int GetLineGap() const;
+
+    protected:
+        uint32_t FindTable(const char* tag) const;
+        bool GetGlyphRange(uint16_t glyph, uint32_t& offset, uint32_t& length) const;
+        bool ReadSimpleGlyph(uint32_t offset, uint32_t length, int contourCount,
+            vector<FontContour>& contours) const;
+        bool ReadCompositeGlyph(uint32_t offset, uint32_t length, int depth,
+            vector<FontContour>& contours) const;
+        bool ReadGlyph(uint16_t glyph, int depth, vector<FontContour>& contours) const;
+
+        uint8_t  U8(uint32_t offset) const;
+        uint16_t U16(uint32_t offset) const;
+        int16_t  S16(uint32_t offset) const;
+        uint32_t U32(uint32_t offset) const;
+
+    private:
+        const uint8_t* mData;
+        size_t mSize;
+        uint32_t mCmap;
+        uint32_t mGlyf;
+        uint32_t mLoca;
+        uint32_t mHmtx;
+        uint16_t mGlyphCount;
+        uint16_t mHMetricCount;
+        bool mLongLoca;
+        int mUnitsPerEm;
+        int mAscender;
+        int mDescender;
+        int mLineGap;
+    };
+}
@@ -0,0 +1,402 @@
+/*
+ * Dashboard.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "Dashboard.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <utility>
+#include "../AppState.h"
+#include "../Common/Logger.h"
+#include "../Common/MappedFile.h"
+#include "../Common/Time.h"
+#include "../Common/Tracer.h"
+#include "DashboardSnapshot.h"
+#include "WidgetFactory.h"
+
+using std::atomic;
+using std::thread;
+
+namespace octronic
+{
+    Dashboard::Dashboard(AppState* state)
+        : mAppState(state),
+          mInitialised(false),
+          mSnapshotsEnabled(true)
+    {
+        debug("Dashboard: Constructor");
+    }
+
+    Dashboard::~Dashboard()
+    {
+        debug("Dashboard: Destructor");
+        Clear();
+    }
+
+    bool Dashboard::Load(const string& path)
+    {
+        TRACE_SCOPE_DETAIL("Dashboard::Load", path);
+        auto start = Time::GetCurrentTime();
+
+        AssetView view;
+        vector<uint8_t> inflated;
+        MappedFile file;
+        if (!mAppState->GetAssetPack().Get(path, view, inflated))
+        {
+            if (!file.Map(path))
+            {
+                error("Dashboard: Unable to open {}", path);
+                return false;
+            }
+            view.data = file.Data();
+            view.size = file.Size();
+        }
+
+        uint64_t sourceHash = DashboardSnapshot::Hash(view.data, view.size);
+        string snapshotPath = DashboardSnapshot::PathFor(path);
+        if (mSnapshotsEnabled && LoadSnapshot(snapshotPath, sourceHash))
+        {
+            info("Dashboard: Read {} widgets from {} in {}ms", mWidgets.size(), snapshotPath,
+                 Time::GetCurrentTime() - start);
+            return true;
+        }
+
+        json j = json::parse(view.data, view.data + view.size, nullptr, false);
+        if (j.is_discarded())
+        {
+            error("Dashboard: {} is not valid JSON", path);
+            return false;
+        }
+        if (!FromJson(j)) return false;
+
+        info("Dashboard: Read {} widgets from {} in {}ms", mWidgets.size(), path,
+             Time::GetCurrentTime() - start);
+
+        if (mSnapshotsEnabled) WriteSnapshot(snapshotPath, sourceHash);
+        return true;
+    }
+
+    void Dashboard::SetSnapshotsEnabled(bool enabled)
+    {
+        mSnapshotsEnabled = enabled;
+    }
+
+    bool Dashboard::LoadSnapshot(const string& path, uint64_t sourceHash)
+    {
+        TRACE_SCOPE_DETAIL("Dashboard::LoadSnapshot", path);
+        DashboardSnapshot snapshot;
+        if (!snapshot.Open(path)) return false;
+        if (snapshot.GetSourceHash() != sourceHash)
+        {
+            info("Dashboard: {} is out of date", path);
+            return false;
+        }
+
+        Clear();
+        mWidgets.reserve(snapshot.GetWidgetCount());
+        for (uint32_t i = 0; i < snapshot.GetWidgetCount(); i++)
+        {
+            const DashboardSnapshotRecord& record = snapshot.GetRecord(i);
+            unique_ptr<Widget> widget(WidgetFactory::Create(mAppState, snapshot.GetString(record.type)));
+            if (widget == nullptr || !widget->ReadSnapshot(snapshot, record))
+            {
+                warn("Dashboard: {} record {} is invalid", path, i);
+                Clear();
+                return false;
+            }
+            // Records are in file order, so a parent always comes first
+            int32_t parent = record.parent;
+            if (parent < -1 || parent >= static_cast<int32_t>(i) ||
+                (parent >= 0 && !widget->SetParent(mWidgets[parent].get())))
+            {
+                warn("Dashboard: {} record {} has an invalid parent", path, i);
+                Clear();
+                return false;
+            }
+            mWidgets.push_back(std::move(widget));
+            mParents.push_back(parent);
+        }
+
+        mAlarms.resize(snapshot.GetAlarmCount());
+        for (uint32_t i = 0; i < snapshot.GetAlarmCount(); i++)
+        {
+            const DashboardSnapshotAlarm& alarm = snapshot.GetAlarm(i);
+            mAlarms[i].channel = snapshot.GetString(alarm.channel);
+            mAlarms[i].limits.lowCritical = alarm.limits[0];
+            mAlarms[i].limits.lowWarning = alarm.limits[1];
+            mAlarms[i].limits.highWarning = alarm.limits[2];
+            mAlarms[i].limits.highCritical = alarm.limits[3];
+            mAlarms[i].limits.hysteresis = alarm.hysteresis;
+        }
+        return true;
+    }
+
+    bool Dashboard::WriteSnapshot(const string& path, uint64_t sourceHash)
+    {
+        TRACE_SCOPE_DETAIL("Dashboard::WriteSnapshot", path);
+        DashboardSnapshotWriter writer;
+        for (size_t i = 0; i < mWidgets.size(); i++)
+        {
+            writer.AddWidget(mWidgets[i].get(), mParents[i]);
+        }
+        for (const DashboardAlarm& alarm : mAlarms)
+        {
+            writer.AddAlarm(alarm.channel, alarm.limits);
+        }
+        if (!writer.Write(path, sourceHash)) return false;
+        debug("Dashboard: Wrote {}", path);
+        return true;
+    }
+
+    json Dashboard::ToJson()
+    {
+        vector<json> descriptions;
+        descriptions.reserve(mWidgets.size());
+        for (auto& widget : mWidgets)
+        {
+            descriptions.push_back(widget->ToJson());
+        }
+
+        // Back to front, so each subtree is complete before it is nested
+        for (size_t i = mWidgets.size(); i-- > 0;)
+        {
+            if (mParents[i] < 0) continue;
+            json& parent = descriptions[mParents[i]];
+            if (!parent.count("children")) parent["children"] = json::array();
+            parent["children"].insert(parent["children"].begin(), std::move(descriptions[i]));
+        }
+
+        json widgets = json::array();
+        for (size_t i = 0; i < mWidgets.size(); i++)
+        {
+            if (mParents[i] < 0) widgets.push_back(std::move(descriptions[i]));
+        }
+        json j;
+        j["widgets"] = widgets;
+
+        if (!mAlarms.empty())
+        {
+            json alarms = json::array();
+            for (const DashboardAlarm& alarm : mAlarms)
+            {
+                // Unused limits are infinite, which JSON cannot hold
+                json a;
+                a["channel"] = alarm.channel;
+                if (std::isfinite(alarm.limits.lowCritical))  a["lowCritical"] = alarm.limits.lowCritical;
+                if (std::isfinite(alarm.limits.lowWarning))   a["lowWarning"] = alarm.limits.lowWarning;
+                if (std::isfinite(alarm.limits.highWarning))  a["highWarning"] = alarm.limits.highWarning;
+                if (std::isfinite(alarm.limits.highCritical)) a["highCritical"] = alarm.limits.highCritical;
+                a["hysteresis"] = alarm.limits.hysteresis;
+                alarms.push_back(a);
+            }
+            j["alarms"] = alarms;
+        }
+        return j;
+    }
+
+    bool Dashboard::FromJson(const json& j)
+    {
+        Clear();
+        if (!j.is_object() || !j.count("widgets") || !j["widgets"].is_array())
+        {
+            error("Dashboard: No widgets array");
+            return false;
+        }
+
+        const json& widgets = j["widgets"];
+        mWidgets.reserve(widgets.size());
+        for (const json& description : widgets)
+        {
+            if (!AddFromJson(description, -1))
+            {
+                Clear();
+                return false;
+            }
+        }
+
+        if (j.count("alarms") && !AlarmsFromJson(j["alarms"]))
+        {
+            Clear();
+            return false;
+        }
+        return true;
+    }
+
+    bool Dashboard::AddFromJson(const json& description, int32_t parent)
+    {
+        Widget* widget = WidgetFactory::CreateFromJson(mAppState, description);
+        if (widget == nullptr) return false;
+        if (parent >= 0) widget->SetParent(mWidgets[parent].get());
+        mWidgets.push_back(unique_ptr<Widget>(widget));
+        mParents.push_back(parent);
+
+        // Children follow their parent, depth first, and draw after it
+        if (!description.count("children")) return true;
+        const json& children = description["children"];
+        if (!children.is_array())
+        {
+            error("Dashboard: {} children is not an array", widget->GetTypeName());
+            return false;
+        }
+        int32_t index = static_cast<int32_t>(mWidgets.size() - 1);
+        for (const json& child : children)
+        {
+            if (!AddFromJson(child, index)) return false;
+        }
+        return true;
+    }
+
+    bool Dashboard::AlarmsFromJson(const json& alarms)
+    {
+        if (!alarms.is_array())
+        {
+            error("Dashboard: alarms is not an array");
+            return false;
+        }
+
+        try
+        {
+            for (const json& a : alarms)
+            {
+                DashboardAlarm alarm;
+                alarm.channel = a.at("channel").get<string>();
+                if (a.count("lowCritical"))  alarm.limits.lowCritical = a["lowCritical"].get<float>();
+                if (a.count("lowWarning"))   alarm.limits.lowWarning = a["lowWarning"].get<float>();
+                if (a.count("highWarning"))  alarm.limits.highWarning = a["highWarning"].get<float>();
+                if (a.count("highCritical")) alarm.limits.highCritical = a["highCritical"].get<float>();
+                if (a.count("hysteresis"))   alarm.limits.hysteresis = a["hysteresis"].get<float>();
+                mAlarms.push_back(alarm);
+            }
+        }
+        catch (const json::exception& e)
+        {
+            // Missing channel or wrongly typed limits
+            error("Dashboard: {}", e.what());
+            return false;
+        }
+        return true;
+    }
+
+    bool Dashboard::PrepareAll(unsigned threadCount)
+    {
+        TRACE_SCOPE("Dashboard::PrepareAll");
+        if (mWidgets.empty()) return true;
+        if (threadCount == 0) threadCount = std::max(1u, thread::hardware_concurrency());
+        threadCount = std::min<unsigned>(threadCount, static_cast<unsigned>(mWidgets.size()));
+
+        atomic<size_t> next(0);
+        atomic<bool> failed(false);
+        auto worker = [this, &next, &failed]()
+        {
+            for (size_t i = next++; i < mWidgets.size(); i = next++)
+            {
+                if (!mWidgets[i]->Prepare())
+                {
+                    error("Dashboard: Unable to prepare {} widget {}", mWidgets[i]->GetTypeName(), i);
+                    failed = true;
+                }
+            }
+        };
+
+        // The calling thread works too, so one thread means no spawning
+        vector<thread> workers;
+        for (unsigned i = 1; i < threadCount; i++) workers.emplace_back(worker);
+        worker();
+        for (thread& t : workers) t.join();
+        return !failed;
+    }
+
+    bool Dashboard::Init(unsigned threadCount)
+    {
+        TRACE_SCOPE("Dashboard::Init");
+        debug("Dashboard: {}", __FUNCTION__);
+        auto start = Time::GetCurrentTime();
+        // World matrices first; Prepare sizes textures from the footprint
+        mAppState->GetSceneGraph().Update();
+        if (!PrepareAll(threadCount)) return false;
+        auto prepared = Time::GetCurrentTime();
+
+        // Set first, so Clear detaches whatever was added before a failure
+        mInitialised = true;
+        Window& window = mAppState->GetWindow();
+        for (auto& widget : mWidgets)
+        {
+            if (!widget->Init())
+            {
+                error("Dashboard: Unable to initialise {} widget", widget->GetTypeName());
+                return false;
+            }
+            window.AddWidget(widget.get());
+        }
+        if (!InitAlarms()) return false;
+
+        info("Dashboard: Initialised {} widgets in {}ms (prepare {}ms, init {}ms)",
+             mWidgets.size(), Time::GetCurrentTime() - start, prepared - start,
+             Time::GetCurrentTime() - prepared);
+        return true;
+    }
+
+    bool Dashboard::InitAlarms()
+    {
+        if (mAlarms.empty()) return true;
+
+        AlarmEngine& engine = mAppState->GetAlarmEngine();
+        ChannelRegistry& registry = mAppState->GetChannelRegistry();
+        for (const DashboardAlarm& alarm : mAlarms)
+        {
+            if (engine.Add(registry.Create(alarm.channel), alarm.limits) < 0) return false;
+        }
+
+        size_t subscribed = 0;
+        for (auto& widget : mWidgets)
+        {
+            Widget* w = widget.get();
+            if (engine.Subscribe(w->GetChannel(), [w](const AlarmEvent& event) { w->SetAlarmLevel(event.level); }))
+            {
+                subscribed++;
+            }
+        }
+        debug("Dashboard: {} alarms, {} widgets subscribed", mAlarms.size(), subscribed);
+        return true;
+    }
+
+    void Dashboard::Clear()
+    {
+        if (mInitialised)
+        {
+            mAppState->GetAlarmEngine().Clear();
+            Window& window = mAppState->GetWindow();
+            for (auto& widget : mWidgets)
+            {
+                window.RemoveWidget(widget.get());
+            }
+        }
+        mWidgets.clear();
+        mParents.clear();
+        mAlarms.clear();
+        mInitialised = false;
+    }
+
+    size_t Dashboard::GetWidgetCount() const
+    {
+        return mWidgets.size();
+    }
+
+    Widget* Dashboard::GetWidget(size_t index) const
+    {
+        return index < mWidgets.size() ? mWidgets[index].get() : nullptr;
+    }
+}
@@ -0,0 +1,106 @@
+/*
+ * Dashboard.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Widget.h"
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+#define DASHBOARD_DEFAULT_FILE "Dashboards/Default.json"
+
+namespace octronic
+{
+    struct DashboardAlarm
+    {
+        string channel;
+        AlarmLimits limits;
+    };
+
+    /**
+     * @brief The widget set described by a dashboard file:
+     *
+     *     { "widgets": [ { "type": "Image", "image": "...", ... }, ... ],
+     *       "alarms":  [ { "channel": "...", "highWarning": 80, ... }, ... ] }
+     *
+     * A widget may carry "children": [ ... ] of its own; they are placed
+     * relative to it in the SceneGraph and so move with it.
+     *
+     * Widgets are created through the WidgetFactory and drawn in file
+     * order. Init runs every widget's Prepare (file reads, image decode)
+     * across worker threads first, then the GL half of Init on the calling
+     * thread, and adds the widgets to the Window.
+     *
+     * Alarms are optional limits per channel (see AlarmLimits). Init adds
+     * them to the AppState's AlarmEngine and subscribes every widget bound
+     * to an alarmed channel, so the widget tints itself while in alarm.
+     *
+     * The JSON stays the source of truth, but once it has been read the
+     * resolved widget set is also written to a DashboardSnapshot beside
+     * it. Later boots map the snapshot instead of parsing the JSON, for as
+     * long as the JSON's hash still matches.
+     */
+    class Dashboard : public JsonSerialization
+    {
+    public:
+        Dashboard(AppState* state);
+        ~Dashboard();
+
+        /**
+         * @brief Reads a dashboard from the asset pack, or from disk, via
+         * its snapshot when that is current.
+         */
+        bool Load(const string& path);
+
+        /** @brief Whether Load reads and writes snapshots. On by default. */
+        void SetSnapshotsEnabled(bool enabled);
+
+        bool LoadSnapshot(const string& path, uint64_t sourceHash);
+        bool WriteSnapshot(const string& path, uint64_t sourceHash);
+
+        json ToJson() override;
+        bool FromJson(const json& j) override;
+
+        /**
+         * @param threadCount Workers for Prepare; 0 for one per core.
+         */
+        bool Init(unsigned threadCount = 0);
+
+        /** @brief Removes the widgets from the Window and destroys them. */
+        void Clear();
+
+        size_t GetWidgetCount() const;
+        Widget* GetWidget(size_t index) const;
+
+    protected:
+        bool PrepareAll(unsigned threadCount);
+        bool AddFromJson(const json& description, int32_t parent);
+        bool AlarmsFromJson(const json& alarms);
+        bool InitAlarms();
+
+    private:
+        AppState* mAppState;
+        vector<unique_ptr<Widget>> mWidgets;
+        // Index of each widget's parent in mWidgets, -1 for top level
+        vector<int32_t> mParents;
+        vector<DashboardAlarm> mAlarms;
+        bool mInitialised;
+        bool mSnapshotsEnabled;
+    };
+}
@@ -0,0 +1,303 @@
+/*
+ * DashboardSnapshot.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "DashboardSnapshot.h"
+
+#include <cstdio>
+#include <cstring>
+#include "../Common/Logger.h"
+#include "../Data/DataChannel.h"
+#include "Widget.h"
+
+namespace octronic
+{
+    DashboardSnapshot::DashboardSnapshot()
+        : mHeader(nullptr),
+          mRecords(nullptr),
+          mAlarms(nullptr),
+          mParams(nullptr),
+          mStrings(nullptr)
+    {
+    }
+
+    bool DashboardSnapshot::Open(const string& path)
+    {
+        debug("DashboardSnapshot: {} {}", __FUNCTION__, path);
+        Close();
+
+        if (!mFile.Map(path)) return false;
+
+        const uint8_t* data = mFile.Data();
+        size_t size = mFile.Size();
+
+        auto header = reinterpret_cast<const DashboardSnapshotHeader*>(data);
+        if (size < sizeof(DashboardSnapshotHeader) ||
+            memcmp(header->magic, DASHBOARD_SNAPSHOT_MAGIC, 4) != 0 ||
+            header->version != DASHBOARD_SNAPSHOT_VERSION)
+        {
+            warn("DashboardSnapshot: {} is not a version {} snapshot", path, DASHBOARD_SNAPSHOT_VERSION);
+            Close();
+            return false;
+        }
+
+        // Written as differences against size so no header field, however
+        // large, can wrap a sum past the checks
+        size_t recordsEnd = sizeof(DashboardSnapshotHeader) +
+            static_cast<size_t>(header->widgetCount) * sizeof(DashboardSnapshotRecord);
+        if (header->widgetCount > (size - sizeof(DashboardSnapshotHeader)) / sizeof(DashboardSnapshotRecord) ||
+            header->alarmsOffset < recordsEnd ||
+            header->alarmsOffset > size ||
+            header->alarmsOffset % DASHBOARD_SNAPSHOT_ALIGNMENT != 0 ||
+            header->alarmCount > (size - header->alarmsOffset) / sizeof(DashboardSnapshotAlarm) ||
+            header->paramsOffset < header->alarmsOffset + header->alarmCount * sizeof(DashboardSnapshotAlarm) ||
+            header->paramsOffset > size ||
+            header->paramsOffset % DASHBOARD_SNAPSHOT_ALIGNMENT != 0 ||
+            header->paramsSize > size - header->paramsOffset ||
+            header->stringTableOffset > size ||
+            header->stringTableSize > size - header->stringTableOffset)
+        {
+            warn("DashboardSnapshot: {} is truncated", path);
+            Close();
+            return false;
+        }
+
+        auto records = reinterpret_cast<const DashboardSnapshotRecord*>(data + sizeof(DashboardSnapshotHeader));
+        for (uint32_t i = 0; i < header->widgetCount; i++)
+        {
+            const DashboardSnapshotRecord& r = records[i];
+            if (static_cast<uint64_t>(r.type.offset) + r.type.length > header->stringTableSize ||
+                static_cast<uint64_t>(r.channel.offset) + r.channel.length > header->stringTableSize ||
+                static_cast<uint64_t>(r.paramOffset) + r.paramSize > header->paramsSize ||
+                r.paramOffset % DASHBOARD_SNAPSHOT_ALIGNMENT != 0)
+            {
+                warn("DashboardSnapshot: {} record {} is out of bounds", path, i);
+                Close();
+                return false;
+            }
+        }
+
+        auto alarms = reinterpret_cast<const DashboardSnapshotAlarm*>(data + header->alarmsOffset);
+        for (uint32_t i = 0; i < header->alarmCount; i++)
+        {
+            if (static_cast<uint64_t>(alarms[i].channel.offset) + alarms[i].channel.length > header->stringTableSize)
+            {
+                warn("DashboardSnapshot: {} alarm {} is out of bounds", path, i);
+                Close();
+                return false;
+            }
+        }
+
+        mHeader = header;
+        mRecords = records;
+        mAlarms = alarms;
+        mParams = data + header->paramsOffset;
+        mStrings = reinterpret_cast<const char*>(data + header->stringTableOffset);
+        mFile.Prefetch();
+        return true;
+    }
+
+    void DashboardSnapshot::Close()
+    {
+        mHeader = nullptr;
+        mRecords = nullptr;
+        mAlarms = nullptr;
+        mParams = nullptr;
+        mStrings = nullptr;
+        mFile.Unmap();
+    }
+
+    bool DashboardSnapshot::IsOpen() const
+    {
+        return mHeader != nullptr;
+    }
+
+    uint64_t DashboardSnapshot::GetSourceHash() const
+    {
+        return IsOpen() ? mHeader->sourceHash : 0;
+    }
+
+    uint32_t DashboardSnapshot::GetWidgetCount() const
+    {
+        return IsOpen() ? mHeader->widgetCount : 0;
+    }
+
+    const DashboardSnapshotRecord& DashboardSnapshot::GetRecord(uint32_t index) const
+    {
+        return mRecords[index];
+    }
+
+    uint32_t DashboardSnapshot::GetAlarmCount() const
+    {
+        return IsOpen() ? mHeader->alarmCount : 0;
+    }
+
+    const DashboardSnapshotAlarm& DashboardSnapshot::GetAlarm(uint32_t index) const
+    {
+        return mAlarms[index];
+    }
+
+    string DashboardSnapshot::GetString(const DashboardSnapshotString& slice) const
+    {
+        if (!IsOpen() ||
+            static_cast<uint64_t>(slice.offset) + slice.length > mHeader->stringTableSize)
+        {
+            return string();
+        }
+        return string(mStrings + slice.offset, slice.length);
+    }
+
+    string DashboardSnapshot::PathFor(const string& dashboardPath)
+    {
+        auto extStart = dashboardPath.find_last_of('.');
+        auto endOfPath = dashboardPath.find_last_of("/\\");
+        if (extStart == string::npos ||
+            (endOfPath != string::npos && extStart < endOfPath))
+        {
+            return dashboardPath + DASHBOARD_SNAPSHOT_EXTENSION;
+        }
+        return dashboardPath.substr(0, extStart) + DASHBOARD_SNAPSHOT_EXTENSION;
+    }
+
+    uint64_t DashboardSnapshot::Hash(const uint8_t* data, size_t size)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= data[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    DashboardSnapshotWriter::DashboardSnapshotWriter()
+    {
+    }
+
+    void DashboardSnapshotWriter::AddWidget(Widget* widget, int32_t parent)
+    {
+        DashboardSnapshotRecord record;
+        memset(&record, 0, sizeof(record));
+        record.type = AddString(widget->GetTypeName());
+        if (widget->GetChannel() != nullptr)
+        {
+            record.channel = AddString(widget->GetChannel()->GetName());
+        }
+        vec3 position = widget->GetPosition();
+        record.position[0] = position.x;
+        record.position[1] = position.y;
+        record.position[2] = position.z;
+        vec3 rotation = widget->GetRotation();
+        record.rotation[0] = rotation.x;
+        record.rotation[1] = rotation.y;
+        record.rotation[2] = rotation.z;
+        vec3 scale = widget->GetScale();
+        record.scale[0] = scale.x;
+        record.scale[1] = scale.y;
+        record.scale[2] = scale.z;
+        record.flags = widget->GetVisible() ? DashboardSnapshot_Visible : 0;
+        record.parent = parent;
+        record.paramOffset = static_cast<uint32_t>(mParams.size());
+        mRecords.push_back(record);
+
+        widget->WriteSnapshot(*this);
+    }
+
+    void DashboardSnapshotWriter::AddAlarm(const string& channel, const AlarmLimits& limits)
+    {
+        DashboardSnapshotAlarm alarm;
+        memset(&alarm, 0, sizeof(alarm));
+        alarm.channel = AddString(channel);
+        alarm.limits[0] = limits.lowCritical;
+        alarm.limits[1] = limits.lowWarning;
+        alarm.limits[2] = limits.highWarning;
+        alarm.limits[3] = limits.highCritical;
+        alarm.hysteresis = limits.hysteresis;
+        mAlarms.push_back(alarm);
+    }
+
+    void DashboardSnapshotWriter::SetParams(const void* params, size_t size)
+    {
+        DashboardSnapshotRecord& record = mRecords.back();
+        size_t padded = (size + DASHBOARD_SNAPSHOT_ALIGNMENT - 1) & ~static_cast<size_t>(DASHBOARD_SNAPSHOT_ALIGNMENT - 1);
+        mParams.resize(record.paramOffset + padded, 0);
+        memcpy(&mParams[record.paramOffset], params, size);
+        record.paramSize = static_cast<uint32_t>(size);
+    }
+
+    DashboardSnapshotString DashboardSnapshotWriter::AddString(const string& value)
+    {
+        auto itr = mStringIndex.find(value);
+        if (itr != mStringIndex.end()) return itr->second;
+
+        DashboardSnapshotString slice;
+        slice.offset = static_cast<uint32_t>(mStrings.size());
+        slice.length = static_cast<uint32_t>(value.size());
+        mStrings += value;
+        mStringIndex[value] = slice;
+        return slice;
+    }
+
+    bool DashboardSnapshotWriter::Write(const string& path, uint64_t sourceHash) const
+    {
+        DashboardSnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, DASHBOARD_SNAPSHOT_MAGIC, 4);
+        header.version = DASHBOARD_SNAPSHOT_VERSION;
+        header.widgetCount = static_cast<uint32_t>(mRecords.size());
+        header.alarmCount = static_cast<uint32_t>(mAlarms.size());
+        header.sourceHash = sourceHash;
+        // Header, records and alarms are multiples of the alignment already
+        header.alarmsOffset = sizeof(header) + mRecords.size() * sizeof(DashboardSnapshotRecord);
+        header.paramsOffset = header.alarmsOffset + mAlarms.size() * sizeof(DashboardSnapshotAlarm);
+        header.paramsSize = mParams.size();
+        header.stringTableOffset = header.paramsOffset + header.paramsSize;
+        header.stringTableSize = mStrings.size();
+
+        // Never leave a half-written snapshot where the next boot looks
+        string temporaryPath = path + ".tmp";
+        FILE* file = fopen(temporaryPath.c_str(), "wb");
+        if (file == nullptr)
+        {
+            warn("DashboardSnapshot: Unable to write {}", temporaryPath);
+            return false;
+        }
+
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+        if (!mRecords.empty())
+        {
+            ok = ok && fwrite(mRecords.data(), sizeof(DashboardSnapshotRecord), mRecords.size(), file) == mRecords.size();
+        }
+        if (!mAlarms.empty())
+        {
+            ok = ok && fwrite(mAlarms.data(), sizeof(DashboardSnapshotAlarm), mAlarms.size(), file) == mAlarms.size();
+        }
+        if (!mParams.empty())
+        {
+            ok = ok && fwrite(mParams.data(), 1, mParams.size(), file) == mParams.size();
+        }
+        if (!mStrings.empty())
+        {
+            ok = ok && fwrite(mStrings.data(), 1, mStrings.size(), file) == mStrings.size();
+        }
+        ok = fclose(file) == 0 && ok;
+
+        if (!ok || rename(temporaryPath.c_str(), path.c_str()) != 0)
+        {
+            warn("DashboardSnapshot: Unable to write {}", path);
+            remove(temporaryPath.c_str());
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,111 @@
+/*
+ * DashboardSnapshot.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "../Common/MappedFile.h"
+#include "../Data/AlarmEngine.h"
+#include "DashboardSnapshotFormat.h"
+
+using std::map;
+using std::string;
+using std::vector;
+using Coconut::MappedFile;
+
+namespace octronic
+{
+    class Widget;
+
+    /**
+     * @brief Read-only view of a mapped dashboard snapshot. Records and
+     * parameter blocks are used in place; nothing is parsed.
+     */
+    class DashboardSnapshot
+    {
+    public:
+        DashboardSnapshot();
+
+        bool Open(const string& path);
+        void Close();
+        bool IsOpen() const;
+
+        uint64_t GetSourceHash() const;
+        uint32_t GetWidgetCount() const;
+        const DashboardSnapshotRecord& GetRecord(uint32_t index) const;
+        uint32_t GetAlarmCount() const;
+        const DashboardSnapshotAlarm& GetAlarm(uint32_t index) const;
+
+        /** @return The slice as a string, or empty if out of bounds. */
+        string GetString(const DashboardSnapshotString& slice) const;
+
+        /**
+         * @return The record's parameter block as T, or nullptr if the
+         * block is not a T.
+         */
+        template <typename T>
+        const T* GetParams(const DashboardSnapshotRecord& record) const
+        {
+            if (record.paramSize != sizeof(T)) return nullptr;
+            return reinterpret_cast<const T*>(mParams + record.paramOffset);
+        }
+
+        /** @brief Dashboards/Default.json -> Dashboards/Default.pdds */
+        static string PathFor(const string& dashboardPath);
+
+        /** @brief 64-bit FNV-1a, used to tie a snapshot to its JSON. */
+        static uint64_t Hash(const uint8_t* data, size_t size);
+
+    private:
+        MappedFile mFile;
+        const DashboardSnapshotHeader* mHeader;
+        const DashboardSnapshotRecord* mRecords;
+        const DashboardSnapshotAlarm* mAlarms;
+        const uint8_t* mParams;
+        const char* mStrings;
+    };
+
+    /**
+     * @brief Builds a snapshot from initialised-or-not widgets. AddWidget
+     * writes the common record and lets the widget append its parameters
+     * through Widget::WriteSnapshot.
+     */
+    class DashboardSnapshotWriter
+    {
+    public:
+        DashboardSnapshotWriter();
+
+        /** @param parent Record index of the widget's parent, -1 for none. */
+        void AddWidget(Widget* widget, int32_t parent = -1);
+        void AddAlarm(const string& channel, const AlarmLimits& limits);
+
+        /** @brief Sets the parameter block of the widget being added. */
+        void SetParams(const void* params, size_t size);
+
+        /** @brief Interns a string in the string table. */
+        DashboardSnapshotString AddString(const string& value);
+
+        /** @brief Writes to a temporary file and renames it over path. */
+        bool Write(const string& path, uint64_t sourceHash) const;
+
+    private:
+        vector<DashboardSnapshotRecord> mRecords;
+        vector<DashboardSnapshotAlarm> mAlarms;
+        vector<uint8_t> mParams;
+        string mStrings;
+        map<string, DashboardSnapshotString> mStringIndex;
+    };
+}
@@ -0,0 +1,152 @@
+/*
+ * DashboardSnapshotFormat.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * On-disk layout of a dashboard snapshot (.pdds): the widget set of a
+ * dashboard JSON file after FromJson has resolved it, stored so that it can
+ * be mapped and read in place. Fields are in the byte order of the host
+ * that wrote them; a snapshot from a host of the other byte order fails
+ * the version check and is rebuilt.
+ *
+ *     DashboardSnapshotHeader
+ *     DashboardSnapshotRecord[widgetCount]
+ *     DashboardSnapshotAlarm[alarmCount], at alarmsOffset
+ *     parameter blocks, each starting on a DASHBOARD_SNAPSHOT_ALIGNMENT boundary
+ *     string table, not null terminated
+ *
+ * Each record holds what every widget has (type, channel, local transform,
+ * visibility, parent) and points at a block of its type's parameters, one of the
+ * *Snapshot structs below.
+ *
+ * sourceHash is the FNV-1a hash of the JSON the snapshot was made from; a
+ * snapshot whose hash does not match its JSON is stale and is rebuilt.
+ * Bump DASHBOARD_SNAPSHOT_VERSION whenever any struct here changes.
+ */
+
+#define DASHBOARD_SNAPSHOT_MAGIC     "PDDS"
+#define DASHBOARD_SNAPSHOT_VERSION   3
+#define DASHBOARD_SNAPSHOT_ALIGNMENT 8
+#define DASHBOARD_SNAPSHOT_EXTENSION ".pdds"
+
+namespace octronic
+{
+    enum DashboardSnapshotRecordFlags
+    {
+        DashboardSnapshot_Visible = 1 << 0
+    };
+
+    /** @brief A string table slice. */
+    struct DashboardSnapshotString
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct DashboardSnapshotHeader
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t widgetCount;
+        uint32_t alarmCount;
+        uint64_t sourceHash;
+        uint64_t paramsOffset;
+        uint64_t paramsSize;
+        uint64_t stringTableOffset;
+        uint64_t stringTableSize;
+        uint64_t alarmsOffset;
+    };
+
+    struct DashboardSnapshotRecord
+    {
+        DashboardSnapshotString type;
+        DashboardSnapshotString channel; // length 0 when unbound
+        float    position[3];
+        float    rotation[3];            // degrees
+        float    scale[3];
+        uint32_t flags;
+        int32_t  parent;                 // index of an earlier record, -1 for none
+        uint32_t paramOffset;            // relative to paramsOffset
+        uint32_t paramSize;
+        uint32_t reserved;
+    };
+
+    /** @brief One entry of the dashboard's alarms array, see AlarmLimits. */
+    struct DashboardSnapshotAlarm
+    {
+        DashboardSnapshotString channel;
+        float    limits[4];              // low critical, low warning, high warning, high critical
+        float    hysteresis;
+        uint32_t reserved;
+    };
+
+    struct GridSnapshot
+    {
+        float majorSpacing;
+        float minorSpacing;
+        float majorColour[3];
+        float minorColour[3];
+        float area[2];
+    };
+
+    struct ImageWidgetSnapshot
+    {
+        DashboardSnapshotString image;
+        float    valueRotation[4];       // min value, max value, min degrees, max degrees
+        float    animationDuration;
+        uint32_t rotateWithValue;
+    };
+
+    struct StripChartSnapshot
+    {
+        float    windowSeconds;
+        uint32_t capacity;
+        float    size[2];
+        float    colour[3];
+        float    valueRange[2];
+        uint32_t history;                // channel history capacity, 0 for none
+    };
+
+    struct TrendChartSnapshot
+    {
+        float    windowSeconds;
+        uint32_t pointCount;
+        float    size[2];
+        float    colour[3];
+        float    valueRange[2];
+        int32_t  refreshInterval;
+    };
+
+    struct TextWidgetSnapshot
+    {
+        DashboardSnapshotString text;
+        DashboardSnapshotString valueFormat;
+        float    size;
+        float    colour[4];
+        uint32_t alignment;
+        uint32_t maxGlyphs;
+    };
+
+    static_assert(sizeof(DashboardSnapshotHeader) == 64, "DashboardSnapshotHeader must be packed");
+    static_assert(sizeof(DashboardSnapshotRecord) == 72, "DashboardSnapshotRecord must be packed");
+    static_assert(sizeof(DashboardSnapshotAlarm) == 32, "DashboardSnapshotAlarm must be packed");
+    static_assert(sizeof(GridSnapshot) == 40, "GridSnapshot must be packed");
+    static_assert(sizeof(ImageWidgetSnapshot) == 32, "ImageWidgetSnapshot must be packed");
+    static_assert(sizeof(StripChartSnapshot) == 40, "StripChartSnapshot must be packed");
+    static_assert(sizeof(TrendChartSnapshot) == 40, "TrendChartSnapshot must be packed");
+    static_assert(sizeof(TextWidgetSnapshot) == 44, "TextWidgetSnapshot must be packed");
+}
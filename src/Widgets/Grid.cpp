@@ -17,9 +17,12 @@
  */
 
 #include "Grid.h"
+#include <cstring>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include "../AppState.h"
 #include "../Common/Logger.h"
+#include "DashboardSnapshot.h"
 
 namespace octronic
 {
@@ -127,9 +130,14 @@ namespace octronic
         mMajorColour = majorColour;
     }
 
+    vec3 Grid::GetTranslation() const
+    {
+        return mAppState->GetSceneGraph().GetTranslation(mNode);
+    }
+
     void Grid::SetTranslation(vec3 translation)
     {
-        mModelMatrix = glm::translate(mat4(1.0f),translation);
+        SetPosition(translation);
     }
 
     float Grid::GetMajorSpacing()
@@ -152,6 +160,56 @@ namespace octronic
         mMinorSpacing = ms < 0.1f ? 0.1f : ms;
     }
 
+    const char* Grid::GetTypeName() const
+    {
+        return "Grid";
+    }
+
+    json Grid::ToJson()
+    {
+        json j = Widget::ToJson();
+        j["majorSpacing"] = mMajorSpacing;
+        j["minorSpacing"] = mMinorSpacing;
+        j["majorColour"] = Vec3ToJson(mMajorColour);
+        j["minorColour"] = Vec3ToJson(mMinorColour);
+        j["area"] = Vec2ToJson(mGridArea);
+        return j;
+    }
+
+    bool Grid::FromJson(const json& j)
+    {
+        if (!Widget::FromJson(j)) return false;
+        if (j.count("majorSpacing")) SetMajorSpacing(j["majorSpacing"].get<float>());
+        if (j.count("minorSpacing")) SetMinorSpacing(j["minorSpacing"].get<float>());
+        if (j.count("majorColour"))  mMajorColour = JsonToVec3(j["majorColour"]);
+        if (j.count("minorColour"))  mMinorColour = JsonToVec3(j["minorColour"]);
+        if (j.count("area"))         mGridArea = JsonToVec2(j["area"]);
+        return true;
+    }
+
+    void Grid::WriteSnapshot(DashboardSnapshotWriter& writer)
+    {
+        GridSnapshot params;
+        params.majorSpacing = mMajorSpacing;
+        params.minorSpacing = mMinorSpacing;
+        memcpy(params.majorColour, &mMajorColour[0], sizeof(params.majorColour));
+        memcpy(params.minorColour, &mMinorColour[0], sizeof(params.minorColour));
+        memcpy(params.area, &mGridArea[0], sizeof(params.area));
+        writer.SetParams(&params, sizeof(params));
+    }
+
+    bool Grid::ReadSnapshot(const DashboardSnapshot& snapshot, const DashboardSnapshotRecord& record)
+    {
+        auto params = snapshot.GetParams<GridSnapshot>(record);
+        if (params == nullptr || !Widget::ReadSnapshot(snapshot, record)) return false;
+        SetMajorSpacing(params->majorSpacing);
+        SetMinorSpacing(params->minorSpacing);
+        mMajorColour = glm::make_vec3(params->majorColour);
+        mMinorColour = glm::make_vec3(params->minorColour);
+        mGridArea = glm::make_vec2(params->area);
+        return true;
+    }
+
     void Grid::RecalculateGridLines()
     {
         debug("Grid: {}",__FUNCTION__);
@@ -39,6 +39,12 @@ namespace octronic
         bool Init() override;
         void Update() override;
 
+        const char* GetTypeName() const override;
+        json ToJson() override;
+        bool FromJson(const json& j) override;
+        void WriteSnapshot(DashboardSnapshotWriter& writer) override;
+        bool ReadSnapshot(const DashboardSnapshot& snapshot, const DashboardSnapshotRecord& record) override;
+
         float GetMajorSpacing();
         void  SetMajorSpacing(float);
 
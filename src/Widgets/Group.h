@@ -0,0 +1,40 @@
+/*
+ * Group.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include "Widget.h"
+
+namespace octronic
+{
+    /**
+     * @brief Draws nothing; its children are placed relative to it, so a
+     * panel of widgets can be moved, rotated or scaled as one.
+     */
+    class Group : public Widget
+    {
+    public:
+        Group(AppState* state);
+        ~Group() override;
+
+        bool Init() override;
+        void Update() override;
+        void Draw(const mat4& view, const mat4& projection) override;
+
+        const char* GetTypeName() const override;
+
+    protected:
+        bool InitShader() override;
+    };
+}
@@ -1,20 +1,58 @@
 #include "ImageWidget.h"
+#include <cmath>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "../Common/Time.h"
+#include "../Common/ImageKernels.h"
+#include "../Common/Tracer.h"
+#include "../AppState.h"
+#include "../Data/DataChannel.h"
+#include "DashboardSnapshot.h"
 
 namespace octronic
 {
+    GLuint ImageWidget::sShaderProgram = 0;
+    unsigned ImageWidget::sShaderUsers = 0;
+
 	ImageWidget::ImageWidget
     (AppState* state, string image_path, bool visible)
         : Widget(state, visible),
           mImageFilePath(image_path),
-          mModelUniform(0),
+          mBakedReleased(false),
+          mImageData(nullptr),
+          mTextureID(0),
           mViewUniform(0),
           mProjectionUniform(0),
-          mImageWidth(0),
-          mImageHeight(0),
+          mTextureUniform(0),
           mVao(0),
           mVbo(0),
-          mTextureID(0)
+          mImageWidth(0),
+          mImageHeight(0),
+          mImageChannels(0),
+          mPrepared(false),
+          mFootprint(0),
+          mScreenFootprint(0),
+          mScreenFootprintNode(0),
+          mScreenFootprintCamera(0),
+          mTextureWidth(0),
+          mTextureHeight(0),
+          mEvicted(false),
+          mSourceDone(false),
+          mSourceLoading(false),
+          mSourceLoaded(false),
+          mSourceFailed(false),
+          mRotateWithValue(false),
+          mMinValue(0.0f),
+          mMaxValue(1.0f),
+          mMinDegrees(0.0f),
+          mMaxDegrees(0.0f),
+          mChannelVersion(0),
+          mAnimFrom(0.0f),
+          mAnimTo(0.0f),
+          mAnimStart(0.0),
+          mAnimEnd(0.0),
+          mAnimEpoch(0.0),
+          mAnimationDuration(0.15f)
 	{
         debug("ImageWidget: Constructor");
     }
@@ -22,21 +60,63 @@ namespace octronic
     ImageWidget::~ImageWidget()
     {
         debug("ImageWidget: Destructor");
+        mAppState->GetAssetReloader().Unwatch(this);
+        JoinSourceThread();
         if (mImageData != nullptr) SOIL_free_image_data(mImageData);
-        if (mTextureID > 0) glDeleteTextures(1,&mTextureID);
-        if (mVao > 0)       glDeleteVertexArrays(1,&mVao);
-        if (mVbo > 0)       glDeleteBuffers(1,&mVbo);
+        DeleteTexture();
+        GpuMemoryTracker& tracker = mAppState->GetGpuMemoryTracker();
+        if (mVao > 0)
+        {
+            tracker.Release(GpuResource_VertexArray, mVao);
+            glDeleteVertexArrays(1,&mVao);
+        }
+        if (mVbo > 0)
+        {
+            tracker.Release(GpuResource_VertexBuffer, mVbo);
+            glDeleteBuffers(1,&mVbo);
+        }
+        // The program is shared; keep Widget from deleting it
+        if (mShaderProgram > 0 && mShaderProgram == sShaderProgram)
+        {
+            if (--sShaderUsers == 0)
+            {
+                glDeleteProgram(sShaderProgram);
+                sShaderProgram = 0;
+            }
+            mShaderProgram = 0;
+        }
+    }
+
+    bool ImageWidget::Prepare()
+    {
+        TRACE_SCOPE_DETAIL("ImageWidget::Prepare", mImageFilePath);
+        if (mPrepared) return true;
+        Window& window = mAppState->GetWindow();
+        mFootprint = GetScreenFootprint(window.GetViewMatrix(), window.GetProjectionMatrix());
+        if (!LoadBakedTexture() && !DecodeImageData()) return false;
+        mPrepared = true;
+        return true;
     }
 
     bool ImageWidget::Init()
     {
+        TRACE_SCOPE_DETAIL("ImageWidget::Init", mImageFilePath);
         debug("ImageWidget: Init");
         if (!InitShader())    return false;
-        if (!LoadImageData()) return false;
+        if (!AttachInstance(IMAGE_INSTANCE_STRIDE)) return false;
+        WriteAnimation();
+        auto loadStart = Time::GetCurrentTime();
+        if (!Prepare())       return false;
+        bool baked = mBakedTexture.IsLoaded();
         if (!LoadIntoGL())    return false;
+        debug("ImageWidget: Loaded {} from {} at {}x{} of {}x{} in {}ms", mImageFilePath,
+             baked ? "baked container" : "source image",
+             mTextureWidth, mTextureHeight, mImageWidth, mImageHeight,
+             Time::GetCurrentTime() - loadStart);
         if (!InitGeometry())  return false;
         if(!InitGLBuffers())  return false;
         SubmitVertexBuffer();
+        mAppState->GetAssetReloader().Watch(this);
         return true;
     }
 
@@ -52,6 +132,7 @@ namespace octronic
             return false;
         }
         glBindVertexArray(mVao);
+        mAppState->GetGpuMemoryTracker().Track(this, GpuResource_VertexArray, mVao, 0);
 
         // VBO
         glGenBuffers(1,&mVbo);
@@ -61,6 +142,7 @@ namespace octronic
             return false;
         }
         glBindBuffer(GL_ARRAY_BUFFER,mVbo);
+        mAppState->GetGpuMemoryTracker().Track(this, GpuResource_VertexBuffer, mVbo, 0);
 
         // Vertex Position Attributes
         glVertexAttribPointer(0,
@@ -124,36 +206,366 @@ namespace octronic
         return true;
     }
 
-    bool ImageWidget::LoadImageData()
+    bool ImageWidget::LoadBakedTexture()
+    {
+        TRACE_SCOPE("ImageWidget::LoadBakedTexture");
+        debug("ImageWidget: {}", __FUNCTION__);
+        if (mImageFilePath.empty()) return false;
+
+        AssetPack& pack = mAppState->GetAssetPack();
+        AssetView view;
+        mBakedReleased = false;
+
+        // A hot reloaded file is newer than its baked container
+        if (mAppState->GetAssetReloader().IsReloaded(mImageFilePath)) return false;
+
+        // Prefer an offline-baked container, which needs no decode or
+        // mipmap generation and is uploaded straight from the mapping
+        string bakedPath = TextureContainer::BakedPathFor(mImageFilePath);
+        bool bakedLoaded = pack.Get(bakedPath, view, mBakedStorage) ?
+            mBakedTexture.Parse(view.data, view.size) :
+            mBakedTexture.Open(bakedPath);
+
+        if (bakedLoaded)
+        {
+            if (mBakedTexture.IsSupportedByGL() && mBakedTexture.IsPremultiplied())
+            {
+                mImageWidth = mBakedTexture.GetWidth();
+                mImageHeight = mBakedTexture.GetHeight();
+                mImageChannels = 4;
+                return true;
+            }
+            warn("ImageWidget: Baked texture for {} is not usable (GL support or straight alpha), using source image",
+                 mImageFilePath);
+            mBakedTexture.Close();
+            vector<uint8_t>().swap(mBakedStorage);
+        }
+        return false;
+    }
+
+    bool ImageWidget::DecodeImageData()
     {
-        debug("ImageWidget: LoadImageData");
+        TRACE_SCOPE("ImageWidget::DecodeImageData");
+        debug("ImageWidget: {}", __FUNCTION__);
         if (mImageFilePath.empty()) return false;
-        mImageData = SOIL_load_image(mImageFilePath.c_str(),
-    		&mImageWidth, &mImageHeight, &mImageChannels,
-    		SOIL_LOAD_RGBA);
 
-        return mImageData != nullptr;
+        // A hot reloaded file is newer than the copy in the pack
+        AssetPack& pack = mAppState->GetAssetPack();
+        AssetView view;
+        vector<uint8_t> inflated;
+        if (!mAppState->GetAssetReloader().IsReloaded(mImageFilePath) &&
+            pack.Get(mImageFilePath, view, inflated))
+        {
+            mImageData = SOIL_load_image_from_memory(view.data, static_cast<int>(view.size),
+                &mImageWidth, &mImageHeight, &mImageChannels,
+                SOIL_LOAD_RGBA);
+        }
+        else
+        {
+            mImageData = SOIL_load_image(mImageFilePath.c_str(),
+                &mImageWidth, &mImageHeight, &mImageChannels,
+                SOIL_LOAD_RGBA);
+        }
+
+        if (mImageData == nullptr) return false;
+        PrepareImageData(mImageData, mImageWidth, mImageHeight);
+        return true;
+    }
+
+    void ImageWidget::PrepareImageData(uint8_t* data, int width, int height)
+    {
+        ImageKernels::PremultiplyAlpha(data, static_cast<size_t>(width) * height);
     }
 
     bool ImageWidget::LoadIntoGL()
     {
+        TRACE_SCOPE("ImageWidget::LoadIntoGL");
         debug("ImageWidget: LoadIntoGL");
-        // Assign texture to ID
+        if (mBakedTexture.IsLoaded())
+        {
+            // Skip the levels larger than the widget is drawn. A mapped
+            // container stays mapped so a larger base level can be uploaded
+            // later; an inflated copy is dropped and inflated again then.
+            uint32_t baseLevel = 0;
+            if (mFootprint.x > 0 && mFootprint.y > 0)
+            {
+                while (baseLevel + 1 < mBakedTexture.GetLevelCount() &&
+                       mBakedTexture.GetLevel(baseLevel + 1).width  >= static_cast<uint32_t>(mFootprint.x) &&
+                       mBakedTexture.GetLevel(baseLevel + 1).height >= static_cast<uint32_t>(mFootprint.y))
+                {
+                    baseLevel++;
+                }
+            }
+
+            GLuint texture = mBakedTexture.Upload(baseLevel);
+            if (texture == 0) return false;
+            DeleteTexture();
+            mTextureID = texture;
+            mTextureWidth = mBakedTexture.GetLevel(baseLevel).width;
+            mTextureHeight = mBakedTexture.GetLevel(baseLevel).height;
+
+            size_t bytes = 0;
+            for (uint32_t i = baseLevel; i < mBakedTexture.GetLevelCount(); i++)
+            {
+                bytes += mBakedTexture.GetLevel(i).size;
+            }
+            mAppState->GetGpuMemoryTracker().Track(this, GpuResource_Texture, mTextureID, bytes);
+
+            if (!mBakedStorage.empty())
+            {
+                mBakedTexture.Close();
+                vector<uint8_t>().swap(mBakedStorage);
+                mBakedReleased = true;
+            }
+            return true;
+        }
+
+        UploadImageData(mImageData, mImageWidth, mImageHeight);
+        SOIL_free_image_data(mImageData);
+        mImageData = nullptr;
+        return mTextureID != 0;
+    }
+
+    void ImageWidget::UploadImageData(const uint8_t* data, int width, int height)
+    {
+        // Resample down to the on-screen size before anything reaches GL
+        vector<uint8_t> fitted;
+        int fittedWidth = width;
+        int fittedHeight = height;
+        FitToFootprint(width, height, fittedWidth, fittedHeight);
+        if (fittedWidth != width || fittedHeight != height)
+        {
+            TRACE_SCOPE("ImageKernels::Resample");
+            fitted.resize(static_cast<size_t>(fittedWidth) * fittedHeight * 4);
+            ImageKernels::Resample(data, width, height, fitted.data(), fittedWidth, fittedHeight);
+            data = fitted.data();
+            width = fittedWidth;
+            height = fittedHeight;
+        }
+        mTextureWidth = width;
+        mTextureHeight = height;
+
+        // A fresh texture object, so no stale levels of a larger image linger
+        DeleteTexture();
         glGenTextures(1, &mTextureID);
+        debug("ImageWidget: Generated texture id {} for {}x{}", mTextureID, width, height);
+
         glBindTexture(GL_TEXTURE_2D, mTextureID);
-        debug("Bound to texture id {}",mTextureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        size_t bytes = static_cast<size_t>(width) * height * 4;
+
+        // Build the mip chain on the CPU; glGenerateMipmap is slow on
+        // software GL implementations
+        vector<uint8_t> mips[2];
+        const uint8_t* previous = data;
+        GLint level = 0;
+        while (width > 1 || height > 1)
+        {
+            int mipWidth = ImageKernels::MipWidth(width);
+            int mipHeight = ImageKernels::MipHeight(height);
+            vector<uint8_t>& mip = mips[level % 2];
+            mip.resize(static_cast<size_t>(mipWidth) * mipHeight * 4);
+            ImageKernels::DownsampleBox(previous, width, height, mip.data());
+            level++;
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, mipWidth, mipHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, mip.data());
+            bytes += mip.size();
+            previous = mip.data();
+            width = mipWidth;
+            height = mipHeight;
+        }
 
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mImageWidth, mImageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, mImageData);
-        glGenerateMipmap(GL_TEXTURE_2D);
         // Set Parameters
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glBindTexture(GL_TEXTURE_2D, 0);
-        SOIL_free_image_data(mImageData);
-        mImageData = nullptr;
-        return mTextureID != 0;
+        mAppState->GetGpuMemoryTracker().Track(this, GpuResource_Texture, mTextureID, bytes);
+    }
+
+    void ImageWidget::DeleteTexture()
+    {
+        if (mTextureID == 0) return;
+        mAppState->GetGpuMemoryTracker().Release(GpuResource_Texture, mTextureID);
+        glDeleteTextures(1, &mTextureID);
+        mTextureID = 0;
+    }
+
+    bool ImageWidget::EvictTextures()
+    {
+        if (mTextureID == 0) return false;
+        debug("ImageWidget: Evicting {}", mImageFilePath);
+        DeleteTexture();
+        mTextureWidth = 0;
+        mTextureHeight = 0;
+        mEvicted = true;
+        return true;
+    }
+
+    bool ImageWidget::RestoreTexture(const ivec2& footprint)
+    {
+        if (!mSourceLoading)
+        {
+            debug("ImageWidget: Restoring {}", mImageFilePath);
+            mFootprint = footprint;
+        }
+        if (!ReloadTexture()) return false;
+        mEvicted = false;
+        return true;
+    }
+
+    bool ImageWidget::ReplaceImage(const uint8_t* data, int width, int height)
+    {
+        debug("ImageWidget: {} {}x{}", __FUNCTION__, width, height);
+        // The replacement supersedes any baked container, and whatever a
+        // load still in flight read
+        JoinSourceThread();
+        if (mImageData != nullptr)
+        {
+            SOIL_free_image_data(mImageData);
+            mImageData = nullptr;
+        }
+        mBakedTexture.Close();
+        vector<uint8_t>().swap(mBakedStorage);
+        mBakedReleased = false;
+        mSourceFailed = false;
+        if (mTextureID == 0 || data == nullptr) return false;
+        mImageWidth = width;
+        mImageHeight = height;
+        UploadImageData(data, width, height);
+        return !GLCheckError();
+    }
+
+    bool ImageWidget::LoadImageSource()
+    {
+        if (mBakedTexture.IsLoaded()) return true;
+        if (mBakedReleased && LoadBakedTexture()) return true;
+        return DecodeImageData();
+    }
+
+    bool ImageWidget::ReloadTexture()
+    {
+        if (mSourceFailed) return false;
+        if (mSourceLoading)
+        {
+            if (!mSourceDone.load(std::memory_order_acquire)) return false;
+            JoinSourceThread();
+            if (!mSourceLoaded)
+            {
+                error("ImageWidget: Unable to reload {}", mImageFilePath);
+                mSourceFailed = true;
+                return false;
+            }
+        }
+        else if (!mBakedTexture.IsLoaded())
+        {
+            // Decoding takes too long for the render thread
+            mSourceLoading = true;
+            mSourceDone.store(false, std::memory_order_relaxed);
+            mSourceThread = thread([this]()
+            {
+                TRACE_SCOPE_DETAIL("ImageWidget::LoadImageSource", mImageFilePath);
+                mSourceLoaded = LoadImageSource();
+                mSourceDone.store(true, std::memory_order_release);
+            });
+            return false;
+        }
+        return LoadIntoGL();
+    }
+
+    void ImageWidget::JoinSourceThread()
+    {
+        if (mSourceThread.joinable()) mSourceThread.join();
+        mSourceLoading = false;
+    }
+
+    void ImageWidget::FitToFootprint(int sourceWidth, int sourceHeight, int& width, int& height) const
+    {
+        width = sourceWidth;
+        height = sourceHeight;
+        if (mFootprint.x <= 0 || mFootprint.y <= 0) return;
+        if (mFootprint.x < width)  width = mFootprint.x;
+        if (mFootprint.y < height) height = mFootprint.y;
+    }
+
+    ivec2 ImageWidget::GetScreenFootprint(const mat4& view, const mat4& projection) const
+    {
+        // Corners as laid out by InitGeometry
+        static const vec2 corners[4] =
+        {
+            vec2(-1.0f,  1.0f), vec2(1.0f,  1.0f),
+            vec2(-1.0f, -1.0f), vec2(1.0f, -1.0f)
+        };
+
+        Window& window = mAppState->GetWindow();
+        vec2 viewport(window.GetWidth(), window.GetHeight());
+        mat4 mvp = projection * view * mModelMatrix;
+        vec2 screen[4];
+        for (int i = 0; i < 4; i++)
+        {
+            glm::vec4 clip = mvp * glm::vec4(corners[i], 0.0f, 1.0f);
+            if (clip.w <= 0.0f) return ivec2(0);
+            screen[i] = (vec2(clip) / clip.w * 0.5f + 0.5f) * viewport;
+        }
+
+        // Edge lengths rather than the bounding box, so an in-plane
+        // rotation does not change the required resolution
+        float u = glm::max(glm::distance(screen[0], screen[1]), glm::distance(screen[2], screen[3]));
+        float v = glm::max(glm::distance(screen[0], screen[2]), glm::distance(screen[1], screen[3]));
+        return ivec2(glm::max(1, static_cast<int>(std::ceil(u))),
+                     glm::max(1, static_cast<int>(std::ceil(v))));
+    }
+
+    const ivec2& ImageWidget::GetCachedScreenFootprint(const mat4& view, const mat4& projection)
+    {
+        uint32_t node = mAppState->GetSceneGraph().GetVersion(mNode);
+        uint32_t camera = mAppState->GetWindow().GetCameraVersion();
+        if (node != mScreenFootprintNode || camera != mScreenFootprintCamera)
+        {
+            mScreenFootprint = GetScreenFootprint(view, projection);
+            mScreenFootprintNode = node;
+            mScreenFootprintCamera = camera;
+        }
+        return mScreenFootprint;
+    }
+
+    bool ImageWidget::NeedsLargerTexture(const ivec2& footprint) const
+    {
+        if (mTextureID == 0) return false;
+        int width = 0;
+        int height = 0;
+        if (footprint.x <= 0 || footprint.y <= 0)
+        {
+            width = mImageWidth;
+            height = mImageHeight;
+        }
+        else
+        {
+            width = glm::min(footprint.x, mImageWidth);
+            height = glm::min(footprint.y, mImageHeight);
+        }
+        return width > mTextureWidth || height > mTextureHeight;
+    }
+
+    bool ImageWidget::GrowTexture(const ivec2& footprint)
+    {
+        if (mSourceLoading) return ReloadTexture();
+
+        // Overshoot so a widget that keeps growing is not re-uploaded on
+        // every frame
+        if (footprint.x <= 0 || footprint.y <= 0)
+        {
+            mFootprint = ivec2(0);
+        }
+        else
+        {
+            mFootprint = glm::max(footprint, ivec2(mTextureWidth, mTextureHeight) * 2);
+        }
+        info("ImageWidget: {} grew to {}x{} on screen, re-uploading", mImageFilePath, footprint.x, footprint.y);
+
+        return ReloadTexture();
     }
 
     string ImageWidget::GetImageFilePath() const
@@ -168,89 +580,208 @@ namespace octronic
 
     void ImageWidget::Update()
     {
+        // The shader clock restarted, so the record's keyframe times are stale
+        if (mInstances != nullptr && mAnimEpoch != mAppState->GetFrameUniforms().GetEpoch()) WriteAnimation();
+        if (mChannel == nullptr || !mRotateWithValue) return;
+        if (mChannel->GetVersion() == mChannelVersion) return;
+        mChannelVersion = mChannel->GetVersion();
+
+        DataSample latest;
+        if (!mChannel->GetLatest(latest)) return;
+        float t = (latest.value - mMinValue) / (mMaxValue - mMinValue);
+        t = glm::clamp(t, 0.0f, 1.0f);
+        float degrees = mMinDegrees + t * (mMaxDegrees - mMinDegrees);
+        AnimateTo(degrees, vec2(mAnimTo.y, mAnimTo.z), mAnimationDuration);
+    }
 
+    void ImageWidget::SetAnimationDuration(float seconds)
+    {
+        mAnimationDuration = glm::max(0.0f, seconds);
     }
 
-	void ImageWidget::Draw(const glm::mat4& view, const glm::mat4& projection)
-	{
-        debug("ImageWidget: {}", __FUNCTION__);
+    void ImageWidget::AnimateTo(float degrees, const vec2& offset, float seconds)
+    {
+        double now = mAppState->GetFrameUniforms().GetTime();
+        mAnimFrom = GetAnimatedState(now);
+        mAnimTo = glm::vec3(glm::radians(degrees), offset.x, offset.y);
+        mAnimStart = now;
+        mAnimEnd = now + seconds;
+        if (mInstances != nullptr) WriteAnimation();
+    }
 
-        // Enable shader program
-        debug("ImageWidget: Using shader {}",mShaderProgram);
-		glUseProgram(mShaderProgram);
-		GLCheckError();
-
-        // Set the projection matrix
-		if (mModelUniform == -1)
-		{
-			error("ImageWidget: ModelUniform not found in ShaderProgram");
-			return;
-		}
-		else
-		{
-			glUniformMatrix4fv(mModelUniform, 1, GL_FALSE, glm::value_ptr(mModelMatrix));
-			GLCheckError();
-		}
-		// Set the view matrix
-		if (mViewUniform == -1)
-		{
-			error("ImageWidget: ViewUniform not found in ShaderProgram");
-			return;
-		}
-		else
-		{
-			glUniformMatrix4fv(mViewUniform, 1, GL_FALSE, glm::value_ptr(view));
-			GLCheckError();
-		}
-		// Set the projection matrix
-		if (mProjectionUniform == -1)
-		{
-			error("ImageWidget: ProjectionUniform not found in ShaderProgram");
-			return;
-		}
-		else
-		{
-			glUniformMatrix4fv(mProjectionUniform, 1, GL_FALSE, glm::value_ptr(projection));
-			GLCheckError();
-		}
-
-        /*
-        // Set the texture
-		if (mTextureUniform == -1)
-		{
-			error("ImageWidget: Texture Uniform not found in ShaderProgram");
-			return;
-		}
-		else
-		{
-			glUniform1f(mTextureUniform, mTextureID);
-			GLCheckError();
-		}
-        */
+    void ImageWidget::WriteAnimation()
+    {
+        const FrameUniforms& uniforms = mAppState->GetFrameUniforms();
+        // A finished animation holds its end state, however old its times
+        if (mAnimEnd <= uniforms.GetTime())
+        {
+            mAnimFrom = mAnimTo;
+            mAnimStart = mAnimEnd;
+        }
+        mAnimEpoch = uniforms.GetEpoch();
 
-        if (!mVertexBuffer.empty())
+        vec4* record = WriteInstance();
+        record[IMAGE_INSTANCE_ANIM_FROM] = vec4(mAnimFrom, uniforms.ToShaderTime(mAnimStart));
+        record[IMAGE_INSTANCE_ANIM_TO] = vec4(mAnimTo, uniforms.ToShaderTime(mAnimEnd));
+
+        // The quad's corners are sqrt(2) from its centre, which the
+        // keyframe offsets move
+        float offset = glm::max(glm::length(vec2(mAnimFrom.y, mAnimFrom.z)),
+            glm::length(vec2(mAnimTo.y, mAnimTo.z)));
+        SetInstanceBounds(vec4(0.0f, 0.0f, 0.0f, glm::root_two<float>() + offset));
+    }
+
+    glm::vec3 ImageWidget::GetAnimatedState(double time) const
+    {
+        // Mirrors the vertex shader
+        float t = 1.0f;
+        if (mAnimEnd > mAnimStart)
         {
-            // Bind Texture
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, mTextureID);
+            t = static_cast<float>(glm::clamp((time - mAnimStart) / (mAnimEnd - mAnimStart), 0.0, 1.0));
+        }
+        t = t * t * (3.0f - 2.0f * t);
+        return glm::mix(mAnimFrom, mAnimTo, t);
+    }
 
-            // Vertex Array
-            glBindVertexArray(mVao);
-        	GLCheckError();
+    const char* ImageWidget::GetTypeName() const
+    {
+        return "Image";
+    }
 
-            // Draw
-            GLuint sz = mVertexBuffer.size();
-            debug("ImageWidget: Drawing {} Triangles", sz/3);
-            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(sz));
-        	GLCheckError();
+    json ImageWidget::ToJson()
+    {
+        json j = Widget::ToJson();
+        j["image"] = mImageFilePath;
+        j["animationDuration"] = mAnimationDuration;
+        if (mRotateWithValue)
+        {
+            j["valueRotation"] = Vec4ToJson(glm::vec4(mMinValue, mMaxValue, mMinDegrees, mMaxDegrees));
+        }
+        return j;
+    }
 
-            glBindVertexArray(0);
-        	GLCheckError();
+    bool ImageWidget::FromJson(const json& j)
+    {
+        if (!Widget::FromJson(j)) return false;
+        if (j.count("image")) mImageFilePath = j["image"].get<string>();
+        if (j.count("animationDuration")) SetAnimationDuration(j["animationDuration"].get<float>());
+        if (j.count("valueRotation"))
+        {
+            glm::vec4 rotation = JsonToVec4(j["valueRotation"]);
+            SetValueRotation(rotation.x, rotation.y, rotation.z, rotation.w);
         }
+        return !mImageFilePath.empty();
+    }
+
+    void ImageWidget::WriteSnapshot(DashboardSnapshotWriter& writer)
+    {
+        ImageWidgetSnapshot params;
+        params.image = writer.AddString(mImageFilePath);
+        params.valueRotation[0] = mMinValue;
+        params.valueRotation[1] = mMaxValue;
+        params.valueRotation[2] = mMinDegrees;
+        params.valueRotation[3] = mMaxDegrees;
+        params.animationDuration = mAnimationDuration;
+        params.rotateWithValue = mRotateWithValue ? 1 : 0;
+        writer.SetParams(&params, sizeof(params));
+    }
+
+    bool ImageWidget::ReadSnapshot(const DashboardSnapshot& snapshot, const DashboardSnapshotRecord& record)
+    {
+        auto params = snapshot.GetParams<ImageWidgetSnapshot>(record);
+        if (params == nullptr || !Widget::ReadSnapshot(snapshot, record)) return false;
+        mImageFilePath = snapshot.GetString(params->image);
+        SetAnimationDuration(params->animationDuration);
+        if (params->rotateWithValue)
+        {
+            SetValueRotation(params->valueRotation[0], params->valueRotation[1],
+                params->valueRotation[2], params->valueRotation[3]);
+        }
+        return !mImageFilePath.empty();
+    }
+
+    void ImageWidget::SetValueRotation(float minValue, float maxValue, float minDegrees, float maxDegrees)
+    {
+        mRotateWithValue = maxValue != minValue;
+        mMinValue = minValue;
+        mMaxValue = maxValue;
+        mMinDegrees = minDegrees;
+        mMaxDegrees = maxDegrees;
+        mChannelVersion = 0;
+    }
+
+	void ImageWidget::Draw(const glm::mat4& view, const glm::mat4& projection)
+	{
+        if (mInstances == nullptr) return;
+        uint32_t slot = mInstance;
+        DrawImages(*mInstances, &slot, 1, view, projection);
 	}
 
+    void ImageWidget::DrawBatch(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+        const mat4& view, const mat4& projection)
+    {
+        TRACE_SCOPE("ImageWidget::DrawBatch");
+        for (size_t i = 0; i < count; i++)
+        {
+            static_cast<ImageWidget*>(instances.GetWidget(slots[i]))->ImageWidget::Update();
+        }
+        DrawImages(instances, slots, count, view, projection);
+    }
+
+    void ImageWidget::DrawImages(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+        const mat4& view, const mat4& projection)
+    {
+        if (count == 0 || sShaderProgram == 0) return;
+        const ImageWidget* first = static_cast<const ImageWidget*>(instances.GetWidget(slots[0]));
+
+        // State shared by every image is set once per batch, and the
+        // records changed since the last frame go up in one upload
+        glUseProgram(sShaderProgram);
+        glUniformMatrix4fv(first->mViewUniform, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(first->mProjectionUniform, 1, GL_FALSE, glm::value_ptr(projection));
+        instances.Upload();
+        instances.Bind();
+        // Textures hold premultiplied alpha
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        glActiveTexture(GL_TEXTURE0);
+        GLCheckError();
+
+        for (size_t i = 0; i < count; i++)
+        {
+            ImageWidget* widget = static_cast<ImageWidget*>(instances.GetWidget(slots[i]));
+            if (widget->mShaderProgram == 0 || widget->mVertexBuffer.empty()) continue;
+
+            // Only binds textures, so the program and blend state survive
+            const ivec2& footprint = widget->GetCachedScreenFootprint(view, projection);
+            if (widget->mEvicted)
+            {
+                if (!widget->RestoreTexture(footprint)) continue;
+            }
+            else if (widget->mSourceLoading || widget->NeedsLargerTexture(footprint))
+            {
+                widget->GrowTexture(footprint);
+            }
+
+            WidgetInstanceBuffer::SelectSlot(slots[i]);
+            glBindTexture(GL_TEXTURE_2D, widget->mTextureID);
+            glBindVertexArray(widget->mVao);
+            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(widget->mVertexBuffer.size()));
+        }
+        glBindVertexArray(0);
+        GLCheckError();
+    }
+
 	bool ImageWidget::InitShader()
 	{
+        TRACE_SCOPE("ImageWidget::InitShader");
+        if (mShaderProgram > 0) return true;
+        if (sShaderProgram > 0)
+        {
+            mShaderProgram = sShaderProgram;
+            sShaderUsers++;
+            return GetUniformLocations();
+        }
         info("ImageWidget: {}", __FUNCTION__);
 
         static string vertexShaderSource =
@@ -259,22 +790,38 @@ namespace octronic
             "layout (location = 1) in vec2 in_uv;\n"
             "\n"
             "out vec2 out_texCoord;\n"
+            "flat out vec4 out_tint;\n"
             "\n"
-            "uniform mat4 model;\n"
             "uniform mat4 view;\n"
             "uniform mat4 projection;\n"
+            FRAME_UNIFORMS_GLSL
+            WIDGET_INSTANCE_GLSL
             "\n"
             "void main () { "
-            "    gl_Position = projection * view * model * vec4(in_position.x, in_position.y, 0.0, 1.0);\n"
+            // IMAGE_INSTANCE_ANIM_FROM and _TO
+            "    vec4 animFrom = InstanceData(5);\n"
+            "    vec4 animTo = InstanceData(6);\n"
+            "    float t = animTo.w > animFrom.w ? clamp((frameTime - animFrom.w) / (animTo.w - animFrom.w), 0.0, 1.0) : 1.0;\n"
+            "    vec3 state = mix(animFrom.xyz, animTo.xyz, t * t * (3.0 - 2.0 * t));\n"
+            "    mat2 rotation = mat2(cos(state.x), sin(state.x), -sin(state.x), cos(state.x));\n"
+            "    vec2 position = rotation * in_position + state.yz;\n"
+            "    gl_Position = projection * view * InstanceModel() * vec4(position, 0.0, 1.0);\n"
             "	 out_texCoord = in_uv;\n"
+            "    out_tint = InstanceData(4);\n"
             "}";
 
         static string fragmentShaderSource =
             "#version 330 core\n"
             "in  vec2 out_texCoord;\n"
+            "flat in vec4 out_tint;\n"
             "out vec4 FragColor;\n"
-            "uniform sampler2D ImgTexture;"
-            "void main() { FragColor = texture(ImgTexture, out_texCoord); }";
+            "uniform sampler2D ImgTexture;\n"
+            FRAME_UNIFORMS_GLSL
+            WIDGET_ALARM_GLSL
+            "void main() {\n"
+            "    vec4 colour = texture(ImgTexture, out_texCoord);\n"
+            "    FragColor = vec4(colour.rgb * mix(vec3(1.0), out_tint.rgb, AlarmOn(out_tint)), colour.a);\n"
+            "}";
 
         GLuint vertexShader = 0;
         GLuint fragmentShader = 0;
@@ -334,24 +881,31 @@ namespace octronic
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
 
-        // Get Uniform Locations
-        mModelUniform = glGetUniformLocation(mShaderProgram, "model");
+        mAppState->GetFrameUniforms().BindProgram(mShaderProgram);
+        WidgetInstanceBuffer::BindProgram(mShaderProgram, IMAGE_INSTANCE_STRIDE);
+        sShaderProgram = mShaderProgram;
+        sShaderUsers++;
+        return GetUniformLocations();
+    }
+
+    bool ImageWidget::GetUniformLocations()
+    {
         mViewUniform = glGetUniformLocation(mShaderProgram,"view");
         mProjectionUniform = glGetUniformLocation(mShaderProgram, "projection");
         mTextureUniform = glGetUniformLocation(mShaderProgram, "ImgTexture");
 
         GLCheckError();
 
-        if (mModelUniform != -1 && mViewUniform != -1 && mProjectionUniform != -1 && mTextureUniform != -1)
+        if (mViewUniform != -1 && mProjectionUniform != -1 && mTextureUniform != -1)
         {
-            debug("ImageWidget: Uniforms found Model:{} View:{} Projection:{} Texture:{}",
-                  mModelUniform, mViewUniform, mProjectionUniform,mTextureUniform);
+            debug("ImageWidget: Uniforms found View:{} Projection:{} Texture:{}",
+                  mViewUniform, mProjectionUniform,mTextureUniform);
         	return true;
         }
         else
         {
-       		error("ImageWidget: Uniform Error M:{} V:{} P:{} T:{}",
-                  mModelUniform, mViewUniform, mProjectionUniform,mTextureUniform);
+       		error("ImageWidget: Uniform Error V:{} P:{} T:{}",
+                  mViewUniform, mProjectionUniform,mTextureUniform);
             return false;
         }
 	}
@@ -366,6 +920,8 @@ namespace octronic
 			glBindBuffer(GL_ARRAY_BUFFER, mVbo);
 			glBufferData(GL_ARRAY_BUFFER, static_cast<GLint>(mVertexBuffer.size() * sizeof(ImageWidgetVertex)), &mVertexBuffer[0], GL_STATIC_DRAW);
 			glBindVertexArray(0);
+			mAppState->GetGpuMemoryTracker().Track(this, GpuResource_VertexBuffer, mVbo,
+				mVertexBuffer.size() * sizeof(ImageWidgetVertex));
         }
     }
 }
@@ -1,10 +1,21 @@
 #pragma once
 
+#include <atomic>
+#include <thread>
 #include "../Common/GLHeader.h"
 #include "Widget.h"
 #include "SOIL.h"
+#include "../Assets/TextureContainer.h"
 
 using glm::vec2;
+using glm::ivec2;
+using std::atomic;
+using std::thread;
+
+// Record layout after the WidgetInstanceBuffer base
+#define IMAGE_INSTANCE_ANIM_FROM 5
+#define IMAGE_INSTANCE_ANIM_TO 6
+#define IMAGE_INSTANCE_STRIDE 7
 
 namespace octronic
 {
@@ -20,26 +31,116 @@ namespace octronic
 		ImageWidget(AppState* state, string image_path, bool visible = true);
         ~ImageWidget();
 
+        bool Prepare() override;
         bool Init() override;
         void Update() override;
         void Draw(const mat4& view, const mat4& projection) override;
+        bool EvictTextures() override;
+
+        const char* GetTypeName() const override;
+        json ToJson() override;
+        bool FromJson(const json& j) override;
+        void WriteSnapshot(DashboardSnapshotWriter& writer) override;
+        bool ReadSnapshot(const DashboardSnapshot& snapshot, const DashboardSnapshotRecord& record) override;
+
+        /**
+         * @brief Maps the bound channel's latest value linearly onto a
+         * rotation about the widget's z axis, clamped to the value range.
+         * Value changes are animated with AnimateTo.
+         */
+        void SetValueRotation(float minValue, float maxValue, float minDegrees, float maxDegrees);
+        void SetAnimationDuration(float seconds);
+
+        /**
+         * @brief Publishes a keyframe: the quad turns about its centre to
+         * degrees and moves to offset (model units) over the given seconds,
+         * starting from wherever the current animation has got to. The
+         * vertex shader interpolates against FrameUniforms' frame time, so
+         * the CPU does no work between keyframes.
+         */
+        void AnimateTo(float degrees, const vec2& offset, float seconds);
 
         string GetImageFilePath() const;
         void   SetImageFilePath(const string& imageFilePath);
 
+        /**
+         * @brief Uploads decoded RGBA pixels into a new texture object,
+         * which replaces and frees the widget's old one. Must be called on
+         * the render thread.
+         */
+        bool ReplaceImage(const uint8_t* data, int width, int height);
+
+        /**
+         * @brief CPU-side preparation of freshly decoded RGBA pixels before
+         * upload (alpha premultiplication). Safe to call off the render
+         * thread.
+         */
+        static void PrepareImageData(uint8_t* data, int width, int height);
+
+        /**
+         * @brief Length in screen pixels of the quad's u and v edges under
+         * the given camera, or (0,0) if it cannot be projected.
+         */
+        ivec2 GetScreenFootprint(const mat4& view, const mat4& projection) const;
+
+        /**
+         * @brief GetScreenFootprint under the window's camera, recomputed
+         * only when the camera or the widget's scene node has changed.
+         */
+        const ivec2& GetCachedScreenFootprint(const mat4& view, const mat4& projection);
+
+        /**
+         * @brief WidgetStore batch for a run of ImageWidgets: updates them,
+         * then draws them with one shared program, setting the camera and
+         * blend state once for the run. Model matrix, keyframes and tint
+         * come from each image's instance record, so a draw binds only its
+         * texture and vertex array.
+         */
+        static void DrawBatch(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+            const mat4& view, const mat4& projection);
+
     protected:
         bool InitShader() override;
-        bool LoadImageData();
+        bool GetUniformLocations();
+        static void DrawImages(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+            const mat4& view, const mat4& projection);
+        glm::vec3 GetAnimatedState(double time) const;
+        /**
+         * @brief Keyframes, relative to the current frame epoch, and the
+         * bounds they sweep, into the record.
+         */
+        void WriteAnimation();
+        bool LoadBakedTexture();
+        bool DecodeImageData();
+        /** @brief Brings back the pixels of an uploaded image to re-upload it. */
+        bool LoadImageSource();
+        /**
+         * @brief Re-uploads at mFootprint, first running LoadImageSource on
+         * a worker thread when the pixels are not at hand. Returns false
+         * until the upload has happened, so call it again on later frames.
+         */
+        bool ReloadTexture();
+        void JoinSourceThread();
         bool LoadIntoGL();
+        void UploadImageData(const uint8_t* data, int width, int height);
+        void FitToFootprint(int sourceWidth, int sourceHeight, int& width, int& height) const;
+        bool NeedsLargerTexture(const ivec2& footprint) const;
+        bool GrowTexture(const ivec2& footprint);
+        bool RestoreTexture(const ivec2& footprint);
+        void DeleteTexture();
         bool InitGeometry();
         bool InitGLBuffers();
 		void SubmitVertexBuffer();
 
     private:
         string mImageFilePath;
+        TextureContainer mBakedTexture;
+        // Inflated copy of a compressed container, empty when it is mapped
+        vector<uint8_t> mBakedStorage;
+        // An inflated container was dropped after upload
+        bool mBakedReleased;
         uint8_t* mImageData;
         GLuint mTextureID;
-        GLuint mModelUniform;
         GLuint mViewUniform;
         GLuint mProjectionUniform;
         GLuint mTextureUniform;
@@ -49,6 +150,39 @@ namespace octronic
         int mImageWidth;
         int mImageHeight;
         int mImageChannels;
+        bool mPrepared;
+        ivec2 mFootprint;
+        // Last GetCachedScreenFootprint and the versions it was taken at
+        ivec2 mScreenFootprint;
+        uint32_t mScreenFootprintNode;
+        uint32_t mScreenFootprintCamera;
+        int mTextureWidth;
+        int mTextureHeight;
+        bool mEvicted;
+        // LoadImageSource running off the render thread. Only that thread
+        // touches the image source and size until mSourceDone is set.
+        thread mSourceThread;
+        atomic<bool> mSourceDone;
+        bool mSourceLoading;
+        bool mSourceLoaded;
+        bool mSourceFailed;
+        bool mRotateWithValue;
+        float mMinValue, mMaxValue;
+        float mMinDegrees, mMaxDegrees;
+        uint64_t mChannelVersion;
+        // Keyframes as (angle in radians, offset x, offset y), at
+        // FrameUniforms times
+        glm::vec3 mAnimFrom;
+        glm::vec3 mAnimTo;
+        double mAnimStart;
+        double mAnimEnd;
+        // Epoch of the keyframe times in the record
+        double mAnimEpoch;
+        float mAnimationDuration;
+
+        // One program serves every ImageWidget
+        static GLuint sShaderProgram;
+        static unsigned sShaderUsers;
     };
 }
 
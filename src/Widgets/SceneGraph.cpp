@@ -0,0 +1,293 @@
+/*
+ * SceneGraph.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "SceneGraph.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include "../Common/Tracer.h"
+
+namespace octronic
+{
+    SceneGraph::SceneGraph()
+        : mOrderDirty(false),
+          mAnyDirty(false)
+    {
+    }
+
+    SceneNode SceneGraph::Create(mat4* target)
+    {
+        SceneNode node;
+        if (!mFreeHandles.empty())
+        {
+            node = mFreeHandles.back();
+            mFreeHandles.pop_back();
+        }
+        else
+        {
+            node = static_cast<SceneNode>(mSlots.size());
+            mSlots.push_back(SCENE_NODE_NONE);
+        }
+
+        // A new root at the end keeps parents ahead of children
+        mSlots[node] = static_cast<uint32_t>(mHandles.size());
+        mTranslations.push_back(vec3(0.0f));
+        mRotations.push_back(quat(1.0f, 0.0f, 0.0f, 0.0f));
+        mScales.push_back(vec3(1.0f));
+        mWorld.push_back(mat4(1.0f));
+        mVersions.push_back(1);
+        mParents.push_back(-1);
+        mFlags.push_back(Node_Dirty);
+        mTargets.push_back(target);
+        mHandles.push_back(node);
+        mParentHandles.push_back(SCENE_NODE_NONE);
+        mAnyDirty = true;
+        return node;
+    }
+
+    void SceneGraph::Destroy(SceneNode node)
+    {
+        if (node >= mSlots.size() || mSlots[node] == SCENE_NODE_NONE) return;
+        uint32_t slot = mSlots[node];
+        mHandles[slot] = SCENE_NODE_NONE;
+        mTargets[slot] = nullptr;
+        mFlags[slot] = 0;
+        mSlots[node] = SCENE_NODE_NONE;
+        // Reorder drops the slot and re-roots the children; the handle is
+        // not reused until then so they cannot attach to a newcomer
+        mDestroyedHandles.push_back(node);
+        mOrderDirty = true;
+    }
+
+    bool SceneGraph::IsAncestor(SceneNode ancestor, SceneNode node) const
+    {
+        for (SceneNode n = node; n != SCENE_NODE_NONE; n = GetParent(n))
+        {
+            if (n == ancestor) return true;
+        }
+        return false;
+    }
+
+    bool SceneGraph::SetParent(SceneNode node, SceneNode parent)
+    {
+        if (node >= mSlots.size() || mSlots[node] == SCENE_NODE_NONE) return false;
+        if (parent != SCENE_NODE_NONE &&
+            (parent >= mSlots.size() || mSlots[parent] == SCENE_NODE_NONE || IsAncestor(node, parent)))
+        {
+            return false;
+        }
+
+        uint32_t slot = mSlots[node];
+        if (mParentHandles[slot] == parent) return true;
+        mParentHandles[slot] = parent;
+        MarkDirty(slot);
+        // Reparenting is rare; rebuild the order once before the next Update
+        mOrderDirty = true;
+        return true;
+    }
+
+    SceneNode SceneGraph::GetParent(SceneNode node) const
+    {
+        if (node >= mSlots.size() || mSlots[node] == SCENE_NODE_NONE) return SCENE_NODE_NONE;
+        SceneNode parent = mParentHandles[mSlots[node]];
+        if (parent == SCENE_NODE_NONE || mSlots[parent] == SCENE_NODE_NONE) return SCENE_NODE_NONE;
+        return parent;
+    }
+
+    void SceneGraph::MarkDirty(uint32_t slot)
+    {
+        mFlags[slot] |= Node_Dirty;
+        mAnyDirty = true;
+    }
+
+    void SceneGraph::SetTranslation(SceneNode node, const vec3& translation)
+    {
+        uint32_t slot = mSlots[node];
+        mTranslations[slot] = translation;
+        MarkDirty(slot);
+    }
+
+    vec3 SceneGraph::GetTranslation(SceneNode node) const
+    {
+        return mTranslations[mSlots[node]];
+    }
+
+    void SceneGraph::SetRotation(SceneNode node, const quat& rotation)
+    {
+        uint32_t slot = mSlots[node];
+        mRotations[slot] = rotation;
+        MarkDirty(slot);
+    }
+
+    quat SceneGraph::GetRotation(SceneNode node) const
+    {
+        return mRotations[mSlots[node]];
+    }
+
+    void SceneGraph::SetScale(SceneNode node, const vec3& scale)
+    {
+        uint32_t slot = mSlots[node];
+        mScales[slot] = scale;
+        MarkDirty(slot);
+    }
+
+    vec3 SceneGraph::GetScale(SceneNode node) const
+    {
+        return mScales[mSlots[node]];
+    }
+
+    void SceneGraph::SetTarget(SceneNode node, mat4* target)
+    {
+        uint32_t slot = mSlots[node];
+        mTargets[slot] = target;
+        if (target != nullptr) *target = mWorld[slot];
+    }
+
+    const mat4& SceneGraph::GetWorldMatrix(SceneNode node) const
+    {
+        return mWorld[mSlots[node]];
+    }
+
+    uint32_t SceneGraph::GetVersion(SceneNode node) const
+    {
+        return mVersions[mSlots[node]];
+    }
+
+    size_t SceneGraph::Update()
+    {
+        if (mOrderDirty) Reorder();
+        if (!mAnyDirty) return 0;
+        TRACE_SCOPE("SceneGraph::Update");
+
+        size_t updated = 0;
+        size_t count = mHandles.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            int32_t parent = mParents[i];
+            bool dirty = (mFlags[i] & Node_Dirty) != 0 ||
+                (parent >= 0 && (mFlags[parent] & Node_Changed) != 0);
+            if (!dirty)
+            {
+                mFlags[i] = 0;
+                continue;
+            }
+
+            mat4 local = glm::translate(mat4(1.0f), mTranslations[i]) *
+                glm::mat4_cast(mRotations[i]) *
+                glm::scale(mat4(1.0f), mScales[i]);
+            mWorld[i] = parent >= 0 ? mWorld[parent] * local : local;
+            if (mTargets[i] != nullptr) *mTargets[i] = mWorld[i];
+            if (++mVersions[i] == 0) mVersions[i] = 1;
+            mFlags[i] = Node_Changed;
+            updated++;
+        }
+        mAnyDirty = false;
+        return updated;
+    }
+
+    void SceneGraph::Reorder()
+    {
+        TRACE_SCOPE("SceneGraph::Reorder");
+        size_t count = mHandles.size();
+
+        // Children of each slot, as a flattened adjacency list
+        vector<uint32_t> childStart(count + 1, 0);
+        vector<int32_t> parentSlot(count, -1);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (mHandles[i] == SCENE_NODE_NONE) continue;
+            SceneNode parent = mParentHandles[i];
+            if (parent != SCENE_NODE_NONE && mSlots[parent] == SCENE_NODE_NONE)
+            {
+                // Parent destroyed
+                mParentHandles[i] = SCENE_NODE_NONE;
+                mFlags[i] |= Node_Dirty;
+                mAnyDirty = true;
+                parent = SCENE_NODE_NONE;
+            }
+            if (parent != SCENE_NODE_NONE)
+            {
+                parentSlot[i] = static_cast<int32_t>(mSlots[parent]);
+                childStart[parentSlot[i] + 1]++;
+            }
+        }
+        for (size_t i = 0; i < count; i++) childStart[i + 1] += childStart[i];
+        vector<uint32_t> children(childStart[count]);
+        vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (parentSlot[i] >= 0) children[fill[parentSlot[i]]++] = static_cast<uint32_t>(i);
+        }
+
+        // Breadth-first from the roots, in their current order
+        vector<uint32_t> order;
+        order.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (mHandles[i] != SCENE_NODE_NONE && parentSlot[i] < 0) order.push_back(static_cast<uint32_t>(i));
+        }
+        for (size_t head = 0; head < order.size(); head++)
+        {
+            uint32_t slot = order[head];
+            for (uint32_t c = childStart[slot]; c < childStart[slot + 1]; c++) order.push_back(children[c]);
+        }
+
+        vector<uint32_t> newSlot(count, SCENE_NODE_NONE);
+        for (size_t i = 0; i < order.size(); i++) newSlot[order[i]] = static_cast<uint32_t>(i);
+
+        vector<vec3> translations(order.size());
+        vector<quat> rotations(order.size());
+        vector<vec3> scales(order.size());
+        vector<mat4> world(order.size());
+        vector<uint32_t> versions(order.size());
+        vector<int32_t> parents(order.size());
+        vector<uint8_t> flags(order.size());
+        vector<mat4*> targets(order.size());
+        vector<SceneNode> handles(order.size());
+        vector<SceneNode> parentHandles(order.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            uint32_t old = order[i];
+            translations[i] = mTranslations[old];
+            rotations[i] = mRotations[old];
+            scales[i] = mScales[old];
+            world[i] = mWorld[old];
+            versions[i] = mVersions[old];
+            parents[i] = parentSlot[old] >= 0 ? static_cast<int32_t>(newSlot[parentSlot[old]]) : -1;
+            flags[i] = mFlags[old];
+            targets[i] = mTargets[old];
+            handles[i] = mHandles[old];
+            parentHandles[i] = mParentHandles[old];
+            mSlots[handles[i]] = static_cast<uint32_t>(i);
+        }
+        mTranslations.swap(translations);
+        mRotations.swap(rotations);
+        mScales.swap(scales);
+        mWorld.swap(world);
+        mVersions.swap(versions);
+        mParents.swap(parents);
+        mFlags.swap(flags);
+        mTargets.swap(targets);
+        mHandles.swap(handles);
+        mParentHandles.swap(parentHandles);
+
+        mFreeHandles.insert(mFreeHandles.end(), mDestroyedHandles.begin(), mDestroyedHandles.end());
+        mDestroyedHandles.clear();
+        mOrderDirty = false;
+    }
+
+    size_t SceneGraph::GetNodeCount() const
+    {
+        return mSlots.size() - mFreeHandles.size() - mDestroyedHandles.size();
+    }
+}
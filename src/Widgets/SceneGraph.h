@@ -0,0 +1,125 @@
+/*
+ * SceneGraph.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+using std::vector;
+using glm::mat4;
+using glm::quat;
+using glm::vec3;
+
+#define SCENE_NODE_NONE 0xFFFFFFFFu
+
+namespace octronic
+{
+    /** @brief Stable handle of a scene node. */
+    typedef uint32_t SceneNode;
+
+    /**
+     * @brief Parent/child transform hierarchy. Each node has a local
+     * translation, rotation and scale; its world matrix is the parent's
+     * world matrix times its local one.
+     *
+     * Nodes live in parallel arrays kept in breadth-first order, parents
+     * before children, so Update is one pass over contiguous memory that
+     * recomputes only the nodes changed since the last Update and the
+     * subtrees below them. Moving a panel of 200 widgets is one Set call
+     * and one pass. Handles map to array slots through an indirection
+     * table, since reparenting reorders the arrays.
+     *
+     * A node may have a target matrix, which Update overwrites with the
+     * node's world matrix whenever it changes; widgets point it at their
+     * model matrix. Render thread only.
+     */
+    class SceneGraph
+    {
+    public:
+        SceneGraph();
+
+        SceneNode Create(mat4* target = nullptr);
+        /** @brief Children move to the root, keeping their local transform. */
+        void Destroy(SceneNode node);
+
+        /**
+         * @param parent SCENE_NODE_NONE for the root.
+         * @return false if parent is node or one of its descendants.
+         */
+        bool SetParent(SceneNode node, SceneNode parent);
+        SceneNode GetParent(SceneNode node) const;
+
+        void SetTranslation(SceneNode node, const vec3& translation);
+        vec3 GetTranslation(SceneNode node) const;
+        void SetRotation(SceneNode node, const quat& rotation);
+        quat GetRotation(SceneNode node) const;
+        void SetScale(SceneNode node, const vec3& scale);
+        vec3 GetScale(SceneNode node) const;
+
+        void SetTarget(SceneNode node, mat4* target);
+
+        /** @brief As of the last Update. */
+        const mat4& GetWorldMatrix(SceneNode node) const;
+        /**
+         * @brief Bumped each time Update rewrites the node's world matrix,
+         * so results derived from it can be cached against it. Never 0.
+         */
+        uint32_t GetVersion(SceneNode node) const;
+
+        /**
+         * @brief Brings every changed world matrix, and its target, up to
+         * date.
+         * @return The number of world matrices recomputed.
+         */
+        size_t Update();
+
+        size_t GetNodeCount() const;
+
+    protected:
+        enum NodeFlags
+        {
+            Node_Dirty   = 1 << 0,  // local transform or parent changed
+            Node_Changed = 1 << 1   // world matrix rewritten this Update
+        };
+
+        void MarkDirty(uint32_t index);
+        void Reorder();
+        bool IsAncestor(SceneNode ancestor, SceneNode node) const;
+
+    private:
+        // Breadth-first, indexed by slot
+        vector<vec3> mTranslations;
+        vector<quat> mRotations;
+        vector<vec3> mScales;
+        vector<mat4> mWorld;
+        vector<uint32_t> mVersions;
+        vector<int32_t> mParents;       // slot of the parent, -1 for roots
+        vector<uint8_t> mFlags;
+        vector<mat4*> mTargets;
+        vector<SceneNode> mHandles;     // handle of each slot
+        vector<SceneNode> mParentHandles;
+
+        // Slot of each handle, SCENE_NODE_NONE once destroyed
+        vector<uint32_t> mSlots;
+        vector<SceneNode> mFreeHandles;
+        // Destroyed, but their slots are only dropped by the next Reorder
+        vector<SceneNode> mDestroyedHandles;
+        bool mOrderDirty;
+        bool mAnyDirty;
+    };
+}
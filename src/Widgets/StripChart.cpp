@@ -0,0 +1,634 @@
+/*
+ * StripChart.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "StripChart.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+#include "../AppState.h"
+#include "../Common/Logger.h"
+#include "../Common/Tracer.h"
+#include "../Data/DataChannel.h"
+#include "DashboardSnapshot.h"
+
+namespace octronic
+{
+    GLuint StripChart::sShaderProgram = 0;
+    unsigned StripChart::sShaderUsers = 0;
+
+    StripChart::StripChart(AppState* state, float windowSeconds, size_t capacity, vec2 size, vec3 colour)
+        : Widget3D(state),
+          mWindowSeconds(windowSeconds),
+          mCapacity(capacity < 2 ? 2 : capacity),
+          mSize(size),
+          mColour(colour),
+          mMinValue(0.0f),
+          mMaxValue(100.0f),
+          mVao(0),
+          mRingBuffer(0),
+          mRingTexture(0),
+          mBucketBuffer(0),
+          mBucketTexture(0),
+          mHead(0),
+          mFirst(0),
+          mCount(0),
+          mTimeBase(0.0),
+          mLatestTime(0.0),
+          mBucketVertexCount(0),
+          mBucketPixelWidth(0),
+          mBucketEnd(0),
+          mDrawSamples(0),
+          mDrawCount(0),
+          mSamplesUniform(-1)
+    {
+        debug("StripChart: Constructor");
+    }
+
+    StripChart::~StripChart()
+    {
+        debug("StripChart: Destructor");
+        GpuMemoryTracker& tracker = mAppState->GetGpuMemoryTracker();
+        if (mRingTexture > 0)
+        {
+            glDeleteTextures(1, &mRingTexture);
+        }
+        if (mBucketTexture > 0)
+        {
+            glDeleteTextures(1, &mBucketTexture);
+        }
+        if (mBucketBuffer > 0)
+        {
+            tracker.Release(GpuResource_VertexBuffer, mBucketBuffer);
+            glDeleteBuffers(1, &mBucketBuffer);
+        }
+        if (mRingBuffer > 0)
+        {
+            tracker.Release(GpuResource_VertexBuffer, mRingBuffer);
+            glDeleteBuffers(1, &mRingBuffer);
+        }
+        if (mVao > 0)
+        {
+            tracker.Release(GpuResource_VertexArray, mVao);
+            glDeleteVertexArrays(1, &mVao);
+        }
+        // The program is shared; keep Widget from deleting it
+        if (mShaderProgram > 0 && mShaderProgram == sShaderProgram)
+        {
+            if (--sShaderUsers == 0)
+            {
+                glDeleteProgram(sShaderProgram);
+                sShaderProgram = 0;
+            }
+            mShaderProgram = 0;
+        }
+    }
+
+    bool StripChart::Init()
+    {
+        TRACE_SCOPE("StripChart::Init");
+        debug("StripChart: {}", __FUNCTION__);
+        if (!InitShader())     return false;
+        if (!AttachInstance(STRIP_CHART_INSTANCE_STRIDE)) return false;
+        if (!InitRingBuffer()) return false;
+        WriteParameters();
+        return true;
+    }
+
+    void StripChart::WriteParameters()
+    {
+        if (mInstances == nullptr) return;
+        vec4* record = WriteInstance();
+        record[STRIP_CHART_INSTANCE_RING].w = mWindowSeconds;
+        record[STRIP_CHART_INSTANCE_AXES] = vec4(mSize, mMinValue, mMaxValue);
+        record[STRIP_CHART_INSTANCE_COLOUR] = vec4(mColour, 1.0f);
+        SetInstanceBounds(vec4(mSize * 0.5f, 0.0f, glm::length(mSize) * 0.5f));
+    }
+
+    bool StripChart::InitRingBuffer()
+    {
+        GLint maxTexels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        size_t maxCapacity = std::min<size_t>(STRIP_CHART_MAX_CAPACITY, static_cast<size_t>(std::max(maxTexels, 2)));
+        if (mCapacity > maxCapacity)
+        {
+            warn("StripChart: Capacity of {} samples exceeds the limit of {}", mCapacity, maxCapacity);
+            mCapacity = maxCapacity;
+        }
+        info("StripChart: {} ({} samples)", __FUNCTION__, mCapacity);
+        GpuMemoryTracker& tracker = mAppState->GetGpuMemoryTracker();
+
+        // Core profile needs a bound VAO to draw, even without attributes
+        glGenVertexArrays(1, &mVao);
+        tracker.Track(this, GpuResource_VertexArray, mVao, 0);
+
+        glGenBuffers(1, &mRingBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, mRingBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(mCapacity * sizeof(vec2)),
+            nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        tracker.Track(this, GpuResource_VertexBuffer, mRingBuffer, mCapacity * sizeof(vec2));
+
+        glGenTextures(1, &mRingTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, mRingTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, mRingBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+        // Decimated min/max pairs, resized as the chart's width changes
+        glGenBuffers(1, &mBucketBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, mBucketBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(vec2), nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        tracker.Track(this, GpuResource_VertexBuffer, mBucketBuffer, sizeof(vec2));
+
+        glGenTextures(1, &mBucketTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, mBucketTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, mBucketBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+        mTimestamps.assign(mCapacity, 0.0);
+        mValues.assign(mCapacity, 0.0f);
+        return !GLCheckError();
+    }
+
+    void StripChart::Update()
+    {
+        if (mChannel == nullptr) return;
+        const vector<DataSample>& samples = mChannel->GetFrameSamples();
+        if (samples.empty()) return;
+
+        TRACE_SCOPE("StripChart::Update");
+        // Only the newest mCapacity samples can survive this frame
+        size_t count = samples.size();
+        const DataSample* first = samples.data();
+        if (count > mCapacity)
+        {
+            first += count - mCapacity;
+            count = mCapacity;
+        }
+        UploadSamples(first, count);
+        TrimToWindow();
+    }
+
+    void StripChart::UploadSamples(const DataSample* samples, size_t count)
+    {
+        // Timestamps are rebased so the GPU copy keeps float precision
+        if (mCount == 0 && mHead == 0) mTimeBase = samples[0].timestamp;
+        else if (samples[count - 1].timestamp - mTimeBase > STRIP_CHART_REBASE_SECONDS) Rebase(samples[0].timestamp);
+
+        vec2* staging = mAppState->GetFrameArena().AllocateArray<vec2>(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            staging[i] = vec2(static_cast<float>(samples[i].timestamp - mTimeBase), samples[i].value);
+            mTimestamps[(mHead + i) % mCapacity] = samples[i].timestamp;
+            mValues[(mHead + i) % mCapacity] = samples[i].value;
+        }
+
+        // At most two sub-range uploads: up to the end of the ring, then
+        // the remainder from the start
+        size_t tail = std::min(count, mCapacity - mHead);
+        glBindBuffer(GL_TEXTURE_BUFFER, mRingBuffer);
+        glBufferSubData(GL_TEXTURE_BUFFER,
+            static_cast<GLintptr>(mHead * sizeof(vec2)),
+            static_cast<GLsizeiptr>(tail * sizeof(vec2)), staging);
+        if (tail < count)
+        {
+            glBufferSubData(GL_TEXTURE_BUFFER, 0,
+                static_cast<GLsizeiptr>((count - tail) * sizeof(vec2)), staging + tail);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        mHead = (mHead + count) % mCapacity;
+        mCount = std::min(mCount + count, mCapacity);
+        mLatestTime = samples[count - 1].timestamp;
+    }
+
+    void StripChart::Rebase(double timeBase)
+    {
+        TRACE_SCOPE("StripChart::Rebase");
+        mTimeBase = timeBase;
+        // Bucket times are relative to the base too
+        mBucketEnd = 0;
+        mBucketPixelWidth = 0;
+
+        // Samples still in the ring from mFirst, in chunks, each up to the
+        // end of the ring at most
+        size_t chunk = std::min<size_t>(mCount, STRIP_CHART_REBASE_CHUNK);
+        if (chunk == 0) return;
+        vec2* staging = mAppState->GetFrameArena().AllocateArray<vec2>(chunk);
+        glBindBuffer(GL_TEXTURE_BUFFER, mRingBuffer);
+        size_t done = 0;
+        while (done < mCount)
+        {
+            size_t begin = (mFirst + done) % mCapacity;
+            size_t count = std::min(std::min(chunk, mCount - done), mCapacity - begin);
+            for (size_t i = 0; i < count; i++)
+            {
+                staging[i] = vec2(static_cast<float>(mTimestamps[begin + i] - mTimeBase), mValues[begin + i]);
+            }
+            glBufferSubData(GL_TEXTURE_BUFFER,
+                static_cast<GLintptr>(begin * sizeof(vec2)),
+                static_cast<GLsizeiptr>(count * sizeof(vec2)), staging);
+            done += count;
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void StripChart::TrimToWindow()
+    {
+        // Samples arrive in time order, so the oldest visible sample only
+        // ever moves forward. One sample before the window is kept so the
+        // line enters from the left edge.
+        double start = mLatestTime - mWindowSeconds;
+        size_t oldest = (mHead + mCapacity - mCount) % mCapacity;
+        while (mCount > 2 && mTimestamps[(oldest + 1) % mCapacity] <= start)
+        {
+            oldest = (oldest + 1) % mCapacity;
+            mCount--;
+        }
+        mFirst = oldest;
+    }
+
+    int StripChart::GetScreenWidth(const mat4& view, const mat4& projection) const
+    {
+        Window& window = mAppState->GetWindow();
+        vec2 viewport(window.GetWidth(), window.GetHeight());
+        mat4 mvp = projection * view * mModelMatrix;
+        glm::vec4 left = mvp * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        glm::vec4 right = mvp * glm::vec4(mSize.x, 0.0f, 0.0f, 1.0f);
+        if (left.w <= 0.0f || right.w <= 0.0f) return 0;
+        vec2 a = vec2(left) / left.w * 0.5f * viewport;
+        vec2 b = vec2(right) / right.w * 0.5f * viewport;
+        return static_cast<int>(std::ceil(glm::distance(a, b)));
+    }
+
+    void StripChart::UpdateBuckets(const MinMaxPyramid& history, int pixelWidth)
+    {
+        if (history.GetEndIndex() == mBucketEnd && pixelWidth == mBucketPixelWidth) return;
+        TRACE_SCOPE("StripChart::UpdateBuckets");
+        mBucketEnd = history.GetEndIndex();
+        mBucketPixelWidth = pixelWidth;
+
+        size_t count = history.QueryTime(mLatestTime - mWindowSeconds, mLatestTime,
+            static_cast<size_t>(pixelWidth), mBuckets);
+
+        // Each bucket becomes a vertical min-max segment of the line strip
+        mBucketVertexCount = count * 2;
+        if (mBucketVertexCount == 0) return;
+        vec2* staging = mAppState->GetFrameArena().AllocateArray<vec2>(mBucketVertexCount);
+        for (size_t i = 0; i < count; i++)
+        {
+            float t = static_cast<float>(mBuckets[i].timestamp - mTimeBase);
+            staging[i * 2]     = vec2(t, mBuckets[i].min);
+            staging[i * 2 + 1] = vec2(t, mBuckets[i].max);
+        }
+
+        size_t bytes = mBucketVertexCount * sizeof(vec2);
+        glBindBuffer(GL_TEXTURE_BUFFER, mBucketBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(bytes), staging, GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        mAppState->GetGpuMemoryTracker().Track(this, GpuResource_VertexBuffer, mBucketBuffer, bytes);
+    }
+
+    void StripChart::Draw(const mat4& view, const mat4& projection)
+    {
+        debug("StripChart: {}", __FUNCTION__);
+        if (mInstances == nullptr) return;
+        uint32_t slot = mInstance;
+        DrawCharts(*mInstances, &slot, 1, view, projection);
+    }
+
+    void StripChart::DrawBatch(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+        const mat4& view, const mat4& projection)
+    {
+        TRACE_SCOPE("StripChart::DrawBatch");
+        for (size_t i = 0; i < count; i++)
+        {
+            static_cast<StripChart*>(instances.GetWidget(slots[i]))->StripChart::Update();
+        }
+        DrawCharts(instances, slots, count, view, projection);
+    }
+
+    bool StripChart::PrepareDraw(const mat4& view, const mat4& projection)
+    {
+        if (mCount < 2) return false;
+
+        // Switch to the pyramid once the raw samples outnumber the pixels
+        GLuint samples = mRingTexture;
+        size_t offset = mFirst;
+        size_t capacity = mCapacity;
+        size_t count = mCount;
+        const MinMaxPyramid* history = mChannel != nullptr ? mChannel->GetHistory() : nullptr;
+        int pixelWidth = history != nullptr ? GetScreenWidth(view, projection) : 0;
+        if (pixelWidth > 0)
+        {
+            uint64_t first = history->FindIndex(mLatestTime - mWindowSeconds);
+            if (history->GetEndIndex() - first > static_cast<uint64_t>(pixelWidth) * 2)
+            {
+                UpdateBuckets(*history, pixelWidth);
+                if (mBucketVertexCount >= 2)
+                {
+                    samples = mBucketTexture;
+                    offset = 0;
+                    capacity = mBucketVertexCount;
+                    count = mBucketVertexCount;
+                }
+            }
+        }
+        mDrawSamples = samples;
+        mDrawCount = count;
+
+        // Indices stay exact as floats up to 2^24 samples
+        vec4 ring(static_cast<float>(offset), static_cast<float>(capacity),
+            static_cast<float>(mLatestTime - mTimeBase), mWindowSeconds);
+        if (mInstances->Read(mInstance)[STRIP_CHART_INSTANCE_RING] != ring)
+        {
+            WriteInstance()[STRIP_CHART_INSTANCE_RING] = ring;
+        }
+        return true;
+    }
+
+    void StripChart::DrawCharts(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+        const mat4& view, const mat4& projection)
+    {
+        if (count == 0 || sShaderProgram == 0) return;
+        TRACE_SCOPE("StripChart::Draw");
+
+        // Records first, so they all go up in the one upload
+        const StripChart* first = static_cast<const StripChart*>(instances.GetWidget(slots[0]));
+        StripChart** charts = first->mAppState->GetFrameArena().AllocateArray<StripChart*>(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            StripChart* chart = static_cast<StripChart*>(instances.GetWidget(slots[i]));
+            charts[i] = chart->PrepareDraw(view, projection) ? chart : nullptr;
+        }
+
+        glUseProgram(sShaderProgram);
+        glUniformMatrix4fv(first->mViewUniform, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(first->mProjectionUniform, 1, GL_FALSE, glm::value_ptr(projection));
+        instances.Upload();
+        instances.Bind();
+        glActiveTexture(GL_TEXTURE0);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (charts[i] == nullptr) continue;
+            WidgetInstanceBuffer::SelectSlot(slots[i]);
+            glBindTexture(GL_TEXTURE_BUFFER, charts[i]->mDrawSamples);
+            glBindVertexArray(charts[i]->mVao);
+            glDrawArrays(GL_LINE_STRIP, 0, static_cast<GLsizei>(charts[i]->mDrawCount));
+        }
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        GLCheckError();
+    }
+
+    bool StripChart::InitShader()
+    {
+        TRACE_SCOPE("StripChart::InitShader");
+        if (mShaderProgram > 0) return true;
+        if (sShaderProgram > 0)
+        {
+            mShaderProgram = sShaderProgram;
+            sShaderUsers++;
+            return GetUniformLocations();
+        }
+        info("StripChart: {}", __FUNCTION__);
+
+        static string vertexShaderSource =
+            "#version 330 core\n"
+            "uniform samplerBuffer samples;\n"
+            "uniform mat4 view;\n"
+            "uniform mat4 projection;\n"
+            WIDGET_INSTANCE_GLSL
+            "out float ChartX;\n"
+            "flat out vec4 Colour;\n"
+            "flat out vec4 Tint;\n"
+            "void main () {\n"
+            // STRIP_CHART_INSTANCE_RING, _AXES and _COLOUR
+            "    vec4 ring = InstanceData(5);\n"
+            "    vec4 axes = InstanceData(6);\n"
+            "    int offset = int(ring.x);\n"
+            "    int capacity = int(ring.y);\n"
+            "    float now = ring.z;\n"
+            "    float window = ring.w;\n"
+            "    vec2 s = texelFetch(samples, (offset + gl_VertexID) % capacity).xy;\n"
+            "    float x = (s.x - now + window) / window * axes.x;\n"
+            "    float y = clamp((s.y - axes.z) / (axes.w - axes.z), 0.0, 1.0) * axes.y;\n"
+            "    gl_Position = projection * view * InstanceModel() * vec4(x, y, 0.0, 1.0);\n"
+            "    ChartX = x;\n"
+            "    Colour = InstanceData(7);\n"
+            "    Tint = InstanceData(4);\n"
+            "}";
+
+        static string fragmentShaderSource =
+            "#version 330 core\n"
+            "in float ChartX;\n"
+            "flat in vec4 Colour;\n"
+            "flat in vec4 Tint;\n"
+            "out vec4 FragColor;\n"
+            FRAME_UNIFORMS_GLSL
+            WIDGET_ALARM_GLSL
+            "void main() {\n"
+            "    if (ChartX < 0.0) discard;\n"
+            "    FragColor = vec4(mix(Colour.rgb, Tint.rgb, AlarmOn(Tint)), 1.0);\n"
+            "}";
+
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+
+        // Compile shaders
+        GLint success;
+        GLchar infoLog[512];
+
+        // Vertex Shader
+        vertexShader = glCreateShader(GL_VERTEX_SHADER);
+        const char *vSource = vertexShaderSource.c_str();
+        glShaderSource(vertexShader, 1, &vSource, nullptr);
+        glCompileShader(vertexShader);
+
+        // Print compile errors if any
+        glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(vertexShader, 512, nullptr, infoLog);
+            error("StripChart: Vertex Shader Error {}", infoLog);
+            return false;
+        }
+
+        // Fragment Shader
+        fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        const char *fSource = fragmentShaderSource.c_str();
+        glShaderSource(fragmentShader, 1, &fSource, nullptr);
+        glCompileShader(fragmentShader);
+
+        // Print compile errors if any
+        glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(fragmentShader, 512, nullptr, infoLog);
+            error("StripChart: Fragment Shader Error {}", infoLog);
+            return false;
+        }
+
+        // Shader Program
+        mShaderProgram = glCreateProgram();
+        glAttachShader(mShaderProgram, vertexShader);
+        glAttachShader(mShaderProgram, fragmentShader);
+        glLinkProgram(mShaderProgram);
+
+        // Print linking errors if any
+        glGetProgramiv(mShaderProgram, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(mShaderProgram, 512, nullptr, infoLog);
+            error("StripChart: Shader Linking Error {}", infoLog);
+            return false;
+        }
+
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+
+        mAppState->GetFrameUniforms().BindProgram(mShaderProgram);
+        WidgetInstanceBuffer::BindProgram(mShaderProgram, STRIP_CHART_INSTANCE_STRIDE);
+        sShaderProgram = mShaderProgram;
+        sShaderUsers++;
+        if (!GetUniformLocations()) return false;
+        glUseProgram(mShaderProgram);
+        glUniform1i(mSamplesUniform, 0);
+        glUseProgram(0);
+        return true;
+    }
+
+    bool StripChart::GetUniformLocations()
+    {
+        mViewUniform = glGetUniformLocation(mShaderProgram, "view");
+        mProjectionUniform = glGetUniformLocation(mShaderProgram, "projection");
+        mSamplesUniform = glGetUniformLocation(mShaderProgram, "samples");
+
+        GLCheckError();
+
+        if (mViewUniform != -1 && mProjectionUniform != -1 && mSamplesUniform != -1)
+        {
+            return true;
+        }
+        else
+        {
+            error("StripChart: Uniform Error V:{} P:{} S:{}",
+                  mViewUniform, mProjectionUniform, mSamplesUniform);
+            return false;
+        }
+    }
+
+    const char* StripChart::GetTypeName() const
+    {
+        return "StripChart";
+    }
+
+    json StripChart::ToJson()
+    {
+        json j = Widget::ToJson();
+        j["windowSeconds"] = mWindowSeconds;
+        j["capacity"] = mCapacity;
+        j["size"] = Vec2ToJson(mSize);
+        j["colour"] = Vec3ToJson(mColour);
+        j["valueRange"] = Vec2ToJson(vec2(mMinValue, mMaxValue));
+        if (mChannel != nullptr && mChannel->GetHistory() != nullptr)
+        {
+            j["history"] = mChannel->GetHistory()->GetCapacity();
+        }
+        return j;
+    }
+
+    bool StripChart::FromJson(const json& j)
+    {
+        if (!Widget::FromJson(j)) return false;
+        if (j.count("windowSeconds")) SetWindowSeconds(j["windowSeconds"].get<float>());
+        if (j.count("capacity"))      mCapacity = std::max<size_t>(2, j["capacity"].get<size_t>());
+        if (j.count("size"))          mSize = JsonToVec2(j["size"]);
+        if (j.count("colour"))        mColour = JsonToVec3(j["colour"]);
+        if (j.count("valueRange"))
+        {
+            vec2 range = JsonToVec2(j["valueRange"]);
+            SetValueRange(range.x, range.y);
+        }
+        if (j.count("history") && mChannel != nullptr)
+        {
+            mChannel->EnableHistory(j["history"].get<size_t>());
+        }
+        return true;
+    }
+
+    void StripChart::WriteSnapshot(DashboardSnapshotWriter& writer)
+    {
+        StripChartSnapshot params;
+        params.windowSeconds = mWindowSeconds;
+        params.capacity = static_cast<uint32_t>(mCapacity);
+        memcpy(params.size, &mSize[0], sizeof(params.size));
+        memcpy(params.colour, &mColour[0], sizeof(params.colour));
+        params.valueRange[0] = mMinValue;
+        params.valueRange[1] = mMaxValue;
+        params.history = 0;
+        if (mChannel != nullptr && mChannel->GetHistory() != nullptr)
+        {
+            params.history = static_cast<uint32_t>(mChannel->GetHistory()->GetCapacity());
+        }
+        writer.SetParams(&params, sizeof(params));
+    }
+
+    bool StripChart::ReadSnapshot(const DashboardSnapshot& snapshot, const DashboardSnapshotRecord& record)
+    {
+        auto params = snapshot.GetParams<StripChartSnapshot>(record);
+        if (params == nullptr || !Widget::ReadSnapshot(snapshot, record)) return false;
+        SetWindowSeconds(params->windowSeconds);
+        mCapacity = std::max<size_t>(2, params->capacity);
+        mSize = glm::make_vec2(params->size);
+        mColour = glm::make_vec3(params->colour);
+        SetValueRange(params->valueRange[0], params->valueRange[1]);
+        if (params->history > 0 && mChannel != nullptr)
+        {
+            mChannel->EnableHistory(params->history);
+        }
+        return true;
+    }
+
+    void StripChart::SetValueRange(float minValue, float maxValue)
+    {
+        mMinValue = minValue;
+        mMaxValue = maxValue;
+        WriteParameters();
+    }
+
+    float StripChart::GetWindowSeconds() const
+    {
+        return mWindowSeconds;
+    }
+
+    void StripChart::SetWindowSeconds(float seconds)
+    {
+        mWindowSeconds = seconds > 0.0f ? seconds : mWindowSeconds;
+        WriteParameters();
+    }
+
+    size_t StripChart::GetCapacity() const
+    {
+        return mCapacity;
+    }
+
+    size_t StripChart::GetSampleCount() const
+    {
+        return mCount;
+    }
+}
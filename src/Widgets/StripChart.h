@@ -0,0 +1,158 @@
+/*
+ * StripChart.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include "Widget3D.h"
+#include "../Data/MinMaxPyramid.h"
+
+using glm::vec2;
+
+#define STRIP_CHART_DEFAULT_CAPACITY (1 << 16)
+#define STRIP_CHART_HISTORY_CAPACITY (1 << 20)
+// Ring offsets reach the shader as floats, exact up to 2^24
+#define STRIP_CHART_MAX_CAPACITY (1 << 24)
+// Span after which sample times are rebased, keeping the float x
+// coordinate of the newest sample finer than 0.1 ms
+#define STRIP_CHART_REBASE_SECONDS 600.0
+#define STRIP_CHART_REBASE_CHUNK 4096
+
+// Record layout after the WidgetInstanceBuffer base
+#define STRIP_CHART_INSTANCE_RING 5     // first sample, sample count, newest time, window
+#define STRIP_CHART_INSTANCE_AXES 6     // size.xy, value range
+#define STRIP_CHART_INSTANCE_COLOUR 7
+#define STRIP_CHART_INSTANCE_STRIDE 8
+
+namespace octronic
+{
+    /**
+     * @brief Scrolling line plot of the last N seconds of the bound channel.
+     *
+     * Samples live in a fixed-size ring on the GPU (a texture buffer of
+     * (time, value) pairs). Each Update uploads only the samples drained
+     * this frame with glBufferSubData, split in two where the ring wraps.
+     * The history is drawn as a single line strip; the vertex shader
+     * fetches sample (offset + gl_VertexID) % capacity, so the wrap point
+     * needs neither a copy nor a second draw.
+     *
+     * When the channel keeps a history (DataChannel::EnableHistory) and the
+     * window holds more than two samples per on-screen pixel, the chart
+     * instead draws one min/max pair per pixel from the history's pyramid,
+     * so the vertex count is bounded by the chart's width on screen.
+     *
+     * Sample times go up relative to a base time. Once the newest sample
+     * is STRIP_CHART_REBASE_SECONDS past the base, the base moves up to it
+     * and the ring is re-sent from its CPU copy, so a chart that runs for
+     * weeks keeps the resolution it had in its first minutes.
+     *
+     * The chart spans [0, size.x] x [0, size.y] in model space, with the
+     * newest sample at the right edge. Every chart shares one program and
+     * reads its placement, window and colour from its instance record.
+     */
+    class StripChart : public Widget3D
+    {
+    public:
+        StripChart(
+            AppState* state,
+            float windowSeconds = 10.0f,
+            size_t capacity = STRIP_CHART_DEFAULT_CAPACITY,
+            vec2 size = vec2(3.0f, 0.6f),
+            vec3 colour = vec3(0.1f, 0.8f, 0.2f)
+        );
+        ~StripChart() override;
+
+        bool Init() override;
+        void Update() override;
+        void Draw(const mat4& view, const mat4& projection) override;
+
+        /**
+         * @brief WidgetStore batch for a run of StripCharts: updates them,
+         * writes the records whose ring position moved, then draws each
+         * chart with one shared program and a single upload.
+         */
+        static void DrawBatch(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+            const mat4& view, const mat4& projection);
+
+        const char* GetTypeName() const override;
+        json ToJson() override;
+        bool FromJson(const json& j) override;
+        void WriteSnapshot(DashboardSnapshotWriter& writer) override;
+        bool ReadSnapshot(const DashboardSnapshot& snapshot, const DashboardSnapshotRecord& record) override;
+
+        void SetValueRange(float minValue, float maxValue);
+        float GetWindowSeconds() const;
+        void SetWindowSeconds(float seconds);
+
+        size_t GetCapacity() const;
+        size_t GetSampleCount() const;
+
+    protected:
+        bool InitShader() override;
+        bool GetUniformLocations();
+        bool InitRingBuffer();
+        static void DrawCharts(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+            const mat4& view, const mat4& projection);
+        /**
+         * @brief Picks the ring or the pyramid buckets for this frame and
+         * writes the record if the ring position changed.
+         * @return false if there is nothing to draw.
+         */
+        bool PrepareDraw(const mat4& view, const mat4& projection);
+        void WriteParameters();
+        void UploadSamples(const DataSample* samples, size_t count);
+        /** @brief Moves mTimeBase to timeBase and re-sends the ring. */
+        void Rebase(double timeBase);
+        void TrimToWindow();
+        int GetScreenWidth(const mat4& view, const mat4& projection) const;
+        void UpdateBuckets(const MinMaxPyramid& history, int pixelWidth);
+
+    private:
+        float mWindowSeconds;
+        size_t mCapacity;
+        vec2 mSize;
+        vec3 mColour;
+        float mMinValue;
+        float mMaxValue;
+
+        GLuint mVao;
+        GLuint mRingBuffer;
+        GLuint mRingTexture;
+        GLuint mBucketBuffer;
+        GLuint mBucketTexture;
+
+        // CPU copy of the ring, used to find the oldest sample still
+        // inside the window and to rebase without reading back from the GPU
+        vector<double> mTimestamps;
+        vector<float> mValues;
+        size_t mHead;
+        size_t mFirst;
+        size_t mCount;
+        double mTimeBase;
+        double mLatestTime;
+        vector<MinMaxBucket> mBuckets;
+        size_t mBucketVertexCount;
+        int mBucketPixelWidth;
+        uint64_t mBucketEnd;
+
+        // Chosen by PrepareDraw for the draw that follows
+        GLuint mDrawSamples;
+        size_t mDrawCount;
+
+        GLint mSamplesUniform;
+
+        // One program serves every StripChart
+        static GLuint sShaderProgram;
+        static unsigned sShaderUsers;
+    };
+}
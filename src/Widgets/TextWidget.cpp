@@ -0,0 +1,274 @@
+/*
+ * TextWidget.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "TextWidget.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "../AppState.h"
+#include "../Common/Logger.h"
+#include "../Common/Tracer.h"
+#include "../Data/DataChannel.h"
+#include "DashboardSnapshot.h"
+
+namespace octronic
+{
+    TextWidget::TextWidget(AppState* state, const string& text, float size, vec4 colour, size_t maxGlyphs)
+        : Widget(state),
+          mText(text),
+          mSize(size),
+          mColour(colour),
+          mAlignment(TextAlign_Left),
+          mChannelVersion(0),
+          mTextWidth(-1.0f),
+          mMaxGlyphs(maxGlyphs),
+          mRun(-1)
+    {
+        debug("TextWidget: Constructor");
+    }
+
+    TextWidget::~TextWidget()
+    {
+        debug("TextWidget: Destructor");
+    }
+
+    bool TextWidget::Init()
+    {
+        debug("TextWidget: {}", __FUNCTION__);
+        mRun = mAppState->GetTextRenderer().CreateRun(glm::max(mMaxGlyphs, mText.size()));
+        if (!InitShader()) return false;
+        if (!AttachInstance(WIDGET_INSTANCE_BASE_STRIDE)) return false;
+        UpdateBounds();
+        return true;
+    }
+
+    bool TextWidget::InitShader()
+    {
+        // Shared program lives in the TextRenderer
+        return true;
+    }
+
+    void TextWidget::Update()
+    {
+        if (mChannel == nullptr || mValueFormat.empty()) return;
+        if (mChannel->GetVersion() == mChannelVersion) return;
+        mChannelVersion = mChannel->GetVersion();
+
+        DataSample latest;
+        if (!mChannel->GetLatest(latest)) return;
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), mValueFormat.c_str(), latest.value);
+        SetText(buffer);
+    }
+
+    void TextWidget::Draw(const mat4& view, const mat4& projection)
+    {
+        (void)view;
+        (void)projection;
+        DrawText(mModelMatrix);
+    }
+
+    void TextWidget::DrawBatch(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+        const mat4& view, const mat4& projection)
+    {
+        (void)view;
+        (void)projection;
+        TRACE_SCOPE("TextWidget::DrawBatch");
+        for (size_t i = 0; i < count; i++)
+        {
+            TextWidget* widget = static_cast<TextWidget*>(instances.GetWidget(slots[i]));
+            widget->TextWidget::Update();
+            const vec4* model = instances.Read(slots[i]) + WIDGET_INSTANCE_MODEL;
+            widget->DrawText(mat4(model[0], model[1], model[2], model[3]));
+        }
+    }
+
+    void TextWidget::DrawText(const mat4& modelMatrix)
+    {
+        if (mText.empty()) return;
+
+        TextRenderer& renderer = mAppState->GetTextRenderer();
+        if (mAlignment != TextAlign_Left && mTextWidth < 0.0f)
+        {
+            mTextWidth = renderer.MeasureText(mText, mSize);
+        }
+
+        mat4 model = modelMatrix;
+        if (mAlignment == TextAlign_Center)
+        {
+            model = glm::translate(model, vec3(-0.5f * mTextWidth, 0.0f, 0.0f));
+        }
+        else if (mAlignment == TextAlign_Right)
+        {
+            model = glm::translate(model, vec3(-mTextWidth, 0.0f, 0.0f));
+        }
+        vec4 colour(GetAlarmColour(vec3(mColour)), mColour.a);
+        if (mRun >= 0)
+        {
+            renderer.DrawRun(mRun, mText, model, mSize, colour);
+        }
+        else
+        {
+            renderer.AddText(mText, model, mSize, colour);
+        }
+    }
+
+    const char* TextWidget::GetTypeName() const
+    {
+        return "Text";
+    }
+
+    json TextWidget::ToJson()
+    {
+        static const char* alignments[] = { "left", "center", "right" };
+        json j = Widget::ToJson();
+        j["text"] = mText;
+        j["size"] = mSize;
+        j["colour"] = Vec4ToJson(mColour);
+        j["align"] = alignments[mAlignment];
+        j["maxGlyphs"] = mMaxGlyphs;
+        if (!mValueFormat.empty()) j["valueFormat"] = mValueFormat;
+        return j;
+    }
+
+    bool TextWidget::FromJson(const json& j)
+    {
+        if (!Widget::FromJson(j)) return false;
+        if (j.count("text"))        SetText(j["text"].get<string>());
+        if (j.count("size"))        SetSize(j["size"].get<float>());
+        if (j.count("colour"))      SetColour(JsonToVec4(j["colour"]));
+        if (j.count("maxGlyphs"))   mMaxGlyphs = j["maxGlyphs"].get<size_t>();
+        if (j.count("valueFormat") && !SetValueFormat(j["valueFormat"].get<string>())) return false;
+        if (j.count("align"))
+        {
+            string align = j["align"].get<string>();
+            if (align == "center")     SetAlignment(TextAlign_Center);
+            else if (align == "right") SetAlignment(TextAlign_Right);
+            else                       SetAlignment(TextAlign_Left);
+        }
+        return true;
+    }
+
+    void TextWidget::WriteSnapshot(DashboardSnapshotWriter& writer)
+    {
+        TextWidgetSnapshot params;
+        params.text = writer.AddString(mText);
+        params.valueFormat = writer.AddString(mValueFormat);
+        params.size = mSize;
+        memcpy(params.colour, &mColour[0], sizeof(params.colour));
+        params.alignment = static_cast<uint32_t>(mAlignment);
+        params.maxGlyphs = static_cast<uint32_t>(mMaxGlyphs);
+        writer.SetParams(&params, sizeof(params));
+    }
+
+    bool TextWidget::ReadSnapshot(const DashboardSnapshot& snapshot, const DashboardSnapshotRecord& record)
+    {
+        auto params = snapshot.GetParams<TextWidgetSnapshot>(record);
+        if (params == nullptr || !Widget::ReadSnapshot(snapshot, record)) return false;
+        SetText(snapshot.GetString(params->text));
+        if (!SetValueFormat(snapshot.GetString(params->valueFormat))) return false;
+        SetSize(params->size);
+        SetColour(glm::make_vec4(params->colour));
+        SetAlignment(params->alignment <= TextAlign_Right ?
+            static_cast<TextAlignment>(params->alignment) : TextAlign_Left);
+        mMaxGlyphs = params->maxGlyphs;
+        return true;
+    }
+
+    void TextWidget::SetText(const string& text)
+    {
+        if (text == mText) return;
+        bool resized = text.size() != mText.size();
+        mText = text;
+        mTextWidth = -1.0f;
+        if (resized) UpdateBounds();
+    }
+
+    void TextWidget::UpdateBounds()
+    {
+        // No glyph advances more than 1.5 ems, nor a line more than that,
+        // so this reaches every glyph from the origin under any alignment
+        size_t lines = 1 + std::count(mText.begin(), mText.end(), '\n');
+        SetInstanceBounds(vec4(0.0f, 0.0f, 0.0f, mSize * 1.5f * (mText.size() + lines + 1)));
+    }
+
+    const string& TextWidget::GetText() const
+    {
+        return mText;
+    }
+
+    void TextWidget::SetSize(float size)
+    {
+        mSize = size;
+        mTextWidth = -1.0f;
+        UpdateBounds();
+    }
+
+    void TextWidget::SetColour(const vec4& colour)
+    {
+        mColour = colour;
+    }
+
+    void TextWidget::SetAlignment(TextAlignment alignment)
+    {
+        mAlignment = alignment;
+    }
+
+    bool TextWidget::SetValueFormat(const string& format)
+    {
+        if (!IsValidValueFormat(format))
+        {
+            error("TextWidget: Value format \"{}\" must hold a single %f, %e or %g conversion", format);
+            return false;
+        }
+        mValueFormat = format;
+        mChannelVersion = 0;
+        return true;
+    }
+
+    bool TextWidget::IsValidValueFormat(const string& format)
+    {
+        // The format comes from dashboard files and is handed to snprintf
+        // with one float, so anything else it could consume is refused
+        if (format.empty()) return true;
+        if (format.find('\0') != string::npos) return false;
+        int conversions = 0;
+        size_t i = 0;
+        while (i < format.size())
+        {
+            if (format[i++] != '%') continue;
+            if (i < format.size() && format[i] == '%')
+            {
+                i++;
+                continue;
+            }
+            while (i < format.size() && strchr("-+ #0", format[i]) != nullptr) i++;
+            // Width and precision of at most two digits each, never '*'
+            for (int d = 0; d < 2 && i < format.size() && isdigit(static_cast<unsigned char>(format[i])); d++) i++;
+            if (i < format.size() && format[i] == '.')
+            {
+                i++;
+                for (int d = 0; d < 2 && i < format.size() && isdigit(static_cast<unsigned char>(format[i])); d++) i++;
+            }
+            if (i == format.size() || strchr("feEgG", format[i]) == nullptr) return false;
+            i++;
+            conversions++;
+        }
+        return conversions == 1;
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * TextWidget.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include "Widget.h"
+#include "../Text/TextRenderer.h"
+
+using glm::vec4;
+
+namespace octronic
+{
+    enum TextAlignment
+    {
+        TextAlign_Left,
+        TextAlign_Center,
+        TextAlign_Right
+    };
+
+    /**
+     * @brief A label or value readout. Holds no GL objects of its own; the
+     * text is a retained run on the AppState's TextRenderer, which draws
+     * every widget's text together after the widget pass.
+     *
+     * With a value format set and a channel bound, the text follows the
+     * channel's latest value. The WidgetStore culls text by a bounding
+     * sphere sized from the length of the text.
+     */
+    class TextWidget : public Widget
+    {
+    public:
+        TextWidget(
+            AppState* state,
+            const string& text = "",
+            float size = 0.25f,
+            vec4 colour = vec4(1.0f),
+            size_t maxGlyphs = TEXT_RUN_DEFAULT_GLYPHS
+        );
+        ~TextWidget() override;
+
+        bool Init() override;
+        void Update() override;
+        void Draw(const mat4& view, const mat4& projection) override;
+
+        /**
+         * @brief WidgetStore batch for a run of TextWidgets: updates them
+         * and places their runs from the model matrices in their instance
+         * records.
+         */
+        static void DrawBatch(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+            const mat4& view, const mat4& projection);
+
+        const char* GetTypeName() const override;
+        json ToJson() override;
+        bool FromJson(const json& j) override;
+        void WriteSnapshot(DashboardSnapshotWriter& writer) override;
+        bool ReadSnapshot(const DashboardSnapshot& snapshot, const DashboardSnapshotRecord& record) override;
+
+        void SetText(const string& text);
+        const string& GetText() const;
+        void SetSize(float size);
+        void SetColour(const vec4& colour);
+        void SetAlignment(TextAlignment alignment);
+
+        /**
+         * @brief printf format for the bound channel's value, e.g. "%.1f".
+         * Empty, or exactly one f, e or g conversion with optional flags,
+         * width and precision; %% may appear anywhere.
+         * @return false, leaving the format unchanged, for any other format.
+         */
+        bool SetValueFormat(const string& format);
+        static bool IsValidValueFormat(const string& format);
+
+    protected:
+        bool InitShader() override;
+        void DrawText(const mat4& model);
+        void UpdateBounds();
+
+    private:
+        string mText;
+        float mSize;
+        vec4 mColour;
+        TextAlignment mAlignment;
+        string mValueFormat;
+        uint64_t mChannelVersion;
+        float mTextWidth;
+        size_t mMaxGlyphs;
+        int mRun;
+    };
+}
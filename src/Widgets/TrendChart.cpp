@@ -0,0 +1,227 @@
+/*
+ * TrendChart.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "TrendChart.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+#include "../AppState.h"
+#include "../Common/Logger.h"
+#include "../Common/Tracer.h"
+#include "../Data/DataChannel.h"
+#include "DashboardSnapshot.h"
+
+namespace octronic
+{
+    TrendChart::TrendChart(AppState* state, float windowSeconds, size_t pointCount, vec2 size, vec3 colour)
+        : Widget3D(state),
+          mWindowSeconds(windowSeconds > TREND_CHART_MIN_WINDOW_SECONDS ? windowSeconds : TREND_CHART_MIN_WINDOW_SECONDS),
+          mPointCount(pointCount < 3 ? 3 : pointCount),
+          mSize(size),
+          mColour(colour),
+          mMinValue(0.0f),
+          mMaxValue(100.0f),
+          mRefreshInterval(100),
+          mLastRebuild(0),
+          mDirty(false),
+          mHistoryStart(0)
+    {
+        debug("TrendChart: Constructor");
+    }
+
+    TrendChart::~TrendChart()
+    {
+        debug("TrendChart: Destructor");
+        mAppState->GetTrendDownsampler().Remove(this);
+    }
+
+    bool TrendChart::Init()
+    {
+        debug("TrendChart: {}", __FUNCTION__);
+        if (!Widget3D::Init()) return false;
+        mPoints.reserve(mPointCount);
+        mAppState->GetTrendDownsampler().Add(this);
+        return true;
+    }
+
+    void TrendChart::Update()
+    {
+    }
+
+    bool TrendChart::TakeFrameSamples(long now)
+    {
+        if (mChannel == nullptr) return false;
+        const vector<DataSample>& samples = mChannel->GetFrameSamples();
+        if (!samples.empty()) AppendSamples(samples);
+        return mDirty && GetVisible() && now - mLastRebuild >= mRefreshInterval;
+    }
+
+    LttbJob TrendChart::GetDownsampleJob()
+    {
+        LttbJob job;
+        job.samples = mHistory.data() + mHistoryStart;
+        job.count = mHistory.size() - mHistoryStart;
+        job.target = mPointCount;
+        job.out = &mPoints;
+        return job;
+    }
+
+    void TrendChart::AppendSamples(const vector<DataSample>& samples)
+    {
+        mHistory.insert(mHistory.end(), samples.begin(), samples.end());
+        mDirty = true;
+
+        // Drop samples that left the window, or the oldest beyond the cap
+        double start = mHistory.back().timestamp - mWindowSeconds;
+        while (mHistoryStart + 2 < mHistory.size() && mHistory[mHistoryStart + 1].timestamp <= start)
+        {
+            mHistoryStart++;
+        }
+        if (mHistory.size() - mHistoryStart > TREND_CHART_MAX_HISTORY)
+        {
+            mHistoryStart = mHistory.size() - TREND_CHART_MAX_HISTORY;
+        }
+        if (mHistoryStart > mHistory.size() / 2)
+        {
+            mHistory.erase(mHistory.begin(), mHistory.begin() + mHistoryStart);
+            mHistoryStart = 0;
+        }
+    }
+
+    void TrendChart::RebuildLine(long now)
+    {
+        TRACE_SCOPE("TrendChart::RebuildLine");
+        mLastRebuild = now;
+        mDirty = false;
+
+        ClearLineVertexBuffer();
+        if (mPoints.size() < 2) return;
+
+        double end = mPoints.back().timestamp;
+        float range = mMaxValue - mMinValue;
+        WidgetVertex previous;
+        for (size_t i = 0; i < mPoints.size(); i++)
+        {
+            float age = static_cast<float>(end - mPoints[i].timestamp);
+            float x = glm::max(0.0f, 1.0f - age / mWindowSeconds) * mSize.x;
+            float y = glm::clamp((mPoints[i].value - mMinValue) / range, 0.0f, 1.0f) * mSize.y;
+
+            WidgetVertex vertex;
+            vertex.Position = vec3(x, y, 0.0f);
+            vertex.Color = mColour;
+            if (i > 0)
+            {
+                AddLineVertex(previous);
+                AddLineVertex(vertex);
+            }
+            previous = vertex;
+        }
+        SubmitLineVertexBuffer();
+    }
+
+    const char* TrendChart::GetTypeName() const
+    {
+        return "TrendChart";
+    }
+
+    json TrendChart::ToJson()
+    {
+        json j = Widget::ToJson();
+        j["windowSeconds"] = mWindowSeconds;
+        j["pointCount"] = mPointCount;
+        j["size"] = Vec2ToJson(mSize);
+        j["colour"] = Vec3ToJson(mColour);
+        j["valueRange"] = Vec2ToJson(vec2(mMinValue, mMaxValue));
+        j["refreshInterval"] = mRefreshInterval;
+        return j;
+    }
+
+    bool TrendChart::FromJson(const json& j)
+    {
+        if (!Widget::FromJson(j)) return false;
+        if (j.count("windowSeconds"))   SetWindowSeconds(j["windowSeconds"].get<float>());
+        if (j.count("pointCount"))      mPointCount = std::max<size_t>(3, j["pointCount"].get<size_t>());
+        if (j.count("size"))            mSize = JsonToVec2(j["size"]);
+        if (j.count("colour"))          mColour = JsonToVec3(j["colour"]);
+        if (j.count("refreshInterval")) SetRefreshInterval(j["refreshInterval"].get<long>());
+        if (j.count("valueRange"))
+        {
+            vec2 range = JsonToVec2(j["valueRange"]);
+            SetValueRange(range.x, range.y);
+        }
+        return true;
+    }
+
+    void TrendChart::WriteSnapshot(DashboardSnapshotWriter& writer)
+    {
+        TrendChartSnapshot params;
+        params.windowSeconds = mWindowSeconds;
+        params.pointCount = static_cast<uint32_t>(mPointCount);
+        memcpy(params.size, &mSize[0], sizeof(params.size));
+        memcpy(params.colour, &mColour[0], sizeof(params.colour));
+        params.valueRange[0] = mMinValue;
+        params.valueRange[1] = mMaxValue;
+        params.refreshInterval = static_cast<int32_t>(mRefreshInterval);
+        writer.SetParams(&params, sizeof(params));
+    }
+
+    bool TrendChart::ReadSnapshot(const DashboardSnapshot& snapshot, const DashboardSnapshotRecord& record)
+    {
+        auto params = snapshot.GetParams<TrendChartSnapshot>(record);
+        if (params == nullptr || !Widget::ReadSnapshot(snapshot, record)) return false;
+        if (!(params->windowSeconds >= TREND_CHART_MIN_WINDOW_SECONDS) || !std::isfinite(params->windowSeconds))
+        {
+            error("TrendChart: Snapshot window of {}s is out of range", params->windowSeconds);
+            return false;
+        }
+        SetWindowSeconds(params->windowSeconds);
+        mPointCount = std::max<size_t>(3, params->pointCount);
+        mSize = glm::make_vec2(params->size);
+        mColour = glm::make_vec3(params->colour);
+        SetRefreshInterval(params->refreshInterval);
+        SetValueRange(params->valueRange[0], params->valueRange[1]);
+        return true;
+    }
+
+    void TrendChart::SetValueRange(float minValue, float maxValue)
+    {
+        mMinValue = minValue;
+        mMaxValue = maxValue;
+        mDirty = true;
+    }
+
+    void TrendChart::SetRefreshInterval(long milliseconds)
+    {
+        mRefreshInterval = milliseconds;
+    }
+
+    float TrendChart::GetWindowSeconds() const
+    {
+        return mWindowSeconds;
+    }
+
+    void TrendChart::SetWindowSeconds(float seconds)
+    {
+        // Also catches NaN; RebuildLine divides by the window
+        mWindowSeconds = seconds > TREND_CHART_MIN_WINDOW_SECONDS ? seconds : TREND_CHART_MIN_WINDOW_SECONDS;
+        mDirty = true;
+    }
+
+    size_t TrendChart::GetHistorySize() const
+    {
+        return mHistory.size() - mHistoryStart;
+    }
+}
@@ -0,0 +1,96 @@
+/*
+ * TrendChart.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include "Widget3D.h"
+#include "../Data/DataSample.h"
+#include "../Data/Lttb.h"
+
+using glm::vec2;
+
+#define TREND_CHART_MAX_HISTORY (1 << 22)
+#define TREND_CHART_MIN_WINDOW_SECONDS 0.001f
+
+namespace octronic
+{
+    /**
+     * @brief Long-window trend line of the bound channel. The raw samples
+     * of the window are kept on the CPU and reduced to a fixed number of
+     * points with Lttb, at most once per refresh interval, into the
+     * Widget3D line buffer. The AppState's TrendDownsampler drives every
+     * chart from one pass, so Update does nothing.
+     *
+     * The chart spans [0, size.x] x [0, size.y] in model space, with the
+     * newest sample at the right edge.
+     */
+    class TrendChart : public Widget3D
+    {
+    public:
+        TrendChart(
+            AppState* state,
+            float windowSeconds = 60.0f,
+            size_t pointCount = 512,
+            vec2 size = vec2(3.0f, 0.6f),
+            vec3 colour = vec3(0.9f, 0.6f, 0.1f)
+        );
+        ~TrendChart() override;
+
+        bool Init() override;
+        void Update() override;
+
+        const char* GetTypeName() const override;
+        json ToJson() override;
+        bool FromJson(const json& j) override;
+        void WriteSnapshot(DashboardSnapshotWriter& writer) override;
+        bool ReadSnapshot(const DashboardSnapshot& snapshot, const DashboardSnapshotRecord& record) override;
+
+        void SetValueRange(float minValue, float maxValue);
+        void SetRefreshInterval(long milliseconds);
+        float GetWindowSeconds() const;
+        /** @brief Clamped to at least TREND_CHART_MIN_WINDOW_SECONDS. */
+        void SetWindowSeconds(float seconds);
+        size_t GetHistorySize() const;
+
+        /**
+         * @brief Appends the channel's frame samples to the window.
+         * @return true if the chart is visible and due a new line at now.
+         */
+        bool TakeFrameSamples(long now);
+        /** @brief Reduces the window into the chart's points. */
+        LttbJob GetDownsampleJob();
+        /** @brief Rebuilds the line buffer from the job's points. */
+        void RebuildLine(long now);
+
+    protected:
+        void AppendSamples(const vector<DataSample>& samples);
+
+    private:
+        float mWindowSeconds;
+        size_t mPointCount;
+        vec2 mSize;
+        vec3 mColour;
+        float mMinValue;
+        float mMaxValue;
+        long mRefreshInterval;
+        long mLastRebuild;
+        bool mDirty;
+
+        // Window samples are mHistory[mHistoryStart, end); the front is
+        // compacted once it is more than half the vector
+        vector<DataSample> mHistory;
+        size_t mHistoryStart;
+        vector<DataSample> mPoints;
+    };
+}
@@ -0,0 +1,66 @@
+/*
+ * TrendDownsampler.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+
+#include "TrendDownsampler.h"
+
+#include <algorithm>
+#include "../Common/Time.h"
+#include "../Common/Tracer.h"
+#include "TrendChart.h"
+
+namespace octronic
+{
+    TrendDownsampler::TrendDownsampler()
+    {
+    }
+
+    void TrendDownsampler::Add(TrendChart* chart)
+    {
+        if (std::find(mCharts.begin(), mCharts.end(), chart) != mCharts.end()) return;
+        mCharts.push_back(chart);
+    }
+
+    void TrendDownsampler::Remove(TrendChart* chart)
+    {
+        mCharts.erase(std::remove(mCharts.begin(), mCharts.end(), chart), mCharts.end());
+    }
+
+    void TrendDownsampler::Run()
+    {
+        if (mCharts.empty()) return;
+        TRACE_SCOPE("TrendDownsampler::Run");
+
+        long now = Time::GetCurrentTime();
+        size_t total = 0;
+        mDue.clear();
+        mJobs.clear();
+        for (TrendChart* chart : mCharts)
+        {
+            if (!chart->TakeFrameSamples(now)) continue;
+            mDue.push_back(chart);
+            mJobs.push_back(chart->GetDownsampleJob());
+            total += mJobs.back().count;
+        }
+        if (mJobs.empty()) return;
+
+        Lttb::DownsampleAll(mJobs, total < TREND_DOWNSAMPLE_PARALLEL_SAMPLES ? 1 : 0);
+        for (TrendChart* chart : mDue) chart->RebuildLine(now);
+    }
+
+    size_t TrendDownsampler::GetChartCount() const
+    {
+        return mCharts.size();
+    }
+}
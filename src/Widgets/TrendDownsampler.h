@@ -0,0 +1,61 @@
+/*
+ * TrendDownsampler.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "../Data/Lttb.h"
+
+using std::vector;
+
+// Below this many window samples across the due charts, the pass runs on
+// the render thread alone rather than starting workers
+#define TREND_DOWNSAMPLE_PARALLEL_SAMPLES (1 << 18)
+
+namespace octronic
+{
+    class TrendChart;
+
+    /**
+     * @brief Refreshes every TrendChart in one pass per frame, after the
+     * channels are drained. Each chart takes in its frame samples; the
+     * charts due a new line are then reduced together by
+     * Lttb::DownsampleAll, spread over worker threads once their windows
+     * are large enough, and their line buffers rebuilt on the render
+     * thread.
+     *
+     * Render thread only. Charts add themselves in Init and remove
+     * themselves when destroyed.
+     */
+    class TrendDownsampler
+    {
+    public:
+        TrendDownsampler();
+
+        void Add(TrendChart* chart);
+        void Remove(TrendChart* chart);
+
+        void Run();
+
+        size_t GetChartCount() const;
+
+    private:
+        vector<TrendChart*> mCharts;
+        // Kept between frames so a pass does not allocate
+        vector<TrendChart*> mDue;
+        vector<LttbJob> mJobs;
+    };
+}
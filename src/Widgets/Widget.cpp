@@ -1,25 +1,69 @@
 #include "Widget.h"
 
 #include "../Common/Logger.h"
+#include "../Common/MemoryPool.h"
 #include "../AppState.h"
+#include "DashboardSnapshot.h"
+#include <map>
+#include <memory>
+#include <mutex>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#define WIDGET_POOL_BLOCKS_PER_CHUNK 32
+
 namespace octronic
 {
+    // One pool per widget size, only touched under the lock
+    struct WidgetPools
+    {
+        std::mutex mutex;
+        std::map<size_t, std::unique_ptr<MemoryPool>> bySize;
+    };
+
+    static WidgetPools& GetWidgetPools()
+    {
+        static WidgetPools pools;
+        return pools;
+    }
+
+    void* Widget::operator new(size_t size)
+    {
+        WidgetPools& pools = GetWidgetPools();
+        std::lock_guard<std::mutex> lock(pools.mutex);
+        std::unique_ptr<MemoryPool>& pool = pools.bySize[size];
+        if (!pool) pool.reset(new MemoryPool(size, WIDGET_POOL_BLOCKS_PER_CHUNK));
+        return pool->Allocate();
+    }
+
+    void Widget::operator delete(void* widget, size_t size)
+    {
+        WidgetPools& pools = GetWidgetPools();
+        std::lock_guard<std::mutex> lock(pools.mutex);
+        pools.bySize[size]->Free(widget);
+    }
+
     Widget::Widget
     (AppState* project, bool visible) :
+		mAppState(project),
 		mModelMatrix(mat4(1.0f)),
 		mVisible(visible),
-		mShaderProgram(0)
+		mShaderProgram(0),
+		mChannel(nullptr),
+		mAlarmLevel(AlarmLevel_Normal),
+		mInstances(nullptr),
+		mInstance(WIDGET_INSTANCE_NONE)
     {
         debug("Widget: Constructor");
+        mNode = mAppState->GetSceneGraph().Create(&mModelMatrix);
     }
 
     Widget::~Widget()
     {
         debug("Widget: Destructor");
+        DetachInstance();
+        mAppState->GetSceneGraph().Destroy(mNode);
 		// Shader
         if (mShaderProgram > 0) glDeleteProgram(mShaderProgram);
     }
@@ -32,16 +76,185 @@ namespace octronic
     void Widget::SetVisible (bool v)
     {
         mVisible = v;
+        if (mInstances != nullptr) mInstances->SetVisible(mInstance, v);
+    }
+
+    WidgetInstanceBuffer* Widget::GetInstances() const
+    {
+        return mInstances;
+    }
+
+    uint32_t Widget::GetInstanceSlot() const
+    {
+        return mInstance;
+    }
+
+    bool Widget::AttachInstance(size_t stride)
+    {
+        if (mInstances != nullptr) return true;
+        mInstances = &mAppState->GetWindow().GetWidgetStore().GetInstances(GetTypeName(), stride);
+        if (mInstances->GetStride() < stride)
+        {
+            error("Widget: {} records are {} texels, not {}", GetTypeName(), mInstances->GetStride(), stride);
+            mInstances = nullptr;
+            return false;
+        }
+        mInstance = mInstances->Add(this, mNode, mVisible);
+        WriteInstance()[WIDGET_INSTANCE_TINT] = GetAlarmTint();
+        return true;
+    }
+
+    void Widget::DetachInstance()
+    {
+        if (mInstances == nullptr) return;
+        mInstances->Remove(mInstance);
+        mInstances = nullptr;
+        mInstance = WIDGET_INSTANCE_NONE;
+    }
+
+    vec4* Widget::WriteInstance()
+    {
+        return mInstances->Write(mInstance);
+    }
+
+    void Widget::SetInstanceBounds(const vec4& sphere)
+    {
+        if (mInstances != nullptr) mInstances->SetBounds(mInstance, sphere);
+    }
+
+    bool Widget::Prepare()
+    {
+        return true;
+    }
+
+    bool Widget::EvictTextures()
+    {
+        return false;
+    }
+
+    bool Widget::BindChannel(const string& channelName)
+    {
+        mChannel = mAppState->GetChannelRegistry().Create(channelName);
+        if (mChannel == nullptr) return false;
+        debug("Widget: Bound to channel '{}'", channelName);
+        return true;
+    }
+
+    DataChannel* Widget::GetChannel() const
+    {
+        return mChannel;
+    }
+
+    json Widget::ToJson()
+    {
+        json j;
+        j["type"] = GetTypeName();
+        j["position"] = Vec3ToJson(GetPosition());
+        vec3 rotation = GetRotation();
+        if (rotation != vec3(0.0f)) j["rotation"] = Vec3ToJson(rotation);
+        if (GetScale() != vec3(1.0f)) j["scale"] = Vec3ToJson(GetScale());
+        j["visible"] = mVisible;
+        if (mChannel != nullptr) j["channel"] = mChannel->GetName();
+        return j;
+    }
+
+    bool Widget::FromJson(const json& j)
+    {
+        if (j.count("position")) SetPosition(JsonToVec3(j["position"]));
+        if (j.count("rotation")) SetRotation(JsonToVec3(j["rotation"]));
+        if (j.count("scale"))    SetScale(JsonToVec3(j["scale"]));
+        if (j.count("visible"))  SetVisible(j["visible"].get<bool>());
+        if (j.count("channel") && !BindChannel(j["channel"].get<string>())) return false;
+        return true;
+    }
+
+    void Widget::WriteSnapshot(DashboardSnapshotWriter& writer)
+    {
+        (void)writer;
+    }
+
+    bool Widget::ReadSnapshot(const DashboardSnapshot& snapshot, const DashboardSnapshotRecord& record)
+    {
+        SetPosition(vec3(record.position[0], record.position[1], record.position[2]));
+        SetRotation(vec3(record.rotation[0], record.rotation[1], record.rotation[2]));
+        SetScale(vec3(record.scale[0], record.scale[1], record.scale[2]));
+        SetVisible((record.flags & DashboardSnapshot_Visible) != 0);
+        if (record.channel.length > 0 && !BindChannel(snapshot.GetString(record.channel))) return false;
+        return true;
+    }
+
+    void Widget::SetAlarmLevel(AlarmLevel level)
+    {
+        if (level == mAlarmLevel) return;
+        mAlarmLevel = level;
+        if (mInstances != nullptr) WriteInstance()[WIDGET_INSTANCE_TINT] = GetAlarmTint();
+    }
+
+    AlarmLevel Widget::GetAlarmLevel() const
+    {
+        return mAlarmLevel;
+    }
+
+    vec4 Widget::GetAlarmTint() const
+    {
+        switch (mAlarmLevel)
+        {
+            case AlarmLevel_Warning:  return vec4(1.0f, 0.7f, 0.0f, 1.0f);
+            case AlarmLevel_Critical: return vec4(1.0f, 0.1f, 0.05f, 2.0f);
+            default:                  return vec4(1.0f, 1.0f, 1.0f, 0.0f);
+        }
+    }
+
+    vec3 Widget::GetAlarmColour(const vec3& colour) const
+    {
+        if (mAlarmLevel == AlarmLevel_Normal) return colour;
+        vec4 tint = GetAlarmTint();
+        if (mAlarmLevel == AlarmLevel_Critical &&
+            glm::fract(mAppState->GetFrameUniforms().GetTime() * WIDGET_ALARM_BLINK_HZ) >= 0.5f)
+        {
+            return colour;
+        }
+        return vec3(tint);
     }
 
     void Widget::SetPosition(const vec3& pos)
     {
-        mModelMatrix = glm::translate(mat4(1.0f),pos);
+        mAppState->GetSceneGraph().SetTranslation(mNode, pos);
     }
 
     vec3 Widget::GetPosition()
     {
-       return vec3(mModelMatrix[3]);
+        return mAppState->GetSceneGraph().GetTranslation(mNode);
+    }
+
+    void Widget::SetRotation(const vec3& degrees)
+    {
+        mAppState->GetSceneGraph().SetRotation(mNode, quat(glm::radians(degrees)));
+    }
+
+    vec3 Widget::GetRotation() const
+    {
+        return glm::degrees(glm::eulerAngles(mAppState->GetSceneGraph().GetRotation(mNode)));
+    }
+
+    void Widget::SetScale(const vec3& scale)
+    {
+        mAppState->GetSceneGraph().SetScale(mNode, scale);
+    }
+
+    vec3 Widget::GetScale() const
+    {
+        return mAppState->GetSceneGraph().GetScale(mNode);
+    }
+
+    bool Widget::SetParent(Widget* parent)
+    {
+        return mAppState->GetSceneGraph().SetParent(mNode, parent != nullptr ? parent->GetNode() : SCENE_NODE_NONE);
+    }
+
+    SceneNode Widget::GetNode() const
+    {
+        return mNode;
     }
 
 }
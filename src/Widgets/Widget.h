@@ -9,40 +9,164 @@
 #include <string>
 #include <glm/glm.hpp>
 #include "../Common/GLHeader.h"
+#include "../Common/JsonSerialization.h"
+#include "../Data/AlarmEngine.h"
+#include "SceneGraph.h"
+#include "WidgetInstanceBuffer.h"
 
 using std::string;
 using glm::vec3;
+using glm::vec4;
 using glm::mat4;
 using std::vector;
 using std::string;
 
+/**
+ * Alarm tint for widget shaders, after FRAME_UNIFORMS_GLSL. The tint is
+ * the WIDGET_INSTANCE_TINT texel of the widget's record: rgb is the alarm
+ * colour, w 0 for none, 1 steady, 2 blinking. AlarmOn(tint) is how much of
+ * the alarm colour to show this frame.
+ */
+#define WIDGET_ALARM_GLSL \
+    "float AlarmOn(vec4 tint) { return tint.w > 1.5 ? step(fract(frameTime * 2.0), 0.5) : tint.w; }\n"
+
+// Matches the GLSL above
+#define WIDGET_ALARM_BLINK_HZ 2.0f
+
 namespace octronic
 {
     class AppState;
-    class Widget
+    class DataChannel;
+    class DashboardSnapshot;
+    class DashboardSnapshotWriter;
+    struct DashboardSnapshotRecord;
+    class Widget : public JsonSerialization
     {
     public:
         Widget(AppState* state,  bool visible = true);
         virtual ~Widget();
 
+        /**
+         * @brief Widgets are allocated from a MemoryPool per size, which in
+         * practice is one per widget type, so a type's instances sit
+         * together for the WidgetStore's batches. Only the allocator is
+         * locked: constructing and destroying a widget touches the
+         * SceneGraph, so both belong on the render thread.
+         */
+        static void* operator new(size_t size);
+        static void operator delete(void* widget, size_t size);
+
+        /** @brief Name the WidgetFactory creates this widget by. */
+        virtual const char* GetTypeName() const = 0;
+
+        /**
+         * @brief CPU-only setup (file reads, image decode) that Init would
+         * otherwise do. Touches no GL state, so a Dashboard can run it for
+         * many widgets at once on worker threads before calling Init.
+         */
+        virtual bool Prepare();
         virtual bool Init() = 0;
         virtual void Update() = 0;
         virtual void Draw(const mat4& view, const mat4& projection) = 0;
 
+        /**
+         * @brief Local transform, relative to the parent widget if there
+         * is one. mModelMatrix follows on the next SceneGraph::Update.
+         */
         void SetPosition(const vec3&);
         vec3 GetPosition();
+        /** @brief Euler angles in degrees. */
+        void SetRotation(const vec3& degrees);
+        vec3 GetRotation() const;
+        void SetScale(const vec3& scale);
+        vec3 GetScale() const;
+
+        /**
+         * @brief Moves the widget under parent, or to the root for nullptr.
+         * @return false if that would make a cycle.
+         */
+        bool SetParent(Widget* parent);
+        SceneNode GetNode() const;
 
         bool GetVisible() const;
         void SetVisible(bool);
 
+        /**
+         * @brief The widget's slot in its type's WidgetInstanceBuffer, or
+         * nullptr and WIDGET_INSTANCE_NONE before AttachInstance.
+         */
+        WidgetInstanceBuffer* GetInstances() const;
+        uint32_t GetInstanceSlot() const;
+
+        /**
+         * @brief Frees textures that can be restored on the next Draw.
+         * Called by the GpuMemoryTracker when over budget.
+         * @return true if anything was freed.
+         */
+        virtual bool EvictTextures();
+
+        /**
+         * @brief Binds the widget to a data channel by name, creating the
+         * channel if no producer has registered it yet.
+         */
+        bool BindChannel(const string& channelName);
+        DataChannel* GetChannel() const;
+
+        /**
+         * @brief Position, visibility and channel binding. Subclasses add
+         * their own parameters; FromJson is applied before Init.
+         */
+        json ToJson() override;
+        bool FromJson(const json& j) override;
+
+        /**
+         * @brief Binary counterpart of ToJson/FromJson for dashboard
+         * snapshots. The writer stores the common fields itself; widgets
+         * with parameters pass their *Snapshot struct to SetParams.
+         */
+        virtual void WriteSnapshot(DashboardSnapshotWriter& writer);
+        virtual bool ReadSnapshot(const DashboardSnapshot& snapshot, const DashboardSnapshotRecord& record);
+
+        /**
+         * @brief Called through the AlarmEngine when the bound channel's
+         * alarm changes level; the tint goes into the widget's record.
+         */
+        void SetAlarmLevel(AlarmLevel level);
+        AlarmLevel GetAlarmLevel() const;
+
     protected: // Member Functions
 
         virtual bool InitShader() = 0;
 
+        /**
+         * @brief Takes a slot of stride vec4s in the WidgetStore's buffer
+         * for this widget's type, from Init. The store keeps its model
+         * matrix, visibility and alarm tint up to date from then on.
+         */
+        bool AttachInstance(size_t stride);
+        void DetachInstance();
+        /** @brief This widget's record, marked for upload. */
+        vec4* WriteInstance();
+        /** @brief Model-space bounding sphere, for culling. */
+        void SetInstanceBounds(const vec4& sphere);
+
+        /** @brief WIDGET_INSTANCE_TINT for the current level. */
+        vec4 GetAlarmTint() const;
+        /**
+         * @brief For widgets coloured on the CPU: colour, or this frame's
+         * alarm colour.
+         */
+        vec3 GetAlarmColour(const vec3& colour) const;
+
     protected: // Variables
         AppState* mAppState;
         bool mVisible;
         mat4 mModelMatrix;
         GLuint mShaderProgram;
+        DataChannel* mChannel;
+        AlarmLevel mAlarmLevel;
+        SceneNode mNode;
+        WidgetInstanceBuffer* mInstances;
+        uint32_t mInstance;
     };
 }
@@ -1,6 +1,7 @@
 #include "Widget3D.h"
 
 #include "../Common/Logger.h"
+#include "../Common/Tracer.h"
 #include "../AppState.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -8,6 +9,9 @@
 
 namespace octronic
 {
+    GLuint Widget3D::sShaderProgram = 0;
+    unsigned Widget3D::sShaderUsers = 0;
+
     Widget3D::Widget3D
     (AppState* state, bool visible) :
         Widget(state,visible),
@@ -16,7 +20,9 @@ namespace octronic
 		mTriangleVao(0),
 		mTriangleVbo(0),
 		mPointVao(0),
-		mPointVbo(0)
+		mPointVbo(0),
+		mViewUniform(-1),
+		mProjectionUniform(-1)
     {
         debug("Widget3D: Constructor");
     }
@@ -24,26 +30,64 @@ namespace octronic
     Widget3D::~Widget3D()
     {
         debug("Widget3D: Destructor");
+        GpuMemoryTracker& tracker = mAppState->GetGpuMemoryTracker();
 
         // Line
-        if (mLineVao > 0) glDeleteVertexArrays(1,&mLineVao);
-        if (mLineVbo > 0) glDeleteBuffers(1,&mLineVbo);
+        if (mLineVao > 0)
+        {
+            tracker.Release(GpuResource_VertexArray, mLineVao);
+            glDeleteVertexArrays(1,&mLineVao);
+        }
+        if (mLineVbo > 0)
+        {
+            tracker.Release(GpuResource_VertexBuffer, mLineVbo);
+            glDeleteBuffers(1,&mLineVbo);
+        }
 
         // Triangle
-        if (mTriangleVao > 0) glDeleteVertexArrays(1,&mTriangleVao);
-        if (mTriangleVbo > 0) glDeleteBuffers(1,&mTriangleVbo);
+        if (mTriangleVao > 0)
+        {
+            tracker.Release(GpuResource_VertexArray, mTriangleVao);
+            glDeleteVertexArrays(1,&mTriangleVao);
+        }
+        if (mTriangleVbo > 0)
+        {
+            tracker.Release(GpuResource_VertexBuffer, mTriangleVbo);
+            glDeleteBuffers(1,&mTriangleVbo);
+        }
 
         // Point
-        if (mPointVao > 0) glDeleteVertexArrays(1,&mPointVao);
-        if (mPointVbo > 0) glDeleteBuffers(1,&mPointVbo);
+        if (mPointVao > 0)
+        {
+            tracker.Release(GpuResource_VertexArray, mPointVao);
+            glDeleteVertexArrays(1,&mPointVao);
+        }
+        if (mPointVbo > 0)
+        {
+            tracker.Release(GpuResource_VertexBuffer, mPointVbo);
+            glDeleteBuffers(1,&mPointVbo);
+        }
+
+        // The program is shared; keep Widget from deleting it
+        if (mShaderProgram > 0 && mShaderProgram == sShaderProgram)
+        {
+            if (--sShaderUsers == 0)
+            {
+                glDeleteProgram(sShaderProgram);
+                sShaderProgram = 0;
+            }
+            mShaderProgram = 0;
+        }
 
         GLCheckError();
     }
 
     bool Widget3D::Init()
     {
+        TRACE_SCOPE("Widget3D::Init");
         debug("Widget3D3D: {}",__FUNCTION__);
         if (!InitShader())          return false;
+        if (!AttachInstance(WIDGET_INSTANCE_BASE_STRIDE)) return false;
         if (!InitLineBuffers())     return false;
         if (!InitTriangleBuffers()) return false;
         if (!InitPointBuffers())    return false;
@@ -63,6 +107,7 @@ namespace octronic
             return false;
         }
         glBindVertexArray(mTriangleVao);
+        mAppState->GetGpuMemoryTracker().Track(this, GpuResource_VertexArray, mTriangleVao, 0);
 
         // VBO
         glGenBuffers(1,&mTriangleVbo);
@@ -72,6 +117,7 @@ namespace octronic
             return false;
         }
         glBindBuffer(GL_ARRAY_BUFFER,mTriangleVbo);
+        mAppState->GetGpuMemoryTracker().Track(this, GpuResource_VertexBuffer, mTriangleVbo, 0);
 
         // Vertex Position Attributes
         glVertexAttribPointer(
@@ -118,6 +164,7 @@ namespace octronic
             return false;
         }
         glBindVertexArray(mLineVao);
+        mAppState->GetGpuMemoryTracker().Track(this, GpuResource_VertexArray, mLineVao, 0);
 
         // VBO
         glGenBuffers(1,&mLineVbo);
@@ -127,6 +174,7 @@ namespace octronic
             return false;
         }
         glBindBuffer(GL_ARRAY_BUFFER,mLineVbo);
+        mAppState->GetGpuMemoryTracker().Track(this, GpuResource_VertexBuffer, mLineVbo, 0);
 
         // Vertex Position Attributes
         glVertexAttribPointer(
@@ -173,6 +221,7 @@ namespace octronic
             return false;
         }
         glBindVertexArray(mPointVao);
+        mAppState->GetGpuMemoryTracker().Track(this, GpuResource_VertexArray, mPointVao, 0);
 
         // VBO
         glGenBuffers(1,&mPointVbo);
@@ -182,6 +231,7 @@ namespace octronic
             return false;
         }
         glBindBuffer(GL_ARRAY_BUFFER,mPointVbo);
+        mAppState->GetGpuMemoryTracker().Track(this, GpuResource_VertexBuffer, mPointVbo, 0);
 
         // Vertex Position Attributes
         glVertexAttribPointer(
@@ -219,99 +269,73 @@ namespace octronic
     void Widget3D::Draw(const mat4& view, const mat4& projection)
     {
         debug("Widget3D: {}", __FUNCTION__);
+        if (mInstances == nullptr) return;
+        uint32_t slot = mInstance;
+        DrawWidgets(*mInstances, &slot, 1, view, projection);
+    }
 
-        // Enable shader program
-		glUseProgram(mShaderProgram);
-		GLCheckError();
-
-        // Set the projection matrix
-		if (mModelUniform == -1)
-		{
-			error("Widget3D: ModelUniform not found in ShaderProgram");
-			return;
-		}
-		else
-		{
-			glUniformMatrix4fv(mModelUniform, 1, GL_FALSE, glm::value_ptr(mModelMatrix));
-			GLCheckError();
-		}
-
-		// Set the view matrix
-		if (mViewUniform == -1)
-		{
-			error("Widget3D: ViewUniform not found in ShaderProgram");
-			return;
-		}
-		else
-		{
-			glUniformMatrix4fv(mViewUniform, 1, GL_FALSE, glm::value_ptr(view));
-			GLCheckError();
-		}
-
-		// Set the projection matrix
-		if (mProjectionUniform == -1)
-		{
-			error("Widget3D: ProjectionUniform not found in ShaderProgram");
-			return;
-		}
-		else
-		{
-			glUniformMatrix4fv(mProjectionUniform, 1, GL_FALSE, glm::value_ptr(projection));
-			GLCheckError();
-		}
-
-        if (!mLineVertexBuffer.empty())
+    void Widget3D::DrawBatch(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+        const mat4& view, const mat4& projection)
+    {
+        TRACE_SCOPE("Widget3D::DrawBatch");
+        for (size_t i = 0; i < count; i++)
         {
-            // Vertex Array
-            glBindVertexArray(mLineVao);
-        	GLCheckError();
-
-            // Draw
-            GLuint sz = mLineVertexBuffer.size();
-            debug("Widget3D: Drawing {} lines", sz/2);
-            glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(sz));
-        	GLCheckError();
-
-            glBindVertexArray(0);
-        	GLCheckError();
+            instances.GetWidget(slots[i])->Update();
         }
+        DrawWidgets(instances, slots, count, view, projection);
+    }
 
-        if (!mTriangleVertexBuffer.empty())
-        {
-            // Vertex Array
-            glBindVertexArray(mTriangleVao);
-        	GLCheckError();
-
-            // Draw
-            GLuint sz = mTriangleVertexBuffer.size();
-            debug("Widget3D: Drawing {} Triangles", sz/3);
-            glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(sz));
-        	GLCheckError();
-
-            glBindVertexArray(0);
-        	GLCheckError();
-        }
+    void Widget3D::DrawWidgets(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+        const mat4& view, const mat4& projection)
+    {
+        if (count == 0) return;
+        const Widget3D* first = static_cast<const Widget3D*>(instances.GetWidget(slots[0]));
+
+        // State shared by every widget is set once per batch
+        glUseProgram(first->mShaderProgram);
+        glUniformMatrix4fv(first->mViewUniform, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(first->mProjectionUniform, 1, GL_FALSE, glm::value_ptr(projection));
+        instances.Upload();
+        instances.Bind();
+        GLCheckError();
 
-        if (!mPointVertexBuffer.empty())
+        for (size_t i = 0; i < count; i++)
         {
-            // Vertex Array
-            glBindVertexArray(mPointVao);
-        	GLCheckError();
-
-            // Draw
-            GLuint sz = mPointVertexBuffer.size();
-            debug("Widget3D: Drawing {} Points", sz);
-            glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(sz));
-        	GLCheckError();
-
-            glBindVertexArray(0);
-        	GLCheckError();
+            const Widget3D* widget = static_cast<const Widget3D*>(instances.GetWidget(slots[i]));
+            WidgetInstanceBuffer::SelectSlot(slots[i]);
+
+            if (!widget->mLineVertexBuffer.empty())
+            {
+                glBindVertexArray(widget->mLineVao);
+                glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(widget->mLineVertexBuffer.size()));
+            }
+
+            if (!widget->mTriangleVertexBuffer.empty())
+            {
+                glBindVertexArray(widget->mTriangleVao);
+                glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(widget->mTriangleVertexBuffer.size()));
+            }
+
+            if (!widget->mPointVertexBuffer.empty())
+            {
+                glBindVertexArray(widget->mPointVao);
+                glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(widget->mPointVertexBuffer.size()));
+            }
         }
-
+        glBindVertexArray(0);
+        GLCheckError();
     }
 
     bool Widget3D::InitShader()
     {
+        TRACE_SCOPE("Widget3D::InitShader");
+        if (mShaderProgram > 0) return true;
+        if (sShaderProgram > 0)
+        {
+            mShaderProgram = sShaderProgram;
+            sShaderUsers++;
+            return GetUniformLocations();
+        }
         info("Widget3D: {}", __FUNCTION__);
 
         static string vertexShaderSource =
@@ -319,19 +343,24 @@ namespace octronic
             "layout (location = 0) in vec3 in_position;\n"
             "layout (location = 1) in vec3 in_color;\n"
             "out vec3 Color;\n"
-            "uniform mat4 model;\n"
+            "flat out vec4 Tint;\n"
             "uniform mat4 view;\n"
             "uniform mat4 projection;\n"
+            WIDGET_INSTANCE_GLSL
             "void main () { "
-            "    gl_Position = projection * view * model *  vec4(in_position.x, in_position.y, in_position.z, 1.0);\n"
+            "    gl_Position = projection * view * InstanceModel() *  vec4(in_position.x, in_position.y, in_position.z, 1.0);\n"
             "    Color = in_color;\n"
+            "    Tint = InstanceData(4);\n"
             "}";
 
         static string fragmentShaderSource =
             "#version 330 core\n"
             "in vec3  Color;\n"
+            "flat in vec4 Tint;\n"
             "out vec4 FragColor;\n"
-            "void main() { FragColor = vec4(Color,1.0); }";
+            FRAME_UNIFORMS_GLSL
+            WIDGET_ALARM_GLSL
+            "void main() { FragColor = vec4(mix(Color, Tint.rgb, AlarmOn(Tint)), 1.0); }";
 
         GLuint vertexShader = 0;
         GLuint fragmentShader = 0;
@@ -392,21 +421,27 @@ namespace octronic
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
 
-        // Get Uniform Locations
-        mModelUniform = glGetUniformLocation(mShaderProgram, "model");
+        mAppState->GetFrameUniforms().BindProgram(mShaderProgram);
+        WidgetInstanceBuffer::BindProgram(mShaderProgram, WIDGET_INSTANCE_BASE_STRIDE);
+        sShaderProgram = mShaderProgram;
+        sShaderUsers++;
+        return GetUniformLocations();
+    }
+
+    bool Widget3D::GetUniformLocations()
+    {
         mViewUniform = glGetUniformLocation(mShaderProgram,"view");
         mProjectionUniform = glGetUniformLocation(mShaderProgram, "projection");
 
         GLCheckError();
 
-        if (mModelUniform != -1 && mViewUniform != -1 && mProjectionUniform != -1)
+        if (mViewUniform != -1 && mProjectionUniform != -1)
         {
         	return true;
         }
         else
         {
-       		error("Widget3D: Uniform Error M:{} V:{} P:{}",
-                  mModelUniform, mViewUniform, mProjectionUniform);
+       		error("Widget3D: Uniform Error V:{} P:{}", mViewUniform, mProjectionUniform);
             return false;
         }
     }
@@ -422,7 +457,10 @@ namespace octronic
 				static_cast<GLint>(mLineVertexBuffer.size() * sizeof(WidgetVertex)),
 				&mLineVertexBuffer[0], GL_STATIC_DRAW);
 			glBindVertexArray(0);
+			mAppState->GetGpuMemoryTracker().Track(this, GpuResource_VertexBuffer, mLineVbo,
+				mLineVertexBuffer.size() * sizeof(WidgetVertex));
         }
+        UpdateBounds();
     }
 
 	void Widget3D::SubmitTriangleVertexBuffer()
@@ -436,7 +474,10 @@ namespace octronic
 				static_cast<GLint>(mTriangleVertexBuffer.size() * sizeof(WidgetVertex)),
 				&mTriangleVertexBuffer[0], GL_STATIC_DRAW);
 			glBindVertexArray(0);
+			mAppState->GetGpuMemoryTracker().Track(this, GpuResource_VertexBuffer, mTriangleVbo,
+				mTriangleVertexBuffer.size() * sizeof(WidgetVertex));
         }
+        UpdateBounds();
     }
 
     void Widget3D::SubmitPointVertexBuffer()
@@ -450,7 +491,28 @@ namespace octronic
 				static_cast<GLint>(mPointVertexBuffer.size() * sizeof(WidgetVertex)),
 				&mPointVertexBuffer[0], GL_STATIC_DRAW);
 			glBindVertexArray(0);
+			mAppState->GetGpuMemoryTracker().Track(this, GpuResource_VertexBuffer, mPointVbo,
+				mPointVertexBuffer.size() * sizeof(WidgetVertex));
+        }
+        UpdateBounds();
+    }
+
+    void Widget3D::UpdateBounds()
+    {
+        const vector<WidgetVertex>* buffers[3] = { &mLineVertexBuffer, &mTriangleVertexBuffer, &mPointVertexBuffer };
+        vec3 low(0.0f);
+        vec3 high(0.0f);
+        bool empty = true;
+        for (const vector<WidgetVertex>* buffer : buffers)
+        {
+            for (const WidgetVertex& vertex : *buffer)
+            {
+                low = empty ? vertex.Position : glm::min(low, vertex.Position);
+                high = empty ? vertex.Position : glm::max(high, vertex.Position);
+                empty = false;
+            }
         }
+        SetInstanceBounds(vec4((low + high) * 0.5f, glm::distance(low, high) * 0.5f));
     }
 
     void Widget3D::AddLineVertex(const WidgetVertex& lv)
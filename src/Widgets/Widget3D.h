@@ -36,6 +36,15 @@ namespace octronic
         virtual void Update() = 0;
         virtual void Draw(const mat4& view, const mat4& projection);
 
+        /**
+         * @brief WidgetStore batch for a run of one Widget3D type: updates
+         * them, then draws them with the shared program, setting the camera
+         * once. Model matrix and tint come from each widget's instance
+         * record.
+         */
+        static void DrawBatch(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+            const mat4& view, const mat4& projection);
+
     protected: // Member Functions
         void AddLineVertex(const WidgetVertex& v);
         void AddLineVertices(const vector<WidgetVertex>& v);
@@ -48,6 +57,7 @@ namespace octronic
 
         void DefaultShader();
         bool InitShader();
+        bool GetUniformLocations();
         bool InitLineBuffers();
         bool InitTriangleBuffers();
         bool InitPointBuffers();
@@ -59,6 +69,11 @@ namespace octronic
         void SubmitLineVertexBuffer();
         void SubmitTriangleVertexBuffer();
         void SubmitPointVertexBuffer();
+        /** @brief Bounds of every submitted vertex, for culling. */
+        void UpdateBounds();
+
+        static void DrawWidgets(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+            const mat4& view, const mat4& projection);
 
     protected: // Variables
         GLuint mLineVao;
@@ -73,8 +88,12 @@ namespace octronic
         GLuint mPointVbo;
         vector<WidgetVertex> mPointVertexBuffer;
 
-        GLint mModelUniform;
         GLint mViewUniform;
         GLint mProjectionUniform;
+
+    private:
+        // One program serves every Widget3D that does not bring its own
+        static GLuint sShaderProgram;
+        static unsigned sShaderUsers;
     };
 }
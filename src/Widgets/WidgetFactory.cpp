@@ -0,0 +1,92 @@
+/*
+ * WidgetFactory.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "WidgetFactory.h"
+
+#include "../Common/Logger.h"
+#include "Grid.h"
+#include "Group.h"
+#include "ImageWidget.h"
+#include "StripChart.h"
+#include "TextWidget.h"
+#include "TrendChart.h"
+
+namespace octronic
+{
+    map<string, WidgetCreator>& WidgetFactory::GetCreators()
+    {
+        static map<string, WidgetCreator> creators =
+        {
+            { "Grid",       [](AppState* s) -> Widget* { return new Grid(s); } },
+            { "Group",      [](AppState* s) -> Widget* { return new Group(s); } },
+            { "Image",      [](AppState* s) -> Widget* { return new ImageWidget(s, ""); } },
+            { "StripChart", [](AppState* s) -> Widget* { return new StripChart(s); } },
+            { "Text",       [](AppState* s) -> Widget* { return new TextWidget(s); } },
+            { "TrendChart", [](AppState* s) -> Widget* { return new TrendChart(s); } }
+        };
+        return creators;
+    }
+
+    void WidgetFactory::Register(const string& type, WidgetCreator creator)
+    {
+        GetCreators()[type] = creator;
+    }
+
+    bool WidgetFactory::IsRegistered(const string& type)
+    {
+        return GetCreators().count(type) > 0;
+    }
+
+    Widget* WidgetFactory::Create(AppState* state, const string& type)
+    {
+        auto itr = GetCreators().find(type);
+        if (itr == GetCreators().end())
+        {
+            error("WidgetFactory: Unknown widget type '{}'", type);
+            return nullptr;
+        }
+        return itr->second(state);
+    }
+
+    Widget* WidgetFactory::CreateFromJson(AppState* state, const json& j)
+    {
+        if (!j.is_object() || !j.count("type") || !j["type"].is_string())
+        {
+            error("WidgetFactory: Widget description has no type");
+            return nullptr;
+        }
+
+        Widget* widget = Create(state, j["type"].get<string>());
+        if (widget == nullptr) return nullptr;
+
+        bool valid = false;
+        try
+        {
+            valid = widget->FromJson(j);
+        }
+        catch (const json::exception& e)
+        {
+            // Wrongly typed values
+            error("WidgetFactory: {}", e.what());
+        }
+
+        if (!valid)
+        {
+            error("WidgetFactory: Invalid {} description", widget->GetTypeName());
+            delete widget;
+            return nullptr;
+        }
+        return widget;
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * WidgetFactory.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include "Widget.h"
+
+using std::function;
+using std::map;
+using std::string;
+
+namespace octronic
+{
+    typedef function<Widget*(AppState*)> WidgetCreator;
+
+    /**
+     * @brief Creates widgets by the type name they report from
+     * GetTypeName(). The built-in widgets are registered on first use.
+     */
+    class WidgetFactory
+    {
+    public:
+        static void Register(const string& type, WidgetCreator creator);
+        static bool IsRegistered(const string& type);
+
+        /** @return A new, uninitialised widget, or nullptr for unknown types. */
+        static Widget* Create(AppState* state, const string& type);
+
+        /**
+         * @brief Creates the widget named by j["type"] and applies the rest
+         * of j to it with FromJson.
+         * @return The widget, or nullptr if it could not be created.
+         */
+        static Widget* CreateFromJson(AppState* state, const json& j);
+
+    protected:
+        static map<string, WidgetCreator>& GetCreators();
+    };
+}
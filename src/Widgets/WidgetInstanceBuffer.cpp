@@ -0,0 +1,247 @@
+/*
+ * WidgetInstanceBuffer.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "WidgetInstanceBuffer.h"
+
+#include <algorithm>
+#include "../Common/Logger.h"
+#include "../Common/Tracer.h"
+
+namespace octronic
+{
+    WidgetInstanceBuffer::WidgetInstanceBuffer(size_t stride)
+        : mStride(std::max<size_t>(stride, WIDGET_INSTANCE_BASE_STRIDE)),
+          mUsed(0),
+          mDirtyBegin(0),
+          mDirtyEnd(0),
+          mBuffer(0),
+          mTexture(0),
+          mBufferSlots(0)
+    {
+        debug("WidgetInstanceBuffer: Constructor");
+    }
+
+    WidgetInstanceBuffer::~WidgetInstanceBuffer()
+    {
+        debug("WidgetInstanceBuffer: Destructor");
+        ReleaseGL();
+    }
+
+    uint32_t WidgetInstanceBuffer::Add(Widget* widget, SceneNode node, bool visible)
+    {
+        uint32_t slot;
+        if (!mFreeSlots.empty())
+        {
+            slot = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+        else
+        {
+            slot = static_cast<uint32_t>(mWidgets.size());
+            mWidgets.push_back(nullptr);
+            mNodes.push_back(SCENE_NODE_NONE);
+            mNodeVersions.push_back(0);
+            mVisible.push_back(0);
+            mBounds.push_back(WIDGET_INSTANCE_UNBOUNDED);
+            mWorldBounds.push_back(WIDGET_INSTANCE_UNBOUNDED);
+            mRecords.resize(mRecords.size() + mStride);
+        }
+
+        mWidgets[slot] = widget;
+        mNodes[slot] = node;
+        // Versions are never 0, so the next Refresh copies the matrix
+        mNodeVersions[slot] = 0;
+        mVisible[slot] = visible ? 1 : 0;
+        mBounds[slot] = WIDGET_INSTANCE_UNBOUNDED;
+        mWorldBounds[slot] = WIDGET_INSTANCE_UNBOUNDED;
+        vec4* record = Write(slot);
+        std::fill(record, record + mStride, vec4(0.0f));
+        mUsed++;
+        return slot;
+    }
+
+    void WidgetInstanceBuffer::Remove(uint32_t slot)
+    {
+        if (slot >= mWidgets.size() || mWidgets[slot] == nullptr) return;
+        mWidgets[slot] = nullptr;
+        mNodes[slot] = SCENE_NODE_NONE;
+        mVisible[slot] = 0;
+        mFreeSlots.push_back(slot);
+
+        // The last widget of a type takes the GL objects with it
+        if (--mUsed == 0) ReleaseGL();
+    }
+
+    Widget* WidgetInstanceBuffer::GetWidget(uint32_t slot) const
+    {
+        return mWidgets[slot];
+    }
+
+    size_t WidgetInstanceBuffer::GetStride() const
+    {
+        return mStride;
+    }
+
+    size_t WidgetInstanceBuffer::GetSlotCount() const
+    {
+        return mWidgets.size();
+    }
+
+    void WidgetInstanceBuffer::SetVisible(uint32_t slot, bool visible)
+    {
+        mVisible[slot] = visible ? 1 : 0;
+    }
+
+    bool WidgetInstanceBuffer::GetVisible(uint32_t slot) const
+    {
+        return mVisible[slot] != 0;
+    }
+
+    void WidgetInstanceBuffer::SetBounds(uint32_t slot, const vec4& sphere)
+    {
+        if (mBounds[slot] == sphere) return;
+        mBounds[slot] = sphere;
+        UpdateWorldBounds(slot);
+    }
+
+    const vec4& WidgetInstanceBuffer::GetWorldBounds(uint32_t slot) const
+    {
+        return mWorldBounds[slot];
+    }
+
+    vec4* WidgetInstanceBuffer::Write(uint32_t slot)
+    {
+        MarkDirty(slot);
+        return &mRecords[slot * mStride];
+    }
+
+    const vec4* WidgetInstanceBuffer::Read(uint32_t slot) const
+    {
+        return &mRecords[slot * mStride];
+    }
+
+    void WidgetInstanceBuffer::MarkDirty(uint32_t slot)
+    {
+        if (mDirtyBegin == mDirtyEnd)
+        {
+            mDirtyBegin = slot;
+            mDirtyEnd = slot + 1;
+            return;
+        }
+        mDirtyBegin = std::min(mDirtyBegin, slot);
+        mDirtyEnd = std::max(mDirtyEnd, slot + 1);
+    }
+
+    void WidgetInstanceBuffer::UpdateWorldBounds(uint32_t slot)
+    {
+        const vec4* model = &mRecords[slot * mStride + WIDGET_INSTANCE_MODEL];
+        const vec4& sphere = mBounds[slot];
+        vec4 centre = model[0] * sphere.x + model[1] * sphere.y + model[2] * sphere.z + model[3];
+        // The longest axis bounds how far scale can stretch the sphere
+        float scale = glm::max(glm::length(vec3(model[0])),
+            glm::max(glm::length(vec3(model[1])), glm::length(vec3(model[2]))));
+        mWorldBounds[slot] = vec4(vec3(centre), sphere.w * scale);
+    }
+
+    void WidgetInstanceBuffer::Refresh(const SceneGraph& graph)
+    {
+        TRACE_SCOPE("WidgetInstanceBuffer::Refresh");
+        for (uint32_t slot = 0; slot < mNodes.size(); slot++)
+        {
+            if (mNodes[slot] == SCENE_NODE_NONE) continue;
+            uint32_t version = graph.GetVersion(mNodes[slot]);
+            if (version == mNodeVersions[slot]) continue;
+            mNodeVersions[slot] = version;
+
+            const mat4& world = graph.GetWorldMatrix(mNodes[slot]);
+            vec4* model = Write(slot) + WIDGET_INSTANCE_MODEL;
+            for (int column = 0; column < 4; column++) model[column] = world[column];
+            UpdateWorldBounds(slot);
+        }
+    }
+
+    void WidgetInstanceBuffer::Upload()
+    {
+        if (mDirtyBegin == mDirtyEnd && mBuffer > 0) return;
+        TRACE_SCOPE("WidgetInstanceBuffer::Upload");
+        size_t recordBytes = mStride * sizeof(vec4);
+
+        if (mBuffer == 0)
+        {
+            glGenBuffers(1, &mBuffer);
+            glGenTextures(1, &mTexture);
+        }
+
+        glBindBuffer(GL_TEXTURE_BUFFER, mBuffer);
+        if (mBufferSlots < mWidgets.size())
+        {
+            // Grow in steps, re-sending everything
+            mBufferSlots = std::max<size_t>(mWidgets.size(), mBufferSlots * 2);
+            GLint maxTexels = 0;
+            glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+            if (mWidgets.size() * mStride > static_cast<size_t>(maxTexels))
+            {
+                warn("WidgetInstanceBuffer: {} widgets of {} texels exceed the texture buffer limit of {}",
+                    mWidgets.size(), mStride, maxTexels);
+            }
+            glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(mBufferSlots * recordBytes),
+                nullptr, GL_DYNAMIC_DRAW);
+            glBufferSubData(GL_TEXTURE_BUFFER, 0,
+                static_cast<GLsizeiptr>(mWidgets.size() * recordBytes), mRecords.data());
+            glBindTexture(GL_TEXTURE_BUFFER, mTexture);
+            glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, mBuffer);
+            glBindTexture(GL_TEXTURE_BUFFER, 0);
+        }
+        else if (mDirtyBegin < mDirtyEnd)
+        {
+            glBufferSubData(GL_TEXTURE_BUFFER,
+                static_cast<GLintptr>(mDirtyBegin * recordBytes),
+                static_cast<GLsizeiptr>((mDirtyEnd - mDirtyBegin) * recordBytes),
+                &mRecords[mDirtyBegin * mStride]);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        mDirtyBegin = mDirtyEnd = 0;
+    }
+
+    void WidgetInstanceBuffer::Bind()
+    {
+        glActiveTexture(GL_TEXTURE0 + WIDGET_INSTANCE_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, mTexture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void WidgetInstanceBuffer::BindProgram(GLuint program, size_t stride)
+    {
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "instances"), WIDGET_INSTANCE_TEXTURE_UNIT);
+        glUniform1i(glGetUniformLocation(program, "instanceStride"), static_cast<GLint>(stride));
+        glUseProgram(0);
+    }
+
+    void WidgetInstanceBuffer::SelectSlot(uint32_t slot)
+    {
+        glVertexAttribI1i(WIDGET_INSTANCE_ATTRIBUTE, static_cast<GLint>(slot));
+    }
+
+    void WidgetInstanceBuffer::ReleaseGL()
+    {
+        if (mTexture > 0) glDeleteTextures(1, &mTexture);
+        if (mBuffer > 0) glDeleteBuffers(1, &mBuffer);
+        mTexture = 0;
+        mBuffer = 0;
+        mBufferSlots = 0;
+        // A new buffer starts from the whole record array
+        mDirtyBegin = mDirtyEnd = 0;
+    }
+}
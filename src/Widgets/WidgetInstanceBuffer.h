@@ -0,0 +1,144 @@
+/*
+ * WidgetInstanceBuffer.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "../Common/GLHeader.h"
+#include "SceneGraph.h"
+
+using glm::mat4;
+using glm::vec4;
+using std::vector;
+
+// Every record starts with the model matrix, then the alarm tint
+#define WIDGET_INSTANCE_MODEL 0
+#define WIDGET_INSTANCE_TINT 4
+#define WIDGET_INSTANCE_BASE_STRIDE 5
+
+#define WIDGET_INSTANCE_NONE 0xFFFFFFFFu
+// Bounds with a negative radius are never culled
+#define WIDGET_INSTANCE_UNBOUNDED vec4(0.0f, 0.0f, 0.0f, -1.0f)
+
+// Texture unit the record buffer is bound to while a batch draws
+#define WIDGET_INSTANCE_TEXTURE_UNIT 1
+// Generic vertex attribute carrying the slot, set per draw
+#define WIDGET_INSTANCE_ATTRIBUTE 7
+
+/**
+ * GLSL side of WidgetInstanceBuffer, for vertex shaders. The program sets
+ * instanceStride once, after linking, and points instances at
+ * WIDGET_INSTANCE_TEXTURE_UNIT.
+ */
+#define WIDGET_INSTANCE_GLSL \
+    "uniform samplerBuffer instances;\n" \
+    "uniform int instanceStride;\n" \
+    "layout (location = 7) in int in_instance;\n" \
+    "vec4 InstanceData(int i) { return texelFetch(instances, in_instance * instanceStride + i); }\n" \
+    "mat4 InstanceModel() { return mat4(InstanceData(0), InstanceData(1), InstanceData(2), InstanceData(3)); }\n"
+
+namespace octronic
+{
+    class Widget;
+
+    /**
+     * @brief The widgets of one type, packed into parallel arrays by slot:
+     * the widget, its scene node, visibility, bounding sphere, and a
+     * record of stride vec4s of render data. A record starts with the
+     * model matrix and alarm tint (WIDGET_INSTANCE_*), followed by the
+     * type's own data.
+     *
+     * Records are mirrored into a GL texture buffer that shaders index by
+     * slot (WIDGET_INSTANCE_GLSL), so a widget's per-draw state is written
+     * only when it changes and reaches the GPU in one upload per frame,
+     * covering the slots written since the last one. Refresh copies world
+     * matrices out of the SceneGraph for the nodes that changed.
+     *
+     * Slots are reused but never move, so a widget keeps its slot for
+     * life. Render thread only.
+     */
+    class WidgetInstanceBuffer
+    {
+    public:
+        explicit WidgetInstanceBuffer(size_t stride);
+        ~WidgetInstanceBuffer();
+
+        uint32_t Add(Widget* widget, SceneNode node, bool visible);
+        void Remove(uint32_t slot);
+
+        Widget* GetWidget(uint32_t slot) const;
+        size_t GetStride() const;
+        /** @brief Highest slot in use, plus one. */
+        size_t GetSlotCount() const;
+
+        void SetVisible(uint32_t slot, bool visible);
+        bool GetVisible(uint32_t slot) const;
+
+        /**
+         * @brief Model-space bounding sphere, xyz centre and w radius. Slots
+         * start WIDGET_INSTANCE_UNBOUNDED.
+         */
+        void SetBounds(uint32_t slot, const vec4& sphere);
+        /** @brief World-space bounding sphere, as of the last Refresh. */
+        const vec4& GetWorldBounds(uint32_t slot) const;
+
+        /** @brief The slot's record, marked for the next Upload. */
+        vec4* Write(uint32_t slot);
+        const vec4* Read(uint32_t slot) const;
+
+        /**
+         * @brief Copies the world matrix of every slot whose node changed
+         * since the last Refresh into its record, and recomputes the world
+         * bounds that depend on it.
+         */
+        void Refresh(const SceneGraph& graph);
+
+        /** @brief Uploads the records written since the last Upload. */
+        void Upload();
+        /** @brief Binds the records to WIDGET_INSTANCE_TEXTURE_UNIT. */
+        void Bind();
+
+        /** @brief Sets instanceStride and instances on a linked program. */
+        static void BindProgram(GLuint program, size_t stride);
+        /** @brief Selects the record the next draw reads. */
+        static void SelectSlot(uint32_t slot);
+
+    protected:
+        void MarkDirty(uint32_t slot);
+        void UpdateWorldBounds(uint32_t slot);
+        void ReleaseGL();
+
+    private:
+        size_t mStride;
+        vector<Widget*> mWidgets;
+        vector<SceneNode> mNodes;
+        vector<uint32_t> mNodeVersions;
+        vector<uint8_t> mVisible;
+        vector<vec4> mBounds;
+        vector<vec4> mWorldBounds;
+        vector<vec4> mRecords;
+        vector<uint32_t> mFreeSlots;
+        size_t mUsed;
+
+        // Slots to upload, [mDirtyBegin, mDirtyEnd)
+        uint32_t mDirtyBegin;
+        uint32_t mDirtyEnd;
+        GLuint mBuffer;
+        GLuint mTexture;
+        size_t mBufferSlots;
+    };
+}
@@ -0,0 +1,204 @@
+/*
+ * WidgetStore.cpp
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#include "WidgetStore.h"
+
+#include <algorithm>
+#include "../AppState.h"
+#include "../Common/Tracer.h"
+#include "ImageWidget.h"
+#include "StripChart.h"
+#include "TextWidget.h"
+
+namespace octronic
+{
+    WidgetStore::WidgetStore(AppState* state)
+        : mAppState(state),
+          mRunsDirty(false),
+          mCulled(0)
+    {
+    }
+
+    map<string, WidgetBatchFunction>& WidgetStore::GetBatchFunctions()
+    {
+        static map<string, WidgetBatchFunction> batches =
+        {
+            { "Grid",       &Widget3D::DrawBatch },
+            { "Image",      &ImageWidget::DrawBatch },
+            { "StripChart", &StripChart::DrawBatch },
+            { "Text",       &TextWidget::DrawBatch },
+            { "TrendChart", &Widget3D::DrawBatch }
+        };
+        return batches;
+    }
+
+    void WidgetStore::RegisterBatch(const string& type, WidgetBatchFunction batch)
+    {
+        GetBatchFunctions()[type] = batch;
+    }
+
+    WidgetInstanceBuffer& WidgetStore::GetInstances(const string& type, size_t stride)
+    {
+        unique_ptr<WidgetInstanceBuffer>& instances = mInstances[type];
+        if (!instances) instances.reset(new WidgetInstanceBuffer(stride));
+        return *instances;
+    }
+
+    void WidgetStore::Add(Widget* widget)
+    {
+        if (std::find(mWidgets.begin(), mWidgets.end(), widget) != mWidgets.end()) return;
+        mWidgets.push_back(widget);
+        mRunsDirty = true;
+    }
+
+    void WidgetStore::Remove(Widget* widget)
+    {
+        auto itr = std::find(mWidgets.begin(), mWidgets.end(), widget);
+        if (itr == mWidgets.end()) return;
+        mWidgets.erase(itr);
+        mRunsDirty = true;
+    }
+
+    void WidgetStore::BuildRuns()
+    {
+        mRuns.clear();
+        mRunSlots.clear();
+        map<string, WidgetBatchFunction>& batches = GetBatchFunctions();
+        for (size_t i = 0; i < mWidgets.size(); i++)
+        {
+            Widget* widget = mWidgets[i];
+            auto itr = batches.find(widget->GetTypeName());
+            WidgetInstanceBuffer* instances = widget->GetInstances();
+            bool batched = itr != batches.end() && instances != nullptr;
+            WidgetBatchFunction batch = batched ? itr->second : nullptr;
+            if (!batched) instances = nullptr;
+
+            if (mRuns.empty() || mRuns.back().batch != batch || mRuns.back().instances != instances)
+            {
+                Run run;
+                run.batch = batch;
+                run.instances = instances;
+                run.begin = static_cast<uint32_t>(batched ? mRunSlots.size() : i);
+                run.count = 0;
+                mRuns.push_back(run);
+            }
+            if (batched) mRunSlots.push_back(widget->GetInstanceSlot());
+            mRuns.back().count++;
+        }
+        mRunsDirty = false;
+    }
+
+    void WidgetStore::GetFrustumPlanes(const mat4& viewProjection, vec4* planes)
+    {
+        // Rows of the matrix, combined as in Gribb and Hartmann
+        vec4 rows[4];
+        for (int i = 0; i < 4; i++)
+        {
+            rows[i] = vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            planes[i * 2]     = rows[3] + rows[i];
+            planes[i * 2 + 1] = rows[3] - rows[i];
+        }
+        for (int i = 0; i < 6; i++)
+        {
+            planes[i] /= glm::length(vec3(planes[i]));
+        }
+    }
+
+    void WidgetStore::DrawAll(const mat4& view, const mat4& projection)
+    {
+        if (mRunsDirty) BuildRuns();
+        {
+            TRACE_SCOPE("WidgetStore::Refresh");
+            SceneGraph& graph = mAppState->GetSceneGraph();
+            for (auto& instances : mInstances) instances.second->Refresh(graph);
+        }
+
+        vec4 frustum[6];
+        GetFrustumPlanes(projection * view, frustum);
+        mCulled = 0;
+
+        for (const Run& run : mRuns)
+        {
+            if (run.instances != nullptr) DrawBatch(run, frustum, view, projection);
+            else DrawEach(run, view, projection);
+        }
+    }
+
+    void WidgetStore::DrawBatch(const Run& run, const vec4* frustum, const mat4& view, const mat4& projection)
+    {
+        WidgetInstanceBuffer& instances = *run.instances;
+        uint32_t* slots = mAppState->GetFrameArena().AllocateArray<uint32_t>(run.count);
+        size_t count = 0;
+        const uint32_t* runSlots = mRunSlots.data() + run.begin;
+        for (uint32_t i = 0; i < run.count; i++)
+        {
+            uint32_t slot = runSlots[i];
+            if (!instances.GetVisible(slot)) continue;
+
+            // Negative radius: the type gave no bounds, so always drawn
+            const vec4& sphere = instances.GetWorldBounds(slot);
+            bool inside = true;
+            for (int p = 0; p < 6 && inside && sphere.w >= 0.0f; p++)
+            {
+                inside = glm::dot(vec3(frustum[p]), vec3(sphere)) + frustum[p].w >= -sphere.w;
+            }
+            if (!inside)
+            {
+                // Still takes in this frame's samples, which will not come again
+                instances.GetWidget(slot)->Update();
+                mCulled++;
+                continue;
+            }
+            slots[count++] = slot;
+        }
+        if (count == 0) return;
+
+        run.batch(instances, slots, count, view, projection);
+        GpuMemoryTracker& tracker = mAppState->GetGpuMemoryTracker();
+        for (size_t i = 0; i < count; i++) tracker.MarkDrawn(instances.GetWidget(slots[i]));
+    }
+
+    void WidgetStore::DrawEach(const Run& run, const mat4& view, const mat4& projection)
+    {
+        GpuMemoryTracker& tracker = mAppState->GetGpuMemoryTracker();
+        Widget* const* widgets = mWidgets.data() + run.begin;
+        for (uint32_t i = 0; i < run.count; i++)
+        {
+            if (!widgets[i]->GetVisible()) continue;
+            TRACE_SCOPE("Widget::Draw");
+            widgets[i]->Update();
+            widgets[i]->Draw(view, projection);
+            tracker.MarkDrawn(widgets[i]);
+        }
+    }
+
+    size_t WidgetStore::GetCount() const
+    {
+        return mWidgets.size();
+    }
+
+    size_t WidgetStore::GetRunCount()
+    {
+        if (mRunsDirty) BuildRuns();
+        return mRuns.size();
+    }
+
+    size_t WidgetStore::GetCulledCount() const
+    {
+        return mCulled;
+    }
+}
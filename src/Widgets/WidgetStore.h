@@ -0,0 +1,111 @@
+/*
+ * WidgetStore.h
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "WidgetInstanceBuffer.h"
+
+using glm::mat4;
+using glm::vec4;
+using std::map;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace octronic
+{
+    class AppState;
+    class Widget;
+
+    /**
+     * @brief Updates and draws count widgets of one type, given by their
+     * slots in the type's WidgetInstanceBuffer. All are visible and at
+     * least partly inside the view frustum.
+     */
+    typedef void (*WidgetBatchFunction)(WidgetInstanceBuffer& instances, const uint32_t* slots, size_t count,
+        const mat4& view, const mat4& projection);
+
+    /**
+     * @brief The Window's widgets, in draw order, split into runs of
+     * consecutive widgets that share a batch function, plus the packed
+     * per-type data of every widget type that keeps its draw state in a
+     * WidgetInstanceBuffer (see Widget::AttachInstance).
+     *
+     * Each frame DrawAll brings the buffers' world matrices up to date,
+     * then for each batched run gathers the slots that are visible and
+     * whose bounds reach into the view frustum, reading only the packed
+     * arrays, and hands them to the run's batch function in one call.
+     * Types without a batch function are updated and drawn one at a time.
+     * Draw order, and so blending, is unchanged. Widgets are added after
+     * their Init, once they have their slot.
+     */
+    class WidgetStore
+    {
+    public:
+        WidgetStore(AppState* state);
+
+        /** @brief Appends widget, unless it is already held. */
+        void Add(Widget* widget);
+        void Remove(Widget* widget);
+
+        /** @brief Updates and draws every visible widget. */
+        void DrawAll(const mat4& view, const mat4& projection);
+
+        size_t GetCount() const;
+        size_t GetRunCount();
+        /** @brief Widgets the last DrawAll skipped as outside the view. */
+        size_t GetCulledCount() const;
+
+        /**
+         * @brief The instance buffer of a widget type, created with stride
+         * vec4s per record by the first widget that asks for it.
+         */
+        WidgetInstanceBuffer& GetInstances(const string& type, size_t stride);
+
+        static void RegisterBatch(const string& type, WidgetBatchFunction batch);
+
+    protected:
+        struct Run
+        {
+            WidgetBatchFunction batch;
+            // Null for widgets drawn one at a time
+            WidgetInstanceBuffer* instances;
+            // Into mWidgets, or into mRunSlots for a batched run
+            uint32_t begin;
+            uint32_t count;
+        };
+
+        static map<string, WidgetBatchFunction>& GetBatchFunctions();
+        void BuildRuns();
+        void DrawEach(const Run& run, const mat4& view, const mat4& projection);
+        void DrawBatch(const Run& run, const vec4* frustum, const mat4& view, const mat4& projection);
+        static void GetFrustumPlanes(const mat4& viewProjection, vec4* planes);
+
+    private:
+        AppState* mAppState;
+        vector<Widget*> mWidgets;
+        vector<Run> mRuns;
+        vector<uint32_t> mRunSlots;
+        bool mRunsDirty;
+        size_t mCulled;
+        map<string, unique_ptr<WidgetInstanceBuffer>> mInstances;
+    };
+}
@@ -19,8 +19,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "AppState.h"
+#include "Assets/TextureContainer.h"
 #include "Widgets/Widget.h"
 #include "Common/Logger.h"
+#include "Common/ImageKernels.h"
+#include "Common/Tracer.h"
 
 using std::cout;
 using std::endl;
@@ -53,6 +56,7 @@ namespace octronic
         mWindowHeight(DEFAULT_WINDOW_HEIGHT),
         mName("PiDash"),
         mAppState(state),
+        mWidgets(state),
         mClearColor(0.5f,0.5f,0.5f),
         mCameraPosition(0.f,10.f,10.f),
         mCameraPitch(glm::radians(0.f)),
@@ -60,6 +64,7 @@ namespace octronic
         mUpVector(0.f,0.f,1.f),
         mViewMatrix(mat4(1.0f)),
         mProjectionMatrix(mat4(1.0f)),
+        mCameraVersion(1),
         mNearClip(.1f),
         mFarClip(1000.f),
         mProjectionType(Perspective)
@@ -85,6 +90,7 @@ namespace octronic
 
     bool Window::Update()
     {
+        TRACE_SCOPE("Window::Update");
         debug("Window: {}",__FUNCTION__);
 
         glfwPollEvents();
@@ -99,6 +105,7 @@ namespace octronic
             debug("Window: Size Changed to {}x{}",mWindowWidth,mWindowHeight);
             glfwGetFramebufferSize(mWindow, &mWindowWidth, &mWindowHeight);
             glViewport(0,0,mWindowWidth,mWindowHeight);
+            mCameraVersion++;
             WindowSizeChanged = false;
         }
 
@@ -117,6 +124,7 @@ namespace octronic
 
     bool Window::Init()
     {
+        TRACE_SCOPE("Window::Init");
         debug("Window: {}", __FUNCTION__);
         if (!InitGLFW()) return false;
         if (!InitGL())   return false;
@@ -127,6 +135,7 @@ namespace octronic
 
     bool Window::InitGLFW()
     {
+        TRACE_SCOPE("Window::InitGLFW");
         debug("Window: {}", __FUNCTION__);
         /* Initialize the library */
         if (!glfwInit())
@@ -159,6 +168,13 @@ namespace octronic
         glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
 #endif
 
+        // Benchmark runs render into a hidden window, unthrottled
+        bool headless = mAppState->HasArgument("--headless");
+        if (headless)
+        {
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        }
+
         debug("Window: {} passed set hints", __FUNCTION__);
 
         mWindow = glfwCreateWindow(mWindowWidth, mWindowHeight, mName.c_str(), nullptr,nullptr);
@@ -177,7 +193,7 @@ namespace octronic
 
         glfwSetErrorCallback(GlfwErrorCallback);
         glfwSetFramebufferSizeCallback(mWindow, FramebufferSizeCallback);
-        glfwSwapInterval(1);
+        glfwSwapInterval(headless ? 0 : 1);
 
 #ifdef __APPLE__
         glfwGetMonitorContentScale(glfwGetPrimaryMonitor(),&mDPIScaleX,&mDPIScaleY); //Requires GLFW >=3.3
@@ -192,6 +208,7 @@ namespace octronic
 
     bool Window::InitGL()
     {
+        TRACE_SCOPE("Window::InitGL");
         debug("Window: {}", __FUNCTION__);
         if(!gladLoadGL())
         {
@@ -204,6 +221,9 @@ namespace octronic
         debug("Window: OpenGL Version {}, Shader Version {}",
               glGetString(GL_VERSION),
               glGetString(GL_SHADING_LANGUAGE_VERSION));
+        debug("Window: Image kernels using {}", ImageKernels::GetInstructionSet());
+        // Loader threads check texture formats without a context
+        TextureContainer::QueryGLSupport();
 
         GLCheckError();
 
@@ -212,6 +232,7 @@ namespace octronic
 
     void Window::SwapBuffers()
     {
+        TRACE_SCOPE("Window::SwapBuffers");
         if (mWindow != nullptr)
         {
             glfwSwapBuffers(mWindow);
@@ -223,39 +244,30 @@ namespace octronic
     Window::DrawWidgets
     ()
     {
-        debug("Window: {}, {}", __FUNCTION__, mWidgets.size());
+        TRACE_SCOPE("Window::DrawWidgets");
+        debug("Window: {}, {}", __FUNCTION__, mWidgets.GetCount());
 
-        for (Widget* widget : mWidgets)
-        {
-            if(widget->GetVisible())
-            {
-                widget->Update();
-                widget->Draw(mViewMatrix, mProjectionMatrix);
-            }
-        }
+        mWidgets.DrawAll(mViewMatrix, mProjectionMatrix);
+
+        // Text queued by the widgets above goes out in one draw
+        mAppState->GetTextRenderer().Flush(mViewMatrix, mProjectionMatrix);
     }
 
     void Window::AddWidget (Widget* widget)
     {
         debug("Window: {}",__FUNCTION__);
-        auto end = mWidgets.end();
-        auto itr = find(mWidgets.begin(), end, widget);
-
-        if (itr == end)
-        {
-            mWidgets.push_back(widget);
-        }
+        mWidgets.Add(widget);
     }
 
     void Window::RemoveWidget(Widget* widget)
     {
         debug("Window: {}",__FUNCTION__);
-        auto end = mWidgets.end();
-        auto itr = find(mWidgets.begin(), end, widget);
-        if (itr != end)
-        {
-            mWidgets.erase(itr);
-        }
+        mWidgets.Remove(widget);
+    }
+
+    WidgetStore& Window::GetWidgetStore()
+    {
+        return mWidgets;
     }
 
     void Window::InitViewMatrix()
@@ -265,6 +277,7 @@ namespace octronic
 			vec3(0.f,0.f,0.f), // Centre
 			mUpVector          // probably glm::vec3(0,1,0), but (0,-1,0) would make you looking upside-down, which can be great too
 		);
+        mCameraVersion++;
     }
 
     void Window::InitProjectionMatrix()
@@ -286,6 +299,7 @@ namespace octronic
                             mNearClip, mFarClip);
                 break;
         }
+        mCameraVersion++;
     }
 
     mat4 Window::GetViewMatrix()
@@ -297,4 +311,19 @@ namespace octronic
     {
         return mProjectionMatrix;
     }
+
+    uint32_t Window::GetCameraVersion() const
+    {
+        return mCameraVersion;
+    }
+
+    int Window::GetWidth() const
+    {
+        return mWindowWidth;
+    }
+
+    int Window::GetHeight() const
+    {
+        return mWindowHeight;
+    }
 }
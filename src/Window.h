@@ -5,6 +5,7 @@
 #include <vector>
 #include <string>
 #include <glm/glm.hpp>
+#include "Widgets/WidgetStore.h"
 
 using glm::vec3;
 using glm::mat4;
@@ -39,6 +40,7 @@ namespace octronic
 
         void AddWidget(Widget* widget);
         void RemoveWidget(Widget* widget);
+        WidgetStore& GetWidgetStore();
 
         bool Init();
 
@@ -47,6 +49,15 @@ namespace octronic
         mat4 GetViewMatrix();
         mat4 GetProjectionMatrix();
 
+        int GetWidth() const;
+        int GetHeight() const;
+
+        /**
+         * @brief Changes whenever the view, projection or viewport does, so
+         * results derived from them can be cached against it.
+         */
+        uint32_t GetCameraVersion() const;
+
     protected:
         bool InitGLFW();
         bool InitGL();
@@ -58,7 +69,7 @@ namespace octronic
     private:
         AppState* mAppState;
         GLFWwindow* mWindow;
-        vector<Widget*> mWidgets;
+        WidgetStore mWidgets;
         int mWindowWidth;
         int mWindowHeight;
         float mDPIScaleX, mDPIScaleY;
@@ -70,6 +81,7 @@ namespace octronic
         vec3 mUpVector;
         mat4 mViewMatrix;
         mat4 mProjectionMatrix;
+        uint32_t mCameraVersion;
         ProjectionType mProjectionType;
         float mNearClip;
         float mFarClip;
@@ -0,0 +1,391 @@
+/*
+ * AssetPacker.cpp
+ *
+ * Builds a single-file resource pack (.pak) with a sorted index and aligned,
+ * optionally zlib-compressed payloads.
+ *
+ * Usage: AssetPacker [--compress] <output.pak> --root <dir> <name>... [--root <dir> <name>...]
+ *
+ * Each name is stored as given and read from <dir>/<name>. Compressed entries
+ * are only kept when they save at least 10%, so already-compressed formats
+ * such as PNG stay zero-copy. Every compressed entry is inflated again with
+ * the runtime's decoder and compared with its source before it is written,
+ * so a pack that builds is a pack that reads back.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Assets/AssetPackFormat.h"
+#include "stb_image_aug.h"
+
+using std::string;
+using std::vector;
+using namespace octronic;
+
+struct PackInput
+{
+    string name;
+    string path;
+    vector<uint8_t> data;
+    uint32_t flags;
+    uint64_t originalSize;
+};
+
+// Deflate ######################################################################
+
+/**
+ * Minimal zlib encoder: greedy LZ77 over a 32K window with hash chains,
+ * emitted as a single fixed-Huffman block. Decoded at runtime by stb_image's
+ * zlib inflater.
+ */
+class DeflateWriter
+{
+public:
+    DeflateWriter(vector<uint8_t>& out) : mOut(out), mBits(0), mBitCount(0) {}
+
+    void WriteBits(uint32_t value, int count)
+    {
+        mBits |= value << mBitCount;
+        mBitCount += count;
+        while (mBitCount >= 8)
+        {
+            mOut.push_back(static_cast<uint8_t>(mBits));
+            mBits >>= 8;
+            mBitCount -= 8;
+        }
+    }
+
+    // Huffman codes are packed most significant bit first
+    void WriteCode(uint32_t code, int length)
+    {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; i++)
+        {
+            reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+        WriteBits(reversed, length);
+    }
+
+    void WriteLiteral(int symbol)
+    {
+        if (symbol < 144)      WriteCode(0x30 + symbol, 8);
+        else if (symbol < 256) WriteCode(0x190 + symbol - 144, 9);
+        else if (symbol < 280) WriteCode(symbol - 256, 7);
+        else                   WriteCode(0xC0 + symbol - 280, 8);
+    }
+
+    void WriteMatch(int length, int distance)
+    {
+        static const int lengthBase[] = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,
+            35,43,51,59,67,83,99,115,131,163,195,227,258};
+        static const int lengthExtra[] = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,
+            3,3,3,3,4,4,4,4,5,5,5,5,0};
+        static const int distBase[] = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,
+            257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+        static const int distExtra[] = {0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,
+            7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+
+        int l = 28;
+        while (lengthBase[l] > length) l--;
+        WriteLiteral(257 + l);
+        WriteBits(length - lengthBase[l], lengthExtra[l]);
+
+        int d = 29;
+        while (distBase[d] > distance) d--;
+        WriteCode(d, 5);
+        WriteBits(distance - distBase[d], distExtra[d]);
+    }
+
+    void Flush()
+    {
+        if (mBitCount > 0) WriteBits(0, 8 - mBitCount);
+    }
+
+private:
+    vector<uint8_t>& mOut;
+    uint32_t mBits;
+    int mBitCount;
+};
+
+static vector<uint8_t> ZlibCompress(const vector<uint8_t>& in)
+{
+    const int windowSize = 32768;
+    const int hashSize = 1 << 15;
+    const int maxChain = 64;
+    const int minMatch = 3;
+    const int maxMatch = 258;
+
+    vector<uint8_t> out;
+    out.push_back(0x78);
+    out.push_back(0x01);
+
+    DeflateWriter writer(out);
+    writer.WriteBits(1, 1); // BFINAL
+    writer.WriteBits(1, 2); // BTYPE fixed Huffman
+
+    vector<int> head(hashSize, -1);
+    vector<int> prev(in.size(), -1);
+    auto hash = [&in](size_t i)
+    {
+        return ((in[i] << 10) ^ (in[i + 1] << 5) ^ in[i + 2]) & (hashSize - 1);
+    };
+
+    size_t i = 0;
+    const size_t n = in.size();
+    while (i < n)
+    {
+        int bestLength = 0;
+        int bestDistance = 0;
+
+        if (i + minMatch <= n)
+        {
+            int h = hash(i);
+            int candidate = head[h];
+            int chain = 0;
+            int limit = static_cast<int>(std::min<size_t>(maxMatch, n - i));
+            while (candidate >= 0 && static_cast<int>(i) - candidate <= windowSize && chain++ < maxChain)
+            {
+                int length = 0;
+                while (length < limit && in[candidate + length] == in[i + length]) length++;
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestDistance = static_cast<int>(i) - candidate;
+                    if (length == limit) break;
+                }
+                candidate = prev[candidate];
+            }
+        }
+
+        size_t advance = bestLength >= minMatch ? bestLength : 1;
+        if (bestLength >= minMatch)
+        {
+            writer.WriteMatch(bestLength, bestDistance);
+        }
+        else
+        {
+            writer.WriteLiteral(in[i]);
+        }
+
+        for (size_t j = 0; j < advance; j++, i++)
+        {
+            if (i + minMatch <= n)
+            {
+                int h = hash(i);
+                prev[i] = head[h];
+                head[h] = static_cast<int>(i);
+            }
+        }
+    }
+
+    writer.WriteLiteral(256);
+    writer.Flush();
+
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : in)
+    {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    uint32_t adler = (b << 16) | a;
+    out.push_back(static_cast<uint8_t>(adler >> 24));
+    out.push_back(static_cast<uint8_t>(adler >> 16));
+    out.push_back(static_cast<uint8_t>(adler >> 8));
+    out.push_back(static_cast<uint8_t>(adler));
+    return out;
+}
+
+/**
+ * Inflates a compressed entry as AssetPack does and checks it against the
+ * source bytes.
+ */
+static bool InflatesTo(const vector<uint8_t>& deflated, const vector<uint8_t>& original)
+{
+    vector<uint8_t> inflated(original.size());
+    int length = stbi_zlib_decode_buffer(
+        reinterpret_cast<char*>(inflated.data()), static_cast<int>(inflated.size()),
+        reinterpret_cast<const char*>(deflated.data()), static_cast<int>(deflated.size()));
+    return length == static_cast<int>(original.size()) && inflated == original;
+}
+
+// Packing ######################################################################
+
+static bool ReadFile(const string& path, vector<uint8_t>& data)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data.resize(size > 0 ? size : 0);
+    size_t read = data.empty() ? 0 : fread(data.data(), 1, data.size(), file);
+    fclose(file);
+    return read == data.size();
+}
+
+static uint64_t Align(uint64_t value)
+{
+    return (value + ASSET_PACK_ALIGNMENT - 1) & ~uint64_t(ASSET_PACK_ALIGNMENT - 1);
+}
+
+static void PrintUsage()
+{
+    fprintf(stderr, "Usage: AssetPacker [--compress] <output.pak> --root <dir> <name>...\n");
+}
+
+int main(int argc, char** argv)
+{
+    bool compress = false;
+    string outputPath;
+    string root;
+    vector<PackInput> inputs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--compress")
+        {
+            compress = true;
+        }
+        else if (arg == "--root" && i + 1 < argc)
+        {
+            root = argv[++i];
+        }
+        else if (outputPath.empty())
+        {
+            outputPath = arg;
+        }
+        else
+        {
+            PackInput input;
+            input.name = arg;
+            input.path = root.empty() ? arg : root + "/" + arg;
+            input.flags = 0;
+            input.originalSize = 0;
+            inputs.push_back(input);
+        }
+    }
+
+    if (outputPath.empty() || inputs.empty())
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    std::sort(inputs.begin(), inputs.end(),
+        [](const PackInput& a, const PackInput& b) { return a.name < b.name; });
+
+    for (size_t i = 1; i < inputs.size(); i++)
+    {
+        if (inputs[i].name == inputs[i - 1].name)
+        {
+            fprintf(stderr, "AssetPacker: Duplicate entry %s\n", inputs[i].name.c_str());
+            return 1;
+        }
+    }
+
+    string strings;
+    uint64_t storedTotal = 0, originalTotal = 0;
+    for (PackInput& input : inputs)
+    {
+        if (!ReadFile(input.path, input.data))
+        {
+            fprintf(stderr, "AssetPacker: Unable to read %s\n", input.path.c_str());
+            return 1;
+        }
+        input.originalSize = input.data.size();
+        if (input.originalSize > ASSET_PACK_MAX_ENTRY_SIZE)
+        {
+            fprintf(stderr, "AssetPacker: %s is larger than %d bytes\n", input.path.c_str(),
+                ASSET_PACK_MAX_ENTRY_SIZE);
+            return 1;
+        }
+
+        if (compress && !input.data.empty())
+        {
+            vector<uint8_t> deflated = ZlibCompress(input.data);
+            if (deflated.size() * 10 < input.data.size() * 9)
+            {
+                if (!InflatesTo(deflated, input.data))
+                {
+                    fprintf(stderr, "AssetPacker: %s does not survive a round trip through zlib\n",
+                        input.name.c_str());
+                    return 1;
+                }
+                input.data.swap(deflated);
+                input.flags |= AssetPackEntry_Compressed;
+            }
+        }
+        storedTotal += input.data.size();
+        originalTotal += input.originalSize;
+    }
+
+    AssetPackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ASSET_PACK_MAGIC, 4);
+    header.version = ASSET_PACK_VERSION;
+    header.entryCount = static_cast<uint32_t>(inputs.size());
+    header.stringTableOffset = sizeof(header) + inputs.size() * sizeof(AssetPackEntry);
+
+    vector<AssetPackEntry> index(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        memset(&index[i], 0, sizeof(AssetPackEntry));
+        index[i].nameOffset = static_cast<uint32_t>(strings.size());
+        index[i].nameLength = static_cast<uint32_t>(inputs[i].name.size());
+        strings += inputs[i].name;
+    }
+    header.stringTableSize = strings.size();
+
+    uint64_t offset = header.stringTableOffset + header.stringTableSize;
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        offset = Align(offset);
+        index[i].flags = inputs[i].flags;
+        index[i].offset = offset;
+        index[i].size = inputs[i].data.size();
+        index[i].originalSize = inputs[i].originalSize;
+        offset += index[i].size;
+    }
+
+    FILE* out = fopen(outputPath.c_str(), "wb");
+    if (out == nullptr)
+    {
+        fprintf(stderr, "AssetPacker: Unable to open %s for writing\n", outputPath.c_str());
+        return 1;
+    }
+
+    static const uint8_t padding[ASSET_PACK_ALIGNMENT] = {0};
+    uint64_t written = 0;
+    written += fwrite(&header, 1, sizeof(header), out);
+    written += fwrite(index.data(), 1, index.size() * sizeof(AssetPackEntry), out);
+    written += fwrite(strings.data(), 1, strings.size(), out);
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        written += fwrite(padding, 1, static_cast<size_t>(index[i].offset - written), out);
+        written += fwrite(inputs[i].data.data(), 1, inputs[i].data.size(), out);
+    }
+    fclose(out);
+
+    if (written != offset)
+    {
+        fprintf(stderr, "AssetPacker: Short write to %s\n", outputPath.c_str());
+        return 1;
+    }
+
+    printf("AssetPacker: %s, %zu entries, %llu of %llu bytes stored\n",
+        outputPath.c_str(), inputs.size(),
+        static_cast<unsigned long long>(storedTotal),
+        static_cast<unsigned long long>(originalTotal));
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * BenchDashboard.cpp
+ *
+ * Writes a large dashboard and a channel recording to drive it, for
+ * headless frame time and allocation runs of the widget store.
+ *
+ * Usage: BenchDashboard [--widgets 10000] [--channels 64] [--layout grouped]
+ *                       [--spread 1.0] [--seconds 10] [--rate 1000]
+ *                       <dashboard.json> [recording.pdrec]
+ *
+ * The widgets are Image, StripChart, TrendChart and Text in equal numbers,
+ * laid out on a square grid facing the default camera and bound round
+ * robin to --channels channels ("Bench<n>"). --layout grouped puts each
+ * type in one run; interleaved alternates types widget by widget, so
+ * every run of the store holds a single widget. --spread multiplies the
+ * grid spacing, so a larger spread pushes part of the grid outside the
+ * view, where it is culled. The recording holds --seconds of --rate samples per
+ * second on every channel, a sine per channel with a little noise. It
+ * only depends on --channels, --seconds and --rate, so dashboards that
+ * share those can share one recording. The BenchDashboards target writes
+ * the 10,000 widget layouts Dashboards/Bench10k.json, Bench10kSpread.json
+ * and Bench10kInterleaved.json, and Bench.pdrec.
+ *
+ * From the build directory:
+ *
+ *     ./GLFWSkeleton --dashboard Dashboards/Bench10k.json --no-dashboard-snapshot \
+ *         --replay Bench.pdrec --replay-speed 0 --headless
+ *
+ * The run ends with the recording and logs its frame times. Built with
+ * COUNT_ALLOCATIONS on, it also logs the last frame in which the render
+ * thread allocated, which stays well short of the final frame once
+ * steady state is reached. The same files drive any earlier build that
+ * loads JSON dashboards and replays recordings.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <json.hh>
+
+#include "Data/ChannelRegistry.h"
+#include "Data/DataChannel.h"
+#include "Data/Recorder.h"
+#include "Data/ReplayDriver.h"
+
+using nlohmann::json;
+using std::string;
+using std::vector;
+using namespace octronic;
+
+#define BENCH_WIDGET_TYPES 4
+// Grid cell, in world units, sized so 100 x 100 cells fill the default view
+#define BENCH_CELL_SIZE 0.08f
+
+struct BenchOptions
+{
+    int widgets = 10000;
+    int channels = 64;
+    bool interleaved = false;
+    float spread = 1.0f;
+    double seconds = 10.0;
+    double rate = 1000.0;
+    string dashboardPath;
+    string recordingPath;
+};
+
+static string ChannelName(int channel)
+{
+    return "Bench" + std::to_string(channel);
+}
+
+static json Position(float x, float y)
+{
+    return json::array({ x, y, 0.0f });
+}
+
+static json Scale(float scale)
+{
+    return json::array({ scale, scale, scale });
+}
+
+static json MakeWidget(int type, int channel, float x, float y)
+{
+    json widget;
+    widget["channel"] = ChannelName(channel);
+    widget["position"] = Position(x, y);
+    switch (type)
+    {
+        case 0:
+            // Images are drawn on a 2 x 2 unit quad
+            widget["type"] = "Image";
+            widget["image"] = "Images/Gauge/Needle.png";
+            widget["valueRotation"] = json::array({ 0.0f, 100.0f, 120.0f, -120.0f });
+            widget["scale"] = Scale(BENCH_CELL_SIZE * 0.4f);
+            break;
+        case 1:
+            widget["type"] = "StripChart";
+            widget["windowSeconds"] = 5.0f;
+            widget["capacity"] = 1024;
+            widget["valueRange"] = json::array({ 0.0f, 100.0f });
+            widget["scale"] = Scale(BENCH_CELL_SIZE * 0.3f);
+            break;
+        case 2:
+            widget["type"] = "TrendChart";
+            widget["windowSeconds"] = 10.0f;
+            widget["pointCount"] = 128;
+            widget["valueRange"] = json::array({ 0.0f, 100.0f });
+            widget["scale"] = Scale(BENCH_CELL_SIZE * 0.3f);
+            break;
+        default:
+            widget["type"] = "Text";
+            widget["valueFormat"] = "%.1f";
+            widget["scale"] = Scale(BENCH_CELL_SIZE);
+            break;
+    }
+    return widget;
+}
+
+static bool WriteDashboard(const BenchOptions& options)
+{
+    int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(options.widgets))));
+    float spacing = BENCH_CELL_SIZE * options.spread;
+    float origin = -0.5f * spacing * (columns - 1);
+    int perType = (options.widgets + BENCH_WIDGET_TYPES - 1) / BENCH_WIDGET_TYPES;
+
+    json widgets = json::array();
+    for (int i = 0; i < options.widgets; i++)
+    {
+        int type = options.interleaved ? i % BENCH_WIDGET_TYPES : i / perType;
+        float x = origin + spacing * (i % columns);
+        float y = origin + spacing * (i / columns);
+        widgets.push_back(MakeWidget(type, i % options.channels, x, y));
+    }
+
+    json dashboard;
+    dashboard["widgets"] = widgets;
+    std::ofstream file(options.dashboardPath.c_str());
+    file << dashboard.dump(1) << '\n';
+    return file.good();
+}
+
+// Records the samples through the dashboard's own Recorder, one replay
+// frame at a time
+static bool WriteRecording(const BenchOptions& options)
+{
+    ChannelRegistry registry;
+    vector<DataChannel*> channels;
+    for (int c = 0; c < options.channels; c++)
+    {
+        channels.push_back(registry.Create(ChannelName(c), DataChannel_SingleProducer));
+    }
+
+    Recorder recorder;
+    if (!recorder.Start(options.recordingPath, registry)) return false;
+
+    std::mt19937 rng(1);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    double frame = REPLAY_FAST_FRAME_STEP;
+    uint64_t total = static_cast<uint64_t>(options.seconds * options.rate);
+    uint64_t sample = 0;
+    for (double end = frame; sample < total; end += frame)
+    {
+        for (; sample < total && sample / options.rate < end; sample++)
+        {
+            double t = sample / options.rate;
+            for (int c = 0; c < options.channels; c++)
+            {
+                float value = 50.0f + 40.0f * static_cast<float>(std::sin(t * (0.5 + 0.05 * c))) + noise(rng);
+                channels[c]->Push(t, value);
+            }
+        }
+        registry.DrainAll();
+        recorder.Capture(registry);
+    }
+    recorder.Stop();
+    return recorder.GetSampleCount() == total * static_cast<uint64_t>(options.channels);
+}
+
+static void PrintUsage(const char* name)
+{
+    fprintf(stderr, "Usage: %s [--widgets n] [--channels n] [--layout grouped|interleaved] [--spread f]\n"
+        "       [--seconds s] [--rate hz] <dashboard.json> [recording.pdrec]\n", name);
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    vector<string> paths;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--widgets" && hasValue)       options.widgets = atoi(argv[++i]);
+        else if (arg == "--channels" && hasValue) options.channels = atoi(argv[++i]);
+        else if (arg == "--layout" && hasValue)   options.interleaved = string(argv[++i]) == "interleaved";
+        else if (arg == "--spread" && hasValue)   options.spread = static_cast<float>(atof(argv[++i]));
+        else if (arg == "--seconds" && hasValue)  options.seconds = atof(argv[++i]);
+        else if (arg == "--rate" && hasValue)     options.rate = atof(argv[++i]);
+        else if (arg.compare(0, 2, "--") != 0)    paths.push_back(arg);
+        else
+        {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Samples per channel per frame must fit the default channel ring
+    if (paths.empty() || paths.size() > 2 || options.widgets < 1 || options.spread <= 0.0f || options.seconds <= 0.0 ||
+        options.channels < 1 || options.channels > CHANNEL_REGISTRY_MAX_CHANNELS ||
+        options.rate <= 0.0 || options.rate * REPLAY_FAST_FRAME_STEP > DATA_CHANNEL_DEFAULT_CAPACITY)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    options.dashboardPath = paths[0];
+    if (paths.size() > 1) options.recordingPath = paths[1];
+
+    if (!WriteDashboard(options))
+    {
+        fprintf(stderr, "Unable to write %s\n", options.dashboardPath.c_str());
+        return 1;
+    }
+    printf("BenchDashboard: %d widgets (%s) on %d channels -> %s\n", options.widgets,
+        options.interleaved ? "interleaved" : "grouped", options.channels, options.dashboardPath.c_str());
+    if (options.recordingPath.empty()) return 0;
+
+    if (!WriteRecording(options))
+    {
+        fprintf(stderr, "Unable to write %s\n", options.recordingPath.c_str());
+        return 1;
+    }
+    printf("BenchDashboard: %.0f s at %.0f Hz -> %s\n", options.seconds, options.rate,
+        options.recordingPath.c_str());
+    return 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * FileReadBench.cpp
+ *
+ * Compares the read paths of Coconut::File (Common/File.h): the mapped
+ * view, the single-allocation ReadString/ReadBinary, and the stream-based
+ * reads they replaced.
+ *
+ * Usage: FileReadBench [--path file] [--size-mb 64] [--runs 5]
+ *
+ * Without --path a text file of --size-mb is written to the working
+ * directory and removed afterwards. Every method also sums the bytes it
+ * read, so the mapped view pays for faulting its pages in. Runs after the
+ * first hit the page cache, so the best run measures copy and allocation
+ * overhead rather than the disk.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Common/File.h"
+
+using std::string;
+using std::vector;
+using Coconut::File;
+using Coconut::MappedFile;
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchOptions
+{
+    string path;
+    int sizeMb = 64;
+    int runs = 5;
+};
+
+// The reads File used before it was given single-allocation reads
+
+static string LegacyReadString(const string& path)
+{
+    std::ifstream inputStream(path.c_str(), std::ifstream::in);
+    std::stringstream stringStream;
+    string line;
+    while (getline(inputStream, line))
+    {
+        stringStream << line << '\n';
+    }
+    return stringStream.str();
+}
+
+static vector<char> LegacyReadBinary(const string& path)
+{
+    std::ifstream inputStream(path.c_str(), std::ios::binary);
+    return vector<char>(
+        (std::istreambuf_iterator<char>(inputStream)),
+        (std::istreambuf_iterator<char>()));
+}
+
+static uint64_t Sum(const char* data, size_t size)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; i++) sum += static_cast<uint8_t>(data[i]);
+    return sum;
+}
+
+static bool WriteTestFile(const string& path, size_t size)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+    char line[64];
+    size_t written = 0;
+    for (unsigned i = 0; written < size; i++)
+    {
+        int length = snprintf(line, sizeof(line), "sample,%u,%.4f\n", i, (i % 1000) * 0.125);
+        written += fwrite(line, 1, static_cast<size_t>(length), file);
+    }
+    fclose(file);
+    return true;
+}
+
+template<typename Read>
+static void Measure(const char* name, const BenchOptions& options, size_t size, Read read)
+{
+    double best = 0.0;
+    uint64_t sum = 0;
+    for (int run = 0; run < options.runs; run++)
+    {
+        Clock::time_point start = Clock::now();
+        sum = read();
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (run == 0 || elapsed < best) best = elapsed;
+    }
+    printf("%-24s %8.2f ms %10.1f MB/s  (sum %llu)\n", name, best * 1000.0,
+        size / best / (1024.0 * 1024.0), static_cast<unsigned long long>(sum));
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--path" && hasValue)         options.path = argv[++i];
+        else if (arg == "--size-mb" && hasValue) options.sizeMb = atoi(argv[++i]);
+        else if (arg == "--runs" && hasValue)    options.runs = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--path file] [--size-mb n] [--runs n]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.sizeMb < 1 || options.runs < 1)
+    {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+
+    bool generated = options.path.empty();
+    if (generated)
+    {
+        options.path = "FileReadBench.tmp";
+        if (!WriteTestFile(options.path, static_cast<size_t>(options.sizeMb) * 1024 * 1024))
+        {
+            fprintf(stderr, "Unable to write %s\n", options.path.c_str());
+            return 1;
+        }
+    }
+
+    File file(options.path);
+    size_t size = static_cast<size_t>(file.GetFileSize());
+    printf("%s: %zu bytes, best of %d runs\n", options.path.c_str(), size, options.runs);
+
+    Measure("File::Map", options, size, [&file]()
+    {
+        MappedFile mapped = file.Map();
+        return Sum(reinterpret_cast<const char*>(mapped.Data()), mapped.Size());
+    });
+    Measure("File::ReadBinary", options, size, [&file]()
+    {
+        vector<char> data = file.ReadBinary();
+        return Sum(data.data(), data.size());
+    });
+    Measure("File::ReadString", options, size, [&file]()
+    {
+        string data = file.ReadString();
+        return Sum(data.data(), data.size());
+    });
+    Measure("istreambuf_iterator", options, size, [&options]()
+    {
+        vector<char> data = LegacyReadBinary(options.path);
+        return Sum(data.data(), data.size());
+    });
+    Measure("getline/stringstream", options, size, [&options]()
+    {
+        string data = LegacyReadString(options.path);
+        return Sum(data.data(), data.size());
+    });
+
+    if (generated) file.DeleteFile();
+    return 0;
+}
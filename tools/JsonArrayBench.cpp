@@ -0,0 +1,224 @@
+/*
+ * JsonArrayBench.cpp
+ *
+ * Round-trips a Widget3D vertex buffer through every bulk float encoding
+ * of JsonSerialization (Common/JsonSerialization.h) and through
+ * JsonFloatArrayReader, checking the result and timing each path.
+ *
+ * Usage: JsonArrayBench [--vertices 100000] [--runs 5]
+ *
+ * Every round trip must give back the buffer bit for bit, and the base64
+ * and CBOR encodings of known floats must match their little-endian bytes,
+ * so the check also holds the wire format on big-endian hosts. Exits
+ * non-zero on any failure. Timings only mean something in an optimised
+ * build (CMAKE_BUILD_TYPE=Release).
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/JsonFloatArrayReader.h"
+#include "Common/JsonSerialization.h"
+#include "Widgets/Widget3D.h"
+
+using std::function;
+using std::string;
+using std::vector;
+using namespace octronic;
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchOptions
+{
+    size_t vertices = 100000;
+    int runs = 5;
+};
+
+/**
+ * Encodes in to its wire form and decodes it into out, which holds as many
+ * vertices as in. Returns false if decoding fails; sets the encoded size.
+ */
+struct RoundTrip
+{
+    const char* name;
+    function<bool(const vector<WidgetVertex>& in, vector<WidgetVertex>& out, size_t& encodedSize)> run;
+};
+
+static json Document(const vector<WidgetVertex>& vertices, JsonArrayEncoding encoding)
+{
+    json document;
+    document["type"] = "Grid";
+    document["vertices"] = JsonSerialization::ArrayToJson(vertices, encoding);
+    return document;
+}
+
+static bool ReadWithSax(const string& text, vector<WidgetVertex>& out)
+{
+    return JsonFloatArrayReader::Read(reinterpret_cast<const uint8_t*>(text.data()), text.size(),
+        "vertices", out);
+}
+
+static bool CheckWireFormat()
+{
+    // 1.0f and -2.0f as little-endian IEEE 754
+    const float values[2] = { 1.0f, -2.0f };
+    const uint8_t little[8] = { 0x00, 0x00, 0x80, 0x3f, 0x00, 0x00, 0x00, 0xc0 };
+    bool passed = true;
+
+    json encoded = JsonSerialization::FloatsToJson(values, 2);
+    if (encoded["data"].get<string>() != "AACAPwAAAMA=")
+    {
+        fprintf(stderr, "base64 encodes 1, -2 as %s, expected AACAPwAAAMA=\n", encoded["data"].get<string>().c_str());
+        passed = false;
+    }
+
+    vector<uint8_t> cbor;
+    JsonSerialization::FloatsToCbor(values, 2, cbor);
+    if (cbor.size() != 11 || memcmp(&cbor[3], little, sizeof(little)) != 0)
+    {
+        fprintf(stderr, "CBOR typed array of 1, -2 is not little-endian\n");
+        passed = false;
+    }
+
+    float decoded[2] = { 0.0f, 0.0f };
+    size_t count = 0;
+    if (!JsonSerialization::JsonToFloats(encoded, decoded, 2, count) || count != 2 ||
+        decoded[0] != 1.0f || decoded[1] != -2.0f)
+    {
+        fprintf(stderr, "base64 AACAPwAAAMA= does not decode to 1, -2\n");
+        passed = false;
+    }
+    return passed;
+}
+
+static bool Measure(const RoundTrip& roundTrip, const vector<WidgetVertex>& in, int runs)
+{
+    vector<WidgetVertex> out(in.size());
+    double best = 0.0;
+    size_t encodedSize = 0;
+    for (int run = 0; run < runs; run++)
+    {
+        out.assign(in.size(), WidgetVertex());
+        Clock::time_point start = Clock::now();
+        bool decoded = roundTrip.run(in, out, encodedSize);
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (!decoded || out.size() != in.size() ||
+            memcmp(out.data(), in.data(), in.size() * sizeof(WidgetVertex)) != 0)
+        {
+            fprintf(stderr, "%s: round trip does not reproduce the vertex buffer\n", roundTrip.name);
+            return false;
+        }
+        if (run == 0 || elapsed < best) best = elapsed;
+    }
+
+    double megabytes = in.size() * sizeof(WidgetVertex) / (1024.0 * 1024.0);
+    printf("%-14s %9.2f ms %9.1f MB/s %10zu bytes\n", roundTrip.name, best * 1000.0,
+        megabytes / best, encodedSize);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--vertices" && hasValue) options.vertices = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--runs" && hasValue) options.runs = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--vertices n] [--runs n]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.vertices < 1 || options.runs < 1)
+    {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> colour(0.0f, 1.0f);
+    vector<WidgetVertex> vertices(options.vertices);
+    for (WidgetVertex& vertex : vertices)
+    {
+        vertex.Position = vec3(position(rng), position(rng), position(rng));
+        vertex.Color = vec3(colour(rng), colour(rng), colour(rng));
+    }
+
+    vector<RoundTrip> roundTrips =
+    {
+        { "numbers", [](const vector<WidgetVertex>& in, vector<WidgetVertex>& out, size_t& encodedSize)
+            {
+                string text = Document(in, JsonArray_Numbers).dump();
+                encodedSize = text.size();
+                return JsonSerialization::JsonToArray(json::parse(text)["vertices"], out);
+            } },
+        { "numbers SAX", [](const vector<WidgetVertex>& in, vector<WidgetVertex>& out, size_t& encodedSize)
+            {
+                string text = Document(in, JsonArray_Numbers).dump();
+                encodedSize = text.size();
+                return ReadWithSax(text, out);
+            } },
+        { "base64", [](const vector<WidgetVertex>& in, vector<WidgetVertex>& out, size_t& encodedSize)
+            {
+                string text = Document(in, JsonArray_Base64).dump();
+                encodedSize = text.size();
+                return JsonSerialization::JsonToArray(json::parse(text)["vertices"], out);
+            } },
+        { "base64 SAX", [](const vector<WidgetVertex>& in, vector<WidgetVertex>& out, size_t& encodedSize)
+            {
+                string text = Document(in, JsonArray_Base64).dump();
+                encodedSize = text.size();
+                return ReadWithSax(text, out);
+            } },
+        { "CBOR base64", [](const vector<WidgetVertex>& in, vector<WidgetVertex>& out, size_t& encodedSize)
+            {
+                vector<uint8_t> cbor = json::to_cbor(Document(in, JsonArray_Base64));
+                encodedSize = cbor.size();
+                JsonFloatArrayReader reader("vertices", reinterpret_cast<float*>(out.data()), out.size() * 6);
+                return reader.ReadCbor(cbor.data(), cbor.size()) && reader.GetCount() == out.size() * 6;
+            } },
+        { "CBOR typed", [](const vector<WidgetVertex>& in, vector<WidgetVertex>& out, size_t& encodedSize)
+            {
+                vector<uint8_t> cbor;
+                JsonSerialization::FloatsToCbor(reinterpret_cast<const float*>(in.data()), in.size() * 6, cbor);
+                encodedSize = cbor.size();
+                vector<float> floats;
+                if (!JsonSerialization::CborToFloats(cbor.data(), cbor.size(), floats) ||
+                    floats.size() != out.size() * 6)
+                {
+                    return false;
+                }
+                memcpy(out.data(), floats.data(), floats.size() * sizeof(float));
+                return true;
+            } }
+    };
+
+    printf("%zu vertices (%zu bytes), best of %d runs\n", vertices.size(),
+        vertices.size() * sizeof(WidgetVertex), options.runs);
+
+    bool passed = CheckWireFormat();
+    for (const RoundTrip& roundTrip : roundTrips)
+    {
+        passed &= Measure(roundTrip, vertices, options.runs);
+    }
+
+    printf("%s\n", passed ? "All round trips match" : "MISMATCH");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+/*
+ * LttbBench.cpp
+ *
+ * Measures Lttb (Data/Lttb.h) throughput in input samples per second, on
+ * one thread and spread over worker threads with Lttb::DownsampleAll.
+ *
+ * Usage: LttbBench [--samples 1000000,10000000,100000000] [--channels 8]
+ *                  [--target 1920] [--threads 0] [--runs 3]
+ *
+ * Each --samples total is split evenly over --channels series of a noisy
+ * sine, and every series is downsampled to --target points, as a chart
+ * redraw of that many channels would be. --threads 0 uses one per hardware
+ * thread. The threaded outputs must match the single-threaded ones; exits
+ * non-zero if they do not. 100M samples needs about 1.6GB. Timings only mean
+ * something in an optimised build (CMAKE_BUILD_TYPE=Release).
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Data/Lttb.h"
+
+using std::string;
+using std::vector;
+using namespace octronic;
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchOptions
+{
+    vector<size_t> samples = { 1000000, 10000000, 100000000 };
+    size_t channels = 8;
+    size_t target = 1920;
+    unsigned threads = 0;
+    int runs = 3;
+};
+
+static bool ParseSamples(const char* list, vector<size_t>& samples)
+{
+    samples.clear();
+    for (const char* p = list; *p != '\0'; )
+    {
+        char* end = nullptr;
+        unsigned long long value = strtoull(p, &end, 10);
+        if (end == p || value == 0) return false;
+        if (*end != ',' && *end != '\0') return false;
+        samples.push_back(static_cast<size_t>(value));
+        p = *end == ',' ? end + 1 : end;
+    }
+    return !samples.empty();
+}
+
+static void FillSeries(DataSample* samples, size_t count, std::mt19937& rng)
+{
+    std::normal_distribution<float> noise(0.0f, 0.05f);
+    for (size_t i = 0; i < count; i++)
+    {
+        samples[i].timestamp = i * 0.001;
+        samples[i].value = std::sin(i * 0.0005f) + noise(rng);
+        samples[i].reserved = 0;
+    }
+}
+
+static double TimeBest(const vector<LttbJob>& jobs, unsigned threads, int runs)
+{
+    double best = 0.0;
+    for (int run = 0; run < runs; run++)
+    {
+        Clock::time_point start = Clock::now();
+        Lttb::DownsampleAll(jobs, threads);
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (run == 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+static bool SameOutput(const vector<DataSample>& a, const vector<DataSample>& b)
+{
+    return a.size() == b.size() &&
+        (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(DataSample)) == 0);
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        bool valid = true;
+        if (arg == "--samples" && hasValue)       valid = ParseSamples(argv[++i], options.samples);
+        else if (arg == "--channels" && hasValue) options.channels = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--target" && hasValue)   options.target = strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && hasValue)  options.threads = static_cast<unsigned>(atoi(argv[++i]));
+        else if (arg == "--runs" && hasValue)     options.runs = atoi(argv[++i]);
+        else valid = false;
+
+        if (!valid)
+        {
+            fprintf(stderr, "Usage: %s [--samples n,n,...] [--channels n] [--target n] [--threads n] [--runs n]\n",
+                argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.channels < 1 || options.target < 3 || options.runs < 1)
+    {
+        fprintf(stderr, "Invalid options\n");
+        return 1;
+    }
+
+    unsigned threads = options.threads > 0 ? options.threads :
+        std::max(1u, std::thread::hardware_concurrency());
+    printf("%zu channels to %zu points, best of %d runs, %u threads\n",
+        options.channels, options.target, options.runs, threads);
+    printf("%12s %16s %16s %8s\n", "samples", "1 thread", "DownsampleAll", "speedup");
+
+    std::mt19937 rng(1);
+    bool passed = true;
+    for (size_t total : options.samples)
+    {
+        size_t perChannel = total / options.channels;
+        if (perChannel < options.target)
+        {
+            fprintf(stderr, "%zu samples is fewer than --target per channel, skipping\n", total);
+            continue;
+        }
+
+        vector<DataSample> samples(perChannel * options.channels);
+        for (size_t c = 0; c < options.channels; c++)
+        {
+            FillSeries(&samples[c * perChannel], perChannel, rng);
+        }
+
+        vector<vector<DataSample>> serialOut(options.channels);
+        vector<vector<DataSample>> parallelOut(options.channels);
+        vector<LttbJob> serialJobs;
+        vector<LttbJob> parallelJobs;
+        for (size_t c = 0; c < options.channels; c++)
+        {
+            LttbJob job = { &samples[c * perChannel], perChannel, options.target, &serialOut[c] };
+            serialJobs.push_back(job);
+            job.out = &parallelOut[c];
+            parallelJobs.push_back(job);
+        }
+
+        double serialTime = TimeBest(serialJobs, 1, options.runs);
+        double parallelTime = TimeBest(parallelJobs, threads, options.runs);
+
+        for (size_t c = 0; c < options.channels; c++)
+        {
+            if (serialOut[c].size() != options.target || !SameOutput(serialOut[c], parallelOut[c]))
+            {
+                fprintf(stderr, "%zu samples: channel %zu differs between 1 and %u threads\n",
+                    total, c, threads);
+                passed = false;
+            }
+        }
+
+        double count = static_cast<double>(samples.size());
+        printf("%12zu %10.1f Mpt/s %10.1f Mpt/s %7.2fx\n", samples.size(),
+            count / serialTime / 1e6, count / parallelTime / 1e6, serialTime / parallelTime);
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+/*
+ * ShmProducer.c
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ *
+ * If you have any questions regarding the use of this file, feel free to
+ * contact the author of this file, or the owner of the project in which
+ * this file belongs to.
+ */
+
+/*
+ * Stand-in acquisition daemon: writes sine waves into a PiDash shared-memory
+ * ring (Data/ShmRing.h) so the ingest path can be exercised locally.
+ *
+ *     ShmProducer [--name /pidash-ingest] [--channels 4] [--rate 1000]
+ *                 [--seconds 0]
+ *
+ * --rate is samples per second per channel; --seconds 0 runs until killed.
+ * The first channel is named "Gauge", the rest "Channel<n>".
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Data/ShmRing.h"
+
+static volatile sig_atomic_t Running = 1;
+
+static void OnSignal(int signal)
+{
+    (void)signal;
+    Running = 0;
+}
+
+static double Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static void Usage(void)
+{
+    fprintf(stderr, "Usage: ShmProducer [--name /pidash-ingest] [--channels 4] [--rate 1000] [--seconds 0]\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* name = SHM_RING_DEFAULT_NAME;
+    int channelCount = 4;
+    double rate = 1000.0;
+    double seconds = 0.0;
+    ShmRingHeader* ring;
+    double start, next, interval;
+    uint64_t pushed = 0;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (i + 1 < argc && strcmp(argv[i], "--name") == 0)          name = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--channels") == 0) channelCount = atoi(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "--rate") == 0)     rate = atof(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "--seconds") == 0)  seconds = atof(argv[++i]);
+        else
+        {
+            Usage();
+            return 1;
+        }
+    }
+
+    if (channelCount < 1 || channelCount > (int)SHM_RING_MAX_CHANNELS || rate <= 0.0)
+    {
+        Usage();
+        return 1;
+    }
+
+    ring = shm_ring_create(name, SHM_RING_DEFAULT_CAPACITY);
+    if (ring == NULL)
+    {
+        perror("ShmProducer: shm_ring_create");
+        return 1;
+    }
+
+    for (i = 0; i < channelCount; i++)
+    {
+        char channelName[SHM_RING_NAME_LENGTH];
+        if (i == 0) snprintf(channelName, sizeof(channelName), "Gauge");
+        else        snprintf(channelName, sizeof(channelName), "Channel%d", i);
+        shm_ring_add_channel(ring, channelName);
+    }
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    printf("ShmProducer: Writing %d channels at %.0f Hz to %s\n", channelCount, rate, name);
+
+    /* Emit in 1ms batches so high rates do not need a sleep per sample */
+    start = Now();
+    next = start;
+    interval = 1.0 / rate;
+    while (Running && (seconds <= 0.0 || Now() - start < seconds))
+    {
+        double now = Now();
+        struct timespec pause = { 0, 1000000 };
+        while (next <= now)
+        {
+            double t = next - start;
+            for (i = 0; i < channelCount; i++)
+            {
+                float value = (float)(50.0 + 50.0 * sin(t * (0.2 + 0.1 * i) * 2.0 * 3.14159265358979));
+                shm_ring_push(ring, (uint32_t)i, next, value);
+                pushed++;
+            }
+            next += interval;
+        }
+        nanosleep(&pause, NULL);
+    }
+
+    printf("ShmProducer: Pushed %llu samples (%.0f/s)\n", (unsigned long long)pushed,
+        pushed / (Now() - start));
+    shm_ring_close(ring);
+    return 0;
+}
@@ -0,0 +1,204 @@
+/*
+ * SocketLoadGenerator.cpp
+ *
+ * Measures the throughput of the Unix socket ingest server
+ * (Data/SocketIngestServer.h) by streaming sample batches from one or more
+ * connections as fast as the server accepts them.
+ *
+ * Usage: SocketLoadGenerator [--path /tmp/pidash-ingest.sock] [--connections 1]
+ *                            [--channels 4] [--batch 256] [--seconds 5]
+ *
+ * Each connection registers --channels channels ("Gauge" on the first
+ * connection, "Load<c>.<n>" for the rest) and sends --batch samples per
+ * frame. Sends block once the socket buffer is full, so the reported rate is
+ * the rate the server consumed samples at.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Data/SocketIngestProtocol.h"
+
+using std::atomic;
+using std::string;
+using std::thread;
+using std::vector;
+using namespace octronic;
+
+typedef std::chrono::steady_clock Clock;
+
+struct LoadOptions
+{
+    string path = SOCKET_INGEST_DEFAULT_PATH;
+    int connections = 1;
+    int channels = 4;
+    int batch = 256;
+    double seconds = 5.0;
+};
+
+static bool WriteAll(int fd, const void* data, size_t size)
+{
+    auto bytes = static_cast<const uint8_t*>(data);
+    while (size > 0)
+    {
+        ssize_t written = write(fd, bytes, size);
+        if (written <= 0) return false;
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+static int Connect(const string& path)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool RegisterChannel(int fd, uint32_t channel, const string& name)
+{
+    if (name.size() > SOCKET_INGEST_MAX_NAME)
+    {
+        fprintf(stderr, "Channel name %s is longer than %d bytes\n", name.c_str(), SOCKET_INGEST_MAX_NAME);
+        return false;
+    }
+
+    uint8_t frame[sizeof(SocketIngestFrameHeader) + sizeof(channel) + SOCKET_INGEST_MAX_NAME];
+    uint8_t* nameField = frame + sizeof(SocketIngestFrameHeader) + sizeof(channel);
+    size_t nameLength = std::min(name.size(), sizeof(frame) - static_cast<size_t>(nameField - frame));
+    SocketIngestFrameHeader header = {
+        static_cast<uint32_t>(sizeof(channel) + nameLength), SocketIngest_RegisterChannel, 0 };
+    memcpy(frame, &header, sizeof(header));
+    memcpy(frame + sizeof(header), &channel, sizeof(channel));
+    memcpy(nameField, name.data(), nameLength);
+    return WriteAll(fd, frame, sizeof(header) + sizeof(channel) + nameLength);
+}
+
+static void RunConnection(const LoadOptions& options, int index, atomic<uint64_t>& sent, atomic<bool>& failed)
+{
+    int fd = Connect(options.path);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Unable to connect to %s: %s\n", options.path.c_str(), strerror(errno));
+        failed = true;
+        return;
+    }
+
+    for (int c = 0; c < options.channels; c++)
+    {
+        string name = (index == 0 && c == 0) ? "Gauge" :
+            "Load" + std::to_string(index) + "." + std::to_string(c);
+        if (!RegisterChannel(fd, static_cast<uint32_t>(c), name))
+        {
+            failed = true;
+            close(fd);
+            return;
+        }
+    }
+
+    vector<uint8_t> frame(sizeof(SocketIngestFrameHeader) + options.batch * sizeof(SocketIngestSample));
+    SocketIngestFrameHeader header = {
+        static_cast<uint32_t>(options.batch * sizeof(SocketIngestSample)), SocketIngest_Samples, 0 };
+    memcpy(frame.data(), &header, sizeof(header));
+    auto samples = reinterpret_cast<SocketIngestSample*>(frame.data() + sizeof(header));
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.seconds));
+    uint64_t count = 0;
+
+    while (Clock::now() < end)
+    {
+        for (int i = 0; i < options.batch; i++, count++)
+        {
+            double t = std::chrono::duration<double>(Clock::now() - start).count();
+            samples[i].channel = static_cast<uint32_t>(count % options.channels);
+            samples[i].value = static_cast<float>(50.0 + 50.0 * sin(t * 2.0));
+            samples[i].timestamp = t;
+        }
+        if (!WriteAll(fd, frame.data(), frame.size()))
+        {
+            fprintf(stderr, "Connection %d closed by server\n", index);
+            failed = true;
+            break;
+        }
+        sent.fetch_add(options.batch, std::memory_order_relaxed);
+    }
+    close(fd);
+}
+
+int main(int argc, char** argv)
+{
+    LoadOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--path" && hasValue)             options.path = argv[++i];
+        else if (arg == "--connections" && hasValue) options.connections = atoi(argv[++i]);
+        else if (arg == "--channels" && hasValue)    options.channels = atoi(argv[++i]);
+        else if (arg == "--batch" && hasValue)       options.batch = atoi(argv[++i]);
+        else if (arg == "--seconds" && hasValue)     options.seconds = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--path p] [--connections n] [--channels n] "
+                "[--batch n] [--seconds s]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    int maxBatch = static_cast<int>(SOCKET_INGEST_MAX_FRAME / sizeof(SocketIngestSample));
+    if (options.connections < 1 || options.channels < 1 ||
+        options.batch < 1 || options.batch > maxBatch || options.seconds <= 0.0)
+    {
+        fprintf(stderr, "Invalid options (batch must be 1..%d)\n", maxBatch);
+        return 1;
+    }
+
+    atomic<uint64_t> sent(0);
+    atomic<bool> failed(false);
+    vector<thread> threads;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < options.connections; i++)
+    {
+        threads.emplace_back(RunConnection, std::cref(options), i, std::ref(sent), std::ref(failed));
+    }
+    for (auto& t : threads) t.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    uint64_t total = sent.load();
+    printf("%llu samples in %.2f s over %d connection(s): %.0f samples/s (%.1f MB/s)\n",
+        static_cast<unsigned long long>(total), elapsed, options.connections,
+        total / elapsed, total * sizeof(SocketIngestSample) / elapsed / (1024.0 * 1024.0));
+    return failed ? 1 : 0;
+}
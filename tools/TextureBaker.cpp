@@ -0,0 +1,224 @@
+/*
+ * TextureBaker.cpp
+ *
+ * Offline converter from any SOIL-readable image to a baked texture
+ * container (.pdtx) with a pre-generated mipmap chain.
+ *
+ * Usage: TextureBaker [--format rgba8|dxt1|dxt5] <input image> <output.pdtx>
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+    #include "stb_image_aug.h"
+    #include "image_DXT.h"
+}
+
+#include "Assets/TextureContainerFormat.h"
+#include "Common/ImageKernels.h"
+
+using std::string;
+using std::vector;
+using namespace octronic;
+
+struct BakedLevel
+{
+    int width;
+    int height;
+    vector<unsigned char> pixels;
+    vector<unsigned char> payload;
+};
+
+static void PrintUsage()
+{
+    fprintf(stderr, "Usage: TextureBaker [--format rgba8|dxt1|dxt5] <input> <output%s>\n",
+        TEXTURE_CONTAINER_EXTENSION);
+}
+
+static bool ParseFormat(const string& name, uint32_t& format)
+{
+    if (name == "rgba8") { format = TexturePixelFormat_RGBA8; return true; }
+    if (name == "dxt1")  { format = TexturePixelFormat_DXT1;  return true; }
+    if (name == "dxt5")  { format = TexturePixelFormat_DXT5;  return true; }
+    return false;
+}
+
+static bool EncodeLevel(BakedLevel& level, uint32_t format)
+{
+    if (format == TexturePixelFormat_RGBA8)
+    {
+        level.payload = level.pixels;
+        return true;
+    }
+
+    int size = 0;
+    unsigned char* dxt = nullptr;
+    if (format == TexturePixelFormat_DXT1)
+    {
+        dxt = convert_image_to_DXT1(level.pixels.data(), level.width, level.height, 4, &size);
+    }
+    else
+    {
+        dxt = convert_image_to_DXT5(level.pixels.data(), level.width, level.height, 4, &size);
+    }
+
+    if (dxt == nullptr) return false;
+    level.payload.assign(dxt, dxt + size);
+    free(dxt);
+    return true;
+}
+
+static bool HasAlpha(const unsigned char* rgba, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (rgba[i * 4 + 3] != 255) return true;
+    }
+    return false;
+}
+
+static uint64_t Align(uint64_t value)
+{
+    return (value + TEXTURE_CONTAINER_ALIGNMENT - 1) & ~uint64_t(TEXTURE_CONTAINER_ALIGNMENT - 1);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t format = TexturePixelFormat_RGBA8;
+    vector<string> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc)
+        {
+            if (!ParseFormat(argv[++i], format))
+            {
+                PrintUsage();
+                return 1;
+            }
+        }
+        else
+        {
+            paths.push_back(arg);
+        }
+    }
+
+    if (paths.size() != 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    const string& inputPath = paths[0];
+    const string& outputPath = paths[1];
+
+    int width = 0, height = 0, channels = 0;
+    unsigned char* image = stbi_load(inputPath.c_str(), &width, &height, &channels, 4);
+    if (image == nullptr)
+    {
+        fprintf(stderr, "TextureBaker: Unable to load %s: %s\n", inputPath.c_str(), stbi_failure_reason());
+        return 1;
+    }
+
+    // DXT1 has no usable alpha, so it would square off cut-out images
+    // such as the needle
+    if (format == TexturePixelFormat_DXT1 && HasAlpha(image, static_cast<size_t>(width) * height))
+    {
+        printf("TextureBaker: %s has alpha, baking as dxt5 instead of dxt1\n", inputPath.c_str());
+        format = TexturePixelFormat_DXT5;
+    }
+
+    // Build the full mip chain down to 1x1, matching the GL level sizes
+    vector<BakedLevel> levels(1);
+    levels[0].width = width;
+    levels[0].height = height;
+    levels[0].pixels.assign(image, image + width * height * 4);
+    stbi_image_free(image);
+
+    // Filter the chain in premultiplied space so transparent texels do not
+    // bleed their colour into the smaller levels
+    ImageKernels::PremultiplyAlpha(levels[0].pixels.data(), static_cast<size_t>(width) * height);
+
+    while (levels.back().width > 1 || levels.back().height > 1)
+    {
+        const BakedLevel& prev = levels.back();
+        BakedLevel next;
+        next.width  = ImageKernels::MipWidth(prev.width);
+        next.height = ImageKernels::MipHeight(prev.height);
+        next.pixels.resize(next.width * next.height * 4);
+        ImageKernels::DownsampleBox(prev.pixels.data(), prev.width, prev.height, next.pixels.data());
+        levels.push_back(next);
+    }
+
+    for (BakedLevel& level : levels)
+    {
+        if (!EncodeLevel(level, format))
+        {
+            fprintf(stderr, "TextureBaker: Unable to encode %dx%d level\n", level.width, level.height);
+            return 1;
+        }
+    }
+
+    TextureContainerHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TEXTURE_CONTAINER_MAGIC, 4);
+    header.version = TEXTURE_CONTAINER_VERSION;
+    header.format = format;
+    header.width = width;
+    header.height = height;
+    header.levelCount = static_cast<uint32_t>(levels.size());
+    header.flags = TextureContainer_PremultipliedAlpha;
+
+    vector<TextureContainerLevel> table(levels.size());
+    uint64_t offset = sizeof(header) + table.size() * sizeof(TextureContainerLevel);
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        offset = Align(offset);
+        table[i].width = levels[i].width;
+        table[i].height = levels[i].height;
+        table[i].offset = offset;
+        table[i].size = levels[i].payload.size();
+        offset += table[i].size;
+    }
+
+    FILE* out = fopen(outputPath.c_str(), "wb");
+    if (out == nullptr)
+    {
+        fprintf(stderr, "TextureBaker: Unable to open %s for writing\n", outputPath.c_str());
+        return 1;
+    }
+
+    static const unsigned char padding[TEXTURE_CONTAINER_ALIGNMENT] = {0};
+    uint64_t written = 0;
+    written += fwrite(&header, 1, sizeof(header), out);
+    written += fwrite(table.data(), 1, table.size() * sizeof(TextureContainerLevel), out);
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        written += fwrite(padding, 1, static_cast<size_t>(table[i].offset - written), out);
+        written += fwrite(levels[i].payload.data(), 1, levels[i].payload.size(), out);
+    }
+    fclose(out);
+
+    if (written != offset)
+    {
+        fprintf(stderr, "TextureBaker: Short write to %s\n", outputPath.c_str());
+        return 1;
+    }
+
+    printf("TextureBaker: %s -> %s (%dx%d, %zu levels, %llu bytes)\n",
+        inputPath.c_str(), outputPath.c_str(), width, height, levels.size(),
+        static_cast<unsigned long long>(written));
+    return 0;
+}
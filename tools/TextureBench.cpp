@@ -0,0 +1,174 @@
+/*
+ * TextureBench.cpp
+ *
+ * Times the two CPU-side texture load paths of ImageWidget: opening a
+ * baked container (.pdtx, see TextureContainerFormat.h) against decoding
+ * the source PNG with stb, premultiplying it and building its mip chain.
+ *
+ * Usage: TextureBench [--runs 5] [--baked-dir dir] <image.png>...
+ *
+ * The container of Images/Gauge/Needle.png is Images/Gauge/Needle.pdtx,
+ * or Needle.pdtx in --baked-dir. From the build directory, where the
+ * resources are copied next to the baked containers:
+ *
+ *     ./TextureBench Images/Gauge/Needle.png Images/Gauge/<name>.png ...
+ *
+ * Both paths stop where the GL upload would start. The container path
+ * reads one byte of every page of each level's payload so its mapping is
+ * faulted in, as the upload would. Runs after the first hit the page
+ * cache, so the best run measures decode and parsing rather than the disk.
+ *
+ * This file may be distributed under the terms of GNU Public License version
+ * 3 (GPL v3) as defined by the Free Software Foundation (FSF). A copy of the
+ * license should have been included with this file, or the project in which
+ * this file belongs to. You may also find the details of GPL v3 at:
+ * http://www.gnu.org/licenses/gpl-3.0.txt
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+    #include "stb_image_aug.h"
+}
+
+#include "Assets/TextureContainer.h"
+#include "Common/ImageKernels.h"
+
+using std::string;
+using std::vector;
+using namespace octronic;
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchOptions
+{
+    int runs = 5;
+    string bakedDir;
+    vector<string> images;
+};
+
+// The source image path of ImageWidget, up to the upload
+static uint64_t LoadPng(const string& path)
+{
+    int width = 0, height = 0, channels = 0;
+    unsigned char* image = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (image == nullptr) return 0;
+    ImageKernels::PremultiplyAlpha(image, static_cast<size_t>(width) * height);
+
+    vector<uint8_t> mips[2];
+    const uint8_t* previous = image;
+    int level = 0;
+    while (width > 1 || height > 1)
+    {
+        int mipWidth = ImageKernels::MipWidth(width);
+        int mipHeight = ImageKernels::MipHeight(height);
+        vector<uint8_t>& mip = mips[level % 2];
+        mip.resize(static_cast<size_t>(mipWidth) * mipHeight * 4);
+        ImageKernels::DownsampleBox(previous, width, height, mip.data());
+        previous = mip.data();
+        width = mipWidth;
+        height = mipHeight;
+        level++;
+    }
+
+    uint64_t sum = previous[0] + previous[1] + previous[2] + previous[3];
+    stbi_image_free(image);
+    return sum + 1;
+}
+
+// The baked container path of ImageWidget, up to the upload
+static uint64_t LoadBaked(const string& path)
+{
+    TextureContainer container;
+    if (!container.Open(path)) return 0;
+
+    uint64_t sum = 1;
+    for (uint32_t level = 0; level < container.GetLevelCount(); level++)
+    {
+        const uint8_t* data = container.GetLevelData(level);
+        uint64_t size = container.GetLevel(level).size;
+        for (uint64_t i = 0; i < size; i += 4096) sum += data[i];
+    }
+    container.Close();
+    return sum;
+}
+
+static string BakedPath(const BenchOptions& options, const string& image)
+{
+    string baked = TextureContainer::BakedPathFor(image);
+    if (options.bakedDir.empty()) return baked;
+    size_t slash = baked.find_last_of("/\\");
+    return options.bakedDir + "/" + (slash == string::npos ? baked : baked.substr(slash + 1));
+}
+
+/** @return The best run in seconds, or a negative value if a load failed. */
+template<typename Load>
+static double Measure(const BenchOptions& options, Load load)
+{
+    double best = 0.0;
+    for (int run = 0; run < options.runs; run++)
+    {
+        Clock::time_point start = Clock::now();
+        if (load() == 0) return -1.0;
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        if (run == 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--runs" && hasValue)           options.runs = atoi(argv[++i]);
+        else if (arg == "--baked-dir" && hasValue) options.bakedDir = argv[++i];
+        else if (arg.compare(0, 2, "--") != 0)     options.images.push_back(arg);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--runs n] [--baked-dir dir] <image.png>...\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.runs < 1 || options.images.empty())
+    {
+        fprintf(stderr, "Usage: %s [--runs n] [--baked-dir dir] <image.png>...\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-32s %12s %12s %8s\n", "image", "png+mips ms", "baked ms", "speedup");
+    double pngTotal = 0.0;
+    double bakedTotal = 0.0;
+    for (const string& image : options.images)
+    {
+        string baked = BakedPath(options, image);
+        double png = Measure(options, [&image]() { return LoadPng(image); });
+        if (png < 0.0)
+        {
+            fprintf(stderr, "Unable to load %s: %s\n", image.c_str(), stbi_failure_reason());
+            return 1;
+        }
+        double container = Measure(options, [&baked]() { return LoadBaked(baked); });
+        if (container < 0.0)
+        {
+            fprintf(stderr, "Unable to open %s\n", baked.c_str());
+            return 1;
+        }
+
+        printf("%-32s %12.3f %12.3f %7.1fx\n", image.c_str(), png * 1000.0, container * 1000.0,
+            png / container);
+        pngTotal += png;
+        bakedTotal += container;
+    }
+    printf("%-32s %12.3f %12.3f %7.1fx\n", "total", pngTotal * 1000.0, bakedTotal * 1000.0,
+        pngTotal / bakedTotal);
+    return 0;
+}